@@ -13,7 +13,7 @@
 // The simulation variable is set up this way so both the checkpt
 // service and main can see it.  This allows main to find where
 // the restored objects are after a restore.
-vpic_simulation * simulation = NULL;
+VPIC_THREAD_LOCAL vpic_simulation * simulation = NULL;
 
 
 /**
@@ -48,20 +48,22 @@ void checkpt(const char* fbase, int tag)
 {
     char fname[256];
     if( !fbase ) ERROR(( "NULL filename base" ));
+    // Deferred dumps refer to the state being checkpointed
+    if( simulation ) simulation->flush_deferred_dumps();
     sprintf( fname, "%s.%i.%i", fbase, tag, world_rank );
     if( world_rank==0 ) log_printf( "*** Checkpointing to \"%s\"\n", fbase );
     checkpt_objects( fname );
 }
 
 /**
- * @brief Program main which triggers a vpic run
+ * @brief Runs vpic on this rank
  *
  * @param argc Standard arguments
  * @param argv Standard arguments
  *
  * @return Application error code
  */
-int main(int argc, char** argv)
+static int vpic_main(int argc, char** argv)
 {
 
     // Initialize underlying threads and services
@@ -149,3 +151,23 @@ int main(int argc, char** argv)
     halt_services();
     return 0;
 }
+
+/**
+ * @brief Program main which triggers a vpic run
+ *
+ * With the threaded message passing backend, the ranks are threads of this
+ * process and each of them runs vpic_main (see mp_run_ranks).
+ *
+ * @param argc Standard arguments
+ * @param argv Standard arguments
+ *
+ * @return Application error code
+ */
+int main(int argc, char** argv)
+{
+#if defined(VPIC_USE_THREAD_MP)
+    return mp_run_ranks( argc, argv, vpic_main );
+#else
+    return vpic_main( argc, argv );
+#endif
+}
@@ -48,8 +48,11 @@ vpic_simulation::user_current_injection( void )
 void                          \
 vpic_simulation::user_field_injection( void )
 
-#define begin_particle_collisions \
-void                              \
+// Decks can leave this out (see defer_dump in vpic/dump.cc)
+#define begin_particle_collisions                               \
+static int _deck_particle_collisions =                          \
+  ( vpic_simulation::deck_particle_collisions = 1 );            \
+void                                                            \
 vpic_simulation::user_particle_collisions( void )
 
 #define repeat( count ) for( int64_t _remain=(int64_t)(count); _remain; _remain-- )
@@ -38,6 +38,26 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
             field_array_t       * RESTRICT fa,
             accumulator_array_t * RESTRICT aa );
 
+/* boundary_p is begin_boundary_p followed by end_boundary_p.
+   begin_boundary_p processes the guard lists, injects the particles
+   of the local boundary handlers and starts sending the particles
+   that leave the local domain.  end_boundary_p receives and injects
+   the particles from the other domains.  In between, the caller may
+   do work that does not touch the particles, the movers or the
+   accumulators of the voxels on the surface of the local domain
+   (which are the only ones the received particles move through). */
+
+void
+begin_boundary_p( particle_bc_t       * RESTRICT pbc_list,
+                  species_t           * RESTRICT sp_list,
+                  field_array_t       * RESTRICT fa,
+                  accumulator_array_t * RESTRICT aa );
+
+void
+end_boundary_p( species_t           * RESTRICT sp_list,
+                field_array_t       * RESTRICT fa,
+                accumulator_array_t * RESTRICT aa );
+
 /* In maxwellian_reflux.c */
 
 particle_bc_t *
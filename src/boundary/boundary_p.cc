@@ -1,6 +1,8 @@
 #define IN_boundary
 #include "boundary_private.h"
 
+#include "../util/pipelines/pipelines_exec.h"
+
 // If this is defined particle and mover buffers will not resize dynamically
 // (This is the common case for the users)
 //#define DISABLE_DYNAMIC_RESIZING
@@ -30,52 +32,923 @@ using namespace v4;
 //#define MIN_NP 32768 // 32768 particles is 1 MiB of memory.
 #endif
 
+// The movers of a species and the injectors of a buffer are processed by
+// the pipelines when there are at least MIN_PIPELINE_NM of them.  Injecting
+// with the pipelines also clears and reduces the pipeline accumulators, so
+// this is only done when there is at least one injector per
+// INJECT_PIPELINE_VOXELS voxels.
+#ifndef MIN_PIPELINE_NM
+#define MIN_PIPELINE_NM 4096
+#endif
+#ifndef INJECT_PIPELINE_VOXELS
+#define INJECT_PIPELINE_VOXELS 8
+#endif
+
 
 enum { MAX_PBC = 32, MAX_SP = 32 };
 
+// Gives the local mp port associated with a local face
+static const int f2b[6]  = { BOUNDARY(-1, 0, 0),
+                             BOUNDARY( 0,-1, 0),
+                             BOUNDARY( 0, 0,-1),
+                             BOUNDARY( 1, 0, 0),
+                             BOUNDARY( 0, 1, 0),
+                             BOUNDARY( 0, 0, 1) };
+
+// Gives the axis associated with a local face
+static const int axis[6]  = { 0, 1, 2,  0,  1,  2 };
+
+// Gives the location of sending face on the receiver
+static const float dir[6] = { 1, 1, 1, -1, -1, -1 };
+
+// Gives the mp ports in the order their particles are injected: the
+// faces first, then the edges and corners
+static const int ports[26] = { BOUNDARY(-1, 0, 0), BOUNDARY( 0,-1, 0),
+                               BOUNDARY( 0, 0,-1), BOUNDARY( 1, 0, 0),
+                               BOUNDARY( 0, 1, 0), BOUNDARY( 0, 0, 1),
+                               0,  1,  2,  3,  5,  6,  7,  8,  9, 11,
+                               15, 17, 18, 19, 20, 21, 23, 24, 25, 26 };
+
+// Gives the remote mp port associated with a local port
+#define RPORT(port) (26-(port))
+
+// State of the exchange between begin_boundary_p and end_boundary_p
+
+static VPIC_THREAD_LOCAL int n_send[27], n_recv[27];
+static VPIC_THREAD_LOCAL int in_progress = 0;
+
+// Unpack the faces of the local domain
+
+static void
+unpack_faces( const grid_t * g,
+              int * bc,
+              int * shared,
+              int64_t * range ) {
+  for( int face=0; face<6; face++ ) {
+    bc[face] = g->bc[f2b[face]];
+    shared[face] = (bc[face]>=0) && (bc[face]<world_size) &&
+                   (bc[face]!=world_rank);
+    if( shared[face] ) range[face] = g->range[bc[face]];
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Edge and corner neighbors
+//
+// A particle that leaves the local domain through a face usually stops in
+// the domain on the other side of the face.  If it instead crosses into a
+// further domain (through an edge or a corner of the local domain), it is
+// followed to that domain here and sent to it directly through the port of
+// that edge or corner, such that it gets to its destination in one round.
+// The domains it passes through on the way are still sent the particle (to
+// deposit its current), but marked such that they drop it after moving it.
+// The edge and corner neighbors are determined from the face neighbors of
+// all domains.  Particles are only sent directly if all domains have the
+// same resolution and the domain at an edge or corner is the same whichever
+// way it is reached.  A particle is only followed through a domain in the
+// layer of voxels it entered that domain through, and only if that layer
+// has no particle boundary conditions (e.g. internal absorbers or
+// reflectors).  Otherwise, that domain gets the particle and applies them.
+//----------------------------------------------------------------------------//
+
+// Injectors with a negative species id are for particles that only pass
+// through the receiving domain.
+
+#define PASS_SP_ID(id) (-1-(id))
+
+// Range of the grid the routes are for (the range changes when the load
+// is rebalanced)
+static VPIC_THREAD_LOCAL int64_t * route_range = NULL;
+
+// (0:9,0:world_size-1) indexed; for each domain, nx, ny, nz, the domain
+// its particles cross into through each face (-1 if not another domain)
+// and a bit for each face set if the layer of voxels on the inside of the
+// face has no particle boundary conditions
+static VPIC_THREAD_LOCAL int * route_face = NULL;
+
+static VPIC_THREAD_LOCAL int route_rank[27]; // Domain for each port, -1 if none
+static VPIC_THREAD_LOCAL int route_any = 0;  // Any edge or corner neighbors?
+
+// Domain reached from domain r by crossing the faces in direction
+// (i,j,k), in any order (-1 if this is ambiguous or crosses a face that is
+// not shared with another domain).
+
+static int
+route_domain( int r, int i, int j, int k ) {
+  static const int perm[6][3] = { {0,1,2}, {0,2,1}, {1,0,2},
+                                  {1,2,0}, {2,0,1}, {2,1,0} };
+  const int off[3] = { i, j, k };
+  int n, a, cur, dst = -1;
+
+  for( n=0; n<6; n++ ) {
+    cur = r;
+    for( a=0; a<3 && cur>=0; a++ )
+      if( off[perm[n][a]] )
+        cur = route_face[ 10*cur + 3 + perm[n][a] + (off[perm[n][a]]>0 ? 3 : 0) ];
+    if( cur<0 || ( dst>=0 && cur!=dst ) ) return -1;
+    dst = cur;
+  }
+
+  return dst==r ? -1 : dst;
+}
+
+// Determine the edge and corner neighbors of the local domain.  This is
+// collective, so whether it is needed is decided from g->range only:
+// g->range is gathered from all domains (see size_grid), so it is the same
+// on every rank and every rank redoes this together when the domains are
+// resized (e.g. by rebalancing).  The routes are not redone if particle
+// boundary conditions are changed without resizing the domains.
+
+static void
+setup_routes( const grid_t * g ) {
+  const int64_t * RESTRICT ALIGNED(128) neighbor = g->neighbor;
+  const int nx = g->nx, ny = g->ny, nz = g->nz;
+  int local[10], face, i, j, k, r, x, y, z, rx, ry, rz;
+
+  if( route_range &&
+      memcmp( route_range, g->range, (world_size+1)*sizeof(int64_t) )==0 )
+    return;
+
+  // Determine which faces particles cross into another domain through.
+  // This is the case if the neighbors of all the voxels on the face are
+  // the matching voxels of that domain.
+
+  local[0] = nx; local[1] = ny; local[2] = nz;
+  for( face=0; face<6; face++ ) {
+    const int b = g->bc[f2b[face]];
+    int ok = (b>=0) && (b<world_size) && (b!=world_rank);
+    for( z=1; ok && z<=nz; z++ )
+      for( y=1; ok && y<=ny; y++ )
+        for( x=1; ok && x<=nx; x++ ) {
+          rx = x; ry = y; rz = z;
+          switch( face ) {
+          case 0: if( x!=1  ) continue; rx = nx; break;
+          case 1: if( y!=1  ) continue; ry = ny; break;
+          case 2: if( z!=1  ) continue; rz = nz; break;
+          case 3: if( x!=nx ) continue; rx = 1;  break;
+          case 4: if( y!=ny ) continue; ry = 1;  break;
+          case 5: if( z!=nz ) continue; rz = 1;  break;
+          }
+          ok = neighbor[ 6*VOXEL(x,y,z,nx,ny,nz) + face ] ==
+               g->range[b] + VOXEL(rx,ry,rz,nx,ny,nz);
+        }
+    local[3+face] = ok ? b : -1;
+  }
+
+  // Determine which layers of voxels on the inside of the faces particles
+  // stream freely through.  This is the case if the neighbors of all the
+  // voxels of the layer within the local domain are the adjacent voxels.
+
+  local[9] = 0;
+  for( face=0; face<6; face++ ) {
+    int ok = 1, n;
+    for( z=1; ok && z<=nz; z++ )
+      for( y=1; ok && y<=ny; y++ )
+        for( x=1; ok && x<=nx; x++ ) {
+          switch( face ) {
+          case 0: if( x!=1  ) continue; break;
+          case 1: if( y!=1  ) continue; break;
+          case 2: if( z!=1  ) continue; break;
+          case 3: if( x!=nx ) continue; break;
+          case 4: if( y!=ny ) continue; break;
+          case 5: if( z!=nz ) continue; break;
+          }
+          for( n=0; ok && n<6; n++ ) {
+            rx = x; ry = y; rz = z;
+            switch( n ) {
+            case 0: rx--; break;
+            case 1: ry--; break;
+            case 2: rz--; break;
+            case 3: rx++; break;
+            case 4: ry++; break;
+            case 5: rz++; break;
+            }
+            if( rx<1 || rx>nx || ry<1 || ry>ny || rz<1 || rz>nz ) continue;
+            ok = neighbor[ 6*VOXEL(x,y,z,nx,ny,nz) + n ] ==
+                 g->rangel + VOXEL(rx,ry,rz,nx,ny,nz);
+          }
+        }
+    if( ok ) local[9] |= 1<<face;
+  }
+
+  FREE( route_face );
+  MALLOC( route_face, 10*world_size );
+  mp_allgather_i( local, route_face, 10 );
+
+  for( i=0; i<27; i++ ) route_rank[i] = -1;
+  route_any = 0;
+  for( face=0; face<6; face++ ) route_rank[f2b[face]] = local[3+face];
+
+  for( r=0; r<world_size; r++ )
+    if( route_face[10*r+0]!=nx || route_face[10*r+1]!=ny ||
+        route_face[10*r+2]!=nz ) break;
+
+  if( r==world_size )
+    for( k=-1; k<=1; k++ )
+      for( j=-1; j<=1; j++ )
+        for( i=-1; i<=1; i++ ) {
+          if( (i!=0) + (j!=0) + (k!=0) < 2 ) continue;
+          r = route_domain( world_rank, i, j, k );
+          if( r>=0 && route_domain( r, -i, -j, -k )==world_rank )
+            route_rank[BOUNDARY(i,j,k)] = r, route_any = 1;
+        }
+
+  FREE( route_range );
+  MALLOC( route_range, world_size+1 );
+  COPY( route_range, g->range, world_size+1 );
+}
+
+// The particle of the injector pi crosses into the domain on the other
+// side of face.  Follow it through that domain (the same way move_p
+// would) and through any further domains it crosses into that it can be
+// sent to directly.  Returns the number of further domains and gives the
+// injector and port for each.  The injector for each domain but the last
+// is for a particle that only passes through.  A particle is only
+// followed from voxel to voxel in the layer of the face it entered a
+// domain through (in) and only if that layer streams freely.  The routes
+// are passed in (rf is route_face and rr is route_rank) as this is called
+// by the pipelines.
+
+static int
+route_particle( const particle_injector_t * RESTRICT pi,
+                int face,
+                const int * RESTRICT rf,
+                const int * RESTRICT rr,
+                particle_injector_t * RESTRICT hop,
+                int * RESTRICT hop_port ) {
+  const int n[3] = { rf[0], rf[1], rf[2] };
+  const int sy = n[0]+2, sz = sy*(n[1]+2);
+  float r[3], d[3], s_dir[3], v[3], v3, s;
+  int c[3], off[3] = { 0, 0, 0 }, nh = 0, a, ax, side, f, port, cur, in;
+
+  r[0] = pi->dx;    r[1] = pi->dy;    r[2] = pi->dz;
+  d[0] = pi->dispx; d[1] = pi->dispy; d[2] = pi->dispz;
+  c[2] = pi->i/sz; c[1] = (pi->i - c[2]*sz)/sy; c[0] = pi->i - c[2]*sz - c[1]*sy;
+  off[axis[face]] = face<3 ? -1 : 1;
+  cur = rr[f2b[face]];
+  in  = face<3 ? face+3 : face-3;
+  if( cur<0 ) return 0; // Not all particles crossing face get to cur
+
+  for(;;) {
+
+    // Streak to the first face crossed (see move_p)
+
+    for( a=0; a<3; a++ ) {
+      s_dir[a] = (d[a]>0.0f) ? 1.0f : -1.0f;
+      v[a] = (d[a]==0.0f) ? 3.4e38f : (s_dir[a]-r[a])/d[a];
+    }
+    /**/        v3=2.0f, ax=3;
+    if(v[0]<v3) v3=v[0], ax=0;
+    if(v[1]<v3) v3=v[1], ax=1;
+    if(v[2]<v3) v3=v[2], ax=2;
+    v3 *= 0.5f;
+    for( a=0; a<3; a++ ) {
+      s = d[a]*v3;
+      d[a] -= s;
+      r[a] += s+s;
+    }
+
+    if( ax==3 ) break; // Stops in this domain
+
+    r[ax] = s_dir[ax];
+    side = s_dir[ax]>0;
+    if( c[ax] != ( side ? n[ax] : 1 ) ) {
+      // Crossed into another voxel of this domain.  Stop following the
+      // particle if it leaves the layer or the layer has particle boundary
+      // conditions (this domain then applies them).
+      if( ax==axis[in] || !( rf[10*cur+9] & (1<<in) ) ) break;
+      c[ax] += side ? 1 : -1;
+      r[ax] = -s_dir[ax];
+      continue;
+    }
+
+    // Crossed into another domain.  Stop following the particle if it
+    // cannot be sent there directly.
+
+    f = ax + (side ? 3 : 0);
+    off[ax] += side ? 1 : -1;
+    if( nh==2 || off[ax]<-1 || off[ax]==0 || off[ax]>1 ) break;
+    port = BOUNDARY( off[0], off[1], off[2] );
+    if( rf[10*cur+3+f]<0 || rf[10*cur+3+f]!=rr[port] ) break;
+    cur = rr[port];
+    in  = side ? ax : ax+3;
+
+#   if defined(VPIC_USE_COMPACT_P)
+    // The domain passed through stores the particle where it stops
+    for( a=0; a<3; a++ ) r[a] = SNAP_OFFSET( r[a] );
+#   endif
+    c[ax] = side ? 1 : n[ax];
+    r[ax] = -s_dir[ax];
+
+    hop[nh] = *pi;
+    hop[nh].dx    = r[0]; hop[nh].dy    = r[1]; hop[nh].dz    = r[2];
+    hop[nh].i     = c[0] + sy*c[1] + sz*c[2];
+    hop[nh].dispx = d[0]; hop[nh].dispy = d[1]; hop[nh].dispz = d[2];
+    hop_port[nh++] = port;
+  }
+
+  return nh;
+}
+
+// Unpack the domains particles are exchanged with through each port (-1
+// if none)
+
+static void
+unpack_ports( const int * bc,
+              const int * shared,
+              int * peer ) {
+  for( int port=0; port<27; port++ ) peer[port] = route_rank[port];
+  for( int face=0; face<6; face++ )
+    peer[f2b[face]] = shared[face] ? bc[face] : -1;
+}
+
+// Resize each species's particle and mover storage to be large enough
+// to guarantee successful injection of max_inj particles.  (If we broke
+// down the n_recv[face] by species before sending it, we could be
+// tighter on memory footprint here.)  Storage only shrinks if shrink is
+// set.
+
+static void
+reserve_particles( species_t * RESTRICT sp_list,
+                   int64_t max_inj,
+                   int shrink ) {
+# ifndef DISABLE_DYNAMIC_RESIZING
+  species_t * sp;
+  int64_t n, nm;
+
+  LIST_FOR_EACH( sp, sp_list ) {
+    particle_mover_t * new_pm;
+    particle_block_t * new_p;
+
+    n = sp->np + max_inj;
+    if( n>sp->max_np ) {
+      n += 0.3125*n; // Increase by 31.25% (~<"silver
+      /**/                     // ratio") to minimize resizes (max
+      /**/                     // rate that avoids excessive heap
+      /**/                     // fragmentation)
+      //float resize_ratio = (float)n/sp->max_np;
+      WARNING(( "Resizing local %s particle storage from %li to %li",
+                sp->name, (long)sp->max_np, (long)n ));
+      MALLOC_ALIGNED( new_p, PARTICLE_BLOCKS(n), 128 );
+      COPY( new_p, sp->p, PARTICLE_BLOCKS(sp->np) );
+      FREE_ALIGNED( sp->p );
+      sp->p = new_p, sp->max_np = n;
+
+      /*nm = sp->max_nm * resize_ratio;
+      WARNING(( "Resizing local %s mover storage from %i to %i",
+                sp->name, sp->max_nm, nm ));
+      MALLOC_ALIGNED( new_pm, nm, 128 );
+      COPY( new_pm, sp->pm, sp->nm );
+      FREE_ALIGNED( sp->pm );
+      sp->pm = new_pm;
+      sp->max_nm = nm;*/
+    }
+    else if(shrink && sp->max_np > MIN_NP && n < sp->max_np>>1)
+    {
+      n += 0.125*n; // Overallocate by less since this rank is decreasing
+      if (n<MIN_NP) n = MIN_NP;
+      //float resize_ratio = (float)n/sp->max_np;
+      WARNING(( "Resizing (shrinking) local %s particle storage from "
+                  "%li to %li", sp->name, (long)sp->max_np, (long)n));
+      MALLOC_ALIGNED( new_p, PARTICLE_BLOCKS(n), 128 );
+      COPY( new_p, sp->p, PARTICLE_BLOCKS(sp->np) );
+      FREE_ALIGNED( sp->p );
+      sp->p = new_p, sp->max_np = n;
+
+      /*nm = sp->max_nm * resize_ratio;
+      WARNING(( "Resizing (shrinking) local %s mover storage from "
+                  "%i to %i", sp->name, sp->max_nm, nm));
+      MALLOC_ALIGNED( new_pm, nm, 128 );
+      COPY( new_pm, sp->pm, sp->nm );
+      FREE_ALIGNED( sp->pm );
+      sp->pm = new_pm, sp->max_nm = nm;*/
+    }
+
+    // Feasibly, a vacuum-filled rank may receive a shock and need more movers
+    // than available from MIN_NP
+    nm = sp->nm + max_inj;
+    if( nm>sp->max_nm ) {
+      nm += 0.3125*nm; // See note above
+      //float resize_ratio = (float)nm/sp->max_nm;
+      WARNING(( "This happened.  Resizing local %s mover storage from "
+                  "%li to %li based on not enough movers",
+                sp->name, (long)sp->max_nm, (long)nm ));
+      MALLOC_ALIGNED( new_pm, nm, 128 );
+      COPY( new_pm, sp->pm, sp->nm );
+      FREE_ALIGNED( sp->pm );
+      sp->pm = new_pm;
+      sp->max_nm = nm;
+
+      /*n = sp->max_np * resize_ratio;
+      WARNING(( "Resizing local %s particle storage from %i to %i",
+                sp->name, sp->max_np, n ));
+      MALLOC_ALIGNED( new_p, n, 128 );
+      COPY( new_p, sp->p, sp->np );
+      FREE_ALIGNED( sp->p );
+      sp->p = new_p, sp->max_np = n;*/
+    }
+  }
+# endif
+}
+
+// Inject the n particles of the injectors pi and move them to their
+// final location, accumulating their current to a0.
+
+static void
+inject_particles( species_t * RESTRICT sp_list,
+                  const particle_injector_t * RESTRICT ALIGNED(16) pi,
+                  int64_t n,
+                  accumulator_t * RESTRICT ALIGNED(128) a0,
+                  const grid_t * g ) {
+  species_t * sp;
+
+  if( !n ) return;
+
+  // Unpack the species list for random acesss
+
+  particle_block_t * RESTRICT ALIGNED(32) sp_p[ MAX_SP];
+  particle_mover_t * RESTRICT ALIGNED(32) sp_pm[MAX_SP];
+  float sp_q[MAX_SP];
+  int64_t sp_np[MAX_SP];
+  int64_t sp_nm[MAX_SP];
+
+# ifdef DISABLE_DYNAMIC_RESIZING
+  int64_t sp_max_np[64], n_dropped_particles[64];
+  int64_t sp_max_nm[64], n_dropped_movers[64];
+# endif
+
+  if( num_species( sp_list ) > MAX_SP )
+    ERROR(( "Update this to support more species" ));
+  LIST_FOR_EACH( sp, sp_list ) {
+    sp_p[  sp->id ] = sp->p;
+    sp_pm[ sp->id ] = sp->pm;
+    sp_q[  sp->id ] = sp->q;
+    sp_np[ sp->id ] = sp->np;
+    sp_nm[ sp->id ] = sp->nm;
+#   ifdef DISABLE_DYNAMIC_RESIZING
+    sp_max_np[sp->id]=sp->max_np; n_dropped_particles[sp->id]=0;
+    sp_max_nm[sp->id]=sp->max_nm; n_dropped_movers[sp->id]=0;
+#   endif
+  }
+
+  /**/  particle_block_t    * RESTRICT ALIGNED(32) p;
+  /**/  particle_mover_t    * RESTRICT ALIGNED(16) pm;
+  int64_t np, nm;
+  int id;
+
+  // Pass through particles are moved in a scratch block, such that their
+  // current is deposited even if the particle storage is full.
+
+  DECLARE_ALIGNED_ARRAY( particle_block_t, 128, scratch, 1 );
+  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16,  scratch_pm, 1 );
+
+  // Reverse order injection is done to reduce thrashing of the
+  // particle list (particles are removed reverse order so the
+  // overall impact of removal + injection is to keep injected
+  // particles in order).
+  //
+  // WARNING: THIS TRUSTS THAT THE INJECTORS (INCLUDING THOSE
+  // RECEIVED FROM OTHER NODES) HAVE VALID PARTICLE IDS.
+
+  pi += n-1;
+  for( ; n; pi--, n-- ) {
+    id = pi->sp_id;
+    if( id<0 ) {
+
+      // The particle only passes through the local domain (it was also
+      // sent to where it stops).  Move it to accumulate its current and
+      // drop it.
+
+      id = PASS_SP_ID(id);
+      store_particle( (const particle_t *)pi, scratch, 0 );
+      scratch_pm->dispx = pi->dispx;
+      scratch_pm->dispy = pi->dispy;
+      scratch_pm->dispz = pi->dispz;
+      scratch_pm->i     = 0;
+      move_p( scratch, scratch_pm, a0, g, sp_q[id] );
+      continue;
+    }
+
+    p  = sp_p[id];  np = sp_np[id];
+    pm = sp_pm[id]; nm = sp_nm[id];
+
+#   ifdef DISABLE_DYNAMIC_RESIZING
+    if( np>=sp_max_np[id] ) { n_dropped_particles[id]++; continue; }
+#   endif
+#   if defined(V4_ACCELERATION) && PARTICLE_LAYOUT_AOS
+    copy_4x1(  &p[np].dx,    &pi->dx    );
+    copy_4x1(  &p[np].ux,    &pi->ux    );
+#   else
+    // The leading fields of an injector are laid out as a particle_t.
+    store_particle( (const particle_t *)pi, p, np );
+#   endif
+    sp_np[id] = np+1;
+
+#   ifdef DISABLE_DYNAMIC_RESIZING
+    if( nm>=sp_max_nm[id] ) { n_dropped_movers[id]++;    continue; }
+#   endif
+#   ifdef V4_ACCELERATION
+    copy_4x1( &pm[nm].dispx, &pi->dispx );
+    pm[nm].i = np;
+#   else
+    pm[nm].dispx=pi->dispx; pm[nm].dispy=pi->dispy; pm[nm].dispz=pi->dispz;
+    pm[nm].i=np;
+#   endif
+    sp_nm[id] = nm + move_p( p, pm+nm, a0, g, sp_q[id] );
+  }
+
+  LIST_FOR_EACH( sp, sp_list ) {
+#   ifdef DISABLE_DYNAMIC_RESIZING
+    if( n_dropped_particles[sp->id] )
+      WARNING(( "Dropped %li particles from species \"%s\".  Use a larger "
+                "local particle allocation in your simulation setup for "
+                "this species on this node.",
+                (long)n_dropped_particles[sp->id], sp->name ));
+    if( n_dropped_movers[sp->id] )
+      WARNING(( "%li particles were not completed moved to their final "
+                "location this timestep for species \"%s\".  Use a larger "
+                "local particle mover buffer in your simulation setup "
+                "for this species on this node.",
+                (long)n_dropped_movers[sp->id], sp->name ));
+#   endif
+    sp->np=sp_np[sp->id];
+    sp->nm=sp_nm[sp->id];
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Pipelined injection
+//
+// The injectors are split among the pipelines with DISTRIBUTE.  Each
+// pipeline first counts the particles of each species in its share.  The
+// host then gives each pipeline the slots its particles go in, such that
+// the particles end up where inject_particles would put them (the shares
+// of the higher pipelines first, as the injectors are processed in
+// reverse order).  Each pipeline then injects its share, accumulating to
+// its own accumulator, and keeps the movers of the particles that hit a
+// boundary.  The host appends these to the mover lists in the same order,
+// so the movers stay in increasing particle order.
+//
+// The caller clears the pipeline accumulators before and reduces them
+// into the host accumulator after.  This needs enough room for all the
+// particles and movers (see reserve_particles), so it is not used with
+// DISABLE_DYNAMIC_RESIZING.
+//----------------------------------------------------------------------------//
+
+typedef struct inject_buffer {
+  int64_t n_sp[MAX_SP];        // Particles of each species in the share
+  int64_t np[MAX_SP];          // Next slot of each species
+  particle_mover_t * ALIGNED(16) pm; // Movers left by the share ...
+  int32_t * pm_id;             // ... and their species
+  int64_t nm, max_nm;
+} inject_buffer_t;
+
+typedef struct inject_pipeline_args {
+  const particle_injector_t * ALIGNED(16) pi;
+  int64_t n;
+  particle_block_t * ALIGNED(128) sp_p[MAX_SP];
+  float sp_q[MAX_SP];
+  accumulator_t * ALIGNED(128) a0; // Pipeline k uses a0 + (1+k)*stride
+  int64_t stride;
+  const grid_t * g;
+  inject_buffer_t * buf;           // Indexed by pipeline rank
+} inject_pipeline_args_t;
+
+static void
+count_injectors_pipeline_scalar( inject_pipeline_args_t * args,
+                                 int pipeline_rank,
+                                 int n_pipeline ) {
+  const particle_injector_t * RESTRICT ALIGNED(16) pi;
+  inject_buffer_t * RESTRICT b = args->buf + pipeline_rank;
+  int64_t i, n;
+
+  CLEAR( b->n_sp, MAX_SP );
+
+  DISTRIBUTE( args->n, 1, pipeline_rank, n_pipeline, i, n );
+
+  for( pi=args->pi+i; n; pi++, n-- )
+    if( pi->sp_id>=0 ) b->n_sp[pi->sp_id]++;
+}
+
+static void
+inject_particles_pipeline_scalar( inject_pipeline_args_t * args,
+                                  int pipeline_rank,
+                                  int n_pipeline ) {
+  const particle_injector_t * RESTRICT ALIGNED(16) pi;
+  inject_buffer_t * RESTRICT b = args->buf + pipeline_rank;
+  accumulator_t * RESTRICT ALIGNED(128) a0 = args->a0;
+  const grid_t * g = args->g;
+
+  particle_block_t * RESTRICT ALIGNED(32) p;
+  particle_mover_t * RESTRICT ALIGNED(16) pm;
+  int64_t i, n, np;
+  int id;
+
+  // Pass through particles are moved in a scratch block, as the free
+  // storage after the particles is in use by the other pipelines.
+
+  DECLARE_ALIGNED_ARRAY( particle_block_t, 128, scratch, 1 );
+  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16,  scratch_pm, 1 );
+
+  if( pipeline_rank<n_pipeline ) a0 += ( 1 + pipeline_rank )*args->stride;
+  b->nm = 0;
+
+  DISTRIBUTE( args->n, 1, pipeline_rank, n_pipeline, i, n );
+
+  // Reverse order injection (see inject_particles)
+
+  for( pi=args->pi+i+n-1; n; pi--, n-- ) {
+    id = pi->sp_id;
+    if( id<0 ) {
+      id = PASS_SP_ID(id);
+      store_particle( (const particle_t *)pi, scratch, 0 );
+      scratch_pm->dispx = pi->dispx;
+      scratch_pm->dispy = pi->dispy;
+      scratch_pm->dispz = pi->dispz;
+      scratch_pm->i     = 0;
+      move_p( scratch, scratch_pm, a0, g, args->sp_q[id] );
+      continue;
+    }
+
+    p  = args->sp_p[id];
+    np = b->np[id]++;
+    pm = b->pm + b->nm;
+
+    // The leading fields of an injector are laid out as a particle_t.
+    store_particle( (const particle_t *)pi, p, np );
+    pm->dispx = pi->dispx; pm->dispy = pi->dispy; pm->dispz = pi->dispz;
+    pm->i     = np;
+    if( move_p( p, pm, a0, g, args->sp_q[id] ) ) b->pm_id[b->nm++] = id;
+  }
+}
+
+// Use the pipelines to inject n particles?
+
+static int
+inject_pipelined( const accumulator_array_t * aa,
+                  int64_t n ) {
+# ifdef DISABLE_DYNAMIC_RESIZING
+  return 0;
+# else
+  return N_PIPELINE>1 && aa->n_pipeline>=N_PIPELINE &&
+         n>=MIN_PIPELINE_NM && n*INJECT_PIPELINE_VOXELS>=aa->stride;
+# endif
+}
+
+// Clear the pipeline accumulators before the pipelined injection
+
+static void
+begin_inject_pipelines( accumulator_array_t * aa ) {
+  CLEAR_PIPELINES( aa->a + aa->stride, (int64_t)aa->n_pipeline*aa->stride,
+                   aa->stride );
+}
+
+// Same as inject_particles, with the pipelines.  Call between
+// begin_inject_pipelines and reduce_accumulator_array.
+
+static void
+inject_particles_pipelined( species_t * RESTRICT sp_list,
+                            const particle_injector_t * RESTRICT ALIGNED(16) pi,
+                            int64_t n,
+                            accumulator_array_t * RESTRICT aa,
+                            const grid_t * g ) {
+  static VPIC_THREAD_LOCAL inject_buffer_t * buf = NULL;
+
+  DECLARE_ALIGNED_ARRAY( inject_pipeline_args_t, 128, args, 1 );
+
+  species_t * sp_of[MAX_SP];
+  species_t * sp;
+  int64_t share, np;
+  int rank, k;
+
+  if( !n ) return;
+
+  if( num_species( sp_list ) > MAX_SP )
+    ERROR(( "Update this to support more species" ));
+
+  if( !buf ) {
+    MALLOC( buf, MAX_PIPELINE+1 );
+    CLEAR( buf, MAX_PIPELINE+1 );
+  }
+
+  // Each pipeline keeps at most one mover per injector of its share.  The
+  // shares DISTRIBUTE gives differ by at most one injector and the host
+  // gets none.
+
+  share = n/N_PIPELINE + 1;
+  for( rank=0; rank<N_PIPELINE; rank++ ) {
+    inject_buffer_t * b = buf + rank;
+    if( share>b->max_nm ) {
+      FREE_ALIGNED( b->pm );
+      FREE( b->pm_id );
+      MALLOC_ALIGNED( b->pm, share, 16 );
+      MALLOC( b->pm_id, share );
+      b->max_nm = share;
+    }
+  }
+
+  args->pi     = pi;
+  args->n      = n;
+  args->a0     = aa->a;
+  args->stride = aa->stride;
+  args->g      = g;
+  args->buf    = buf;
+  LIST_FOR_EACH( sp, sp_list ) {
+    args->sp_p[sp->id] = sp->p;
+    args->sp_q[sp->id] = sp->q;
+    sp_of[sp->id]      = sp;
+  }
+
+  EXEC_PIPELINES( count_injectors, args, 0 );
+  WAIT_PIPELINES();
+
+  // The higher pipelines have the injectors that are injected first
+
+  LIST_FOR_EACH( sp, sp_list ) {
+    np = sp->np;
+    for( rank=N_PIPELINE; rank>=0; rank-- ) {
+      buf[rank].np[sp->id] = np;
+      np += buf[rank].n_sp[sp->id];
+    }
+    sp->np = np;
+  }
+
+  EXEC_PIPELINES( inject_particles, args, 0 );
+  WAIT_PIPELINES();
+
+  for( rank=N_PIPELINE; rank>=0; rank-- )
+    for( k=0; k<buf[rank].nm; k++ ) {
+      sp = sp_of[ buf[rank].pm_id[k] ];
+      sp->pm[ sp->nm++ ] = buf[rank].pm[k];
+    }
+}
+
+//----------------------------------------------------------------------------//
+// Pipelined mover processing
+//
+// The movers of a species are split among the pipelines with DISTRIBUTE.
+// Each pipeline processes its share in reverse order.  It loads the
+// injectors of the particles sent to another domain (and those of the
+// edges and corners they are sent on to) into its own buffers and marks
+// the other movers for the host.  The host then gives each pipeline where
+// its injectors go in the send buffers (the shares of the higher pipelines
+// first) and the pipelines copy them there, such that the send buffers
+// are the same as when the host processes the movers in reverse order.
+//
+// The host does the absorption and the user-defined handling (these are
+// not thread safe: they accumulate rhob and tally and draw random numbers)
+// and removes the particles of all movers in reverse order, which keeps
+// the backfilling of begin_boundary_p.  The particle of a mover is not
+// moved before its mover is processed, so the pipelines see the same
+// particles the host does.
+//----------------------------------------------------------------------------//
+
+typedef struct mover_buffer {
+  particle_injector_t * ALIGNED(16) pi; // Injectors sent through a face ...
+  int8_t * pi_face;                     // ... and the face
+  particle_injector_t * ALIGNED(16) di; // Injectors sent through edges and
+  int * di_port;                        // corners and their port
+  int64_t n, n_pi[6], n_di;
+  int64_t off[6], off_di;               // Where these go
+  int64_t max_pi, max_di;
+} mover_buffer_t;
+
+typedef struct mover_pipeline_args {
+  const particle_block_t * ALIGNED(128) p0;
+  const particle_mover_t * ALIGNED(16)  pm;
+  int64_t nm;
+  int32_t sp_id;
+  int8_t * on_host;                     // Movers left to the host
+  const int64_t * ALIGNED(128) neighbor;
+  int64_t rangel, rangeh, rangem;
+  int64_t range[6];
+  int route_any;
+  const int * route_face;
+  const int * route_rank;
+  mover_buffer_t * buf;                 // Indexed by pipeline rank
+  particle_injector_t * pi_send[6];
+  particle_injector_t * di;
+  int * di_port;
+} mover_pipeline_args_t;
+
+static void
+load_movers_pipeline_scalar( mover_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline ) {
+  const particle_block_t * RESTRICT ALIGNED(128) p0       = args->p0;
+  const int64_t          * RESTRICT ALIGNED(128) neighbor = args->neighbor;
+  const int64_t rangel = args->rangel;
+  const int64_t rangeh = args->rangeh;
+  const int64_t rangem = args->rangem;
+  const int32_t sp_id  = args->sp_id;
+  int8_t * RESTRICT on_host = args->on_host;
+  mover_buffer_t * RESTRICT b = args->buf + pipeline_rank;
+
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
+
+  const particle_mover_t * RESTRICT ALIGNED(16) pm;
+  particle_injector_t * RESTRICT ALIGNED(16) pi;
+  int64_t i, n, nn, n_pi = 0, n_di = 0;
+  int voxel, face, nh;
+
+  for( face=0; face<6; face++ ) b->n_pi[face] = 0;
+
+  DISTRIBUTE( args->nm, 1, pipeline_rank, n_pipeline, i, n );
+
+  for( pm=args->pm+i+n-1; n; pm--, n-- ) {
+    load_particle( p0, pm->i, p );
+    voxel = p->i;
+    face = voxel & 7;
+    voxel >>= 3;
+    p->i = voxel;
+    nn = neighbor[ 6*voxel + face ];
+
+    // Everything but sending to a neighboring node is left to the host
+
+    on_host[ pm-args->pm ] =
+      !( ((nn>=0) & (nn< rangel)) | ((nn>rangeh) & (nn<=rangem)) );
+    if( on_host[ pm-args->pm ] ) continue;
+
+    b->pi_face[n_pi] = face;
+    b->n_pi[face]++;
+    pi = b->pi + n_pi++;
+#   ifdef V4_ACCELERATION
+    copy_4x1( &pi->dx,    &p->dx     );
+    copy_4x1( &pi->ux,    &p->ux     );
+    copy_4x1( &pi->dispx, &pm->dispx );
+#   else
+    pi->dx=p->dx; pi->dy=p->dy; pi->dz=p->dz;
+    pi->ux=p->ux; pi->uy=p->uy; pi->uz=p->uz; pi->w=p->w;
+    pi->dispx = pm->dispx; pi->dispy = pm->dispy; pi->dispz = pm->dispz;
+#   endif
+    (&pi->dx)[axis[face]] = dir[face];
+    pi->i                 = nn - args->range[face];
+    pi->sp_id             = sp_id;
+    if( args->route_any ) {
+      nh = route_particle( pi, face, args->route_face, args->route_rank,
+                           b->di+n_di, b->di_port+n_di );
+      if( nh ) {
+        pi->sp_id = PASS_SP_ID(sp_id);
+        if( nh>1 ) b->di[n_di].sp_id = PASS_SP_ID(sp_id);
+        n_di += nh;
+      }
+    }
+  }
+
+  b->n    = n_pi;
+  b->n_di = n_di;
+}
+
+static void
+merge_movers_pipeline_scalar( mover_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline ) {
+  const mover_buffer_t * RESTRICT b = args->buf + pipeline_rank;
+  int64_t off[6], k;
+  int face;
+
+  for( face=0; face<6; face++ ) off[face] = b->off[face];
+  for( k=0; k<b->n; k++ ) {
+    face = b->pi_face[k];
+    args->pi_send[face][ off[face]++ ] = b->pi[k];
+  }
+
+  if( b->n_di ) {
+    COPY( args->di      + b->off_di, b->di,      b->n_di );
+    COPY( args->di_port + b->off_di, b->di_port, b->n_di );
+  }
+}
+
 void
-boundary_p( particle_bc_t       * RESTRICT pbc_list,
-            species_t           * RESTRICT sp_list,
-            field_array_t       * RESTRICT fa,
-            accumulator_array_t * RESTRICT aa ) {
+begin_boundary_p( particle_bc_t       * RESTRICT pbc_list,
+                  species_t           * RESTRICT sp_list,
+                  field_array_t       * RESTRICT fa,
+                  accumulator_array_t * RESTRICT aa ) {
 
-  // Gives the local mp port associated with a local face
-  static const int f2b[6]  = { BOUNDARY(-1, 0, 0),
-                               BOUNDARY( 0,-1, 0),
-                               BOUNDARY( 0, 0,-1),
-                               BOUNDARY( 1, 0, 0),
-                               BOUNDARY( 0, 1, 0),
-                               BOUNDARY( 0, 0, 1) };
-
-  // Gives the remote mp port associated with a local face
-  static const int f2rb[6] = { BOUNDARY( 1, 0, 0),
-                               BOUNDARY( 0, 1, 0),
-                               BOUNDARY( 0, 0, 1),
-                               BOUNDARY(-1, 0, 0),
-                               BOUNDARY( 0,-1, 0),
-                               BOUNDARY( 0, 0,-1) };
-
-  // Gives the axis associated with a local face
-  static const int axis[6]  = { 0, 1, 2,  0,  1,  2 };
-
-  // Gives the location of sending face on the receiver
-  static const float dir[6] = { 1, 1, 1, -1, -1, -1 };
-
-  // Temporary store for local particle injectors
+  // Temporary store for local particle injectors and for particles
+  // sent through edges and corners
   // FIXME: Ugly static usage
-  static particle_injector_t * RESTRICT ALIGNED(16) ci = NULL;
-  static int max_ci = 0;
+  static VPIC_THREAD_LOCAL particle_injector_t * RESTRICT ALIGNED(16) ci = NULL;
+  static VPIC_THREAD_LOCAL int64_t max_ci = 0;
+  static VPIC_THREAD_LOCAL particle_injector_t * RESTRICT ALIGNED(16) di = NULL;
+  static VPIC_THREAD_LOCAL int * RESTRICT di_port = NULL;
+  static VPIC_THREAD_LOCAL int64_t max_di = 0;
+  static VPIC_THREAD_LOCAL int8_t * RESTRICT on_host = NULL;
+  static VPIC_THREAD_LOCAL mover_buffer_t * buf = NULL;
+
+  DECLARE_ALIGNED_ARRAY( mover_pipeline_args_t, 128, args, 1 );
 
-  int n_send[6], n_recv[6], n_ci;
+  int64_t n_ci, n_di;
 
   species_t * sp;
-  int face;
+  int face, port, n;
 
   // Check input args
 
   if( !sp_list ) return; // Nothing to do if no species
   if( !fa || !aa || sp_list->g!=aa->g || fa->g!=aa->g )
     ERROR(( "Bad args" ));
+  if( in_progress ) ERROR(( "Particle boundary exchange already in progress" ));
 
   // Unpack the particle boundary conditions
 
@@ -93,10 +966,6 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
   field_t * RESTRICT ALIGNED(128) f = fa->f;
   grid_t  * RESTRICT              g = fa->g;
 
-  // Unpack accumulator
-
-  accumulator_t * RESTRICT ALIGNED(128) a0 = aa->a;
-
   // Unpack the grid
 
   const int64_t * RESTRICT ALIGNED(128) neighbor = g->neighbor;
@@ -104,21 +973,18 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
   const int64_t rangel = g->rangel;
   const int64_t rangeh = g->rangeh;
   const int64_t rangem = g->range[world_size];
-  /*const*/ int bc[6], shared[6];
+  /*const*/ int bc[6], shared[6], peer[27];
   /*const*/ int64_t range[6];
-  for( face=0; face<6; face++ ) {
-    bc[face] = g->bc[f2b[face]];
-    shared[face] = (bc[face]>=0) && (bc[face]<world_size) &&
-                   (bc[face]!=world_rank);
-    if( shared[face] ) range[face] = g->range[bc[face]];
-  }
+  unpack_faces( g, bc, shared, range );
+  setup_routes( g );
+  unpack_ports( bc, shared, peer );
 
   // Begin receiving the particle counts
 
-  for( face=0; face<6; face++ )
-    if( shared[face] ) {
-      mp_size_recv_buffer( mp, f2b[face], sizeof(int) );
-      mp_begin_recv( mp, f2b[face], sizeof(int), bc[face], f2rb[face] );
+  for( n=0; n<26; n++ )
+    if( peer[port=ports[n]]>=0 ) {
+      mp_size_recv_buffer( mp, port, sizeof(int) );
+      mp_begin_recv( mp, port, sizeof(int), peer[port], RPORT(port) );
     }
 
   // Load the particle send and local injection buffers
@@ -150,39 +1016,150 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
     // more flexible though in the future (especially given above the
     // above overalloc).
 
-    int nm = 0; LIST_FOR_EACH( sp, sp_list ) nm += sp->nm;
+    int64_t nm = 0; LIST_FOR_EACH( sp, sp_list ) nm += sp->nm;
+
+    // Message sizes are int.  This limits the number of particles that
+    // can be sent through a face per call (but not the local number of
+    // particles or movers).
+
+    const int64_t max_send = ( INT_MAX - 16 ) / sizeof(particle_injector_t);
 
     for( face=0; face<6; face++ )
       if( shared[face] ) {
-        mp_size_send_buffer( mp, f2b[face], 16+nm*sizeof(particle_injector_t) );
+        mp_size_send_buffer( mp, f2b[face],
+                             16+(nm<max_send ? nm : max_send)*
+                             sizeof(particle_injector_t) );
         pi_send[face] = (particle_injector_t *)(((char *)mp_send_buffer(mp,f2b[face]))+16);
-        n_send[face] = 0;
       }
+    for( port=0; port<27; port++ ) n_send[port] = 0;
 
     if( max_ci<nm ) {
       particle_injector_t * new_ci = ci;
       FREE_ALIGNED( new_ci );
+      FREE( on_host );
       MALLOC_ALIGNED( new_ci, nm, 16 );
+      MALLOC( on_host, nm );
       ci     = new_ci;
       max_ci = nm;
     }
     n_ci = 0;
 
+    // A particle sent through a face is sent to at most two more
+    // domains through edges and corners.
+
+    if( route_any && max_di<2*nm ) {
+      particle_injector_t * new_di = di;
+      FREE_ALIGNED( new_di );
+      FREE( di_port );
+      MALLOC_ALIGNED( new_di, 2*nm, 16 );
+      MALLOC( di_port, 2*nm );
+      di     = new_di;
+      max_di = 2*nm;
+    }
+    n_di = 0;
+
+    // The movers are loaded into the send buffers by the pipelines (see
+    // load_movers_pipeline_scalar)
+
+    if( !buf ) {
+      MALLOC( buf, MAX_PIPELINE+1 );
+      CLEAR( buf, MAX_PIPELINE+1 );
+    }
+
+    args->on_host    = on_host;
+    args->neighbor   = neighbor;
+    args->rangel     = rangel;
+    args->rangeh     = rangeh;
+    args->rangem     = rangem;
+    args->route_any  = route_any;
+    args->route_face = route_face;
+    args->route_rank = route_rank;
+    args->buf        = buf;
+    args->di         = di;
+    args->di_port    = di_port;
+    for( face=0; face<6; face++ ) {
+      args->range[face]   = shared[face] ? range[face] : 0;
+      args->pi_send[face] = shared[face] ? pi_send[face] : NULL;
+    }
+
     // For each species, load the movers
 
     LIST_FOR_EACH( sp, sp_list ) {
       const float   sp_q  = sp->q;
-      const int32_t sp_id = sp->id;
 
-      particle_t * RESTRICT ALIGNED(128) p0 = sp->p;
-      int np = sp->np;
+      particle_block_t * RESTRICT ALIGNED(128) p0 = sp->p;
+      int64_t np = sp->np;
+
+      // The particle being processed is copied out of the particle
+      // array so the boundary handlers do not depend on its layout.
+
+      DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
 
       particle_mover_t * RESTRICT ALIGNED(16)  pm = sp->pm + sp->nm - 1;
       nm = sp->nm;
 
-      particle_injector_t * RESTRICT ALIGNED(16) pi;
-      int i, voxel;
-      int64_t nn;
+      int64_t i, nn, share;
+      int voxel, rank;
+
+      const int n_pipeline =
+        ( N_PIPELINE>1 && nm>=MIN_PIPELINE_NM ) ? N_PIPELINE : 1;
+
+      // Size the buffers of the pipelines for their shares
+
+      for( rank=0; rank<=n_pipeline; rank++ ) {
+        mover_buffer_t * b = buf + rank;
+        DISTRIBUTE( nm, 1, rank, n_pipeline, i, share );
+        if( share>b->max_pi ) {
+          FREE_ALIGNED( b->pi );
+          FREE( b->pi_face );
+          MALLOC_ALIGNED( b->pi, share, 16 );
+          MALLOC( b->pi_face, share );
+          b->max_pi = share;
+        }
+        if( route_any && 2*share>b->max_di ) {
+          FREE_ALIGNED( b->di );
+          FREE( b->di_port );
+          MALLOC_ALIGNED( b->di, 2*share, 16 );
+          MALLOC( b->di_port, 2*share );
+          b->max_di = 2*share;
+        }
+      }
+
+      args->p0    = p0;
+      args->pm    = sp->pm;
+      args->nm    = nm;
+      args->sp_id = sp->id;
+
+      if( n_pipeline>1 ) {
+        EXEC_PIPELINES( load_movers, args, 0 );
+        WAIT_PIPELINES();
+      } else {
+        load_movers_pipeline_scalar( args, 0, 1 );
+        load_movers_pipeline_scalar( args, 1, 1 );
+      }
+
+      // The higher pipelines have the movers that are processed first
+
+      for( rank=n_pipeline; rank>=0; rank-- ) {
+        mover_buffer_t * b = buf + rank;
+        for( face=0; face<6; face++ ) {
+          b->off[face] = n_send[f2b[face]];
+          n_send[f2b[face]] += b->n_pi[face];
+        }
+        b->off_di = n_di;
+        n_di += b->n_di;
+      }
+      for( face=0; face<6; face++ )
+        if( n_send[f2b[face]]>max_send )
+          ERROR(( "Too many particles sent through face %i", face ));
+
+      if( n_pipeline>1 ) {
+        EXEC_PIPELINES( merge_movers, args, 0 );
+        WAIT_PIPELINES();
+      } else {
+        merge_movers_pipeline_scalar( args, 0, 1 );
+        merge_movers_pipeline_scalar( args, 1, 1 );
+      }
 
       // Note that particle movers for each species are processed in
       // reverse order.  This allows us to backfill holes in the
@@ -195,10 +1172,13 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
 
       for( ; nm; pm--, nm-- ) {
         i = pm->i;
-        voxel = p0[i].i;
+        if( !on_host[nm-1] ) goto backfill; // Sent by the pipelines
+
+        load_particle( p0, i, p );
+        voxel = p->i;
         face = voxel & 7;
         voxel >>= 3;
-        p0[i].i = voxel;
+        p->i = voxel;
         nn = neighbor[ 6*voxel + face ];
 
         // Absorb
@@ -206,26 +1186,7 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
         if( nn==absorb_particles ) {
           // Ideally, we would batch all rhob accumulations together
           // for efficiency
-          accumulate_rhob( f, p0+i, g, sp_q );
-          goto backfill;
-        }
-
-        // Send to a neighboring node
-
-        if( ((nn>=0) & (nn< rangel)) | ((nn>rangeh) & (nn<=rangem)) ) {
-          pi = &pi_send[face][n_send[face]++];
-#         ifdef V4_ACCELERATION
-          copy_4x1( &pi->dx,    &p0[i].dx  );
-          copy_4x1( &pi->ux,    &p0[i].ux  );
-          copy_4x1( &pi->dispx, &pm->dispx );
-#         else
-          pi->dx=p0[i].dx; pi->dy=p0[i].dy; pi->dz=p0[i].dz;
-          pi->ux=p0[i].ux; pi->uy=p0[i].uy; pi->uz=p0[i].uz; pi->w=p0[i].w;
-          pi->dispx = pm->dispx; pi->dispy = pm->dispy; pi->dispz = pm->dispz;
-#         endif
-          (&pi->dx)[axis[face]] = dir[face];
-          pi->i                 = nn - range[face];
-          pi->sp_id             = sp_id;
+          accumulate_rhob( f, p, g, sp_q );
           goto backfill;
         }
 
@@ -249,7 +1210,7 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
 
         nn = -nn - 3; // Assumes reflective/absorbing are -1, -2
         if( (nn>=0) & (nn<nb) ) {
-          n_ci += pbc_interact[nn]( pbc_params[nn], sp, p0+i, pm,
+          n_ci += pbc_interact[nn]( pbc_params[nn], sp, p, pm,
                                     ci+n_ci, 1, face );
           goto backfill;
         }
@@ -262,11 +1223,11 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
       backfill:
 
         np--;
-#       ifdef V4_ACCELERATION
+#       if defined(V4_ACCELERATION) && PARTICLE_LAYOUT_AOS
         copy_4x1( &p0[i].dx, &p0[np].dx );
         copy_4x1( &p0[i].ux, &p0[np].ux );
 #       else
-        p0[i] = p0[np];
+        copy_particle( p0, i, p0, np );
 #       endif
 
       }
@@ -275,10 +1236,24 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
       sp->nm = 0;
     }
 
+    // Load the send buffers of the edges and corners
+
+    for( n=0; n<n_di; n++ ) n_send[di_port[n]]++;
+    for( n=6; n<26; n++ )
+      if( peer[port=ports[n]]>=0 ) {
+        if( n_send[port]>max_send )
+          ERROR(( "Too many particles sent through port %i", port ));
+        mp_size_send_buffer( mp, port,
+                             16+n_send[port]*sizeof(particle_injector_t) );
+        particle_injector_t * RESTRICT ALIGNED(16) pd =
+          (particle_injector_t *)(((char *)mp_send_buffer(mp,port))+16);
+        for( int64_t l=0; l<n_di; l++ )
+          if( di_port[l]==port ) *(pd++) = di[l];
+      }
+
   } while(0);
 
-  // Finish exchanging particle counts and start exchanging actual
-  // particles.
+  // Start exchanging particle counts.
 
   // Note: This is wasteful of communications.  A better protocol
   // would fuse the exchange of the counts with the exchange of the
@@ -289,230 +1264,111 @@ boundary_p( particle_bc_t       * RESTRICT pbc_list,
   // equilvanet of a MPI_Getcount to determine how much data you
   // actually received.
 
-  for( face=0; face<6; face++ )
-    if( shared[face] ) {
-      *((int *)mp_send_buffer( mp, f2b[face] )) = n_send[face];
-      mp_begin_send( mp, f2b[face], sizeof(int), bc[face], f2b[face] );
+  for( n=0; n<26; n++ )
+    if( peer[port=ports[n]]>=0 ) {
+      *((int *)mp_send_buffer( mp, port )) = n_send[port];
+      mp_begin_send( mp, port, sizeof(int), peer[port], port );
     }
 
-  for( face=0; face<6; face++ )
-    if( shared[face] )  {
-      mp_end_recv( mp, f2b[face] );
-      n_recv[face] = *((int *)mp_recv_buffer( mp, f2b[face] ));
-      mp_size_recv_buffer( mp, f2b[face],
-                           16+n_recv[face]*sizeof(particle_injector_t) );
-      mp_begin_recv( mp, f2b[face], 16+n_recv[face]*sizeof(particle_injector_t),
-                     bc[face], f2rb[face] );
+  // Inject the particles of the local boundary handlers while the
+  // counts are in flight.  These can move anywhere in the local domain,
+  // so this must be done before the caller does anything with the
+  // accumulators.
+
+  reserve_particles( sp_list, n_ci, 0 );
+  if( inject_pipelined( aa, n_ci ) ) {
+    begin_inject_pipelines( aa );
+    inject_particles_pipelined( sp_list, ci, n_ci, aa, g );
+    reduce_accumulator_array( aa );
+  } else {
+    inject_particles( sp_list, ci, n_ci, aa->a, g );
+  }
+
+  // Finish exchanging particle counts and start exchanging actual
+  // particles.
+
+  for( n=0; n<26; n++ )
+    if( peer[port=ports[n]]>=0 ) {
+      mp_end_recv( mp, port );
+      n_recv[port] = *((int *)mp_recv_buffer( mp, port ));
+      mp_size_recv_buffer( mp, port,
+                           16+n_recv[port]*sizeof(particle_injector_t) );
+      mp_begin_recv( mp, port, 16+n_recv[port]*sizeof(particle_injector_t),
+                     peer[port], RPORT(port) );
     }
 
-  for( face=0; face<6; face++ )
-    if( shared[face] ) {
-      mp_end_send( mp, f2b[face] );
+  for( n=0; n<26; n++ )
+    if( peer[port=ports[n]]>=0 ) {
+      mp_end_send( mp, port );
       // FIXME: ASSUMES MP WON'T MUCK WITH REST OF SEND BUFFER. IF WE
       // DID MORE EFFICIENT MOVER ALLOCATION ABOVE, THIS WOULD BE
       // ROBUSTED AGAINST MP IMPLEMENTATION VAGARIES
-      mp_begin_send( mp, f2b[face], 16+n_send[face]*sizeof(particle_injector_t),
-                     bc[face], f2b[face] );
+      mp_begin_send( mp, port, 16+n_send[port]*sizeof(particle_injector_t),
+                     peer[port], port );
     }
 
-# ifndef DISABLE_DYNAMIC_RESIZING
-  // Resize particle storage to accomodate worst case inject
-
-  do {
-    int n, nm;
-
-    // Resize each species's particle and mover storage to be large
-    // enough to guarantee successful injection.  (If we broke down
-    // the n_recv[face] by species before sending it, we could be
-    // tighter on memory footprint here.)
-
-    int max_inj = n_ci;
-    for( face=0; face<6; face++ )
-      if( shared[face] ) max_inj += n_recv[face];
-
-    LIST_FOR_EACH( sp, sp_list ) {
-      particle_mover_t * new_pm;
-      particle_t * new_p;
-
-      n = sp->np + max_inj;
-      if( n>sp->max_np ) {
-        n += 0.3125*n; // Increase by 31.25% (~<"silver
-        /**/                     // ratio") to minimize resizes (max
-        /**/                     // rate that avoids excessive heap
-        /**/                     // fragmentation)
-        //float resize_ratio = (float)n/sp->max_np;
-        WARNING(( "Resizing local %s particle storage from %i to %i",
-                  sp->name, sp->max_np, n ));
-        MALLOC_ALIGNED( new_p, n, 128 );
-        COPY( new_p, sp->p, sp->np );
-        FREE_ALIGNED( sp->p );
-        sp->p = new_p, sp->max_np = n;
-
-        /*nm = sp->max_nm * resize_ratio;
-        WARNING(( "Resizing local %s mover storage from %i to %i",
-                  sp->name, sp->max_nm, nm ));
-        MALLOC_ALIGNED( new_pm, nm, 128 );
-        COPY( new_pm, sp->pm, sp->nm );
-        FREE_ALIGNED( sp->pm );
-        sp->pm = new_pm;
-        sp->max_nm = nm;*/
-      }
-      else if(sp->max_np > MIN_NP && n < sp->max_np>>1)
-      {
-        n += 0.125*n; // Overallocate by less since this rank is decreasing
-        if (n<MIN_NP) n = MIN_NP;
-        //float resize_ratio = (float)n/sp->max_np;
-        WARNING(( "Resizing (shrinking) local %s particle storage from "
-                    "%i to %i", sp->name, sp->max_np, n));
-        MALLOC_ALIGNED( new_p, n, 128 );
-        COPY( new_p, sp->p, sp->np );
-        FREE_ALIGNED( sp->p );
-        sp->p = new_p, sp->max_np = n;
-
-        /*nm = sp->max_nm * resize_ratio;
-        WARNING(( "Resizing (shrinking) local %s mover storage from "
-                    "%i to %i", sp->name, sp->max_nm, nm));
-        MALLOC_ALIGNED( new_pm, nm, 128 );
-        COPY( new_pm, sp->pm, sp->nm );
-        FREE_ALIGNED( sp->pm );
-        sp->pm = new_pm, sp->max_nm = nm;*/
-      }
-
-      // Feasibly, a vacuum-filled rank may receive a shock and need more movers
-      // than available from MIN_NP
-      nm = sp->nm + max_inj;
-      if( nm>sp->max_nm ) {
-        nm += 0.3125*nm; // See note above
-        //float resize_ratio = (float)nm/sp->max_nm;
-        WARNING(( "This happened.  Resizing local %s mover storage from "
-                    "%i to %i based on not enough movers",
-                  sp->name, sp->max_nm, nm ));
-        MALLOC_ALIGNED( new_pm, nm, 128 );
-        COPY( new_pm, sp->pm, sp->nm );
-        FREE_ALIGNED( sp->pm );
-        sp->pm = new_pm;
-        sp->max_nm = nm;
-
-        /*n = sp->max_np * resize_ratio;
-        WARNING(( "Resizing local %s particle storage from %i to %i",
-                  sp->name, sp->max_np, n ));
-        MALLOC_ALIGNED( new_p, n, 128 );
-        COPY( new_p, sp->p, sp->np );
-        FREE_ALIGNED( sp->p );
-        sp->p = new_p, sp->max_np = n;*/
-      }
-    }
-  } while(0);
-# endif
+  in_progress = 1;
+}
 
-  do {
+void
+end_boundary_p( species_t           * RESTRICT sp_list,
+                field_array_t       * RESTRICT fa,
+                accumulator_array_t * RESTRICT aa ) {
+  int port, n;
 
-    // Unpack the species list for random acesss
+  if( !sp_list ) return; // Nothing to do if no species
+  if( !fa || !aa || sp_list->g!=aa->g || fa->g!=aa->g )
+    ERROR(( "Bad args" ));
+  if( !in_progress ) ERROR(( "No particle boundary exchange in progress" ));
 
-    particle_t       * RESTRICT ALIGNED(32) sp_p[ MAX_SP];
-    particle_mover_t * RESTRICT ALIGNED(32) sp_pm[MAX_SP];
-    float sp_q[MAX_SP];
-    int sp_np[MAX_SP];
-    int sp_nm[MAX_SP];
+  grid_t * RESTRICT g  = fa->g;
+  mp_t   * RESTRICT mp = g->mp;
+  /*const*/ int bc[6], shared[6], peer[27];
+  /*const*/ int64_t range[6];
+  unpack_faces( g, bc, shared, range );
+  unpack_ports( bc, shared, peer );
 
-#   ifdef DISABLE_DYNAMIC_RESIZING
-    int sp_max_np[64], n_dropped_particles[64];
-    int sp_max_nm[64], n_dropped_movers[64];
-#   endif
+  // Resize particle storage to accomodate worst case inject
 
-    if( num_species( sp_list ) > MAX_SP )
-      ERROR(( "Update this to support more species" ));
-    LIST_FOR_EACH( sp, sp_list ) {
-      sp_p[  sp->id ] = sp->p;
-      sp_pm[ sp->id ] = sp->pm;
-      sp_q[  sp->id ] = sp->q;
-      sp_np[ sp->id ] = sp->np;
-      sp_nm[ sp->id ] = sp->nm;
-#     ifdef DISABLE_DYNAMIC_RESIZING
-      sp_max_np[sp->id]=sp->max_np; n_dropped_particles[sp->id]=0;
-      sp_max_nm[sp->id]=sp->max_nm; n_dropped_movers[sp->id]=0;
-#     endif
+  int64_t max_inj = 0;
+  for( n=0; n<26; n++ )
+    if( peer[port=ports[n]]>=0 ) max_inj += n_recv[port];
+  reserve_particles( sp_list, max_inj, 1 );
+
+  // Inject the particles received from the other domains.  Since a
+  // particle moves less than a cell per step (Courant condition), a
+  // received particle only moves through the voxels on the surface of
+  // the local domain.  When the pipelines inject, the interior voxels of
+  // their accumulators stay clear, so the reduction leaves the interior
+  // of the host accumulator as it is.
+
+  const int pipelined = inject_pipelined( aa, max_inj );
+  if( pipelined ) begin_inject_pipelines( aa );
+
+  for( n=0; n<26; n++ )
+    if( peer[port=ports[n]]>=0 ) {
+      mp_end_recv( mp, port );
+      const particle_injector_t * pi = (const particle_injector_t *)
+        (((char *)mp_recv_buffer(mp,port))+16);
+      if( pipelined )
+        inject_particles_pipelined( sp_list, pi, n_recv[port], aa, g );
+      else
+        inject_particles( sp_list, pi, n_recv[port], aa->a, g );
     }
 
-    // Inject particles.  We do custom local injection first to
-    // increase message overlap opportunities.
-
-    face = 5;
-    do {
-      /**/  particle_t          * RESTRICT ALIGNED(32) p;
-      /**/  particle_mover_t    * RESTRICT ALIGNED(16) pm;
-      const particle_injector_t * RESTRICT ALIGNED(16) pi;
-      int np, nm, n, id;
-
-      face++; if( face==7 ) face = 0;
-      if( face==6 ) pi = ci, n = n_ci;
-      else if( shared[face] ) {
-        mp_end_recv( mp, f2b[face] );
-        pi = (const particle_injector_t *)
-          (((char *)mp_recv_buffer(mp,f2b[face]))+16);
-        n  = n_recv[face];
-      } else continue;
-
-      // Reverse order injection is done to reduce thrashing of the
-      // particle list (particles are removed reverse order so the
-      // overall impact of removal + injection is to keep injected
-      // particles in order).
-      //
-      // WARNING: THIS TRUSTS THAT THE INJECTORS (INCLUDING THOSE
-      // RECEIVED FROM OTHER NODES) HAVE VALID PARTICLE IDS.
-
-      pi += n-1;
-      for( ; n; pi--, n-- ) {
-        id = pi->sp_id;
-        p  = sp_p[id];  np = sp_np[id];
-        pm = sp_pm[id]; nm = sp_nm[id];
-
-#       ifdef DISABLE_DYNAMIC_RESIZING
-        if( np>=sp_max_np[id] ) { n_dropped_particles[id]++; continue; }
-#       endif
-#       ifdef V4_ACCELERATION
-        copy_4x1(  &p[np].dx,    &pi->dx    );
-        copy_4x1(  &p[np].ux,    &pi->ux    );
-#       else
-        p[np].dx=pi->dx; p[np].dy=pi->dy; p[np].dz=pi->dz; p[np].i=pi->i;
-        p[np].ux=pi->ux; p[np].uy=pi->uy; p[np].uz=pi->uz; p[np].w=pi->w;
-#       endif
-        sp_np[id] = np+1;
-
-#       ifdef DISABLE_DYNAMIC_RESIZING
-        if( nm>=sp_max_nm[id] ) { n_dropped_movers[id]++;    continue; }
-#       endif
-#       ifdef V4_ACCELERATION
-        copy_4x1( &pm[nm].dispx, &pi->dispx );
-        pm[nm].i = np;
-#       else
-        pm[nm].dispx=pi->dispx; pm[nm].dispy=pi->dispy; pm[nm].dispz=pi->dispz;
-        pm[nm].i=np;
-#       endif
-        sp_nm[id] = nm + move_p( p, pm+nm, a0, g, sp_q[id] );
-      }
-    } while(face!=5);
+  if( pipelined ) reduce_accumulator_array( aa );
 
-    LIST_FOR_EACH( sp, sp_list ) {
-#     ifdef DISABLE_DYNAMIC_RESIZING
-      if( n_dropped_particles[sp->id] )
-        WARNING(( "Dropped %i particles from species \"%s\".  Use a larger "
-                  "local particle allocation in your simulation setup for "
-                  "this species on this node.",
-                  n_dropped_particles[sp->id], sp->name ));
-      if( n_dropped_movers[sp->id] )
-        WARNING(( "%i particles were not completed moved to their final "
-                  "location this timestep for species \"%s\".  Use a larger "
-                  "local particle mover buffer in your simulation setup "
-                  "for this species on this node.",
-                  n_dropped_movers[sp->id], sp->name ));
-#     endif
-      sp->np=sp_np[sp->id];
-      sp->nm=sp_nm[sp->id];
-    }
+  for( n=0; n<26; n++ )
+    if( peer[port=ports[n]]>=0 ) mp_end_send(mp,port);
 
-  } while(0);
+  in_progress = 0;
+}
 
-  for( face=0; face<6; face++ )
-    if( shared[face] ) mp_end_send(mp,f2b[face]);
+void
+boundary_p( particle_bc_t       * RESTRICT pbc_list,
+            species_t           * RESTRICT sp_list,
+            field_array_t       * RESTRICT fa,
+            accumulator_array_t * RESTRICT aa ) {
+  begin_boundary_p( pbc_list, sp_list, fa, aa );
+  end_boundary_p( sp_list, fa, aa );
 }
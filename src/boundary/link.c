@@ -25,7 +25,7 @@ link_boundary( link_boundary_t     * lb,
                particle_injector_t * pi,
                rng_t               * rng,
                int                   face ) {
-  static FILE *fp = NULL; 
+  static VPIC_THREAD_LOCAL FILE *fp = NULL; 
   int ix, iy, iz;
   double x, y, z;
   char fname[512];
@@ -45,12 +45,12 @@ END_C_DECLS
 // Langevin pipeline interface
 
 typedef struct langevin_pipeline_args {
-  MEM_PTR( particle_t, 128 ) p;
+  MEM_PTR( particle_block_t, 128 ) p;
   MEM_PTR( rng_t,      128 ) rng[ MAX_PIPELINE ];
   float decay; 
   float drive;
-  int np;
-  PAD_STRUCT( (1+MAX_PIPELINE)*SIZEOF_MEM_PTR+2*sizeof(float)+sizeof(int) )
+  int64_t np;
+  PAD_STRUCT( (1+MAX_PIPELINE)*SIZEOF_MEM_PTR+2*sizeof(float)+sizeof(int64_t) )
 } langevin_pipeline_args_t;
 
 // PROTOTYPE_PIPELINE( langevin, langevin_pipeline_args_t );
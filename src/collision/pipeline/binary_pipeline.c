@@ -30,20 +30,27 @@ binary_pipeline_scalar( binary_collision_model_t * RESTRICT cm,
   /**/  species_t  * RESTRICT spj           = cm->spj;
   /**/  rng_t      * RESTRICT rng           = cm->rp->rng[ pipeline_rank ];
 
-  /**/  particle_t * RESTRICT spi_p         = spi->p;
-  const int        * RESTRICT spi_partition = spi->partition;
+  /**/  particle_block_t * RESTRICT spi_p   = spi->p;
+  const int64_t    * RESTRICT spi_partition = spi->partition;
   const grid_t     * RESTRICT g             = spi->g;
 
-  /**/  particle_t * RESTRICT spj_p         = spj->p;
-  const int        * RESTRICT spj_partition = spj->partition;
+  /**/  particle_block_t * RESTRICT spj_p   = spj->p;
+  const int64_t    * RESTRICT spj_partition = spj->partition;
+
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, pk, 1 );
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, pl, 1 );
 
   const double sample        = (spi_p==spj_p ? 0.5 : 1)*cm->sample;
   const float  dtinterval_dV = ( g->dt * (float)cm->interval ) / g->dV;
 
   float pr_norm, pr_coll, wk, wl, w_max, w_min;
-  int v, v1, k, k0, nk, rk, l, l0, nl, rl, np, nc, type, n_large_pr = 0;
+  int v, v1, nk, rk, nl, rl, np, nc, type, n_large_pr = 0;
+  int64_t k, k0, l, l0;
 
-  /* Stripe the (mostly non-ghost) voxels over threads for load balance */
+  /* Stripe the (mostly non-ghost) voxels over threads for load balance.
+     The partitions are indexed by position along the grid's space
+     filling curve (see sort_p), so v is a curve position below.  Every
+     non-ghost voxel has a position in the striped range. */
 
   v  = VOXEL( 0,0,0,             g->nx,g->ny,g->nz ) + pipeline_rank;
   v1 = VOXEL( g->nx,g->ny,g->nz, g->nx,g->ny,g->nz ) + 1;
@@ -117,8 +124,8 @@ binary_pipeline_scalar( binary_collision_model_t * RESTRICT cm,
          of getting k on 0:nk-1 and l on 0:nl-1 and uses the
          preferred high order randgen bits). */
   
-      do { k = (int)(uirand(rng)/rk); } while( k==nk ); k += k0;
-      do { l = (int)(uirand(rng)/rl); } while( l==nl ); l += l0;
+      do { k = (int64_t)(uirand(rng)/rk); } while( k==nk ); k += k0;
+      do { l = (int64_t)(uirand(rng)/rl); } while( l==nl ); l += l0;
      
       /* Compute the probability that a physical particle in the
          species whose candidate computational particle has the least
@@ -128,11 +135,14 @@ binary_pipeline_scalar( binary_collision_model_t * RESTRICT cm,
          If this probability is bigger than one, make a note for
          diagnostic use. */
 
-      wk = spi_p[k].w;
-      wl = spj_p[l].w;
+      load_particle( spi_p, k, pk );
+      load_particle( spj_p, l, pl );
+
+      wk = pk->w;
+      wl = pl->w;
       w_max = (wk>wl) ? wk : wl;
       pr_coll = w_max * pr_norm *
-        rate_constant( params, spi, spj, &spi_p[k], &spj_p[l] );
+        rate_constant( params, spi, spj, pk, pl );
       if( pr_coll>1 ) n_large_pr++;
 
       /* Yes, >= so that 0 rate constants guarantee no collision and
@@ -149,7 +159,10 @@ binary_pipeline_scalar( binary_collision_model_t * RESTRICT cm,
       w_min = (wk>wl) ? wl : wk;
       type = 1; if( wl==w_min ) type++;
       if( w_max==w_min || w_max*frand_c0(rng)<w_min ) type = 3;
-      collision( params, spi, spj, &spi_p[k], &spj_p[l], rng, type );
+      collision( params, spi, spj, pk, pl, rng, type );
+
+      if( type & 1 ) store_particle( pk, spi_p, k );
+      if( type & 2 ) store_particle( pl, spj_p, l );
     }
   }
 
@@ -18,21 +18,27 @@ langevin_pipeline_scalar( langevin_pipeline_args_t * RESTRICT args,
     return; /* No host straggler cleanup */
   }
 
-  particle_t * RESTRICT p     = args->p;
+  particle_block_t * RESTRICT p = args->p;
   rng_t      * RESTRICT rng   = args->rng[ pipeline_rank ];
   float                 decay = args->decay;
   float                 drive = args->drive;
 
   double n_target = (double)args->np / (double)n_pipeline;
 
-  /**/  int i  = (int)( 0.5 + n_target * (double)  pipeline_rank    );
-  const int i1 = (int)( 0.5 + n_target * (double) (pipeline_rank+1) );
+  /**/  int64_t i  = (int64_t)( 0.5 + n_target * (double)  pipeline_rank    );
+  const int64_t i1 = (int64_t)( 0.5 + n_target * (double) (pipeline_rank+1) );
+
+  particle_t q;
 
   for( ; i < i1; i++ )
   {
-    p[i].ux = decay * p[i].ux + drive * frandn(rng);
-    p[i].uy = decay * p[i].uy + drive * frandn(rng);
-    p[i].uz = decay * p[i].uz + drive * frandn(rng);
+    load_particle( p, i, &q );
+
+    q.ux = decay * q.ux + drive * frandn(rng);
+    q.uy = decay * q.uy + drive * frandn(rng);
+    q.uz = decay * q.uz + drive * frandn(rng);
+
+    store_particle( &q, p, i );
   }
 }
 
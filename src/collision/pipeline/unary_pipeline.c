@@ -25,15 +25,17 @@ unary_pipeline_scalar( unary_collision_model_t * RESTRICT cm,
 
   /**/  void       * RESTRICT params = cm->params;
   const species_t  * RESTRICT sp     = cm->sp;
-  /**/  particle_t * RESTRICT p      = cm->sp->p;
+  /**/  particle_block_t * RESTRICT p = cm->sp->p;
   /**/  rng_t      * RESTRICT rng    = cm->rp->rng[ pipeline_rank ];
 
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, pi, 1 );
+
   const float dt = sp->g->dt * (float) cm->interval;
 
   double n_target = (double) sp->np / (double) n_pipeline;
 
-  /**/  int i  = (int) ( 0.5 + n_target * (double)  pipeline_rank    );
-  const int i1 = (int) ( 0.5 + n_target * (double) (pipeline_rank+1) );
+  /**/  int64_t i  = (int64_t) ( 0.5 + n_target * (double)  pipeline_rank    );
+  const int64_t i1 = (int64_t) ( 0.5 + n_target * (double) (pipeline_rank+1) );
 
   float pr_coll;
   int n_large_pr = 0;
@@ -46,7 +48,9 @@ unary_pipeline_scalar( unary_collision_model_t * RESTRICT cm,
 
   for( ; i < i1; i++ )
   {
-    pr_coll = dt * rate_constant( params, sp, &p[i] );
+    load_particle( p, i, pi );
+
+    pr_coll = dt * rate_constant( params, sp, pi );
 
     if ( pr_coll > 1 )
     {
@@ -57,7 +61,9 @@ unary_pipeline_scalar( unary_collision_model_t * RESTRICT cm,
        and, yes, _c0, so that 1 probabilities guarantee a collision  */
     if ( frand_c0( rng ) < pr_coll )
     {
-      collision( params, sp, &p[i], rng );
+      collision( params, sp, pi, rng );
+
+      store_particle( pi, p, i );
     }
   }
 
@@ -41,12 +41,12 @@ emit_child_langmuir( child_langmuir_t * RESTRICT              cl,
   /**/  accumulator_t    * RESTRICT ALIGNED(128) a   = cl->aa->a;
   /**/  rng_t            * RESTRICT              rng = cl->rng;
 
-  /**/  particle_t       * RESTRICT ALIGNED(128) p   = sp->p;
+  /**/  particle_block_t * RESTRICT ALIGNED(128) p   = sp->p;
   /**/  particle_mover_t * RESTRICT ALIGNED(128) pm  = sp->pm;
   /**/  grid_t           * RESTRICT              g   = sp->g;
 
-  const int max_np           = sp->max_np;
-  const int max_nm           = sp->max_nm;
+  const int64_t max_np       = sp->max_np;
+  const int64_t max_nm       = sp->max_nm;
   const int np_emit_per_face = cl->n_emit_per_face;
 
   const float qsp     = sp->q;
@@ -63,12 +63,14 @@ emit_child_langmuir( child_langmuir_t * RESTRICT              cl,
   const float ut_perp = cl->ut_perp;
   const float thresh  = fabsf(qsp)*cl->thresh_e_norm;
 
-  int np = sp->np, np_skipped = 0;
-  int nm = sp->nm, nm_skipped = 0;
+  int64_t np = sp->np, np_skipped = 0;
+  int64_t nm = sp->nm, nm_skipped = 0;
 
   float w, ux, uy, uz;
   int c, cc, i, np_emit;
 
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, q, 1 );
+
   // Loop over all components of the region
 
   for( c=0; c<n_component; c++ ) {
@@ -90,15 +92,16 @@ emit_child_langmuir( child_langmuir_t * RESTRICT              cl,
         u##X = dir ut_para*sqrtf(2*frande(rng));                        \
         u##Y = ut_perp*frandn(rng);                                     \
         u##Z = ut_perp*frandn(rng);                                     \
-        p[np].d##X = -(dir 1);                                          \
-        p[np].d##Y = 2*frand_c0(rng)-1;                                 \
-        p[np].d##Z = 2*frand_c0(rng)-1;                                 \
-        p[np].i    = i;                                                 \
-        p[np].u##X = u##X;                                              \
-        p[np].u##Y = u##Y;                                              \
-        p[np].u##Z = u##Z;                                              \
-        p[np].w    = w;                                                 \
-        accumulate_rhob( f, p+np, g, -qsp );                            \
+        q->d##X = -(dir 1);                                             \
+        q->d##Y = 2*frand_c0(rng)-1;                                    \
+        q->d##Z = 2*frand_c0(rng)-1;                                    \
+        q->i    = i;                                                    \
+        q->u##X = u##X;                                                 \
+        q->u##Y = u##Y;                                                 \
+        q->u##Z = u##Z;                                                 \
+        q->w    = w;                                                    \
+        store_particle( q, p, np );                                     \
+        accumulate_rhob( f, q, g, -qsp );                               \
         np++;                                                           \
                                                                         \
         /* Age the particle */                                          \
@@ -134,10 +137,10 @@ emit_child_langmuir( child_langmuir_t * RESTRICT              cl,
   sp->np = np;
   sp->nm = nm;
 
-  if( np_skipped ) WARNING(( "Insufficient local particle storage.  Did not emit %i "
-                             "particles in emit_child_langmuir", np_skipped ));
-  if( nm_skipped ) WARNING(( "Insufficient local particle mover storage.  Did not age %i "
-                             "emitted particles in emit_child_langmuir", nm_skipped ));
+  if( np_skipped ) WARNING(( "Insufficient local particle storage.  Did not emit %li "
+                             "particles in emit_child_langmuir", (long)np_skipped ));
+  if( nm_skipped ) WARNING(( "Insufficient local particle mover storage.  Did not age %li "
+                             "emitted particles in emit_child_langmuir", (long)nm_skipped ));
 }
 
 void
@@ -190,6 +193,11 @@ child_langmuir( /**/  species_t            * RESTRICT sp,
       n_emit_per_face<1 || ut_para<0  || ut_perp<0 || thresh_e_norm<0 )
     ERROR(( "Bad args" ));
 
+# if defined(VPIC_USE_COMPACT_P)
+  // Emitted particles have a field dependent weight.
+  ERROR(( "Child-Langmuir emission requires particle weights" ));
+# endif
+
   MALLOC( cl, 1 );
   cl->sp              = sp;
   cl->ia              = ia;
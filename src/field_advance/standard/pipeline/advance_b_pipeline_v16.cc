@@ -9,6 +9,8 @@
 
 using namespace v16;
 
+SIMD_KERNEL_BEGIN
+
 void
 advance_b_pipeline_v16( pipeline_args_t * args,
                         int pipeline_rank,
@@ -118,6 +120,8 @@ advance_b_pipeline_v16( pipeline_args_t * args,
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -9,6 +9,8 @@
 
 using namespace v4;
 
+SIMD_KERNEL_BEGIN
+
 void
 advance_b_pipeline_v4( pipeline_args_t * args,
                        int pipeline_rank,
@@ -76,6 +78,8 @@ advance_b_pipeline_v4( pipeline_args_t * args,
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -9,6 +9,8 @@
 
 using namespace v8;
 
+SIMD_KERNEL_BEGIN
+
 void
 advance_b_pipeline_v8( pipeline_args_t * args,
                        int pipeline_rank,
@@ -90,6 +92,8 @@ advance_b_pipeline_v8( pipeline_args_t * args,
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -9,6 +9,8 @@
 
 using namespace v4;
 
+SIMD_KERNEL_BEGIN
+
 void
 advance_e_pipeline_v4( pipeline_args_t * args,
                        int pipeline_rank,
@@ -156,6 +158,8 @@ advance_e_pipeline_v4( pipeline_args_t * args,
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -9,6 +9,8 @@
 
 using namespace v16;
 
+SIMD_KERNEL_BEGIN
+
 void
 clean_div_b_pipeline_v16( pipeline_args_t * args,
                           int pipeline_rank,
@@ -151,6 +153,8 @@ clean_div_b_pipeline_v16( pipeline_args_t * args,
 # undef LOAD_STENCIL
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -9,6 +9,8 @@
 
 using namespace v4;
 
+SIMD_KERNEL_BEGIN
+
 void
 clean_div_b_pipeline_v4( pipeline_args_t * args,
                          int pipeline_rank,
@@ -112,6 +114,8 @@ clean_div_b_pipeline_v4( pipeline_args_t * args,
 # undef LOAD_STENCIL
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
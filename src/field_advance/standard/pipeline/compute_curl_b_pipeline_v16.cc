@@ -9,6 +9,8 @@
 
 using namespace v16;
 
+SIMD_KERNEL_BEGIN
+
 void
 compute_curl_b_pipeline_v16( pipeline_args_t * args,
                              int pipeline_rank,
@@ -172,6 +174,8 @@ compute_curl_b_pipeline_v16( pipeline_args_t * args,
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
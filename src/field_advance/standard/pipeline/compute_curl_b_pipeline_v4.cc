@@ -9,6 +9,8 @@
 
 using namespace v4;
 
+SIMD_KERNEL_BEGIN
+
 void
 compute_curl_b_pipeline_v4( pipeline_args_t * args,
                             int pipeline_rank,
@@ -118,6 +120,8 @@ compute_curl_b_pipeline_v4( pipeline_args_t * args,
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
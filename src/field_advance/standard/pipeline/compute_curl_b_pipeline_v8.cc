@@ -9,6 +9,8 @@
 
 using namespace v8;
 
+SIMD_KERNEL_BEGIN
+
 void
 compute_curl_b_pipeline_v8( pipeline_args_t * args,
                             int pipeline_rank,
@@ -136,6 +138,8 @@ compute_curl_b_pipeline_v8( pipeline_args_t * args,
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -9,6 +9,8 @@
 
 using namespace v16;
 
+SIMD_KERNEL_BEGIN
+
 void
 vacuum_advance_e_pipeline_v16( pipeline_args_t * args,
                                int pipeline_rank,
@@ -175,6 +177,8 @@ vacuum_advance_e_pipeline_v16( pipeline_args_t * args,
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
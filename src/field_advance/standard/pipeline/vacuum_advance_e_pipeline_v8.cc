@@ -9,6 +9,8 @@
 
 using namespace v8;
 
+SIMD_KERNEL_BEGIN
+
 void
 vacuum_advance_e_pipeline_v8( pipeline_args_t * args,
                               int pipeline_rank,
@@ -141,6 +143,8 @@ vacuum_advance_e_pipeline_v8( pipeline_args_t * args,
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
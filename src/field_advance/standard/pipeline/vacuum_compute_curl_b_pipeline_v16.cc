@@ -9,6 +9,8 @@
 
 using namespace v16;
 
+SIMD_KERNEL_BEGIN
+
 void
 vacuum_compute_curl_b_pipeline_v16( pipeline_args_t * args,
                                     int pipeline_rank,
@@ -132,6 +134,8 @@ vacuum_compute_curl_b_pipeline_v16( pipeline_args_t * args,
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -195,7 +195,7 @@ new_standard_field_array( grid_t           * RESTRICT g,
   if( !g || !m_list || damp<0 ) ERROR(( "Bad args" ));
   MALLOC( fa, 1 );
   MALLOC_ALIGNED( fa->f, g->nv, 128 );
-  CLEAR( fa->f, g->nv );
+  CLEAR_PIPELINES( fa->f, g->nv, 1 );
   fa->g = g;
   fa->params = create_sfa_params( g, m_list, damp );
   fa->kernel[0] = sfa_kernels;
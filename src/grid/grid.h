@@ -27,7 +27,12 @@ enum grid_enums {
 
   // Phase 3 boundary conditions
   reflect_particles = -1, // Cell boundary should reflect particles
-  absorb_particles  = -2  // Cell boundary should absorb particles
+  absorb_particles  = -2, // Cell boundary should absorb particles
+
+  // Space filling curves used to order the voxels when sorting particles
+  fortran_sfc = 0, // FORTRAN order (x fastest, z slowest)
+  morton_sfc  = 1, // Morton (Z-order) curve
+  hilbert_sfc = 2  // Hilbert curve
 
   // Symmetry in the field boundary conditions refers to image charge
   // sign
@@ -125,6 +130,15 @@ typedef struct grid {
                           //   rangeh = range[rank+1]-1.
                           // Note: rangeh-rangel <~ 2^26
 
+  int sfc_type;           // Space filling curve used to order the voxels
+  int * ALIGNED(128) sfc; // (0:local_num_voxel-1) indexed array giving
+                          // the position of each voxel along the space
+                          // filling curve.  Non-ghost voxels occupy
+                          // positions VOXEL(1,1,1):VOXEL(1,1,1)+
+                          // nx*ny*nz-1 (a subset of VOXEL(1,1,1):
+                          // VOXEL(nx,ny,nz)), ghost voxels the rest.
+                          // For fortran_sfc, sfc[i]=i.
+
   // Nearest neighbor communications ports
   mp_t * mp;
 
@@ -185,6 +199,20 @@ set_fbc( grid_t *g, int bound, int fbc );
 void
 set_pbc( grid_t *g, int bound, int pbc );
 
+// In sfc.c
+
+// Order the voxels along the space filling curve sfc (fortran_sfc,
+// morton_sfc or hilbert_sfc).  This can be called before or after
+// size_grid.  Particles are sorted in this order by sort_p.
+
+void
+set_sfc( grid_t *g, int sfc );
+
+// Rebuild g->sfc for the current local mesh (called by size_grid).
+
+void
+size_sfc( grid_t *g );
+
 // In partition.c
 
 // g->{n,d}{x,y,z} is _coherent_ on all nodes in the domain after
@@ -240,6 +268,23 @@ partition_metal_box( grid_t *g,
                      int gnx, int gny, int gnz,
                      int gpx, int gpy, int gpz );
 
+// Move the x-boundaries of the local domain to x0 and x1 and resize it
+// to lnx voxels in x, keeping its neighbors and boundary conditions
+// (used to rebalance the load, see rebalance.cc).  Everybody must do
+// this in parallel and domains joined through a y- or z-face must get
+// the same x-boundaries.  Only the boundary conditions of whole local
+// domain faces are kept; can_repartition_grid_x returns whether these
+// are all the local voxel neighbors depend on (no set_pbc on part of a
+// face or set_region_bc inside the domain).
+
+int
+can_repartition_grid_x( const grid_t * g );
+
+void
+repartition_grid_x( grid_t *g,
+                    double x0, double x1,
+                    int lnx );
+
 // In grid_comm.c
 
 // FIXME: SHOULD TAKE A RAW PORT INDEX INSTEAD OF A PORT COORDS
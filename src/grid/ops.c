@@ -85,34 +85,8 @@ size_grid( grid_t * g,
         }
       }
 
-# if 0
   // Setup the space filling curve
-  // FIXME: THIS IS A CRUDE HACK UNTIL A GOOD SFC CAN BE WRITTEN
-  // CURRENT SFC IS GOOD FOR THREADING WITH POWER-OF-TWO NUMBER OF THREADS.
-  // UP TO AND INCLUDING 8 THREADS.
-
-  FREE_ALIGNED( g->sfc );
-  MALLOC_ALIGNED( g->sfc, g->nv, 128 );
-
-  do {
-    int off;
-    int ox, oy, oz;
-    int nx, ny, nz;
-    int nx1 = (lnx+2)/2,   ny1 = (lny+2)/2,   nz1 = (lnz+2)/2;
-    int nx0 = (lnx+2)-nx1, ny0 = (lny+2)-ny1, nz0 = (lnz+2)-nz1;
-
-    for( z=0; z<=lnz+1; z++ )
-      for( y=0; y<=lny+1; y++ )
-        for( x=0; x<=lnx+1; x++ ) {
-          i = LOCAL_CELL_ID(x,y,z);
-          off = 0;
-          ox=x; nx=nx0; if(ox>=nx) ox-=nx, off+=nx,                 nx=nx1;
-          oy=y; ny=ny0; if(oy>=ny) oy-=ny, off+=ny*(lnx+2),         ny=ny1;
-          oz=z; nz=nz0; if(oz>=nz) oz-=nz, off+=nz*(lnx+2)*(lny+2), nz=nz1;
-          g->sfc[i] = off + ox + nx*( oy + ny*oz );
-        }
-  } while(0);
-# endif
+  size_sfc( g );
 }
 
 void
@@ -190,3 +190,92 @@ partition_metal_box( grid_t * g,
     set_pbc(g,BOUNDARY(0,0,1),reflect_particles);
   }
 }
+
+// The faces of the local domain, in the order of the neighbor entries of
+// a voxel
+
+static const int face_bc[6] = { BOUNDARY(-1, 0, 0), BOUNDARY( 0,-1, 0),
+                                BOUNDARY( 0, 0,-1), BOUNDARY( 1, 0, 0),
+                                BOUNDARY( 0, 1, 0), BOUNDARY( 0, 0, 1) };
+
+// The particle boundary conditions of the local domain boundaries are
+// read from the neighbors of a voxel on each face
+
+static void
+face_pbc( const grid_t * g, int64_t * pbc ) {
+  const int nx = g->nx, ny = g->ny, nz = g->nz;
+  pbc[0] = g->neighbor[ 6*VOXEL( 1, 1, 1,nx,ny,nz)+0 ];
+  pbc[1] = g->neighbor[ 6*VOXEL( 1, 1, 1,nx,ny,nz)+1 ];
+  pbc[2] = g->neighbor[ 6*VOXEL( 1, 1, 1,nx,ny,nz)+2 ];
+  pbc[3] = g->neighbor[ 6*VOXEL(nx, 1, 1,nx,ny,nz)+3 ];
+  pbc[4] = g->neighbor[ 6*VOXEL( 1,ny, 1,nx,ny,nz)+4 ];
+  pbc[5] = g->neighbor[ 6*VOXEL( 1, 1,nz,nx,ny,nz)+5 ];
+}
+
+int
+can_repartition_grid_x( const grid_t * g ) {
+  int64_t pbc[6], expected;
+  int n[3], r[3], c[3], x, y, z, face, a, b;
+
+  if( !g ) ERROR(( "Bad args" ));
+
+  n[0] = g->nx, n[1] = g->ny, n[2] = g->nz;
+  face_pbc( g, pbc );
+
+  // Compare the neighbors of each local voxel with the ones size_grid,
+  // join_grid and set_pbc would give it for the face boundary conditions
+
+  for( z=1; z<=n[2]; z++ )
+    for( y=1; y<=n[1]; y++ )
+      for( x=1; x<=n[0]; x++ )
+        for( face=0; face<6; face++ ) {
+          a = face%3;
+          c[0] = x, c[1] = y, c[2] = z;
+          c[a] += face<3 ? -1 : 1;
+          if( c[a]>=1 && c[a]<=n[a] ) {
+            expected = g->rangel + VOXEL(c[0],c[1],c[2], n[0],n[1],n[2]);
+          } else if( (b = g->bc[ face_bc[face] ])>=0 ) {
+            r[0] = n[0], r[1] = n[1], r[2] = n[2];
+            r[a] = ( g->range[b+1] - g->range[b] ) /
+                   ( (n[(a+1)%3]+2)*(n[(a+2)%3]+2) ) - 2;
+            c[a] = face<3 ? r[a] : 1;
+            expected = g->range[b] + VOXEL(c[0],c[1],c[2], r[0],r[1],r[2]);
+          } else {
+            expected = pbc[face];
+          }
+          if( g->neighbor[ 6*VOXEL(x,y,z, n[0],n[1],n[2]) + face ]!=expected )
+            return 0;
+        }
+
+  return 1;
+}
+
+void
+repartition_grid_x( grid_t * g,
+                    double x0, double x1,
+                    int lnx ) {
+  int64_t pbc[6];
+  int bc[6], face;
+
+  if( !g || lnx<1 || x1<=x0 ) ERROR(( "Bad args" ));
+
+  // Save the boundary conditions of the local domain boundaries
+
+  face_pbc( g, pbc );
+  for( face=0; face<6; face++ ) bc[face] = g->bc[ face_bc[face] ];
+
+  // Resize the local grid and restore the boundary conditions
+
+  g->x0 = x0;
+  g->x1 = x1;
+
+  size_grid( g, lnx, g->ny, g->nz );
+
+  for( face=0; face<6; face++ )
+    if( bc[face]>=0 ) {
+      join_grid( g, face_bc[face], bc[face] );
+    } else {
+      if( bc[face]!=pec_fields ) set_fbc( g, face_bc[face], bc[face] );
+      set_pbc( g, face_bc[face], (int)pbc[face] );
+    }
+}
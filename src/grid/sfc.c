@@ -0,0 +1,129 @@
+/*
+ * Space filling curve orderings of the local voxels.  sort_p sorts the
+ * particles in this order such that particles that are close in space
+ * (along all three axes) are also close in memory.
+ */
+
+#include "grid.h"
+
+typedef struct sfc_key {
+  uint64_t key; // Position along the curve on the enclosing 2^b cube
+  int v;        // Local voxel index
+} sfc_key_t;
+
+static int
+compare_sfc_key( const void * a,
+                 const void * b ) {
+  const uint64_t ka = ((const sfc_key_t *)a)->key;
+  const uint64_t kb = ((const sfc_key_t *)b)->key;
+  return ka<kb ? -1 : ka>kb ? 1 : 0;
+}
+
+// Interleave the low b bits of x, y and z, z being the most significant.
+
+static uint64_t
+interleave_bits( uint32_t x,
+                 uint32_t y,
+                 uint32_t z,
+                 int b ) {
+  uint64_t key = 0;
+  int n;
+  for( n=b-1; n>=0; n-- )
+    key = (key<<3) | (((z>>n)&1)<<2) | (((y>>n)&1)<<1) | ((x>>n)&1);
+  return key;
+}
+
+// Position of (x,y,z) along a Hilbert curve filling a 2^b cube.  This is
+// Skilling's algorithm (AIP Conf. Proc. 707, 381, 2004): the coordinates
+// are converted in place to the "transposed" Hilbert index whose bits are
+// then interleaved.
+
+static uint64_t
+hilbert_key( uint32_t x,
+             uint32_t y,
+             uint32_t z,
+             int b ) {
+  uint32_t X[3], M = 1u<<(b-1), P, Q, t;
+  int i;
+
+  X[0] = z; X[1] = y; X[2] = x;
+
+  // Inverse undo
+  for( Q=M; Q>1; Q>>=1 ) {
+    P = Q-1;
+    for( i=0; i<3; i++ )
+      if( X[i] & Q ) X[0] ^= P;
+      else { t = (X[0]^X[i]) & P; X[0] ^= t; X[i] ^= t; }
+  }
+
+  // Gray encode
+  for( i=1; i<3; i++ ) X[i] ^= X[i-1];
+  t = 0;
+  for( Q=M; Q>1; Q>>=1 ) if( X[2] & Q ) t ^= Q-1;
+  for( i=0; i<3; i++ ) X[i] ^= t;
+
+  return interleave_bits( X[2], X[1], X[0], b );
+}
+
+void
+size_sfc( grid_t * g ) {
+  sfc_key_t * key;
+  int nx, ny, nz, v0, x, y, z, v, n, b;
+
+  if( !g ) ERROR(( "Bad args" ));
+
+  nx = g->nx;
+  ny = g->ny;
+  nz = g->nz;
+  v0 = VOXEL(1,1,1, nx,ny,nz);
+
+  FREE_ALIGNED( g->sfc );
+  MALLOC_ALIGNED( g->sfc, g->nv, 128 );
+
+  if( g->sfc_type==fortran_sfc ) {
+    for( v=0; v<g->nv; v++ ) g->sfc[v] = v;
+    return;
+  }
+
+  // Rank the non-ghost voxels by their position along the curve on the
+  // smallest 2^b cube enclosing the local mesh.
+
+  for( b=1; (1<<b)<nx || (1<<b)<ny || (1<<b)<nz; b++ );
+  if( b>21 ) ERROR(( "Local mesh too large for a space filling curve" ));
+
+  MALLOC( key, nx*ny*nz );
+  n = 0;
+  for( z=1; z<=nz; z++ )
+    for( y=1; y<=ny; y++ )
+      for( x=1; x<=nx; x++ ) {
+        key[n].v   = VOXEL(x,y,z, nx,ny,nz);
+        key[n].key = g->sfc_type==morton_sfc ?
+          interleave_bits( x-1, y-1, z-1, b ) :
+          hilbert_key(     x-1, y-1, z-1, b );
+        n++;
+      }
+  qsort( key, n, sizeof(*key), compare_sfc_key );
+
+  // Non-ghost voxels take positions v0:v0+n-1 along the curve.  The ghost
+  // voxels keep their FORTRAN order in the remaining positions (voxels
+  // 0:v0-1 are all ghosts and keep their index).
+
+  for( v=0; v<g->nv; v++ ) g->sfc[v] = -1;
+  for( v=0; v<n; v++ ) g->sfc[ key[v].v ] = v0 + v;
+  for( n=0, v=0; v<g->nv; v++ )
+    if( g->sfc[v]<0 ) {
+      if( n==v0 ) n += nx*ny*nz;
+      g->sfc[v] = n++;
+    }
+
+  FREE( key );
+}
+
+void
+set_sfc( grid_t * g,
+         int sfc ) {
+  if( !g || ( sfc!=fortran_sfc && sfc!=morton_sfc && sfc!=hilbert_sfc ) )
+    ERROR(( "Bad args" ));
+  g->sfc_type = sfc;
+  if( g->nv ) size_sfc( g );
+}
@@ -13,7 +13,10 @@
 static int
 aa_n_pipeline(void)
 {
-#if defined(VPIC_USE_PTHREADS)                         // Pthreads case.
+#if defined(VPIC_USE_TILE_ACCUMULATORS)                // Tile case.
+  int                          n = 0;
+
+#elif defined(VPIC_USE_PTHREADS)                         // Pthreads case.
   int                          n = serial.n_pipeline;
   if ( n < thread.n_pipeline ) n = thread.n_pipeline;
 
@@ -41,6 +44,13 @@ restore_accumulator_array( void ) {
   RESTORE( aa );
   RESTORE_ALIGNED( aa->a );
   RESTORE_PTR( aa->g );
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  aa->t        = NULL; // Tiles do not persist between advance_p calls
+  aa->max_t    = 0;
+  aa->n_tile   = 0;
+  aa->max_tile = 0;
+  aa->tile     = NULL;
+#endif
   if( aa->n_pipeline!=aa_n_pipeline() )
     ERROR(( "Number of accumulators restored is not the same as the number of "
             "accumulators checkpointed.  Did you change the number of threads "
@@ -57,7 +67,17 @@ new_accumulator_array( grid_t * g ) {
   aa->stride     = POW2_CEIL(g->nv,2);
   aa->g          = g;
   MALLOC_ALIGNED( aa->a, (size_t)(aa->n_pipeline+1)*(size_t)aa->stride, 128 );
-  CLEAR( aa->a, (size_t)(aa->n_pipeline+1)*(size_t)aa->stride );
+  // Each pipeline first touches its own accumulator, such that the
+  // accumulator is in the NUMA domain of the pipeline when pinned.
+  CLEAR_PIPELINES( aa->a, (int64_t)aa->n_pipeline*aa->stride, aa->stride );
+  CLEAR( aa->a + (size_t)aa->n_pipeline*(size_t)aa->stride, aa->stride );
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  aa->t        = NULL;
+  aa->max_t    = 0;
+  aa->n_tile   = 0;
+  aa->max_tile = 0;
+  aa->tile     = NULL;
+#endif
   REGISTER_OBJECT( aa, checkpt_accumulator_array, restore_accumulator_array,
                   NULL );
   return aa;
@@ -67,7 +87,121 @@ void
 delete_accumulator_array( accumulator_array_t * aa ) {
   if( !aa ) return;
   UNREGISTER_OBJECT( aa );
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  FREE_ALIGNED( aa->t );
+  FREE( aa->tile );
+#endif
   FREE_ALIGNED( aa->a );
   FREE( aa );
 }
 
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+
+// Compute the voxels tile k must cover to include voxels lo:hi.  Tiles are
+// clipped to the voxels reduced by reduce_accumulator_array.  Particles
+// only deposit current to the voxels they occupy during a move, which are
+// all inside this range.  If the tiles are already in use, the tile also
+// keeps covering its current voxels.
+
+static void
+tile_window( const accumulator_array_t * aa,
+             int k,
+             int lo,
+             int hi,
+             int * l,
+             int * h ) {
+  const grid_t * g = aa->g;
+  int i0 = ( VOXEL(1,1,1, g->nx,g->ny,g->nz) / 2 ) * 2;
+  int i1 = VOXEL(g->nx,g->ny,g->nz, g->nx,g->ny,g->nz);
+
+  if( lo<i0 ) lo = i0;
+  if( hi>i1 ) hi = i1;
+  if( lo>hi ) lo = i0, hi = i0-1;
+
+  if( aa->n_tile && aa->tile[3*k]<=aa->tile[3*k+1] ) {
+    if( lo>hi || lo>aa->tile[3*k  ] ) lo = aa->tile[3*k  ];
+    if( lo>hi || hi<aa->tile[3*k+1] ) hi = aa->tile[3*k+1];
+  }
+
+  *l = lo, *h = hi;
+}
+
+void
+begin_accumulator_tiles( accumulator_array_t * RESTRICT aa,
+                         int n,
+                         const int * RESTRICT lo,
+                         const int * RESTRICT hi,
+                         accumulator_t ** RESTRICT a ) {
+  accumulator_t * ALIGNED(128) t;
+  int k, l, h, n_t, grow;
+
+  if( !aa || n<0 || ( n && ( !lo || !hi || !a ) ) ) ERROR(( "Bad args" ));
+  if( aa->n_tile && aa->n_tile!=n )
+    ERROR(( "Number of accumulator tiles changed before they were reduced" ));
+
+  if( aa->max_tile<n ) {
+    FREE( aa->tile );
+    MALLOC( aa->tile, 3*n );
+    aa->max_tile = n;
+  }
+
+  // Find out if the tiles in use need to grow and how many tile
+  // accumulators are needed.
+
+  for( grow=0, n_t=0, k=0; k<n; k++ ) {
+    tile_window( aa, k, lo[k], hi[k], &l, &h );
+    if( aa->n_tile && ( l!=aa->tile[3*k] || h!=aa->tile[3*k+1] ) ) grow = 1;
+    n_t += h-l+1;
+  }
+
+  if( aa->n_tile && grow ) {
+
+    // Move the tiles in use into a larger allocation.  The tiles are zero
+    // where they did not overlap the old tiles.
+
+    MALLOC_ALIGNED( t, n_t + n_t/8, 128 );
+    CLEAR( t, n_t + n_t/8 );
+
+    for( n_t=0, k=0; k<n; k++ ) {
+      tile_window( aa, k, lo[k], hi[k], &l, &h );
+      COPY( t + n_t + aa->tile[3*k] - l, aa->t + aa->tile[3*k+2],
+            aa->tile[3*k+1] - aa->tile[3*k] + 1 );
+      aa->tile[3*k  ] = l;
+      aa->tile[3*k+1] = h;
+      aa->tile[3*k+2] = n_t;
+      n_t += h-l+1;
+    }
+
+    FREE_ALIGNED( aa->t );
+    aa->t     = t;
+    aa->max_t = n_t + n_t/8;
+
+  } else if( !aa->n_tile ) {
+
+    // Tile accumulators are zero whenever they are not in use, so only
+    // newly allocated tiles need to be cleared.  Leave some slack to avoid
+    // reallocating as the particles move around.
+
+    if( aa->max_t<n_t ) {
+      FREE_ALIGNED( aa->t );
+      aa->max_t = n_t + n_t/8;
+      MALLOC_ALIGNED( aa->t, aa->max_t, 128 );
+      CLEAR( aa->t, aa->max_t );
+    }
+
+    for( n_t=0, k=0; k<n; k++ ) {
+      tile_window( aa, k, lo[k], hi[k], &l, &h );
+      aa->tile[3*k  ] = l;
+      aa->tile[3*k+1] = h;
+      aa->tile[3*k+2] = n_t;
+      n_t += h-l+1;
+    }
+
+  }
+
+  for( k=0; k<n; k++ ) a[k] = aa->t + aa->tile[3*k+2] - aa->tile[3*k];
+
+  aa->n_tile = n;
+}
+
+#endif
@@ -17,4 +17,16 @@ clear_accumulator_array( accumulator_array_t * RESTRICT aa )
 
   // Conditionally execute this when more abstractions are available.
   clear_accumulator_array_pipeline( aa );
+
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  // Tiles are normally zeroed when they are reduced.  Discard any
+  // currents accumulated to tiles that were never reduced.
+
+  if ( aa->n_tile )
+  {
+    CLEAR( aa->t, aa->max_t );
+
+    aa->n_tile = 0;
+  }
+#endif
 }
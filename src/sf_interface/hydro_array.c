@@ -26,6 +26,8 @@ restore_hydro_array( void ) {
   RESTORE( ha );
   RESTORE_ALIGNED( ha->h );
   RESTORE_PTR( ha->g );
+  ha->hp         = NULL; // Allocated on first use
+  ha->n_pipeline = 0;
   return ha;
 }
 
@@ -36,7 +38,10 @@ new_hydro_array( grid_t * g ) {
   MALLOC( ha, 1 );
   MALLOC_ALIGNED( ha->h, g->nv, 128 );
   ha->g = g;
-  clear_hydro_array( ha );
+  ha->hp = NULL;
+  ha->n_pipeline = 0;
+  ha->stride = POW2_CEIL(g->nv,2);
+  CLEAR_PIPELINES( ha->h, g->nv, 1 );
   REGISTER_OBJECT( ha, checkpt_hydro_array, restore_hydro_array, NULL );
   return ha;
 }
@@ -45,6 +50,7 @@ void
 delete_hydro_array( hydro_array_t * ha ) {
   if( !ha ) return;
   UNREGISTER_OBJECT( ha );
+  FREE_ALIGNED( ha->hp );
   FREE_ALIGNED( ha->h );
   FREE( ha );
 }
@@ -55,6 +61,24 @@ clear_hydro_array( hydro_array_t * ha ) {
   CLEAR( ha->h, ha->g->nv ); // FIXME: SPU THIS?
 }
 
+void
+size_hydro_array_pipelines( hydro_array_t * ha ) {
+  int n;
+  if( !ha ) ERROR(( "NULL hydro array" ));
+
+# if defined(VPIC_USE_PTHREADS)
+  n = serial.n_pipeline;
+  if( n<thread.n_pipeline ) n = thread.n_pipeline;
+# else
+  n = omp_helper.n_pipeline;
+# endif
+
+  if( ha->hp && ha->n_pipeline>=n ) return;
+  FREE_ALIGNED( ha->hp );
+  MALLOC_ALIGNED( ha->hp, (size_t)n*(size_t)ha->stride, 128 );
+  ha->n_pipeline = n;
+}
+
 #define hydro(x,y,z) h0[ VOXEL(x,y,z, nx,ny,nz) ]
 
 // Generic looping
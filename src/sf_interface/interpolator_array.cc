@@ -27,7 +27,7 @@ new_interpolator_array( grid_t * g )
   if( !g ) ERROR(( "NULL grid" ));
   MALLOC( ia, 1 );
   MALLOC_ALIGNED( ia->i, g->nv, 128 );
-  CLEAR( ia->i, g->nv );
+  CLEAR_PIPELINES( ia->i, g->nv, 1 );
   ia->g = g;
   REGISTER_OBJECT( ia, checkpt_interpolator_array, restore_interpolator_array,
                    NULL );
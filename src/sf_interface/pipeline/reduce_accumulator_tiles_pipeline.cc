@@ -0,0 +1,92 @@
+#define IN_sf_interface
+
+#include "sf_interface_pipeline.h"
+
+#include "../sf_interface_private.h"
+
+#include "../../util/pipelines/pipelines_exec.h"
+
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+
+// Each pipeline reduces a block of voxels.  For every voxel in its block,
+// the tiles covering the voxel are added to the host accumulator in tile
+// order and then zeroed so they are ready for the next advance_p.
+
+void
+reduce_accumulator_tiles_pipeline_scalar( accumulator_tiles_pipeline_args_t * args,
+                                          int pipeline_rank,
+                                          int n_pipeline )
+{
+  const int * RESTRICT tile = args->tile;
+  const int si = sizeof(accumulator_t) / sizeof(float);
+  int i, i1, k, l, h, j, n;
+
+  DISTRIBUTE( args->n, accumulators_n_block,
+              pipeline_rank, n_pipeline, i, i1 );
+
+  i  += args->i0;
+  i1 += i;
+
+  for( k = 0; k < args->n_tile; k++ )
+  {
+    l = tile[3*k  ] > i  ? tile[3*k  ] : i;
+    h = tile[3*k+1] < i1 ? tile[3*k+1] : i1 - 1;
+
+    if ( l > h ) continue;
+
+    /**/  float * RESTRICT ALIGNED(16) a = args->a[l].jx;
+    /**/  float * RESTRICT ALIGNED(16) t = args->t[ tile[3*k+2] + l - tile[3*k] ].jx;
+
+    n = ( h - l + 1 )*si;
+
+    for( j = 0; j < n; j++ )
+    {
+      a[j] += t[j];
+      t[j]  = 0;
+    }
+  }
+}
+
+void
+reduce_accumulator_tiles_pipeline( accumulator_array_t * RESTRICT aa )
+{
+  DECLARE_ALIGNED_ARRAY( accumulator_tiles_pipeline_args_t, 128, args, 1 );
+
+  int k, i0, i1;
+
+  if ( !aa )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  // Find the voxels covered by the tiles.
+
+  i0 = aa->stride;
+  i1 = -1;
+
+  for( k = 0; k < aa->n_tile; k++ )
+  {
+    if ( aa->tile[3*k] > aa->tile[3*k+1] ) continue;
+
+    if ( i0 > aa->tile[3*k  ] ) i0 = aa->tile[3*k  ];
+    if ( i1 < aa->tile[3*k+1] ) i1 = aa->tile[3*k+1];
+  }
+
+  if ( i0 <= i1 )
+  {
+    args->a      = aa->a;
+    args->t      = aa->t;
+    args->tile   = aa->tile;
+    args->n_tile = aa->n_tile;
+    args->i0     = i0;
+    args->n      = i1 - i0 + 1;
+
+    EXEC_PIPELINES( reduce_accumulator_tiles, args, 0 );
+
+    WAIT_PIPELINES();
+  }
+
+  aa->n_tile = 0;
+}
+
+#endif
@@ -0,0 +1,74 @@
+#define IN_sf_interface
+
+#include "sf_interface_pipeline.h"
+
+#include "../sf_interface_private.h"
+
+#include "../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Add the hydro arrays of the pipelines to the host hydro array.  Each
+// pipeline reduces a block of voxels, adding the arrays in pipeline order
+// so the result does not depend on the number of threads doing the
+// reduction.
+//----------------------------------------------------------------------------//
+
+void
+reduce_hydro_pipeline_scalar( hydro_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  const int si = sizeof(hydro_t) / sizeof(float);
+  const int nr = args->n_array;
+  const int64_t sr = (int64_t) si * args->s_array;
+
+  int64_t i, i1, k;
+  int r, j;
+
+  DISTRIBUTE( args->n, hydro_n_block, pipeline_rank, n_pipeline, i, i1 );
+
+  i1 += i;
+
+  /**/  float * RESTRICT ALIGNED(16) a = (float *) args->h;
+  const float * RESTRICT ALIGNED(16) b = (const float *) args->hp;
+
+  for( ; i < i1; i++ )
+  {
+    k = i*si;
+
+    for( r = 0; r < nr; r++ )
+    {
+      for( j = 0; j < si; j++ )
+      {
+        a[k+j] += b[k+r*sr+j];
+      }
+    }
+  }
+}
+
+#if defined(V4_ACCELERATION) && defined(HAS_V4_PIPELINE)
+
+#error "V4 version not hooked up yet."
+
+#endif
+
+void
+reduce_hydro_array_pipeline( hydro_array_t * RESTRICT ha )
+{
+  DECLARE_ALIGNED_ARRAY( hydro_pipeline_args_t, 128, args, 1 );
+
+  if ( !ha || !ha->hp || ha->n_pipeline < N_PIPELINE )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  args->h       = ha->h;
+  args->hp      = ha->hp;
+  args->n       = ha->g->nv;
+  args->n_array = N_PIPELINE;
+  args->s_array = ha->stride;
+
+  EXEC_PIPELINES( reduce_hydro, args, 0 );
+
+  WAIT_PIPELINES();
+}
@@ -66,6 +66,27 @@ reduce_accumulators_pipeline_scalar( accumulators_pipeline_args_t * args,
                                      int pipeline_rank,
                                      int n_pipeline );
 
+///////////////////////////////////////////////////////////////////////////////
+// reduce_accumulator_tiles_pipeline interface
+
+typedef struct accumulator_tiles_pipeline_args
+{
+  MEM_PTR( accumulator_t, 128 ) a;    // Host accumulator array
+  MEM_PTR( accumulator_t, 128 ) t;    // Tile accumulators
+  MEM_PTR( const int,     16  ) tile; // Tile descriptors
+  int n_tile;                         // Number of tiles
+  int i0;                             // First voxel covered by a tile
+  int n;                              // Number of voxels covered by tiles
+
+  PAD_STRUCT( 3*SIZEOF_MEM_PTR + 3*sizeof(int) )
+
+} accumulator_tiles_pipeline_args_t;
+
+void
+reduce_accumulator_tiles_pipeline_scalar( accumulator_tiles_pipeline_args_t * args,
+                                          int pipeline_rank,
+                                          int n_pipeline );
+
 ///////////////////////////////////////////////////////////////////////////////
 
 typedef struct unload_accumulator_pipeline_args
@@ -75,11 +96,14 @@ typedef struct unload_accumulator_pipeline_args
   int nx;                                // Local domain x-resolution
   int ny;                                // Local domain y-resolution
   int nz;                                // Local domain z-resolution
+  int x0, x1;                            // Voxels to unload are
+  int y0, y1;                            // [x0,x1]x[y0,y1]x[z0,z1]
+  int z0, z1;
   float cx;                              // x-axis coupling constant
   float cy;                              // y-axis coupling constant
   float cz;                              // z-axis coupling constant
 
-  PAD_STRUCT( 2*SIZEOF_MEM_PTR + 3*sizeof(int) + 3*sizeof(float) )
+  PAD_STRUCT( 2*SIZEOF_MEM_PTR + 9*sizeof(int) + 3*sizeof(float) )
 
 } unload_accumulator_pipeline_args_t;
 
@@ -88,4 +112,26 @@ unload_accumulator_pipeline_scalar( unload_accumulator_pipeline_args_t * args,
                                     int pipeline_rank,
                                     int n_pipeline );
 
+///////////////////////////////////////////////////////////////////////////////
+// reduce_hydro_pipeline interface
+
+enum { hydro_n_block = 64 };
+
+typedef struct hydro_pipeline_args
+{
+  MEM_PTR( hydro_t, 128 ) h;        // Host hydro array
+  MEM_PTR( const hydro_t, 128 ) hp; // Pipeline hydro arrays
+  int n;                            // Number of voxels to reduce
+  int n_array;                      // Number of pipeline hydro arrays
+  int s_array;                      // Stride between each array
+
+  PAD_STRUCT( 2*SIZEOF_MEM_PTR + 3*sizeof(int) )
+
+} hydro_pipeline_args_t;
+
+void
+reduce_hydro_pipeline_scalar( hydro_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
 #endif // _sf_interface_pipeline_h_
@@ -32,7 +32,6 @@ unload_accumulator_pipeline_scalar( unload_accumulator_pipeline_args_t * args,
 
   const int nx = args->nx;
   const int ny = args->ny;
-  const int nz = args->nz;
 
   const float cx = args->cx;
   const float cy = args->cy;
@@ -45,7 +44,8 @@ unload_accumulator_pipeline_scalar( unload_accumulator_pipeline_args_t * args,
     return; // No need for straggler cleanup
   }
 
-  DISTRIBUTE_VOXELS( 1, nx+1, 1, ny+1, 1, nz+1, 1,
+  DISTRIBUTE_VOXELS( args->x0, args->x1, args->y0, args->y1,
+                     args->z0, args->z1, 1,
                      pipeline_rank, n_pipeline, x, y, z, n_voxel );
 
 # define LOAD_STENCIL()                                                 \
@@ -65,10 +65,10 @@ unload_accumulator_pipeline_scalar( unload_accumulator_pipeline_args_t * args,
     f0++; a0++; ax++; ay++; az++; ayz++; azx++; axy++;
 
     x++;
-    if ( x > nx + 1 )
+    if ( x > args->x1 )
     {
-      x=1, y++;
-      if ( y > ny + 1 ) y=1, z++;
+      x=args->x0, y++;
+      if ( y > args->y1 ) y=args->y0, z++;
       LOAD_STENCIL();
     }
   }
@@ -85,7 +85,10 @@ unload_accumulator_pipeline_scalar( unload_accumulator_pipeline_args_t * args,
 
 void
 unload_accumulator_array_pipeline( field_array_t * RESTRICT fa,
-                                   const accumulator_array_t * RESTRICT aa )
+                                   const accumulator_array_t * RESTRICT aa,
+                                   int x0, int x1,
+                                   int y0, int y1,
+                                   int z0, int z1 )
 {
   unload_accumulator_pipeline_args_t args[1];
 
@@ -96,6 +99,11 @@ unload_accumulator_array_pipeline( field_array_t * RESTRICT fa,
     ERROR( ( "Bad args" ) );
   }
 
+  if ( x1 < x0 || y1 < y0 || z1 < z0 )
+  {
+    return; // Nothing to unload
+  }
+
 # if 0 // Original non-pipelined version
 
   for( z=1; z<=nz+1; z++ ) {
@@ -126,6 +134,12 @@ unload_accumulator_array_pipeline( field_array_t * RESTRICT fa,
   args->nx = fa->g->nx;
   args->ny = fa->g->ny;
   args->nz = fa->g->nz;
+  args->x0 = x0;
+  args->x1 = x1;
+  args->y0 = y0;
+  args->y1 = y1;
+  args->z0 = z0;
+  args->z1 = z1;
 
   args->cx = 0.25 * fa->g->rdy * fa->g->rdz / fa->g->dt;
   args->cy = 0.25 * fa->g->rdz * fa->g->rdx / fa->g->dt;
@@ -17,4 +17,8 @@ reduce_accumulator_array( accumulator_array_t * RESTRICT aa )
 
   // Conditionally execute this when more abstractions are available.
   reduce_accumulator_array_pipeline( aa );
+
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  reduce_accumulator_tiles_pipeline( aa );
+#endif
 }
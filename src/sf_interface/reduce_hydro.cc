@@ -0,0 +1,20 @@
+#define IN_sf_interface
+
+#include "sf_interface_private.h"
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper reduce_hydro_array
+// function.
+//----------------------------------------------------------------------------//
+
+void
+reduce_hydro_array( hydro_array_t * RESTRICT ha )
+{
+  if ( !ha || !ha->hp )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  // Conditionally execute this when more abstractions are available.
+  reduce_hydro_array_pipeline( ha );
+}
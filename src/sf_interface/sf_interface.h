@@ -25,7 +25,8 @@
 // 64-byte align
 
 #if defined(USE_V16_PORTABLE) || \
-    defined(USE_V16_AVX512)
+    defined(USE_V16_AVX512)   || \
+    defined(VPIC_DISPATCH_V16)
 
 #define PAD_SIZE_INTERPOLATOR 14
 #define PAD_SIZE_ACCUMULATOR   4
@@ -36,7 +37,8 @@
 
 #elif defined(USE_V8_PORTABLE) || \
       defined(USE_V8_AVX)      || \
-      defined(USE_V8_AVX2)
+      defined(USE_V8_AVX2)     || \
+      defined(VPIC_DISPATCH_V8)
 
 #define PAD_SIZE_INTERPOLATOR 6
 #define PAD_SIZE_ACCUMULATOR  4
@@ -111,6 +113,15 @@ END_C_DECLS
 // processor.  a(:,:,:,1:n_pipeline) are the accumulators used by
 // pipelines during operations.  Like the interpolator, accumulators
 // on the surface of the local domain are not used.
+//
+// With VPIC_USE_TILE_ACCUMULATORS, n_pipeline is 0 and there are no
+// full size pipeline accumulators.  Instead, each advance_p pipeline
+// is given a private tile accumulator that only covers the voxels its
+// particles can deposit current to.  For particles sorted in voxel
+// order, this is a small halo padded tile of the domain.  Otherwise, it
+// can cover the whole domain (see advance_p_tiles_pipeline).
+// reduce_accumulator_array reduces the tiles into the host accumulator in
+// pipeline order.
 
 typedef struct accumulator
 {
@@ -128,6 +139,14 @@ typedef struct accumulator_array
   int n_pipeline; // Number of pipelines supported by this accumulator
   int stride;     // Stride be each pipeline's accumulator array
   grid_t * g;
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  accumulator_t * ALIGNED(128) t; // Tile accumulators
+  int max_t;      // Number of tile accumulators allocated
+  int n_tile;     // Number of tiles in use
+  int max_tile;   // Number of tiles allocated
+  int * tile;     // Tile k covers voxels tile[3*k]:tile[3*k+1] (inclusive)
+                  // and starts at t+tile[3*k+2]
+#endif
 } accumulator_array_t;
 
 BEGIN_C_DECLS
@@ -158,6 +177,25 @@ clear_accumulator_array( accumulator_array_t * RESTRICT a );
 void
 reduce_accumulator_array( accumulator_array_t * RESTRICT a );
 
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+
+// In accumulator_array.c
+
+// Assign n pipelines tile accumulators.  The tile of pipeline k covers
+// voxels lo[k]:hi[k] (an empty tile if lo[k]>hi[k]) and a[k] is set such
+// that a[k]+v is the accumulator of voxel v in the tile.  Tiles stay in
+// use until reduce_accumulator_array, so advancing further species grows
+// the tiles as needed and keeps what was accumulated to them.
+
+void
+begin_accumulator_tiles( accumulator_array_t * RESTRICT aa,
+                         int n,
+                         const int * RESTRICT lo,
+                         const int * RESTRICT hi,
+                         accumulator_t ** RESTRICT a );
+
+#endif
+
 // In unload_accumulator.c
 
 // Going into unload_accumulator, the accumulator contains 4 times the
@@ -170,9 +208,24 @@ reduce_accumulator_array( accumulator_array_t * RESTRICT a );
 // accumulators have been reduced into the host accumulator.
 
 void
-unload_accumulator_array( /**/  field_array_t       * RESTRICT fa, 
+unload_accumulator_array( /**/  field_array_t       * RESTRICT fa,
                           const accumulator_array_t * RESTRICT aa );
 
+// unload_accumulator_array_interior and unload_accumulator_array_surface
+// together do the same as unload_accumulator_array.  The interior part
+// does not depend on the accumulators of the voxels on the surface of the
+// local domain.  Particles received from other domains only move through
+// these (see begin_boundary_p), so the interior can be unloaded while they
+// are in flight.
+
+void
+unload_accumulator_array_interior( /**/  field_array_t       * RESTRICT fa,
+                                   const accumulator_array_t * RESTRICT aa );
+
+void
+unload_accumulator_array_surface( /**/  field_array_t       * RESTRICT fa,
+                                  const accumulator_array_t * RESTRICT aa );
+
 END_C_DECLS
 
 /*****************************************************************************/
@@ -191,10 +244,19 @@ typedef struct hydro
   float _pad[PAD_SIZE_HYDRO]; // 16, 32 and 64-byte align
 } hydro_t;
 
+// The pipelines accumulate hydro fields into hydro arrays of their own
+// (pipeline rank r uses hp + r*stride), while the host accumulates into h
+// directly.  reduce_hydro_array adds these to h.  As hydro fields are only
+// accumulated on dump steps, the pipeline arrays are not checkpointed and
+// are allocated on first use (see size_hydro_array_pipelines).
+
 typedef struct hydro_array
 {
   hydro_t * ALIGNED(128) h;
   grid_t * g;
+  hydro_t * ALIGNED(128) hp; // Hydro arrays of the pipelines
+  int n_pipeline;            // Number of pipeline hydro arrays allocated
+  int stride;                // Stride between each pipeline's hydro array
 } hydro_array_t;
 
 BEGIN_C_DECLS
@@ -224,6 +286,19 @@ clear_hydro_array( hydro_array_t * ha );
 void
 synchronize_hydro_array( hydro_array_t * ha );
 
+// Make sure ha has a hydro array for each pipeline.  The pipelines clear
+// their hydro array before accumulating into it.
+
+void
+size_hydro_array_pipelines( hydro_array_t * ha );
+
+// Add the hydro arrays of the pipelines to the host hydro array in a
+// pipelined fashion.  Use after the pipelines have accumulated hydro
+// fields.
+
+void
+reduce_hydro_array( hydro_array_t * ha );
+
 END_C_DECLS
 
 #endif // _sf_interface_h_
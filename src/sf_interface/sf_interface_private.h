@@ -23,10 +23,23 @@ clear_accumulator_array_pipeline( accumulator_array_t * RESTRICT aa );
 void
 reduce_accumulator_array_pipeline( accumulator_array_t * RESTRICT aa );
 
+void
+reduce_hydro_array_pipeline( hydro_array_t * RESTRICT ha );
+
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+
+void
+reduce_accumulator_tiles_pipeline( accumulator_array_t * RESTRICT aa );
+
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void
 unload_accumulator_array_pipeline( field_array_t * RESTRICT fa,
-                                   const accumulator_array_t * RESTRICT aa );
+                                   const accumulator_array_t * RESTRICT aa,
+                                   int x0, int x1,
+                                   int y0, int y1,
+                                   int z0, int z1 );
 
 #endif // _sf_interface_private_h_
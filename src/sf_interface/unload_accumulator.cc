@@ -18,6 +18,63 @@ unload_accumulator_array( field_array_t * RESTRICT fa,
     ERROR( ( "Bad args" ) );
   }
 
+  const int nx = fa->g->nx, ny = fa->g->ny, nz = fa->g->nz;
+
   // Conditionally execute this when more abstractions are available.
-  unload_accumulator_array_pipeline( fa, aa );
+  unload_accumulator_array_pipeline( fa, aa, 1, nx+1, 1, ny+1, 1, nz+1 );
+}
+
+//----------------------------------------------------------------------------//
+// The current of a voxel depends on the accumulators of the voxel and of its
+// lower neighbors.  The interior voxels are those whose current does not
+// depend on the accumulators of the voxels on the surface of the local
+// domain (x = 1 or nx, y = 1 or ny, z = 1 or nz), i.e. the voxels in
+// [3,nx-1]x[3,ny-1]x[3,nz-1].  The surface voxels are all the others.
+//----------------------------------------------------------------------------//
+
+void
+unload_accumulator_array_interior( field_array_t * RESTRICT fa,
+                                   const accumulator_array_t * RESTRICT aa )
+{
+  if ( !fa              ||
+       !aa              ||
+       fa->g != aa->g )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  const int nx = fa->g->nx, ny = fa->g->ny, nz = fa->g->nz;
+
+  unload_accumulator_array_pipeline( fa, aa, 3, nx-1, 3, ny-1, 3, nz-1 );
+}
+
+void
+unload_accumulator_array_surface( field_array_t * RESTRICT fa,
+                                  const accumulator_array_t * RESTRICT aa )
+{
+  if ( !fa              ||
+       !aa              ||
+       fa->g != aa->g )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  const int nx = fa->g->nx, ny = fa->g->ny, nz = fa->g->nz;
+
+  // Without interior voxels, the surface is the whole domain.
+
+  if ( nx < 4 || ny < 4 || nz < 4 )
+  {
+    unload_accumulator_array_pipeline( fa, aa, 1, nx+1, 1, ny+1, 1, nz+1 );
+    return;
+  }
+
+  // Unload the surface as six slabs around the interior.
+
+  unload_accumulator_array_pipeline( fa, aa, 1, nx+1, 1, ny+1, 1,    2    );
+  unload_accumulator_array_pipeline( fa, aa, 1, nx+1, 1, ny+1, nz,   nz+1 );
+  unload_accumulator_array_pipeline( fa, aa, 1, nx+1, 1, 2,    3,    nz-1 );
+  unload_accumulator_array_pipeline( fa, aa, 1, nx+1, ny,ny+1, 3,    nz-1 );
+  unload_accumulator_array_pipeline( fa, aa, 1, 2,    3, ny-1, 3,    nz-1 );
+  unload_accumulator_array_pipeline( fa, aa, nx,nx+1, 3, ny-1, 3,    nz-1 );
 }
@@ -12,17 +12,32 @@
 
 /* Private interface *********************************************************/
 
+// Particles are checkpointed in the AoS format regardless of the particle
+// layout such that checkpoints can be restored by builds using either.
+
 void
 checkpt_species( const species_t * sp ) {
   CHECKPT( sp, 1 );
   CHECKPT_STR( sp->name );
+# if PARTICLE_LAYOUT_AOS
   checkpt_data( sp->p,
                 sp->np    *sizeof(particle_t),
                 sp->max_np*sizeof(particle_t), 1, 1, 128 );
+# else
+  particle_t * p;
+  int64_t n;
+  MALLOC_ALIGNED( p, sp->np, 128 );
+  for( n=0; n<sp->np; n++ ) load_particle( sp->p, n, p+n );
+  checkpt_data( p,
+                sp->np    *sizeof(particle_t),
+                sp->max_np*sizeof(particle_t), 1, 1, 128 );
+  FREE_ALIGNED( p );
+# endif
   checkpt_data( sp->pm,
                 sp->nm    *sizeof(particle_mover_t),
                 sp->max_nm*sizeof(particle_mover_t), 1, 1, 128 );
   CHECKPT_ALIGNED( sp->partition, sp->g->nv+1, 128 );
+  if( sp->sub_a ) CHECKPT_ALIGNED( sp->sub_a, sp->g->nv, 128 );
   CHECKPT_PTR( sp->g );
   CHECKPT_PTR( sp->next );
 }
@@ -32,9 +47,23 @@ restore_species( void ) {
   species_t * sp;
   RESTORE( sp );
   RESTORE_STR( sp->name );
+# if PARTICLE_LAYOUT_AOS
   sp->p  = (particle_t *)      restore_data();
+# else
+  particle_t * p = (particle_t *)restore_data();
+  int64_t n;
+  MALLOC_ALIGNED( sp->p, PARTICLE_BLOCKS(sp->max_np), 128 );
+  for( n=0; n<sp->np; n++ ) {
+#   if defined(VPIC_USE_COMPACT_P)
+    if( p[n].w!=1 ) ERROR(( "Compact particles have unit weight" ));
+#   endif
+    store_particle( p+n, sp->p, n );
+  }
+  FREE_ALIGNED( p );
+# endif
   sp->pm = (particle_mover_t *)restore_data();
   RESTORE_ALIGNED( sp->partition );
+  if( sp->sub_a ) RESTORE_ALIGNED( sp->sub_a );
   RESTORE_PTR( sp->g );
   RESTORE_PTR( sp->next );
   return sp;
@@ -43,6 +72,7 @@ restore_species( void ) {
 void
 delete_species( species_t * sp ) {
   UNREGISTER_OBJECT( sp );
+  FREE_ALIGNED( sp->sub_a );
   FREE_ALIGNED( sp->partition );
   FREE_ALIGNED( sp->pm );
   FREE_ALIGNED( sp->p );
@@ -107,6 +137,7 @@ species( const char * name,
          size_t max_local_nm,
          int sort_interval,
          int sort_out_of_place,
+         int subcycle,
          grid_t * g ) {
   species_t * sp;
   int len = name ? strlen(name) : 0;
@@ -116,6 +147,7 @@ species( const char * name,
   if( g->nv == 0) ERROR(( "Allocate grid before defining species." ));
   if( max_local_np<1 ) max_local_np = 1;
   if( max_local_nm<1 ) max_local_nm = 1;
+  if( subcycle<1 ) subcycle = 1;
 
   MALLOC( sp, 1 );
   CLEAR( sp, 1 );
@@ -126,17 +158,25 @@ species( const char * name,
   sp->q = q;
   sp->m = m;
 
-  MALLOC_ALIGNED( sp->p, max_local_np, 128 );
+  MALLOC_ALIGNED( sp->p, PARTICLE_BLOCKS(max_local_np), 128 );
   sp->max_np = max_local_np;
 
   MALLOC_ALIGNED( sp->pm, max_local_nm, 128 );
+  CLEAR_PIPELINES( sp->pm, max_local_nm, 8 );
   sp->max_nm = max_local_nm;
 
   sp->last_sorted       = INT64_MIN;
+  sp->wide_tiles        = INT64_MAX;
   sp->sort_interval     = sort_interval;
   sp->sort_out_of_place = sort_out_of_place;
   MALLOC_ALIGNED( sp->partition, g->nv+1, 128 );
 
+  sp->subcycle = subcycle;
+  if( subcycle>1 ) {
+    MALLOC_ALIGNED( sp->sub_a, g->nv, 128 );
+    CLEAR( sp->sub_a, g->nv );
+  }
+
   sp->g = g;   
 
   /* id, next are set by append species */
@@ -144,3 +184,21 @@ species( const char * name,
   REGISTER_OBJECT( sp, checkpt_species, restore_species, NULL );
   return sp;
 }
+
+// The pipelines push particles in DISTRIBUTE( np, 16, ... ) shares.  The
+// rest of the array, where the species grows into, is spread over the
+// pipelines the same way.
+
+void
+home_species( species_t * sp ) {
+  particle_block_t * ALIGNED(128) p;
+  int64_t nb, max_nb;
+  if( !sp ) ERROR(( "Bad args" ));
+  nb     = PARTICLE_BLOCKS( sp->np );
+  max_nb = PARTICLE_BLOCKS( sp->max_np );
+  MALLOC_ALIGNED( p, max_nb, 128 );
+  COPY_PIPELINES(  p,      sp->p, nb,        16/PARTICLE_BLOCK_SIZE );
+  CLEAR_PIPELINES( p + nb,        max_nb-nb, 16/PARTICLE_BLOCK_SIZE );
+  FREE_ALIGNED( sp->p );
+  sp->p = p;
+}
@@ -15,10 +15,16 @@
 #include "../sf_interface/sf_interface.h"
 
 //----------------------------------------------------------------------------//
-// Choose between using AoSoA or AoS data layout for the particles.
+// Choose between using AoSoA, compact or AoS data layout for the particles.
 //----------------------------------------------------------------------------//
 
+#if defined(VPIC_USE_AOSOA_P)
+#include "species_advance_aosoa.h"
+#elif defined(VPIC_USE_COMPACT_P)
+#include "species_advance_compact.h"
+#else
 #include "species_advance_aos.h"
+#endif
 
 //----------------------------------------------------------------------------//
 // Declare methods.
@@ -54,8 +60,15 @@ species( const char * name,
          size_t max_local_nm,
          int sort_interval,
          int sort_out_of_place,
+         int subcycle,
          grid_t * g );
 
+// Moves the particles into a new particle array first touched by the
+// pipelines that push them (see CLEAR_PIPELINES).
+
+void
+home_species( species_t * sp );
+
 // FIXME: TEMPORARY HACK UNTIL THIS SPECIES_ADVANCE KERNELS
 // CAN BE CONSTRUCTED ANALOGOUS TO THE FIELD_ADVANCE KERNELS
 // (THESE FUNCTIONS ARE NECESSARY FOR HIGHER LEVEL CODE)
@@ -68,6 +81,26 @@ sort_p( species_t * RESTRICT sp );
 void
 sort_p_pipeline( species_t * sp );
 
+// Adaptive sorting of species with a negative sort_interval.
+// adaptive_sort_p sorts sp if that is cheaper than the advance_p slowdown
+// it fixes and returns 1 if it did.  update_adaptive_sort_p is given the
+// time taken by the last advance_p of sp.  report_adaptive_sort_p logs the
+// decisions since the last report (if dump) and resets the counts.  As
+// sorting is decided locally, species used by binary collision models
+// (which require sorting on the steps they are applied) should not be
+// sorted adaptively.
+
+int
+adaptive_sort_p( species_t * sp );
+
+void
+update_adaptive_sort_p( species_t * sp,
+                        double t_push );
+
+void
+report_adaptive_sort_p( species_t * sp_list,
+                        int dump );
+
 // In advance_p.cxx
 
 void
@@ -75,10 +108,46 @@ advance_p( species_t * RESTRICT sp,
            accumulator_array_t * RESTRICT aa,
            const interpolator_array_t * RESTRICT ia );
 
-void
+// advance_p_moments is advance_p on a diagnostic step.  Along with the
+// push, it adds the hydro moments of the particles to ha (if not NULL)
+// and returns their kinetic energy.  These are the same as
+// accumulate_hydro_p and energy_p give before the push, computed in the
+// same pass over the particles.  All nodes get the same energy.
+
+double
+advance_p_moments( species_t * RESTRICT sp,
+                   accumulator_array_t * RESTRICT aa,
+                   const interpolator_array_t * RESTRICT ia,
+                   hydro_array_t * RESTRICT ha );
+
+double
 advance_p_pipeline( species_t * RESTRICT sp,
                     accumulator_array_t * RESTRICT aa,
-                    const interpolator_array_t * RESTRICT ia );
+                    const interpolator_array_t * RESTRICT ia,
+                    hydro_array_t * RESTRICT ha,
+                    int moments );
+
+// Orbit averaged current of subcycled species.  A species with a subcycle
+// interval N>1 is pushed every N steps with an N times larger step, on the
+// steps after the multiples of N (see SUBCYCLE_PUSH_STEP).
+// store_subcycle_p saves 1/N of the current in aa (which must hold only the
+// reduced current of that push) in the species and accumulate_subcycle_p
+// adds the saved current of sp to the reduced current in aa.  The latter is
+// done every step such that the current of a push is spread evenly over the
+// steps until the next push.  Thus, the current of a push has been deposited
+// in full by the next multiple of N, where the charge of the species is
+// conserved again.
+
+#define SUBCYCLE_PUSH_STEP(sp,step) \
+  ( ( (step) % (sp)->subcycle ) == ( 1 % (sp)->subcycle ) )
+
+void
+store_subcycle_p( species_t * RESTRICT sp,
+                  const accumulator_array_t * RESTRICT aa );
+
+void
+accumulate_subcycle_p( accumulator_array_t * RESTRICT aa,
+                       const species_t * RESTRICT sp );
 
 // In center_p.cxx
 
@@ -129,12 +198,24 @@ void
 accumulate_rho_p( field_array_t * RESTRICT fa,
                   const species_t * RESTRICT sp );
 
+void
+accumulate_rho_p_pipeline( field_array_t * RESTRICT fa,
+                           const species_t * RESTRICT sp );
+
 void
 accumulate_rhob( field_t * RESTRICT ALIGNED(128) f,
                  const particle_t * RESTRICT ALIGNED(32)  p,
                  const grid_t * RESTRICT g,
                  const float qsp );
 
+void
+accumulate_rhob_movers( field_array_t * RESTRICT fa,
+                        const species_t * RESTRICT sp );
+
+void
+accumulate_rhob_movers_pipeline( field_array_t * RESTRICT fa,
+                                 const species_t * RESTRICT sp );
+
 // In hydro_p.c
 
 void
@@ -142,15 +223,49 @@ accumulate_hydro_p( hydro_array_t * RESTRICT ha,
                     const species_t * RESTRICT sp,
                     const interpolator_array_t * RESTRICT ia );
 
+void
+accumulate_hydro_p_pipeline( hydro_array_t * RESTRICT ha,
+                             const species_t * RESTRICT sp,
+                             const interpolator_array_t * RESTRICT ia );
+
 // In move_p.cxx
 
 int
-move_p( particle_t       * ALIGNED(128) p0,    // Particle array
+move_p( particle_block_t * ALIGNED(128) p0,    // Particle array
         particle_mover_t * ALIGNED(16)  m,     // Particle mover to apply
         accumulator_t    * ALIGNED(128) a0,    // Accumulator to use
         const grid_t     *              g,     // Grid parameters
         const float                     qsp ); // Species particle charge
 
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+
+// Same as move_p, but a particle that crosses into a local voxel that is
+// not adjacent to the voxel it leaves (e.g. through a periodic boundary) is
+// stopped on the face it crossed, as if it hit a boundary.  Used with tile
+// accumulators, which only cover the voxels near the particles.
+
+int
+move_p_tile( particle_block_t * ALIGNED(128) p0,
+             particle_mover_t * ALIGNED(16)  m,
+             accumulator_t    * ALIGNED(128) a0,
+             const grid_t     *              g,
+             const float                     qsp );
+
+#endif
+
+#if defined(VPIC_USE_COMPACT_P)
+
+// Move the particle p, which a move left in voxel, to the closest position
+// a compact particle can store and accumulate the current of this streak.
+
+void
+snap_p( particle_t    * ALIGNED(32)  p,     // Particle to snap
+        accumulator_t * ALIGNED(128) a0,    // Accumulator to use
+        const float                  qsp,   // Species particle charge
+        const int32_t                voxel ); // Voxel of the particle
+
+#endif
+
 END_C_DECLS
 
 #endif // _species_advance_h_
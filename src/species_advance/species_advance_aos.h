@@ -31,16 +31,29 @@ typedef struct particle {
   float w;          // Particle weight (number of physical particles)
 } particle_t;
 
+// In the AoS layout, a particle block holds a single particle.
+
+#define PARTICLE_LAYOUT_AOS 1
+
+#define PARTICLE_BLOCK_SIZE 1
+
+#define PARTICLE_BLOCKS(n) (n)
+
+typedef particle_t particle_block_t;
+
 // WARNING: FUNCTIONS THAT USE A PARTICLE_MOVER ASSUME THAT EVERYBODY
 // WHO USES THAT PARTICLE MOVER WILL HAVE ACCESS TO PARTICLE ARRAY
 
 typedef struct particle_mover {
   float dispx, dispy, dispz; // Displacement of particle
-  int32_t i;                 // Index of the particle to move
+  int32_t pad0;              // (Keeps the displacement a 4-vector)
+  int64_t i;                 // Index of the particle to move
+  int64_t pad1;              // (Keeps movers 16-byte aligned)
 } particle_mover_t;
 
 // NOTE: THE LAYOUT OF A PARTICLE_INJECTOR _MUST_ BE COMPATIBLE WITH
-// THE CONCATENATION OF A PARTICLE_T AND A PARTICLE_MOVER!
+// THE CONCATENATION OF A PARTICLE_T AND THE DISPLACEMENT OF A
+// PARTICLE_MOVER!  (sp_id takes the place of the mover pad0.)
 
 typedef struct particle_injector {
   float dx, dy, dz;          // Particle position in cell coords (on [-1,1])
@@ -56,17 +69,34 @@ typedef struct species {
   float q;                            // Species particle charge
   float m;                            // Species particle rest mass
 
-  int np, max_np;                     // Number and max local particles
+  int64_t np, max_np;                 // Number and max local particles
   particle_t * ALIGNED(128) p;        // Array of particles for the species
 
-  int nm, max_nm;                     // Number and max local movers in use
+  int64_t nm, max_nm;                 // Number and max local movers in use
   particle_mover_t * ALIGNED(128) pm; // Particle movers
 
   int64_t last_sorted;                // Step when the particles were last
                                       // sorted.
   int sort_interval;                  // How often to sort the species
+  /**/                                // (<0: adaptively, see sort_p.c)
   int sort_out_of_place;              // Sort method
-  int * ALIGNED(128) partition;       // Static array indexed 0:
+  int64_t n_far;                      // Adaptive sort state: far particles
+  int n_sort;                         // in the last advance_p, sorts since
+  double sort_cost;                   // the last profile update, last sort
+  double far_ref, push_ref;           // time, far fraction and advance_p
+  double push_excess;                 // time per particle after it and
+  /**/                                // advance_p slowdown since.
+  int64_t wide_tiles;                 // last_sorted when the accumulator
+  /**/                                // tiles of the species last covered
+  /**/                                // most of the grid (see
+  /**/                                // advance_p_tiles_pipeline)
+  int subcycle;                       // Push every subcycle steps with a
+  /**/                                // subcycle times larger step (1: push
+  /**/                                // every step)
+  accumulator_t * ALIGNED(128) sub_a; // Current of the last push spread over
+  /**/                                // the steps until the next one
+  /**/                                // (subcycle>1, NULL otherwise)
+  int64_t * ALIGNED(128) partition;   // Static array indexed 0:
   /**/                                // (nx+2)*(ny+2)*(nz+2).  Each value
   /**/                                // corresponds to the associated particle
   /**/                                // array index of the first particle in
@@ -85,12 +115,53 @@ typedef struct species {
   /**/                                //          sp->partition[ j+1 ] ]
   /**/                                // are all the particles in voxel
   /**/                                // with space filling curve index j.
-  /**/                                // Note: SFC NOT IN USE RIGHT NOW THUS
-  /**/                                // g->sfc[i]=i ABOVE.
+  /**/                                // Note: g->sfc[i]=i for the default
+  /**/                                // fortran_sfc (see set_sfc).
 
   grid_t * g;                         // Underlying grid
   species_id id;                      // Unique identifier for a species
   struct species *next;               // Next species in the list
 } species_t;
 
+//----------------------------------------------------------------------------//
+// Particle accessors.  Code that is not specific to a particle layout should
+// access individual particles through these.
+//----------------------------------------------------------------------------//
+
+// Voxel index of particle n (an lvalue).
+
+#define PARTICLE_VOXEL(p,n) ( (p)[n].i )
+
+// Copy particle n of particle array p into q.
+
+STATIC_INLINE void
+load_particle( const particle_block_t * RESTRICT p,
+               int64_t n,
+               particle_t * RESTRICT q )
+{
+  *q = p[n];
+}
+
+// Copy q into particle n of particle array p.
+
+STATIC_INLINE void
+store_particle( const particle_t * RESTRICT q,
+                particle_block_t * RESTRICT p,
+                int64_t n )
+{
+  p[n] = *q;
+}
+
+// Copy particle i of particle array src into particle j of particle array
+// dst.  The arrays may be the same.
+
+STATIC_INLINE void
+copy_particle( particle_block_t * dst,
+               int64_t j,
+               const particle_block_t * src,
+               int64_t i )
+{
+  dst[j] = src[i];
+}
+
 #endif // _species_advance_aos_h_
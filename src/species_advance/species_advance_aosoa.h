@@ -0,0 +1,195 @@
+#ifndef _species_advance_aosoa_h_
+#define _species_advance_aosoa_h_
+
+typedef int32_t species_id; // Must be 32-bit wide for particle_injector_t
+
+//----------------------------------------------------------------------------//
+// Particles are stored in blocks of PARTICLE_BLOCK_SIZE particles.  Within a
+// block, each particle component is stored contiguously such that a block
+// can be loaded into vector registers with aligned loads instead of the
+// transposing loads needed by the AoS layout.  The block size matches the
+// widest vector length enabled in the build, including kernels selected at
+// runtime.
+//----------------------------------------------------------------------------//
+
+#define PARTICLE_LAYOUT_AOS 0
+
+#if defined(USE_V16_PORTABLE) || \
+    defined(USE_V16_AVX512)   || \
+    defined(VPIC_DISPATCH_V16)
+
+#define PARTICLE_BLOCK_SIZE 16
+
+#else
+
+#define PARTICLE_BLOCK_SIZE 8
+
+#endif
+
+// Number of particle blocks needed to hold n particles.
+
+#define PARTICLE_BLOCKS(n) ( ( (n) + PARTICLE_BLOCK_SIZE - 1 ) / \
+                             PARTICLE_BLOCK_SIZE )
+
+// A single particle.  This is the interchange format used to load, store,
+// inject and communicate individual particles.
+
+typedef struct particle {
+  float dx, dy, dz; // Particle position in cell coordinates (on [-1,1])
+  int32_t i;        // Voxel containing the particle.  Note that
+  /**/              // particles awaiting processing by boundary_p
+  /**/              // have actually set this to 8*voxel + face where
+  /**/              // face is the index of the face they interacted
+  /**/              // with (on 0:5).  This limits the local number of
+  /**/              // voxels to 2^28 but emitter handling already
+  /**/              // has a stricter limit on this (2^26).
+  float ux, uy, uz; // Particle normalized momentum
+  float w;          // Particle weight (number of physical particles)
+} particle_t;
+
+typedef struct particle_block {
+  float   dx[PARTICLE_BLOCK_SIZE]; // Particle positions in cell coordinates
+  float   dy[PARTICLE_BLOCK_SIZE];
+  float   dz[PARTICLE_BLOCK_SIZE];
+  int32_t  i[PARTICLE_BLOCK_SIZE]; // Voxels containing the particles
+  float   ux[PARTICLE_BLOCK_SIZE]; // Particle normalized momenta
+  float   uy[PARTICLE_BLOCK_SIZE];
+  float   uz[PARTICLE_BLOCK_SIZE];
+  float    w[PARTICLE_BLOCK_SIZE]; // Particle weights
+} particle_block_t;
+
+// WARNING: FUNCTIONS THAT USE A PARTICLE_MOVER ASSUME THAT EVERYBODY
+// WHO USES THAT PARTICLE MOVER WILL HAVE ACCESS TO PARTICLE ARRAY
+
+typedef struct particle_mover {
+  float dispx, dispy, dispz; // Displacement of particle
+  int32_t pad0;              // (Keeps the displacement a 4-vector)
+  int64_t i;                 // Index of the particle to move
+  int64_t pad1;              // (Keeps movers 16-byte aligned)
+} particle_mover_t;
+
+// NOTE: THE LAYOUT OF A PARTICLE_INJECTOR _MUST_ BE COMPATIBLE WITH
+// THE CONCATENATION OF A PARTICLE_T AND THE DISPLACEMENT OF A
+// PARTICLE_MOVER!  (sp_id takes the place of the mover pad0.)
+
+typedef struct particle_injector {
+  float dx, dy, dz;          // Particle position in cell coords (on [-1,1])
+  int32_t i;                 // Index of cell containing the particle
+  float ux, uy, uz;          // Particle normalized momentum
+  float w;                   // Particle weight (number of physical particles)
+  float dispx, dispy, dispz; // Displacement of particle
+  species_id sp_id;          // Species of particle
+} particle_injector_t;
+
+typedef struct species {
+  char * name;                        // Species name
+  float q;                            // Species particle charge
+  float m;                            // Species particle rest mass
+
+  int64_t np, max_np;                 // Number and max local particles
+  particle_block_t * ALIGNED(128) p;  // Particle blocks for the species.
+  /**/                                // Particle n is in lane
+  /**/                                // n%PARTICLE_BLOCK_SIZE of block
+  /**/                                // n/PARTICLE_BLOCK_SIZE.
+
+  int64_t nm, max_nm;                 // Number and max local movers in use
+  particle_mover_t * ALIGNED(128) pm; // Particle movers
+
+  int64_t last_sorted;                // Step when the particles were last
+                                      // sorted.
+  int sort_interval;                  // How often to sort the species
+  /**/                                // (<0: adaptively, see sort_p.c)
+  int sort_out_of_place;              // Sort method
+  int64_t n_far;                      // Adaptive sort state: far particles
+  int n_sort;                         // in the last advance_p, sorts since
+  double sort_cost;                   // the last profile update, last sort
+  double far_ref, push_ref;           // time, far fraction and advance_p
+  double push_excess;                 // time per particle after it and
+  /**/                                // advance_p slowdown since.
+  int64_t wide_tiles;                 // last_sorted when the accumulator
+  /**/                                // tiles of the species last covered
+  /**/                                // most of the grid (see
+  /**/                                // advance_p_tiles_pipeline)
+  int subcycle;                       // Push every subcycle steps with a
+  /**/                                // subcycle times larger step (1: push
+  /**/                                // every step)
+  accumulator_t * ALIGNED(128) sub_a; // Current of the last push spread over
+  /**/                                // the steps until the next one
+  /**/                                // (subcycle>1, NULL otherwise)
+  int64_t * ALIGNED(128) partition;   // Static array indexed 0:
+  /**/                                // (nx+2)*(ny+2)*(nz+2).  Each value
+  /**/                                // corresponds to the associated particle
+  /**/                                // array index of the first particle in
+  /**/                                // the cell.  See species_advance_aos.h.
+
+  grid_t * g;                         // Underlying grid
+  species_id id;                      // Unique identifier for a species
+  struct species *next;               // Next species in the list
+} species_t;
+
+//----------------------------------------------------------------------------//
+// Particle accessors.  Code that is not specific to a particle layout should
+// access individual particles through these.
+//----------------------------------------------------------------------------//
+
+// Voxel index of particle n (an lvalue).
+
+#define PARTICLE_VOXEL(p,n) \
+  ( (p)[ (n) / PARTICLE_BLOCK_SIZE ].i[ (n) % PARTICLE_BLOCK_SIZE ] )
+
+// Copy particle n of particle array p into q.
+
+STATIC_INLINE void
+load_particle( const particle_block_t * RESTRICT p,
+               int64_t n,
+               particle_t * RESTRICT q )
+{
+  const int64_t b = n / PARTICLE_BLOCK_SIZE;
+  const int     l = n % PARTICLE_BLOCK_SIZE;
+
+  q->dx = p[b].dx[l];
+  q->dy = p[b].dy[l];
+  q->dz = p[b].dz[l];
+  q->i  = p[b].i [l];
+  q->ux = p[b].ux[l];
+  q->uy = p[b].uy[l];
+  q->uz = p[b].uz[l];
+  q->w  = p[b].w [l];
+}
+
+// Copy q into particle n of particle array p.
+
+STATIC_INLINE void
+store_particle( const particle_t * RESTRICT q,
+                particle_block_t * RESTRICT p,
+                int64_t n )
+{
+  const int64_t b = n / PARTICLE_BLOCK_SIZE;
+  const int     l = n % PARTICLE_BLOCK_SIZE;
+
+  p[b].dx[l] = q->dx;
+  p[b].dy[l] = q->dy;
+  p[b].dz[l] = q->dz;
+  p[b].i [l] = q->i;
+  p[b].ux[l] = q->ux;
+  p[b].uy[l] = q->uy;
+  p[b].uz[l] = q->uz;
+  p[b].w [l] = q->w;
+}
+
+// Copy particle i of particle array src into particle j of particle array
+// dst.  The arrays may be the same.
+
+STATIC_INLINE void
+copy_particle( particle_block_t * dst,
+               int64_t j,
+               const particle_block_t * src,
+               int64_t i )
+{
+  particle_t q;
+
+  load_particle( src, i, &q );
+  store_particle( &q, dst, j );
+}
+
+#endif // _species_advance_aosoa_h_
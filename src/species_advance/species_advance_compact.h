@@ -0,0 +1,289 @@
+#ifndef _species_advance_compact_h_
+#define _species_advance_compact_h_
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+typedef int32_t species_id; // Must be 32-bit wide for particle_injector_t
+
+//----------------------------------------------------------------------------//
+// Particles are stored in a compact format that is decoded to and encoded from
+// the particle_t interchange format by the particle accessors.  Positions are
+// stored in fixed point with PARTICLE_OFFSET_BITS fractional bits and
+// particles have unit weight implicitly.  Momenta are stored as floats or,
+// when VPIC_USE_COMPACT_P_FP16_MOMENTUM is defined, as IEEE half precision
+// floats.  A uniform weight is folded into the charge and mass of a species,
+// i.e. a species of physical charge q and mass m with particle weight w is
+// defined with charge q*w and mass m*w and its particles are injected with
+// unit weight.  The dynamics, which only depend on q/m, are unchanged.
+//----------------------------------------------------------------------------//
+
+#define PARTICLE_LAYOUT_AOS 0
+
+#define PARTICLE_BLOCK_SIZE 1
+
+#define PARTICLE_BLOCKS(n) (n)
+
+#define PARTICLE_OFFSET_BITS 14
+
+// A single particle.  This is the interchange format used to load, store,
+// inject and communicate individual particles.
+
+typedef struct particle {
+  float dx, dy, dz; // Particle position in cell coordinates (on [-1,1])
+  int32_t i;        // Voxel containing the particle.  Note that
+  /**/              // particles awaiting processing by boundary_p
+  /**/              // have actually set this to 8*voxel + face where
+  /**/              // face is the index of the face they interacted
+  /**/              // with (on 0:5).  This limits the local number of
+  /**/              // voxels to 2^28 but emitter handling already
+  /**/              // has a stricter limit on this (2^26).
+  float ux, uy, uz; // Particle normalized momentum
+  float w;          // Particle weight (number of physical particles)
+} particle_t;
+
+#if defined(VPIC_USE_COMPACT_P_FP16_MOMENTUM)
+
+typedef struct particle_block {
+  int16_t dx, dy, dz;  // Particle position in cell coordinates times
+  /**/                 // 2^PARTICLE_OFFSET_BITS
+  uint16_t ux, uy, uz; // Particle normalized momentum (IEEE half)
+  int32_t i;           // Voxel containing the particle
+} particle_block_t;    // 16 bytes
+
+#else
+
+typedef struct particle_block {
+  int16_t dx, dy, dz;  // Particle position in cell coordinates times
+  /**/                 // 2^PARTICLE_OFFSET_BITS
+  int16_t pad;         // (Keeps the momentum 4-byte aligned)
+  int32_t i;           // Voxel containing the particle
+  float ux, uy, uz;    // Particle normalized momentum
+} particle_block_t;    // 24 bytes
+
+#endif
+
+// WARNING: FUNCTIONS THAT USE A PARTICLE_MOVER ASSUME THAT EVERYBODY
+// WHO USES THAT PARTICLE MOVER WILL HAVE ACCESS TO PARTICLE ARRAY
+
+typedef struct particle_mover {
+  float dispx, dispy, dispz; // Displacement of particle
+  int32_t pad0;              // (Keeps the displacement a 4-vector)
+  int64_t i;                 // Index of the particle to move
+  int64_t pad1;              // (Keeps movers 16-byte aligned)
+} particle_mover_t;
+
+// NOTE: THE LAYOUT OF A PARTICLE_INJECTOR _MUST_ BE COMPATIBLE WITH
+// THE CONCATENATION OF A PARTICLE_T AND THE DISPLACEMENT OF A
+// PARTICLE_MOVER!  (sp_id takes the place of the mover pad0.)
+
+typedef struct particle_injector {
+  float dx, dy, dz;          // Particle position in cell coords (on [-1,1])
+  int32_t i;                 // Index of cell containing the particle
+  float ux, uy, uz;          // Particle normalized momentum
+  float w;                   // Particle weight (number of physical particles)
+  float dispx, dispy, dispz; // Displacement of particle
+  species_id sp_id;          // Species of particle
+} particle_injector_t;
+
+typedef struct species {
+  char * name;                        // Species name
+  float q;                            // Species particle charge
+  float m;                            // Species particle rest mass
+
+  int64_t np, max_np;                 // Number and max local particles
+  particle_block_t * ALIGNED(128) p;  // Compact particles for the species
+
+  int64_t nm, max_nm;                 // Number and max local movers in use
+  particle_mover_t * ALIGNED(128) pm; // Particle movers
+
+  int64_t last_sorted;                // Step when the particles were last
+                                      // sorted.
+  int sort_interval;                  // How often to sort the species
+  /**/                                // (<0: adaptively, see sort_p.c)
+  int sort_out_of_place;              // Sort method
+  int64_t n_far;                      // Adaptive sort state: far particles
+  int n_sort;                         // in the last advance_p, sorts since
+  double sort_cost;                   // the last profile update, last sort
+  double far_ref, push_ref;           // time, far fraction and advance_p
+  double push_excess;                 // time per particle after it and
+  /**/                                // advance_p slowdown since.
+  int64_t wide_tiles;                 // last_sorted when the accumulator
+  /**/                                // tiles of the species last covered
+  /**/                                // most of the grid (see
+  /**/                                // advance_p_tiles_pipeline)
+  int subcycle;                       // Push every subcycle steps with a
+  /**/                                // subcycle times larger step (1: push
+  /**/                                // every step)
+  accumulator_t * ALIGNED(128) sub_a; // Current of the last push spread over
+  /**/                                // the steps until the next one
+  /**/                                // (subcycle>1, NULL otherwise)
+  int64_t * ALIGNED(128) partition;   // Static array indexed 0:
+  /**/                                // (nx+2)*(ny+2)*(nz+2).  Each value
+  /**/                                // corresponds to the associated particle
+  /**/                                // array index of the first particle in
+  /**/                                // the cell.  See species_advance_aos.h.
+
+  grid_t * g;                         // Underlying grid
+  species_id id;                      // Unique identifier for a species
+  struct species *next;               // Next species in the list
+} species_t;
+
+//----------------------------------------------------------------------------//
+// Conversions between the stored and the interchange particle components.
+// The offset scale is a power of two such that decoding is exact and cell
+// faces (+/-1) are represented exactly.
+//----------------------------------------------------------------------------//
+
+STATIC_INLINE int16_t
+encode_offset( float x )
+{
+  x *= (float)( 1 << PARTICLE_OFFSET_BITS );
+
+  return (int16_t)( x < 0 ? x - 0.5f : x + 0.5f );
+}
+
+STATIC_INLINE float
+decode_offset( int16_t x )
+{
+  return (float)x * ( 1.0f / (float)( 1 << PARTICLE_OFFSET_BITS ) );
+}
+
+// The stored value closest to the offset x.  Code moving particles uses
+// this to deposit current consistent with the stored positions.
+
+#define SNAP_OFFSET(x) decode_offset( encode_offset( x ) )
+
+#if defined(VPIC_USE_COMPACT_P_FP16_MOMENTUM)
+
+// Round to nearest even conversions between float and IEEE half.
+
+STATIC_INLINE uint16_t
+encode_momentum( float x )
+{
+# if defined(__F16C__)
+  return _cvtss_sh( x, 0 );
+# else
+  union { float f; uint32_t u; } v;
+  uint32_t s, e, m, r, h;
+
+  v.f = x;
+  s   = ( v.u >> 16 ) & 0x8000;
+  e   = ( v.u >> 23 ) & 0xff;
+  m   =   v.u         & 0x7fffff;
+
+  if ( e == 0xff )                               // Inf or NaN
+    return s | 0x7c00 | ( m ? 0x200 : 0 );
+
+  if ( e >= 127 + 16 )                           // Overflow
+    return s | 0x7c00;
+
+  if ( e <= 127 - 15 )                           // Subnormal or zero
+  {
+    if ( e < 127 - 25 ) return s;
+
+    m |= 0x800000;
+    e  = 126 - e;                                // Shift on 14:24
+    h  = m >> e;
+    r  = m & ( ( 1u << e ) - 1 );
+    m  = 1u << ( e - 1 );
+
+    return s | ( h + ( r > m || ( r == m && ( h & 1 ) ) ) );
+  }
+
+  h = s | ( ( e - 127 + 15 ) << 10 ) | ( m >> 13 );
+  r = m & 0x1fff;
+
+  return h + ( r > 0x1000 || ( r == 0x1000 && ( h & 1 ) ) );
+# endif
+}
+
+STATIC_INLINE float
+decode_momentum( uint16_t x )
+{
+# if defined(__F16C__)
+  return _cvtsh_ss( x );
+# else
+  union { float f; uint32_t u; } v;
+  uint32_t s, e, m;
+
+  s = ( (uint32_t) x & 0x8000 ) << 16;
+  e = ( x >> 10 ) & 0x1f;
+  m =   x         & 0x3ff;
+
+  if      ( e == 0x1f ) v.u = s | 0x7f800000 | ( m << 13 );
+  else if ( e )         v.u = s | ( ( e + 127 - 15 ) << 23 ) | ( m << 13 );
+  else
+  {
+    v.f  = (float) m * 5.9604644775390625e-8f;   // m 2^-24
+    v.u |= s;
+  }
+
+  return v.f;
+# endif
+}
+
+#else
+
+#define encode_momentum(x) (x)
+#define decode_momentum(x) (x)
+
+#endif
+
+//----------------------------------------------------------------------------//
+// Particle accessors.  Code that is not specific to a particle layout should
+// access individual particles through these.
+//----------------------------------------------------------------------------//
+
+// Voxel index of particle n (an lvalue).
+
+#define PARTICLE_VOXEL(p,n) ( (p)[n].i )
+
+// Copy particle n of particle array p into q.
+
+STATIC_INLINE void
+load_particle( const particle_block_t * RESTRICT p,
+               int64_t n,
+               particle_t * RESTRICT q )
+{
+  q->dx = decode_offset( p[n].dx );
+  q->dy = decode_offset( p[n].dy );
+  q->dz = decode_offset( p[n].dz );
+  q->i  = p[n].i;
+  q->ux = decode_momentum( p[n].ux );
+  q->uy = decode_momentum( p[n].uy );
+  q->uz = decode_momentum( p[n].uz );
+  q->w  = 1;
+}
+
+// Copy q into particle n of particle array p.  The weight of q is not
+// stored (it must be 1).
+
+STATIC_INLINE void
+store_particle( const particle_t * RESTRICT q,
+                particle_block_t * RESTRICT p,
+                int64_t n )
+{
+  p[n].dx = encode_offset( q->dx );
+  p[n].dy = encode_offset( q->dy );
+  p[n].dz = encode_offset( q->dz );
+  p[n].i  = q->i;
+  p[n].ux = encode_momentum( q->ux );
+  p[n].uy = encode_momentum( q->uy );
+  p[n].uz = encode_momentum( q->uz );
+}
+
+// Copy particle i of particle array src into particle j of particle array
+// dst.  The arrays may be the same.
+
+STATIC_INLINE void
+copy_particle( particle_block_t * dst,
+               int64_t j,
+               const particle_block_t * src,
+               int64_t i )
+{
+  dst[j] = src[i];
+}
+
+#endif // _species_advance_compact_h_
@@ -13,7 +13,92 @@ advance_p( species_t * RESTRICT sp,
            accumulator_array_t * RESTRICT aa,
            const interpolator_array_t * RESTRICT ia )
 {
+  double t = 0;
+
+  // Adaptively sorted species need the advance_p time.
+  if ( sp->sort_interval < 0 )
+  {
+    t = wallclock();
+  }
+
   // Once more options are available, this should be conditionally executed
   // based on user choice.
-  advance_p_pipeline( sp, aa, ia );
+  advance_p_pipeline( sp, aa, ia, NULL, 0 );
+
+  if ( sp->sort_interval < 0 )
+  {
+    update_adaptive_sort_p( sp, wallclock() - t );
+  }
+}
+
+// The extra work on diagnostic steps is not timed for adaptive sorting.
+
+double
+advance_p_moments( species_t * RESTRICT sp,
+                   accumulator_array_t * RESTRICT aa,
+                   const interpolator_array_t * RESTRICT ia,
+                   hydro_array_t * RESTRICT ha )
+{
+  return advance_p_pipeline( sp, aa, ia, ha, 1 );
+}
+
+//----------------------------------------------------------------------------//
+// Orbit averaged current of subcycled species.  These are done by the host
+// as they only touch one accumulator per voxel.
+//----------------------------------------------------------------------------//
+
+void
+store_subcycle_p( species_t * RESTRICT sp,
+                  const accumulator_array_t * RESTRICT aa )
+{
+  const accumulator_t * RESTRICT ALIGNED(128) a;
+  accumulator_t * RESTRICT ALIGNED(128) s;
+  float r;
+  int v, n;
+
+  if ( !sp || !aa || sp->g != aa->g || !sp->sub_a )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  a = aa->a;
+  s = sp->sub_a;
+  r = 1.0f / (float) sp->subcycle;
+
+  for( v = 0; v < sp->g->nv; v++ )
+  {
+    for( n = 0; n < 4; n++ )
+    {
+      s[v].jx[n] = r * a[v].jx[n];
+      s[v].jy[n] = r * a[v].jy[n];
+      s[v].jz[n] = r * a[v].jz[n];
+    }
+  }
+}
+
+void
+accumulate_subcycle_p( accumulator_array_t * RESTRICT aa,
+                       const species_t * RESTRICT sp )
+{
+  accumulator_t * RESTRICT ALIGNED(128) a;
+  const accumulator_t * RESTRICT ALIGNED(128) s;
+  int v, n;
+
+  if ( !sp || !aa || sp->g != aa->g || !sp->sub_a )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  a = aa->a;
+  s = sp->sub_a;
+
+  for( v = 0; v < sp->g->nv; v++ )
+  {
+    for( n = 0; n < 4; n++ )
+    {
+      a[v].jx[n] += s[v].jx[n];
+      a[v].jy[n] += s[v].jy[n];
+      a[v].jz[n] += s[v].jz[n];
+    }
+  }
 }
@@ -27,12 +27,13 @@
 
 using namespace v4;
 
-int
-move_p( particle_t       * RESTRICT ALIGNED(128) p,
-        particle_mover_t * RESTRICT ALIGNED(16)  pm,
-        accumulator_t    * RESTRICT ALIGNED(128) a,
-        const grid_t     *                       g,
-        const float                              qsp ) {
+static inline int
+move_particle( particle_t       * RESTRICT ALIGNED(32)  p,
+               particle_mover_t * RESTRICT ALIGNED(16)  pm,
+               accumulator_t    * RESTRICT ALIGNED(128) a,
+               const grid_t     *                       g,
+               const float                              qsp,
+               const int                                tile ) {
 
   /*const*/ v4float one( 1.f );
   /*const*/ v4float tiny( 1e-37f );
@@ -46,13 +47,13 @@ move_p( particle_t       * RESTRICT ALIGNED(128) p,
   float * RESTRICT ALIGNED(16) stack_vf = (float *)&_stack_vf;
   int   * RESTRICT ALIGNED(16) stack_vi =   (int *)&_stack_vi;
   float f0, f1;
-  int32_t n, voxel;
-  int64_t neighbor;
+  int64_t n, neighbor;
+  int32_t voxel;
   int type;
 
   load_4x1( &pm->dispx, dr );  n     = pm->i;
-  load_4x1( &p[n].dx,   r  );  voxel = p[n].i;
-  load_4x1( &p[n].ux,   u  );
+  load_4x1( &p->dx,     r  );  voxel = p->i;
+  load_4x1( &p->ux,     u  );
 
   q  = v4float(qsp)*splat<3>(u); // q  = p_q,   p_q,   p_q,   D/C
   q3 = v4float(1.f/3.f)*q;      // q3 = p_q/3, p_q/3, p_q/3, D/C
@@ -149,7 +150,7 @@ move_p( particle_t       * RESTRICT ALIGNED(128) p,
     // was succesfully processed.  Should be just under ~50% of the
     // time.
 
-    if( type==3 ) { store_4x1( r, &p[n].dx ); p[n].i = voxel; break; }
+    if( type==3 ) { store_4x1( r, &p->dx ); p->i = voxel; break; }
 
     // Streak terminated on a voxel face.  Determine if the particle
     // crossed into a local voxel or if it hit a boundary.  Convert
@@ -185,7 +186,7 @@ move_p( particle_t       * RESTRICT ALIGNED(128) p,
 
       dr = toggle_bits( bits, dr );
       u  = toggle_bits( bits, u  );
-      store_4x1( u, &p[n].ux );
+      store_4x1( u, &p->ux );
       continue;
     }
 
@@ -195,10 +196,24 @@ move_p( particle_t       * RESTRICT ALIGNED(128) p,
       // particle position and update the remaining displacement in
       // the particle mover.
 
-      store_4x1( r, &p[n].dx );    p[n].i = 8*voxel + type;
+      store_4x1( r, &p->dx );      p->i   = 8*voxel + type;
+      store_4x1( dr, &pm->dispx ); pm->i  = n;
+      return 1; // Mover still in use
+    }
+
+#   if defined(VPIC_USE_TILE_ACCUMULATORS)
+    if( UNLIKELY( tile &&
+                  neighbor - g->rangel !=
+                  voxel + ( type<3 ? -1 : 1 )*(&g->sx)[type%3] ) ) {
+
+      // Crossed into a voxel that might not be in the tile.  Stop the
+      // particle on the face as above.
+
+      store_4x1( r, &p->dx );      p->i   = 8*voxel + type;
       store_4x1( dr, &pm->dispx ); pm->i  = n;
       return 1; // Mover still in use
     }
+#   endif
 
     // Crossed into a normal voxel.  Update the voxel index, convert the
     // particle coordinate system and keep moving the particle.
@@ -212,12 +227,13 @@ move_p( particle_t       * RESTRICT ALIGNED(128) p,
 
 #else
 
-int
-move_p( particle_t       * ALIGNED(128) p0,
-        particle_mover_t * ALIGNED(16)  pm,
-        accumulator_t    * ALIGNED(128) a0,
-        const grid_t     *              g,
-        const float                     qsp ) {
+static inline int
+move_particle( particle_t       * ALIGNED(32)  p,
+               particle_mover_t * ALIGNED(16)  pm,
+               accumulator_t    * ALIGNED(128) a0,
+               const grid_t     *              g,
+               const float                     qsp,
+               const int                       tile ) {
   float s_midx, s_midy, s_midz;
   float s_dispx, s_dispy, s_dispz;
   float s_dir[3];
@@ -225,7 +241,6 @@ move_p( particle_t       * ALIGNED(128) p0,
   int axis, face;
   int64_t neighbor;
   float *a;
-  particle_t * ALIGNED(32) p = p0 + pm->i;
 
   q = qsp*p->w;
 
@@ -341,6 +356,17 @@ move_p( particle_t       * ALIGNED(128) p0,
       return 1; // Return "mover still in use"
     }
 
+#   if defined(VPIC_USE_TILE_ACCUMULATORS)
+    if( UNLIKELY( tile &&
+                  neighbor - g->rangel !=
+                  p->i + ( face<3 ? -1 : 1 )*(&g->sx)[axis] ) ) {
+      // Crossed into a voxel that might not be in the tile.  Stop the
+      // particle on the face as above.
+      p->i = 8*p->i + face;
+      return 1; // Return "mover still in use"
+    }
+#   endif
+
     // Crossed into a normal voxel.  Update the voxel index, convert the
     // particle coordinate system and keep moving the particle.
 
@@ -353,3 +379,117 @@ move_p( particle_t       * ALIGNED(128) p0,
 }
 
 #endif
+
+#if defined(VPIC_USE_COMPACT_P)
+
+// Compact particles store their position in fixed point.  Move the particle
+// p (which a move left in voxel, possibly on one of its faces) to the
+// closest stored position, accumulating the current of this short streak,
+// such that the current accumulated for a move matches the change of the
+// stored particle position exactly (charge conservation).  The streak stays
+// in the voxel (or the face).
+
+void
+snap_p( particle_t    * ALIGNED(32)  p,
+        accumulator_t * ALIGNED(128) a0,
+        const float                  qsp,
+        const int32_t                voxel ) {
+  float s_midx, s_midy, s_midz;
+  float s_dispx, s_dispy, s_dispz;
+  float v0, v1, v2, v3, v4, v5, q;
+  float *a;
+
+  v0 = SNAP_OFFSET( p->dx );
+  v1 = SNAP_OFFSET( p->dy );
+  v2 = SNAP_OFFSET( p->dz );
+
+  s_dispx = 0.5f*( v0 - p->dx );
+  s_dispy = 0.5f*( v1 - p->dy );
+  s_dispz = 0.5f*( v2 - p->dz );
+
+  s_midx  = p->dx + s_dispx;
+  s_midy  = p->dy + s_dispy;
+  s_midz  = p->dz + s_dispz;
+
+  p->dx = v0;
+  p->dy = v1;
+  p->dz = v2;
+
+  q  = qsp*p->w;
+  v5 = q*s_dispx*s_dispy*s_dispz*(1./3.);
+  a  = (float *)(a0 + voxel);
+# define accumulate_j(X,Y,Z)                                        \
+  v4  = q*s_disp##X;    /* v2 = q ux                            */  \
+  v1  = v4*s_mid##Y;    /* v1 = q ux dy                         */  \
+  v0  = v4-v1;          /* v0 = q ux (1-dy)                     */  \
+  v1 += v4;             /* v1 = q ux (1+dy)                     */  \
+  v4  = 1+s_mid##Z;     /* v4 = 1+dz                            */  \
+  v2  = v0*v4;          /* v2 = q ux (1-dy)(1+dz)               */  \
+  v3  = v1*v4;          /* v3 = q ux (1+dy)(1+dz)               */  \
+  v4  = 1-s_mid##Z;     /* v4 = 1-dz                            */  \
+  v0 *= v4;             /* v0 = q ux (1-dy)(1-dz)               */  \
+  v1 *= v4;             /* v1 = q ux (1+dy)(1-dz)               */  \
+  v0 += v5;             /* v0 = q ux [ (1-dy)(1-dz) + uy*uz/3 ] */  \
+  v1 -= v5;             /* v1 = q ux [ (1+dy)(1-dz) - uy*uz/3 ] */  \
+  v2 -= v5;             /* v2 = q ux [ (1-dy)(1+dz) - uy*uz/3 ] */  \
+  v3 += v5;             /* v3 = q ux [ (1+dy)(1+dz) + uy*uz/3 ] */  \
+  a[0] += v0;                                                       \
+  a[1] += v1;                                                       \
+  a[2] += v2;                                                       \
+  a[3] += v3
+  accumulate_j(x,y,z); a += 4;
+  accumulate_j(y,z,x); a += 4;
+  accumulate_j(z,x,y);
+# undef accumulate_j
+}
+
+#endif
+
+// With the AoS layout, the particle is moved in place.  Otherwise, it is
+// moved in a local AoS copy.
+
+static inline int
+move_p_block( particle_block_t * ALIGNED(128) p0,
+              particle_mover_t * ALIGNED(16)  pm,
+              accumulator_t    * ALIGNED(128) a0,
+              const grid_t     *              g,
+              const float                     qsp,
+              const int                       tile ) {
+#if PARTICLE_LAYOUT_AOS
+  return move_particle( p0 + pm->i, pm, a0, g, qsp, tile );
+#else
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
+  int ret;
+
+  load_particle( p0, pm->i, p );
+  ret = move_particle( p, pm, a0, g, qsp, tile );
+# if defined(VPIC_USE_COMPACT_P)
+  snap_p( p, a0, qsp, ret ? p->i >> 3 : p->i );
+# endif
+  store_particle( p, p0, pm->i );
+
+  return ret;
+#endif
+}
+
+int
+move_p( particle_block_t * ALIGNED(128) p0,
+        particle_mover_t * ALIGNED(16)  pm,
+        accumulator_t    * ALIGNED(128) a0,
+        const grid_t     *              g,
+        const float                     qsp ) {
+  return move_p_block( p0, pm, a0, g, qsp, 0 );
+}
+
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+
+int
+move_p_tile( particle_block_t * ALIGNED(128) p0,
+             particle_mover_t * ALIGNED(16)  pm,
+             accumulator_t    * ALIGNED(128) a0,
+             const grid_t     *              g,
+             const float                     qsp ) {
+  return move_p_block( p0, pm, a0, g, qsp, 1 );
+}
+
+#endif
@@ -21,12 +21,11 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
                            int pipeline_rank,
                            int n_pipeline )
 {
-  particle_t           * ALIGNED(128) p0 = args->p0;
+  particle_block_t     * ALIGNED(128) p0 = args->p0;
   accumulator_t        * ALIGNED(128) a0 = args->a0;
   const interpolator_t * ALIGNED(128) f0 = args->f0;
   const grid_t *                      g  = args->g;
 
-  particle_t           * ALIGNED(32)  p;
   particle_mover_t     * ALIGNED(16)  pm;
   const interpolator_t * ALIGNED(16)  f;
   float                * ALIGNED(16)  a;
@@ -45,19 +44,24 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
   float v0, v1, v2, v3, v4, v5;
   int   ii;
 
-  int itmp, n, nm, max_nm;
+  int64_t i, itmp, n, nm, max_nm;
 
-  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
+  int far = args->far, ii_far;
+
+  int64_t n_far = 0;
+
+  hydro_t * hp = pipeline_hydro_array( args->h, args->hp, args->h_stride,
+                                        pipeline_rank, n_pipeline );
 
-  // Determine which quads of particles quads this pipeline processes.
+  double en = 0.0;
 
-  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, itmp, n );
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
 
-  p = args->p0 + itmp;
+  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
 
   // Determine which movers are reserved for this pipeline.
-  // Movers (16 bytes) should be reserved for pipelines in at least
-  // multiples of 8 such that the set of particle movers reserved for
+  // Movers (32 bytes) should be reserved for pipelines in at least
+  // multiples of 4 such that the set of particle movers reserved for
   // a pipeline is 128-byte aligned and a multiple of 128-byte in
   // size.  The host is guaranteed to get enough movers to process its
   // particles with this allocation.
@@ -77,19 +81,40 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
   // Determine which accumulator array to use
   // The host gets the first accumulator array.
 
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  a0 = args->a_tile[ pipeline_rank ];
+#else
   if ( pipeline_rank != n_pipeline )
     a0 += ( 1 + pipeline_rank ) *
           POW2_CEIL( (args->nx+2)*(args->ny+2)*(args->nz+2), 2 );
+#endif
 
-  // Process particles for this pipeline.
+  // Process particles for this pipeline, one chunk of quads of particles
+  // at a time.  Particles are copied in and out of p so the same code works
+  // for all particle layouts.
 
-  for( ; n; n--, p++ )
+  FOR_EACH_ADVANCE_P_CHUNK( i, n )
+  for( ii_far = n ? PARTICLE_VOXEL( p0, i ) : 0; n; n--, i++ )
   {
+    load_particle( p0, i, p );                // Load particle
+
+    if ( args->en )                           // Diagnostic step moments
+    {
+      hydro_p_particle( hp, &en, p, f0, qdt_2mc, qsp, args->msp,
+                        args->cvac, args->r8V, args->nx, args->ny );
+    }
+
     dx   = p->dx;                             // Load position
     dy   = p->dy;
     dz   = p->dz;
     ii   = p->i;
 
+    if ( far )                                // Count far particles
+    {
+      n_far  += (unsigned)( ii - ii_far + far ) > 2u*far;
+      ii_far  = ii;
+    }
+
     f    = f0 + ii;                           // Interpolate E
 
     hax  = qdt_2mc*(    ( f->ex    + dy*f->dexdy    ) +
@@ -168,10 +193,26 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
 
       q *= qsp;
 
+#     if defined(VPIC_USE_COMPACT_P)
+      v3 = SNAP_OFFSET( v3 );                 // Move to the stored position
+      v4 = SNAP_OFFSET( v4 );                 // (see species_advance_compact.h)
+      v5 = SNAP_OFFSET( v5 );
+
+      ux = 0.5f*( v3 - dx );
+      uy = 0.5f*( v4 - dy );
+      uz = 0.5f*( v5 - dz );
+
+      v0 = dx + ux;
+      v1 = dy + uy;
+      v2 = dz + uz;
+#     endif
+
       p->dx = v3;                             // Store new position
       p->dy = v4;
       p->dz = v5;
 
+      store_particle( p, p0, i );             // Store particle
+
       dx = v0;                                // Streak midpoint
       dy = v1;
       dz = v2;
@@ -213,19 +254,13 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
       local_pm->dispy = uy;
       local_pm->dispz = uz;
 
-      local_pm->i     = p - p0;
+      local_pm->i     = i;
+
+      store_particle( p, p0, i );             // Store momentum
 
-      if ( move_p( p0, local_pm, a0, g, qsp ) ) // Unlikely
+      if ( ADVANCE_P_MOVE_P( p0, local_pm, a0, g, qsp ) ) // Unlikely
       {
-        if ( nm < max_nm )
-        {
-          pm[nm++] = local_pm[0];
-        }
-
-        else
-        {
-          itmp++;                               // Unlikely
-        }
+        ADVANCE_P_SAVE_MOVER( local_pm[0] );
       }
     }
   }
@@ -234,6 +269,9 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
   args->seg[pipeline_rank].max_nm    = max_nm;
   args->seg[pipeline_rank].nm        = nm;
   args->seg[pipeline_rank].n_ignored = itmp;
+  args->seg[pipeline_rank].n_far     = n_far;
+
+  if ( args->en ) args->en[pipeline_rank] = en;
 }
 
 //----------------------------------------------------------------------------//
@@ -241,18 +279,80 @@ advance_p_pipeline_scalar( advance_p_pipeline_args_t * args,
 // function.
 //----------------------------------------------------------------------------//
 
-void
+// Put the nm movers pm that the pipelines took from the shared counter back
+// in particle order.  The np particles were cut into chunks as in
+// FOR_EACH_ADVANCE_P_CHUNK.  Each chunk is pushed by a single pipeline, which
+// takes the movers of the chunk in particle order (move_p_batch keeps the
+// order of its queue), and the host pushes the particles after the last
+// chunk.  A stable counting sort on the chunk of each mover thus sorts the
+// movers, in O(nm + chunks) instead of O(nm log nm) for a comparison sort.
+
+static void
+sort_shared_movers( particle_mover_t * RESTRICT pm,
+                    int64_t nm,
+                    int64_t np )
+{
+  static VPIC_THREAD_LOCAL particle_mover_t * ALIGNED(128) scratch = NULL;
+  static VPIC_THREAD_LOCAL int64_t          * ALIGNED(128) count   = NULL;
+  static VPIC_THREAD_LOCAL int64_t max_scratch = 0, max_count = 0;
+
+  pipeline_chunks_t pc = begin_pipeline_chunks( np, 16, 0, N_PIPELINE );
+
+  int64_t n_item = ( np >> 4 ) << 4, m, c;
+
+  if ( !pc.chunk ) return; // The host pushed all the particles
+
+  if ( nm > max_scratch )
+  {
+    FREE_ALIGNED( scratch );
+    MALLOC_ALIGNED( scratch, nm, 128 );
+    max_scratch = nm;
+  }
+
+  if ( pc.n_chunk + 2 > max_count )
+  {
+    FREE_ALIGNED( count );
+    MALLOC_ALIGNED( count, pc.n_chunk + 2, 128 );
+    max_count = pc.n_chunk + 2;
+  }
+
+# define CHUNK(i) ( (i) < n_item ? (i) / pc.chunk : pc.n_chunk )
+
+  CLEAR( count, pc.n_chunk + 2 );
+  for( m = 0; m < nm; m++ ) count[ CHUNK( pm[m].i ) + 1 ]++;
+  for( c = 1; c <= pc.n_chunk; c++ ) count[c] += count[c-1];
+  for( m = 0; m < nm; m++ ) scratch[ count[ CHUNK( pm[m].i ) ]++ ] = pm[m];
+
+# undef CHUNK
+
+  COPY( pm, scratch, nm );
+}
+
+double
 advance_p_pipeline( species_t * RESTRICT sp,
                     accumulator_array_t * RESTRICT aa,
-                    const interpolator_array_t * RESTRICT ia )
+                    const interpolator_array_t * RESTRICT ia,
+                    hydro_array_t * RESTRICT ha,
+                    int moments )
 {
   DECLARE_ALIGNED_ARRAY( advance_p_pipeline_args_t, 128, args, 1 );
 
   DECLARE_ALIGNED_ARRAY( particle_mover_seg_t, 128, seg, MAX_PIPELINE + 1 );
 
+  DECLARE_ALIGNED_ARRAY( double, 128, en, MAX_PIPELINE + 1 );
+
+  int64_t shared_nm = 0;
+
+  double local, global;
+
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  DECLARE_ALIGNED_ARRAY( accumulator_t *, 16, a_tile, MAX_PIPELINE + 1 );
+#endif
+
   int rank;
 
-  if ( !sp || !aa || !ia || sp->g != aa->g || sp->g != ia->g )
+  if ( !sp || !aa || !ia || sp->g != aa->g || sp->g != ia->g ||
+       ( ha && ( !moments || ha->g != sp->g ) ) )
   {
     ERROR( ( "Bad args" ) );
   }
@@ -264,17 +364,24 @@ advance_p_pipeline( species_t * RESTRICT sp,
   args->seg     = seg;
   args->g       = sp->g;
 
-  args->qdt_2mc = (sp->q*sp->g->dt)/(2*sp->m*sp->g->cvac);
-  args->cdt_dx  = sp->g->cvac*sp->g->dt*sp->g->rdx;
-  args->cdt_dy  = sp->g->cvac*sp->g->dt*sp->g->rdy;
-  args->cdt_dz  = sp->g->cvac*sp->g->dt*sp->g->rdz;
+  // Subcycled species are pushed with a subcycle times larger step.
+
+  args->qdt_2mc = (sp->q*sp->g->dt*sp->subcycle)/(2*sp->m*sp->g->cvac);
+  args->cdt_dx  = sp->g->cvac*sp->g->dt*sp->subcycle*sp->g->rdx;
+  args->cdt_dy  = sp->g->cvac*sp->g->dt*sp->subcycle*sp->g->rdy;
+  args->cdt_dz  = sp->g->cvac*sp->g->dt*sp->subcycle*sp->g->rdz;
   args->qsp     = sp->q;
+  args->msp     = sp->m;
+  args->cvac    = sp->g->cvac;
+  args->r8V     = sp->g->r8V;
 
   args->np      = sp->np;
   args->max_nm  = sp->max_nm;
   args->nx      = sp->g->nx;
   args->ny      = sp->g->ny;
   args->nz      = sp->g->nz;
+  args->far     = sp->sort_interval < 0 ?
+                  sp->g->sx + sp->g->sy + sp->g->sz : 0;
 
   // Have the host processor do the last incomplete bundle if necessary.
   // Note: This is overlapped with the pipelined processing.  As such,
@@ -287,23 +394,59 @@ advance_p_pipeline( species_t * RESTRICT sp,
   // However, it is worth reconsidering this at some point in the
   // future.
 
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  advance_p_tiles_pipeline( sp, aa, a_tile );
+
+  args->a_tile  = a_tile;
+#endif
+
+  // On diagnostic steps, the pipelines accumulate the hydro fields into
+  // hydro arrays of their own, which are added to ha once they are done.
+
+  args->en       = moments ? en : NULL;
+  args->h        = NULL;
+  args->hp       = NULL;
+  args->h_stride = 0;
+
+  if ( ha )
+  {
+    size_hydro_array_pipelines( ha );
+
+    args->h        = ha->h;
+    args->hp       = ha->hp;
+    args->h_stride = ha->stride;
+  }
+
+  // When the pipelines steal particles, they take their movers from a
+  // shared counter (see ADVANCE_P_SAVE_MOVER).
+
+  args->shared_nm = ( !ADVANCE_P_TILE && N_PIPELINE > 1 &&
+                      pipelines_steal() ) ? &shared_nm : NULL;
+
   EXEC_PIPELINES( advance_p, args, 0 );
 
   WAIT_PIPELINES();
 
+  if ( ha ) reduce_hydro_array( ha );
+
   // FIXME: HIDEOUS HACK UNTIL BETTER PARTICLE MOVER SEMANTICS
   // INSTALLED FOR DEALING WITH PIPELINES.  COMPACT THE PARTICLE
   // MOVERS TO ELIMINATE HOLES FROM THE PIPELINING.
 
-  sp->nm = 0;
+  sp->nm    = 0;
+  sp->n_far = 0;
   for( rank = 0; rank <= N_PIPELINE; rank++ )
   {
+    sp->n_far += args->seg[rank].n_far;
+
     if ( args->seg[rank].n_ignored )
     {
-      WARNING( ( "Pipeline %i ran out of storage for %i movers",
-                 rank, args->seg[rank].n_ignored ) );
+      WARNING( ( "Pipeline %i ran out of storage for %li movers",
+                 rank, (long)args->seg[rank].n_ignored ) );
     }
 
+    if ( args->shared_nm ) continue;
+
     if ( sp->pm + sp->nm != args->seg[rank].pm )
     {
       MOVE( sp->pm + sp->nm, args->seg[rank].pm, args->seg[rank].nm );
@@ -311,4 +454,68 @@ advance_p_pipeline( species_t * RESTRICT sp,
 
     sp->nm += args->seg[rank].nm;
   }
+
+  // The movers taken from the shared counter are packed but in the order
+  // the pipelines took them.  The particle boundary handlers need them in
+  // increasing particle order (see boundary_p).
+
+  if ( args->shared_nm )
+  {
+    int64_t m;
+
+    sp->nm = shared_nm < sp->max_nm ? shared_nm : sp->max_nm;
+
+    for( m = 1; m < sp->nm; m++ )
+    {
+      if ( sp->pm[m-1].i > sp->pm[m].i )
+      {
+        sort_shared_movers( sp->pm, sp->nm, sp->np );
+        break;
+      }
+    }
+  }
+
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  // Finish moving the particles the pipelines stopped on a face with a
+  // local neighbor (see ADVANCE_P_MOVE_P).  The host accumulator covers
+  // the whole grid.  This is rare (in-rank periodic boundaries only).
+
+  {
+    const grid_t * g = sp->g;
+    particle_mover_t * pm;
+    int64_t m, n, neighbor;
+    int voxel;
+
+    for( m = 0, n = 0; m < sp->nm; m++ )
+    {
+      pm       = sp->pm + m;
+      voxel    = PARTICLE_VOXEL( sp->p, pm->i );
+      neighbor = g->neighbor[ 6*( voxel >> 3 ) + ( voxel & 7 ) ];
+
+      if ( neighbor >= g->rangel && neighbor <= g->rangeh )
+      {
+        PARTICLE_VOXEL( sp->p, pm->i ) = voxel >> 3;
+
+        if ( !move_p( sp->p, pm, aa->a, g, sp->q ) ) continue;
+      }
+
+      sp->pm[n++] = *pm;
+    }
+
+    sp->nm = n;
+  }
+#endif
+
+  if ( !moments ) return 0;
+
+  local = 0.0;
+  for( rank = 0; rank <= N_PIPELINE; rank++ )
+  {
+    local += en[rank];
+  }
+
+  mp_allsum_d( &local, &global, 1 );
+
+  return global * ( ( double ) sp->g->cvac *
+                    ( double ) sp->g->cvac );
 }
@@ -6,6 +6,8 @@
 
 using namespace v16;
 
+SIMD_KERNEL_BEGIN
+
 //----------------------------------------------------------------------------//
 // Method 4
 //----------------------------------------------------------------------------//
@@ -23,12 +25,17 @@ advance_p_pipeline_v16( advance_p_pipeline_args_t * args,
                         int pipeline_rank,
                         int n_pipeline )
 {
-  particle_t           * ALIGNED(128) p0 = args->p0;
+  particle_block_t     * ALIGNED(128) p0 = args->p0;
   accumulator_t        * ALIGNED(128) a0 = args->a0;
   const interpolator_t * ALIGNED(128) f0 = args->f0;
   const grid_t         *              g  = args->g;
 
+#if defined(VPIC_USE_COMPACT_P)
   particle_t           * ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 16 );
+#else
+  particle_block_t     * ALIGNED(128) p;
+#endif
   particle_mover_t     * ALIGNED(16)  pm;
 
   float                * ALIGNED(64)  vp00;
@@ -56,6 +63,9 @@ advance_p_pipeline_v16( advance_p_pipeline_args_t * args,
   const v16float qsp(args->qsp);
   const v16float one(1.0);
   const v16float one_third(1.0/3.0);
+#if defined(VPIC_USE_COMPACT_P)
+  const v16float half(0.5);
+#endif
   const v16float two_fifteenths(2.0/15.0);
   const v16float neg_one(-1.0);
 
@@ -67,21 +77,28 @@ advance_p_pipeline_v16( advance_p_pipeline_args_t * args,
   v16float v08, v09, v10, v11, v12, v13, v14, v15;
   v16int   ii, outbnd;
 
-  int itmp, nq, nm, max_nm;
+  int64_t n, itmp, nq, nm, max_nm;
 
-  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
+  int far = args->far, ii_far;
+
+  int64_t n_far = 0;
 
-  // Determine which blocks of particle quads this pipeline processes.
+  hydro_t * hp = pipeline_hydro_array( args->h, args->hp, args->h_stride,
+                                        pipeline_rank, n_pipeline );
 
-  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, itmp, nq );
+  double en = 0.0;
 
-  p = args->p0 + itmp;
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p_moments, 1 );
 
-  nq >>= 4;
+  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
+#if defined(VPIC_USE_BATCHED_MOVE_P)
+  DECLARE_ALIGNED_ARRAY( particle_mover_t, 128, pq, MOVE_P_BATCH );
+  int64_t n_queued = 0;
+#endif
 
   // Determine which movers are reserved for this pipeline.
-  // Movers (16 bytes) should be reserved for pipelines in at least
-  // multiples of 8 such that the set of particle movers reserved for
+  // Movers (32 bytes) should be reserved for pipelines in at least
+  // multiples of 4 such that the set of particle movers reserved for
   // a pipeline is 128-byte aligned and a multiple of 128-byte in
   // size.  The host is guaranteed to get enough movers to process its
   // particles with this allocation.
@@ -101,19 +118,47 @@ advance_p_pipeline_v16( advance_p_pipeline_args_t * args,
   // Determine which accumulator array to use.
   // The host gets the first accumulator array.
 
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  a0 = args->a_tile[ pipeline_rank ];
+#else
   a0 += ( 1 + pipeline_rank ) *
         POW2_CEIL( (args->nx+2)*(args->ny+2)*(args->nz+2), 2 );
+#endif
 
-  // Process the particle blocks for this pipeline.
+  // Process the particle blocks for this pipeline, one chunk of blocks of
+  // particle quads at a time.
 
-  for( ; nq; nq--, p+=16 )
+  FOR_EACH_ADVANCE_P_CHUNK( n, nq )
+  for( ii_far = nq ? PARTICLE_VOXEL( p0, n ) : 0, nq >>= 4; nq; nq--, n+=16 )
   {
+    ADVANCE_P_MOMENTS( n, 16 );
+
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, n, p_bundle, 16 );
+    p = p_bundle;
+#   else
+    p = p0 + n/PARTICLE_BLOCK_SIZE;
+#   endif
+
     //--------------------------------------------------------------------------
     // Load particle data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    load_16x1( p->dx, dx );
+    load_16x1( p->dy, dy );
+    load_16x1( p->dz, dz );
+    load_16x1( p->i,  ii );
+    load_16x1( p->ux, ux );
+    load_16x1( p->uy, uy );
+    load_16x1( p->uz, uz );
+    load_16x1( p->w,  q  );
+#   else
     load_16x8_tr_p( &p[ 0].dx, &p[ 2].dx, &p[ 4].dx, &p[ 6].dx,
                     &p[ 8].dx, &p[10].dx, &p[12].dx, &p[14].dx,
                     dx, dy, dz, ii, ux, uy, uz, q );
+#   endif
+
+    ADVANCE_P_COUNT_FAR( ii, 16 );
 
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
@@ -238,9 +283,39 @@ advance_p_pipeline_v16( advance_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Store particle data, final.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    store_16x1( v03, p->dx );
+    store_16x1( v04, p->dy );
+    store_16x1( v05, p->dz );
+    store_16x1( v06, p->ux );
+    store_16x1( v07, p->uy );
+    store_16x1( v08, p->uz );
+#   else
     store_16x8_tr_p( v03, v04, v05, ii, v06, v07, v08, q,
                      &p[ 0].dx, &p[ 2].dx, &p[ 4].dx, &p[ 6].dx,
                      &p[ 8].dx, &p[10].dx, &p[12].dx, &p[14].dx );
+#   endif
+
+#   if defined(VPIC_USE_COMPACT_P)
+    // Encode the bundle and move the in bound particles along the streak
+    // to their stored positions so the current is consistent with them.
+    STORE_PARTICLE_BUNDLE( p, p0, n, 16 );
+    LOAD_PARTICLE_BUNDLE( p0, n, p, 16 );
+
+    load_16x3_tr( &p[ 0].dx, &p[ 1].dx, &p[ 2].dx, &p[ 3].dx,
+                  &p[ 4].dx, &p[ 5].dx, &p[ 6].dx, &p[ 7].dx,
+                  &p[ 8].dx, &p[ 9].dx, &p[10].dx, &p[11].dx,
+                  &p[12].dx, &p[13].dx, &p[14].dx, &p[15].dx,
+                  v03, v04, v05 );
+
+    ux  = merge( outbnd, ux, half*( v03 - dx ) );
+    uy  = merge( outbnd, uy, half*( v04 - dy ) );
+    uz  = merge( outbnd, uz, half*( v05 - dz ) );
+
+    v00 = dx + ux;
+    v01 = dy + uy;
+    v02 = dz + uz;
+#   endif
 
     // Accumulate current of inbnd particles.
     // Note: accumulator values are 4 times the total physical charge that
@@ -359,25 +434,30 @@ advance_p_pipeline_v16( advance_p_pipeline_args_t * args,
     // particles.
     //--------------------------------------------------------------------------
 
+#   if defined(VPIC_USE_BATCHED_MOVE_P)
+#   define MOVE_OUTBND(N)                                               \
+    if ( outbnd(N) )                                /* Unlikely */      \
+    {                                                                   \
+      pq[n_queued].dispx = ux(N);                                       \
+      pq[n_queued].dispy = uy(N);                                       \
+      pq[n_queued].dispz = uz(N);                                       \
+      pq[n_queued].i     = n + N;                                       \
+      n_queued++;                                                       \
+    }
+#   else
 #   define MOVE_OUTBND(N)                                               \
     if ( outbnd(N) )                                /* Unlikely */      \
     {                                                                   \
       local_pm->dispx = ux(N);                                          \
       local_pm->dispy = uy(N);                                          \
       local_pm->dispz = uz(N);                                          \
-      local_pm->i     = ( p - p0 ) + N;                                 \
-      if ( move_p( p0, local_pm, a0, g, _qsp ) )    /* Unlikely */      \
+      local_pm->i     = n + N;                                          \
+      if ( ADVANCE_P_MOVE_P( p0, local_pm, a0, g, _qsp ) ) /* Unlikely */ \
       {                                                                 \
-        if ( nm < max_nm )                                              \
-        {                                                               \
-          v4::copy_4x1( &pm[nm++], local_pm );                          \
-        }                                                               \
-        else                                        /* Unlikely */      \
-        {                                                               \
-          itmp++;                                                       \
-        }                                                               \
+        ADVANCE_P_SAVE_MOVER( local_pm[0] );                            \
       }                                                                 \
     }
+#   endif
 
     MOVE_OUTBND( 0);
     MOVE_OUTBND( 1);
@@ -397,14 +477,30 @@ advance_p_pipeline_v16( advance_p_pipeline_args_t * args,
     MOVE_OUTBND(15);
 
 #   undef MOVE_OUTBND
+
+#   if defined(VPIC_USE_BATCHED_MOVE_P)
+    if ( n_queued > MOVE_P_BATCH - 16 )
+    {
+      ADVANCE_P_MOVE_P_BATCH( move_p_batch_v16 );
+    }
+#   endif
   }
 
+#if defined(VPIC_USE_BATCHED_MOVE_P)
+  ADVANCE_P_MOVE_P_BATCH( move_p_batch_v16 );
+#endif
+
   args->seg[pipeline_rank].pm        = pm;
   args->seg[pipeline_rank].max_nm    = max_nm;
   args->seg[pipeline_rank].nm        = nm;
   args->seg[pipeline_rank].n_ignored = itmp;
+  args->seg[pipeline_rank].n_far     = n_far;
+
+  if ( args->en ) args->en[pipeline_rank] = en;
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -6,17 +6,24 @@
 
 using namespace v4;
 
+SIMD_KERNEL_BEGIN
+
 void
 advance_p_pipeline_v4( advance_p_pipeline_args_t * args,
                        int pipeline_rank,
                        int n_pipeline )
 {
-  particle_t           * ALIGNED(128) p0 = args->p0;
+  particle_block_t     * ALIGNED(128) p0 = args->p0;
   accumulator_t        * ALIGNED(128) a0 = args->a0;
   const interpolator_t * ALIGNED(128) f0 = args->f0;
   const grid_t         *              g  = args->g;
 
+#if defined(VPIC_USE_COMPACT_P)
   particle_t           * ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 4 );
+#else
+  particle_block_t     * ALIGNED(128) p;
+#endif
   particle_mover_t     * ALIGNED(16)  pm;
 
   float                * ALIGNED(16)  vp00;
@@ -32,6 +39,9 @@ advance_p_pipeline_v4( advance_p_pipeline_args_t * args,
   const v4float qsp(args->qsp);
   const v4float one(1.0);
   const v4float one_third(1.0/3.0);
+#if defined(VPIC_USE_COMPACT_P)
+  const v4float half(0.5);
+#endif
   const v4float two_fifteenths(2.0/15.0);
   const v4float neg_one(-1.0);
 
@@ -42,21 +52,24 @@ advance_p_pipeline_v4( advance_p_pipeline_args_t * args,
   v4float v00, v01, v02, v03, v04, v05;
   v4int   ii, outbnd;
 
-  int itmp, nq, nm, max_nm;
+  int64_t n, itmp, nq, nm, max_nm;
 
-  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
+  int far = args->far, ii_far;
 
-  // Determine which quads of particle quads this pipeline processes.
+  int64_t n_far = 0;
 
-  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, itmp, nq );
+  hydro_t * hp = pipeline_hydro_array( args->h, args->hp, args->h_stride,
+                                        pipeline_rank, n_pipeline );
 
-  p = args->p0 + itmp;
+  double en = 0.0;
 
-  nq >>= 2;
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p_moments, 1 );
+
+  DECLARE_ALIGNED_ARRAY( particle_mover_t, 16, local_pm, 1 );
 
   // Determine which movers are reserved for this pipeline.
-  // Movers (16 bytes) should be reserved for pipelines in at least
-  // multiples of 8 such that the set of particle movers reserved for
+  // Movers (32 bytes) should be reserved for pipelines in at least
+  // multiples of 4 such that the set of particle movers reserved for
   // a pipeline is 128-byte aligned and a multiple of 128-byte in
   // size.  The host is guaranteed to get enough movers to process its
   // particles with this allocation.
@@ -76,18 +89,44 @@ advance_p_pipeline_v4( advance_p_pipeline_args_t * args,
   // Determine which accumulator array to use.
   // The host gets the first accumulator array.
 
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  a0 = args->a_tile[ pipeline_rank ];
+#else
   a0 += ( 1 + pipeline_rank ) *
         POW2_CEIL( (args->nx+2)*(args->ny+2)*(args->nz+2), 2 );
+#endif
 
-  // Process the particle blocks for this pipeline.
+  // Process the particle blocks for this pipeline, one chunk of quads of
+  // particles at a time.
 
-  for( ; nq; nq--, p+=4 )
+  FOR_EACH_ADVANCE_P_CHUNK( n, nq )
+  for( ii_far = nq ? PARTICLE_VOXEL( p0, n ) : 0, nq >>= 2; nq; nq--, n+=4 )
   {
+    ADVANCE_P_MOMENTS( n, 4 );
+
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, n, p_bundle, 4 );
+    p = p_bundle;
+#   else
+    p = p0 + n/PARTICLE_BLOCK_SIZE;
+#   endif
+
     //--------------------------------------------------------------------------
     // Load particle data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    const int l = n%PARTICLE_BLOCK_SIZE;
+
+    load_4x1( &p->dx[l], dx );
+    load_4x1( &p->dy[l], dy );
+    load_4x1( &p->dz[l], dz );
+    load_4x1( &p->i [l], ii );
+#   else
     load_4x4_tr( &p[0].dx, &p[1].dx, &p[2].dx, &p[3].dx,
                  dx, dy, dz, ii );
+#   endif
+
+    ADVANCE_P_COUNT_FAR( ii, 4 );
 
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
@@ -142,8 +181,15 @@ advance_p_pipeline_v4( advance_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Load particle data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    load_4x1( &p->ux[l], ux );
+    load_4x1( &p->uy[l], uy );
+    load_4x1( &p->uz[l], uz );
+    load_4x1( &p->w [l], q  );
+#   else
     load_4x4_tr( &p[0].ux, &p[1].ux, &p[2].ux, &p[3].ux,
                  ux, uy, uz, q );
+#   endif
 
     //--------------------------------------------------------------------------
     // Update momentum.
@@ -179,8 +225,14 @@ advance_p_pipeline_v4( advance_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Store particle data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    store_4x1( ux, &p->ux[l] );
+    store_4x1( uy, &p->uy[l] );
+    store_4x1( uz, &p->uz[l] );
+#   else
     store_4x4_tr( ux, uy, uz, q,
                   &p[0].ux, &p[1].ux, &p[2].ux, &p[3].ux );
+#   endif
 
     //--------------------------------------------------------------------------
     // Update the position of in bound particles.
@@ -217,8 +269,32 @@ advance_p_pipeline_v4( advance_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Store particle data, final.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    store_4x1( v03, &p->dx[l] );
+    store_4x1( v04, &p->dy[l] );
+    store_4x1( v05, &p->dz[l] );
+#   else
     store_4x4_tr( v03, v04, v05, ii,
                   &p[0].dx, &p[1].dx, &p[2].dx, &p[3].dx );
+#   endif
+
+#   if defined(VPIC_USE_COMPACT_P)
+    // Encode the bundle and move the in bound particles along the streak
+    // to their stored positions so the current is consistent with them.
+    STORE_PARTICLE_BUNDLE( p, p0, n, 4 );
+    LOAD_PARTICLE_BUNDLE( p0, n, p, 4 );
+
+    load_4x3_tr( &p[0].dx, &p[1].dx, &p[2].dx, &p[3].dx,
+                 v03, v04, v05 );
+
+    ux  = merge( outbnd, ux, half*( v03 - dx ) );
+    uy  = merge( outbnd, uy, half*( v04 - dy ) );
+    uz  = merge( outbnd, uz, half*( v05 - dz ) );
+
+    v00 = dx + ux;
+    v01 = dy + uy;
+    v02 = dz + uz;
+#   endif
 
     // Accumulate current of inbnd particles.
     // Note: accumulator values are 4 times the total physical charge that
@@ -280,17 +356,10 @@ advance_p_pipeline_v4( advance_p_pipeline_args_t * args,
       local_pm->dispx = ux(N);                                          \
       local_pm->dispy = uy(N);                                          \
       local_pm->dispz = uz(N);                                          \
-      local_pm->i     = ( p - p0 ) + N;                                 \
-      if ( move_p( p0, local_pm, a0, g, _qsp ) )    /* Unlikely */      \
+      local_pm->i     = n + N;                                          \
+      if ( ADVANCE_P_MOVE_P( p0, local_pm, a0, g, _qsp ) ) /* Unlikely */ \
       {                                                                 \
-        if ( nm < max_nm )                                              \
-        {                                                               \
-          copy_4x1( &pm[nm++], local_pm );                              \
-        }                                                               \
-        else                                        /* Unlikely */      \
-        {                                                               \
-          itmp++;                                                       \
-        }                                                               \
+        ADVANCE_P_SAVE_MOVER( local_pm[0] );                            \
       }                                                                 \
     }
 
@@ -306,8 +375,13 @@ advance_p_pipeline_v4( advance_p_pipeline_args_t * args,
   args->seg[pipeline_rank].max_nm    = max_nm;
   args->seg[pipeline_rank].nm        = nm;
   args->seg[pipeline_rank].n_ignored = itmp;
+  args->seg[pipeline_rank].n_far     = n_far;
+
+  if ( args->en ) args->en[pipeline_rank] = en;
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -0,0 +1,147 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+
+//----------------------------------------------------------------------------//
+// Find the range of voxels occupied by the particles of each advance_p
+// pipeline.  The particles are distributed exactly as in advance_p.
+//----------------------------------------------------------------------------//
+
+void
+voxel_range_pipeline_scalar( voxel_range_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline )
+{
+  const particle_block_t * RESTRICT ALIGNED(128) p0 = args->p0;
+
+  int64_t i, n;
+
+  int v, lo = 1, hi = 0;
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, i, n );
+
+  if ( n )
+  {
+    lo = hi = PARTICLE_VOXEL( p0, i );
+
+    for( ; n; n--, i++ )
+    {
+      v = PARTICLE_VOXEL( p0, i );
+
+      if ( v < lo ) lo = v;
+      if ( v > hi ) hi = v;
+    }
+  }
+
+  args->lo[pipeline_rank] = lo;
+  args->hi[pipeline_rank] = hi;
+}
+
+//----------------------------------------------------------------------------//
+// Top level function to assign the advance_p pipelines their tiles.
+//----------------------------------------------------------------------------//
+
+void
+advance_p_tiles_pipeline( species_t * RESTRICT sp,
+                          accumulator_array_t * RESTRICT aa,
+                          accumulator_t ** RESTRICT a_tile )
+{
+  DECLARE_ALIGNED_ARRAY( voxel_range_pipeline_args_t, 128, args, 1 );
+
+  DECLARE_ALIGNED_ARRAY( int, 16, lo, MAX_PIPELINE + 1 );
+  DECLARE_ALIGNED_ARRAY( int, 16, hi, MAX_PIPELINE + 1 );
+
+  const grid_t * g;
+
+  int rank, halo;
+
+  int64_t i, n, n_t;
+
+  if ( !sp || !aa || !a_tile || sp->g != aa->g )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  g = sp->g;
+
+  // A particle moves less than a cell along each axis in a time step (less
+  // than subcycle cells for subcycled species, which are pushed with a
+  // subcycle times larger step), so it can only deposit current to voxels
+  // within this distance of the voxel it started in.
+
+  halo = sp->subcycle * ( 1 + ( g->nx + 2 ) + ( g->nx + 2 )*( g->ny + 2 ) );
+
+  if ( sp->last_sorted == g->step && g->sfc_type == fortran_sfc )
+  {
+    // The sorted particles of a pipeline occupy the voxels between those
+    // of its first and last particle.  This does not hold when they were
+    // sorted along another space filling curve.
+
+    for( rank = 0; rank < N_PIPELINE; rank++ )
+    {
+      DISTRIBUTE( sp->np, 16, rank, N_PIPELINE, i, n );
+
+      lo[rank] = n ? PARTICLE_VOXEL( sp->p, i       ) : 1;
+      hi[rank] = n ? PARTICLE_VOXEL( sp->p, i + n - 1 ) : 0;
+    }
+  }
+
+  else if ( sp->wide_tiles == sp->last_sorted )
+  {
+    // The tiles covered most of the grid since the species was last
+    // sorted.  Use tiles covering the whole grid, which are just
+    // per-pipeline accumulators, rather than looking for narrower ones.
+
+    for( rank = 0; rank < N_PIPELINE; rank++ )
+    {
+      lo[rank] = 0;
+      hi[rank] = g->nv - 1;
+    }
+  }
+
+  else
+  {
+    args->p0 = sp->p;
+    args->lo = lo;
+    args->hi = hi;
+    args->np = sp->np;
+
+    EXEC_PIPELINES( voxel_range, args, 0 );
+
+    WAIT_PIPELINES();
+  }
+
+  for( n_t = 0, rank = 0; rank < N_PIPELINE; rank++ )
+  {
+    if ( lo[rank] <= hi[rank] )
+    {
+      lo[rank] -= halo;
+      hi[rank] += halo;
+
+      n_t += ( hi[rank] < g->nv - 1 ? hi[rank] : g->nv - 1 ) -
+             ( lo[rank] > 0         ? lo[rank] : 0         ) + 1;
+    }
+  }
+
+  // Tiles only pay off when they are narrow, which needs the particles of
+  // each pipeline to be close in voxel order.  Unsorted particles and
+  // particles sorted along a Morton or Hilbert curve usually are not.  Once
+  // the tiles add up to more than half of the per-pipeline accumulators
+  // they replace, the pass over the particles above costs more than the
+  // tiles save, so it is skipped until the species is sorted again.
+
+  if ( 2*n_t > (int64_t) N_PIPELINE * g->nv )
+  {
+    sp->wide_tiles = sp->last_sorted;
+  }
+
+  begin_accumulator_tiles( aa, N_PIPELINE, lo, hi, a_tile );
+
+  a_tile[N_PIPELINE] = aa->a;
+}
+
+#endif
@@ -19,8 +19,7 @@ center_p_pipeline_scalar( center_p_pipeline_args_t * args,
                           int n_pipeline )
 {
   const interpolator_t * ALIGNED(128) f0 = args->f0;
-
-  particle_t           * ALIGNED(32)  p;
+  particle_block_t     * ALIGNED(128) p0 = args->p0;
 
   const interpolator_t * ALIGNED(16)  f;
 
@@ -35,18 +34,19 @@ center_p_pipeline_scalar( center_p_pipeline_args_t * args,
   float v0, v1, v2, v3, v4;
   int   ii;
 
-  int first, n;
-
-  // Determine which particles this pipeline processes.
-
-  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, first, n );
+  int64_t i, n;
 
-  p = args->p0 + first;
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
 
-  // Process particles for this pipeline.
+  // Determine which particles this pipeline processes and process them.
+  // The particles come in chunks idle pipelines can steal (see
+  // FOR_EACH_PIPELINE_CHUNK).
 
-  for( ; n; n--, p++ )
+  FOR_EACH_PIPELINE_CHUNK( args->np, 16, pipeline_rank, n_pipeline, i, n )
+  for( ; n; n--, i++ )
   {
+    load_particle( p0, i, p );               // Load particle
+
     dx   = p->dx;                            // Load position
     dy   = p->dy;
     dz   = p->dz;
@@ -94,6 +94,8 @@ center_p_pipeline_scalar( center_p_pipeline_args_t * args,
     p->ux = ux;                              // Store momentum
     p->uy = uy;
     p->uz = uz;
+
+    store_particle( p, p0, i );              // Store particle
   }
 }
 
@@ -120,7 +122,7 @@ center_p_pipeline( species_t * RESTRICT sp,
 
   args->p0      = sp->p;
   args->f0      = ia->i;
-  args->qdt_2mc = (sp->q*sp->g->dt)/(2*sp->m*sp->g->cvac);
+  args->qdt_2mc = (sp->q*sp->g->dt*sp->subcycle)/(2*sp->m*sp->g->cvac);
   args->np      = sp->np;
 
   EXEC_PIPELINES( center_p, args, 0 );
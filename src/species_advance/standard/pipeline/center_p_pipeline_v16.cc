@@ -6,6 +6,8 @@
 
 using namespace v16;
 
+SIMD_KERNEL_BEGIN
+
 void
 center_p_pipeline_v16( center_p_pipeline_args_t * args,
                        int pipeline_rank,
@@ -13,7 +15,14 @@ center_p_pipeline_v16( center_p_pipeline_args_t * args,
 {
   const interpolator_t * ALIGNED(128) f0 = args->f0;
 
+  particle_block_t     * ALIGNED(128) p0 = args->p0;
+
+#if defined(VPIC_USE_COMPACT_P)
   particle_t           * ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 16 );
+#else
+  particle_block_t     * ALIGNED(128) p;
+#endif
 
   const float          * ALIGNED(64)  vp00;
   const float          * ALIGNED(64)  vp01;
@@ -43,26 +52,39 @@ center_p_pipeline_v16( center_p_pipeline_args_t * args,
   v16float v00, v01, v02, v03, v04, v05, v06, v07, v08, v09, v10;
   v16int   ii;
 
-  int itmp, nq;
-
-  // Determine which particle quads this pipeline processes.
-
-  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, itmp, nq );
+  int64_t itmp, nq;
 
-  p = args->p0 + itmp;
+  // Determine which particle quads this pipeline processes and process them.
+  // The particles come in chunks idle pipelines can steal (see
+  // FOR_EACH_PIPELINE_CHUNK).
 
-  nq >>= 4;
-
-  // Process the particle quads for this pipeline.
-
-  for( ; nq; nq--, p+=16 )
+  FOR_EACH_PIPELINE_CHUNK( args->np, 16, pipeline_rank, n_pipeline, itmp, nq )
+  for( nq >>= 4; nq; nq--, itmp+=16 )
   {
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, itmp, p_bundle, 16 );
+    p = p_bundle;
+#   else
+    p = p0 + itmp/PARTICLE_BLOCK_SIZE;
+#   endif
+
     //--------------------------------------------------------------------------
     // Load particle position data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    load_16x1( p->dx, dx );
+    load_16x1( p->dy, dy );
+    load_16x1( p->dz, dz );
+    load_16x1( p->i,  ii );
+    load_16x1( p->ux, ux );
+    load_16x1( p->uy, uy );
+    load_16x1( p->uz, uz );
+    load_16x1( p->w,  q );
+#   else
     load_16x8_tr_p( &p[ 0].dx, &p[ 2].dx, &p[ 4].dx, &p[ 6].dx,
                     &p[ 8].dx, &p[10].dx, &p[12].dx, &p[14].dx,
 		    dx, dy, dz, ii, ux, uy, uz, q );
+#   endif
 
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
@@ -140,12 +162,24 @@ center_p_pipeline_v16( center_p_pipeline_args_t * args,
     // Store particle momentum data.  Could use store_16x4_tr_p or
     // store_16x3_tr_p.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    store_16x1( ux, p->ux );
+    store_16x1( uy, p->uy );
+    store_16x1( uz, p->uz );
+#   else
     store_16x8_tr_p( dx, dy, dz, ii, ux, uy, uz, q,
                      &p[ 0].dx, &p[ 2].dx, &p[ 4].dx, &p[ 6].dx,
                      &p[ 8].dx, &p[10].dx, &p[12].dx, &p[14].dx );
+#   endif
+
+#   if defined(VPIC_USE_COMPACT_P)
+    STORE_PARTICLE_BUNDLE( p, p0, itmp, 16 );
+#   endif
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
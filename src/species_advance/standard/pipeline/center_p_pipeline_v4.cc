@@ -6,6 +6,8 @@
 
 using namespace v4;
 
+SIMD_KERNEL_BEGIN
+
 void
 center_p_pipeline_v4( center_p_pipeline_args_t * args,
                       int pipeline_rank,
@@ -13,7 +15,14 @@ center_p_pipeline_v4( center_p_pipeline_args_t * args,
 {
   const interpolator_t * ALIGNED(128) f0 = args->f0;
 
+  particle_block_t     * ALIGNED(128) p0 = args->p0;
+
+#if defined(VPIC_USE_COMPACT_P)
   particle_t           * ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 4 );
+#else
+  particle_block_t     * ALIGNED(128) p;
+#endif
 
   const float          * ALIGNED(16)  vp00;
   const float          * ALIGNED(16)  vp01;
@@ -31,25 +40,36 @@ center_p_pipeline_v4( center_p_pipeline_args_t * args,
   v4float v00, v01, v02, v03, v04, v05;
   v4int   ii;
 
-  int itmp, nq;
-
-  // Determine which particle blocks this pipeline processes.
-
-  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, itmp, nq );
+  int64_t itmp, nq;
 
-  p = args->p0 + itmp;
+  // Determine which particle blocks this pipeline processes and process them.
+  // The particles come in chunks idle pipelines can steal (see
+  // FOR_EACH_PIPELINE_CHUNK).
 
-  nq >>= 2;
-
-  // Process the particle blocks for this pipeline.
-
-  for( ; nq; nq--, p+=4 )
+  FOR_EACH_PIPELINE_CHUNK( args->np, 16, pipeline_rank, n_pipeline, itmp, nq )
+  for( nq >>= 2; nq; nq--, itmp+=4 )
   {
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, itmp, p_bundle, 4 );
+    p = p_bundle;
+#   else
+    p = p0 + itmp/PARTICLE_BLOCK_SIZE;
+#   endif
+
     //--------------------------------------------------------------------------
     // Load particle position data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    const int l = itmp%PARTICLE_BLOCK_SIZE;
+
+    load_4x1( &p->dx[l], dx );
+    load_4x1( &p->dy[l], dy );
+    load_4x1( &p->dz[l], dz );
+    load_4x1( &p->i [l], ii );
+#   else
     load_4x4_tr( &p[0].dx, &p[1].dx, &p[2].dx, &p[3].dx,
 		 dx, dy, dz, ii );
+#   endif
 
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
@@ -103,8 +123,15 @@ center_p_pipeline_v4( center_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Load particle momentum data.  Could use load_4x3_tr.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    load_4x1( &p->ux[l], ux );
+    load_4x1( &p->uy[l], uy );
+    load_4x1( &p->uz[l], uz );
+    load_4x1( &p->w [l], q  );
+#   else
     load_4x4_tr( &p[0].ux, &p[1].ux, &p[2].ux, &p[3].ux,
 		 ux, uy, uz, q );
+#   endif
 
     //--------------------------------------------------------------------------
     // Update momentum.
@@ -131,11 +158,23 @@ center_p_pipeline_v4( center_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Store particle momentum data.  Could use store_4x3_tr.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    store_4x1( ux, &p->ux[l] );
+    store_4x1( uy, &p->uy[l] );
+    store_4x1( uz, &p->uz[l] );
+#   else
     store_4x4_tr( ux, uy, uz, q,
 		  &p[0].ux, &p[1].ux, &p[2].ux, &p[3].ux );
+#   endif
+
+#   if defined(VPIC_USE_COMPACT_P)
+    STORE_PARTICLE_BUNDLE( p, p0, itmp, 4 );
+#   endif
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -19,8 +19,8 @@ energy_p_pipeline_scalar( energy_p_pipeline_args_t * RESTRICT args,
                           int pipeline_rank,
                           int n_pipeline )
 {
-  const interpolator_t * RESTRICT ALIGNED(128) f = args->f;
-  const particle_t     * RESTRICT ALIGNED(32)  p = args->p;
+  const interpolator_t   * RESTRICT ALIGNED(128) f  = args->f;
+  const particle_block_t * RESTRICT ALIGNED(128) p0 = args->p;
 
   const float qdt_2mc = args->qdt_2mc;
   const float msp     = args->msp;
@@ -31,7 +31,9 @@ energy_p_pipeline_scalar( energy_p_pipeline_args_t * RESTRICT args,
 
   double en = 0.0;
 
-  int i, n, n0, n1;
+  int64_t i, n, n0, n1;
+
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
 
   // Determine which particles this pipeline processes.
 
@@ -43,23 +45,25 @@ energy_p_pipeline_scalar( energy_p_pipeline_args_t * RESTRICT args,
 
   for( n = n0; n < n1; n++ )
   {
-    dx  = p[n].dx;
-    dy  = p[n].dy;
-    dz  = p[n].dz;
-    i   = p[n].i;
+    load_particle( p0, n, p );
+
+    dx  = p->dx;
+    dy  = p->dy;
+    dz  = p->dz;
+    i   = p->i;
 
-    v0  = p[n].ux + qdt_2mc*(    ( f[i].ex    + dy*f[i].dexdy    ) +
+    v0  = p->ux + qdt_2mc*(    ( f[i].ex    + dy*f[i].dexdy    ) +
                               dz*( f[i].dexdz + dy*f[i].d2exdydz ) );
 
-    v1  = p[n].uy + qdt_2mc*(    ( f[i].ey    + dz*f[i].deydz    ) +
+    v1  = p->uy + qdt_2mc*(    ( f[i].ey    + dz*f[i].deydz    ) +
                               dx*( f[i].deydx + dz*f[i].d2eydzdx ) );
 
-    v2  = p[n].uz + qdt_2mc*(    ( f[i].ez    + dx*f[i].dezdx    ) +
+    v2  = p->uz + qdt_2mc*(    ( f[i].ez    + dx*f[i].dezdx    ) +
                               dy*( f[i].dezdy + dx*f[i].d2ezdxdy ) );
 
     v0  = v0*v0 + v1*v1 + v2*v2;
 
-    v0  = (msp * p[n].w) * (v0 / (one + sqrtf(one + v0)));
+    v0  = (msp * p->w) * (v0 / (one + sqrtf(one + v0)));
 
     en += ( double ) v0;
   }
@@ -94,7 +98,7 @@ energy_p_pipeline( const species_t * RESTRICT sp,
   args->p       = sp->p;
   args->f       = ia->i;
   args->en      = en;
-  args->qdt_2mc = (sp->q*sp->g->dt)/(2*sp->m*sp->g->cvac);
+  args->qdt_2mc = (sp->q*sp->g->dt*sp->subcycle)/(2*sp->m*sp->g->cvac);
   args->msp     = sp->m;
   args->np      = sp->np;
 
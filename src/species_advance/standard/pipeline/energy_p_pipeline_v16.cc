@@ -6,13 +6,21 @@
 
 using namespace v16;
 
+SIMD_KERNEL_BEGIN
+
 void
 energy_p_pipeline_v16( energy_p_pipeline_args_t * args,
                        int pipeline_rank,
                        int n_pipeline )
 {
   const interpolator_t * RESTRICT ALIGNED(128) f = args->f;
-  const particle_t     * RESTRICT ALIGNED(128) p = args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) p0 = args->p;
+#if defined(VPIC_USE_COMPACT_P)
+  const particle_t       * RESTRICT ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 16 );
+#else
+  const particle_block_t * RESTRICT ALIGNED(128) p;
+#endif
 
   const float          * RESTRICT ALIGNED(64)  vp00;
   const float          * RESTRICT ALIGNED(64)  vp01;
@@ -45,28 +53,40 @@ energy_p_pipeline_v16( energy_p_pipeline_args_t * args,
   double en08 = 0.0, en09 = 0.0, en10 = 0.0, en11 = 0.0;
   double en12 = 0.0, en13 = 0.0, en14 = 0.0, en15 = 0.0;
 
-  int n0, nq;
+  int64_t n0, nq;
 
   // Determine which particle blocks this pipeline processes.
 
   DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n0, nq );
 
-  p += n0;
-
   nq >>= 4;
 
   // Process the particle blocks for this pipeline.
 
-  for( ; nq; nq--, p+=16 )
+  for( ; nq; nq--, n0+=16 )
   {
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, n0, p_bundle, 16 );
+    p = p_bundle;
+#   else
+    p = p0 + n0/PARTICLE_BLOCK_SIZE;
+#   endif
+
     //--------------------------------------------------------------------------
     // Load particle position data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    load_16x1( p->dx, dx );
+    load_16x1( p->dy, dy );
+    load_16x1( p->dz, dz );
+    load_16x1( p->i,  i );
+#   else
     load_16x4_tr( &p[ 0].dx, &p[ 1].dx, &p[ 2].dx, &p[ 3].dx,
                   &p[ 4].dx, &p[ 5].dx, &p[ 6].dx, &p[ 7].dx,
                   &p[ 8].dx, &p[ 9].dx, &p[10].dx, &p[11].dx,
                   &p[12].dx, &p[13].dx, &p[14].dx, &p[15].dx,
                   dx, dy, dz, i );
+#   endif
 
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
@@ -124,11 +144,18 @@ energy_p_pipeline_v16( energy_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Load particle momentum data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    load_16x1( p->ux, v00 );
+    load_16x1( p->uy, v01 );
+    load_16x1( p->uz, v02 );
+    load_16x1( p->w,  w );
+#   else
     load_16x4_tr( &p[ 0].ux, &p[ 1].ux, &p[ 2].ux, &p[ 3].ux,
                   &p[ 4].ux, &p[ 5].ux, &p[ 6].ux, &p[ 7].ux,
                   &p[ 8].ux, &p[ 9].ux, &p[10].ux, &p[11].ux,
                   &p[12].ux, &p[13].ux, &p[14].ux, &p[15].ux,
                   v00, v01, v02, w );
+#   endif
 
     //--------------------------------------------------------------------------
     // Update momentum to half step. Note that Boris rotation does not change
@@ -175,6 +202,8 @@ energy_p_pipeline_v16( energy_p_pipeline_args_t * args,
                             en12 + en13 + en14 + en15;
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
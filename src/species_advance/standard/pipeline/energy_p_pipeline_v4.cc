@@ -6,13 +6,21 @@
 
 using namespace v4;
 
+SIMD_KERNEL_BEGIN
+
 void
 energy_p_pipeline_v4( energy_p_pipeline_args_t * args,
                       int pipeline_rank,
                       int n_pipeline )
 {
   const interpolator_t * RESTRICT ALIGNED(128) f = args->f;
-  const particle_t     * RESTRICT ALIGNED(128) p = args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) p0 = args->p;
+#if defined(VPIC_USE_COMPACT_P)
+  const particle_t       * RESTRICT ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 4 );
+#else
+  const particle_block_t * RESTRICT ALIGNED(128) p;
+#endif
 
   const float          * RESTRICT ALIGNED(16)  vp00;
   const float          * RESTRICT ALIGNED(16)  vp01;
@@ -30,25 +38,39 @@ energy_p_pipeline_v4( energy_p_pipeline_args_t * args,
 
   double en00 = 0.0, en01 = 0.0, en02 = 0.0, en03 = 0.0;
 
-  int n0, nq;
+  int64_t n0, nq;
 
   // Determine which particle blocks this pipeline processes.
 
   DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n0, nq );
 
-  p += n0;
-
   nq >>= 2;
 
   // Process the particle blocks for this pipeline.
 
-  for( ; nq; nq--, p+=4 )
+  for( ; nq; nq--, n0+=4 )
   {
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, n0, p_bundle, 4 );
+    p = p_bundle;
+#   else
+    p = p0 + n0/PARTICLE_BLOCK_SIZE;
+#   endif
+
     //--------------------------------------------------------------------------
     // Load particle position data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    const int l = n0%PARTICLE_BLOCK_SIZE;
+
+    load_4x1( &p->dx[l], dx );
+    load_4x1( &p->dy[l], dy );
+    load_4x1( &p->dz[l], dz );
+    load_4x1( &p->i [l], i  );
+#   else
     load_4x4_tr( &p[0].dx, &p[1].dx, &p[2].dx, &p[3].dx,
                  dx, dy, dz, i );
+#   endif
 
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
@@ -85,8 +107,15 @@ energy_p_pipeline_v4( energy_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Load particle momentum data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    load_4x1( &p->ux[l], v00 );
+    load_4x1( &p->uy[l], v01 );
+    load_4x1( &p->uz[l], v02 );
+    load_4x1( &p->w [l], w  );
+#   else
     load_4x4_tr( &p[0].ux, &p[1].ux, &p[2].ux, &p[3].ux,
                  v00, v01, v02, w );
+#   endif
 
     //--------------------------------------------------------------------------
     // Update momentum to half step. Note that Boris rotation does not change
@@ -118,6 +147,8 @@ energy_p_pipeline_v4( energy_p_pipeline_args_t * args,
   args->en[pipeline_rank] = en00 + en01 + en02 + en03;
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -0,0 +1,94 @@
+#define IN_spa
+
+#define HAS_V4_PIPELINE
+#define HAS_V8_PIPELINE
+#define HAS_V16_PIPELINE
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Reference implementation for an accumulate_hydro_p pipeline function which
+// does not make use of explicit calls to vector intrinsic functions.
+//----------------------------------------------------------------------------//
+
+void
+accumulate_hydro_p_pipeline_scalar( accumulate_hydro_p_pipeline_args_t * args,
+                                    int pipeline_rank,
+                                    int n_pipeline )
+{
+  const particle_block_t * RESTRICT ALIGNED(128) p0 = args->p0;
+  const interpolator_t   * RESTRICT ALIGNED(128) f0 = args->f0;
+
+  hydro_t * RESTRICT ALIGNED(128) h;
+
+  int64_t n, n0, n1;
+
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
+
+  // Determine which particles this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n0, n1 );
+
+  n1 += n0;
+
+  // Determine which hydro array to use.
+
+  h = pipeline_hydro_array( args->h, args->hp, args->stride,
+                            pipeline_rank, n_pipeline );
+
+  // Process particles for this pipeline.
+
+  for( n = n0; n < n1; n++ )
+  {
+    load_particle( p0, n, p );
+
+    hydro_p_particle( h, NULL, p, f0, args->qdt_2mc, args->qsp, args->msp,
+                      args->cvac, args->r8V, args->nx, args->ny );
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper accumulate_hydro_p
+// pipeline function.
+//----------------------------------------------------------------------------//
+
+void
+accumulate_hydro_p_pipeline( hydro_array_t * RESTRICT ha,
+                             const species_t * RESTRICT sp,
+                             const interpolator_array_t * RESTRICT ia )
+{
+  DECLARE_ALIGNED_ARRAY( accumulate_hydro_p_pipeline_args_t, 128, args, 1 );
+
+  if ( !ha || !sp || !ia || ha->g != sp->g || ha->g != ia->g )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  // The pipelines accumulate into hydro arrays of their own, which are
+  // added to the host hydro array once they are done.  The host does the
+  // final incomplete block of particles.
+
+  size_hydro_array_pipelines( ha );
+
+  args->p0      = sp->p;
+  args->f0      = ia->i;
+  args->h       = ha->h;
+  args->hp      = ha->hp;
+  args->qdt_2mc = (sp->q*sp->g->dt*sp->subcycle)/(2*sp->m*sp->g->cvac);
+  args->qsp     = sp->q;
+  args->msp     = sp->m;
+  args->cvac    = sp->g->cvac;
+  args->r8V     = sp->g->r8V;
+  args->np      = sp->np;
+  args->nx      = sp->g->nx;
+  args->ny      = sp->g->ny;
+  args->stride  = ha->stride;
+
+  EXEC_PIPELINES( accumulate_hydro_p, args, 0 );
+
+  WAIT_PIPELINES();
+
+  reduce_hydro_array( ha );
+}
@@ -0,0 +1,290 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V16_ACCELERATION)
+
+using namespace v16;
+
+SIMD_KERNEL_BEGIN
+
+void
+accumulate_hydro_p_pipeline_v16( accumulate_hydro_p_pipeline_args_t * args,
+                                 int pipeline_rank,
+                                 int n_pipeline )
+{
+  const particle_block_t * RESTRICT ALIGNED(128) p0 = args->p0;
+  const interpolator_t   * RESTRICT ALIGNED(128) f0 = args->f0;
+#if defined(VPIC_USE_COMPACT_P)
+  const particle_t       * RESTRICT ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 16 );
+#else
+  const particle_block_t * RESTRICT ALIGNED(128) p;
+#endif
+
+  hydro_t * RESTRICT ALIGNED(128) h;
+
+  const float          * RESTRICT ALIGNED(64)  vp00;
+  const float          * RESTRICT ALIGNED(64)  vp01;
+  const float          * RESTRICT ALIGNED(64)  vp02;
+  const float          * RESTRICT ALIGNED(64)  vp03;
+  const float          * RESTRICT ALIGNED(64)  vp04;
+  const float          * RESTRICT ALIGNED(64)  vp05;
+  const float          * RESTRICT ALIGNED(64)  vp06;
+  const float          * RESTRICT ALIGNED(64)  vp07;
+  const float          * RESTRICT ALIGNED(64)  vp08;
+  const float          * RESTRICT ALIGNED(64)  vp09;
+  const float          * RESTRICT ALIGNED(64)  vp10;
+  const float          * RESTRICT ALIGNED(64)  vp11;
+  const float          * RESTRICT ALIGNED(64)  vp12;
+  const float          * RESTRICT ALIGNED(64)  vp13;
+  const float          * RESTRICT ALIGNED(64)  vp14;
+  const float          * RESTRICT ALIGNED(64)  vp15;
+
+  // Basic constants.
+  const v16float qdt_2mc(args->qdt_2mc);
+  const v16float qdt_4mc2(args->qdt_2mc/(2*args->cvac));
+  const v16float c(args->cvac);
+  const v16float qsp(args->qsp);
+  const v16float mspc(args->msp*args->cvac);
+  const v16float r8V(args->r8V);
+  const v16float one(1.0);
+  const v16float one_third(1.0/3.0);
+  const v16float two_fifteenths(2.0/15.0);
+  const v16float zero(0.0);
+
+  // Voxel offsets of the 8 nodes a particle contributes to, in the order
+  // of the reference implementation.
+  const int sx  = 1;
+  const int sy  = args->nx + 2;
+  const int sz  = ( args->nx + 2 )*( args->ny + 2 );
+
+  v16float dx, dy, dz, ux, uy, uz, w;
+  v16float ex, ey, ez, cbx, cby, cbz;
+  v16float vx, vy, vz, ke_mc, t;
+  v16float w0, w1, w2, w3, w4, w5, w6, w7;
+  v16float v00, v01, v02, v03, v04, v05, v06, v07;
+  v16float v08, v09, v10, v11, v12, v13, v14, v15;
+  v16int   ii;
+
+  int64_t n, nq;
+
+  // Determine which particle blocks this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n, nq );
+
+  nq >>= 4;
+
+  // Determine which hydro array to use.
+
+  h = pipeline_hydro_array( args->h, args->hp, args->stride,
+                            pipeline_rank, n_pipeline );
+
+  // Process the particle blocks for this pipeline.
+
+  for( ; nq; nq--, n+=16 )
+  {
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, n, p_bundle, 16 );
+    p = p_bundle;
+#   else
+    p = p0 + n/PARTICLE_BLOCK_SIZE;
+#   endif
+
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    load_16x1( p->dx, dx );
+    load_16x1( p->dy, dy );
+    load_16x1( p->dz, dz );
+    load_16x1( p->i,  ii );
+    load_16x1( p->ux, ux );
+    load_16x1( p->uy, uy );
+    load_16x1( p->uz, uz );
+    load_16x1( p->w,  w  );
+#   else
+    load_16x8_tr_p( &p[ 0].dx, &p[ 2].dx, &p[ 4].dx, &p[ 6].dx,
+                    &p[ 8].dx, &p[10].dx, &p[12].dx, &p[14].dx,
+                    dx, dy, dz, ii, ux, uy, uz, w );
+#   endif
+
+    //--------------------------------------------------------------------------
+    // Set field interpolation pointers.
+    //--------------------------------------------------------------------------
+    vp00 = ( const float * ALIGNED(64) ) ( f0 + ii( 0) );
+    vp01 = ( const float * ALIGNED(64) ) ( f0 + ii( 1) );
+    vp02 = ( const float * ALIGNED(64) ) ( f0 + ii( 2) );
+    vp03 = ( const float * ALIGNED(64) ) ( f0 + ii( 3) );
+    vp04 = ( const float * ALIGNED(64) ) ( f0 + ii( 4) );
+    vp05 = ( const float * ALIGNED(64) ) ( f0 + ii( 5) );
+    vp06 = ( const float * ALIGNED(64) ) ( f0 + ii( 6) );
+    vp07 = ( const float * ALIGNED(64) ) ( f0 + ii( 7) );
+    vp08 = ( const float * ALIGNED(64) ) ( f0 + ii( 8) );
+    vp09 = ( const float * ALIGNED(64) ) ( f0 + ii( 9) );
+    vp10 = ( const float * ALIGNED(64) ) ( f0 + ii(10) );
+    vp11 = ( const float * ALIGNED(64) ) ( f0 + ii(11) );
+    vp12 = ( const float * ALIGNED(64) ) ( f0 + ii(12) );
+    vp13 = ( const float * ALIGNED(64) ) ( f0 + ii(13) );
+    vp14 = ( const float * ALIGNED(64) ) ( f0 + ii(14) );
+    vp15 = ( const float * ALIGNED(64) ) ( f0 + ii(15) );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles.
+    //--------------------------------------------------------------------------
+    load_16x16_tr( vp00, vp01, vp02, vp03,
+                   vp04, vp05, vp06, vp07,
+                   vp08, vp09, vp10, vp11,
+                   vp12, vp13, vp14, vp15,
+                   ex, v00, v01, v02, ey, v03, v04, v05,
+                   ez, v06, v07, v08, cbx, v09, cby, v10 );
+
+    ex = fma( fma( v02, dy, v01 ), dz, fma( v00, dy, ex ) );
+
+    ey = fma( fma( v05, dz, v04 ), dx, fma( v03, dz, ey ) );
+
+    ez = fma( fma( v08, dx, v07 ), dy, fma( v06, dx, ez ) );
+
+    cbx = fma( v09, dx, cbx );
+
+    cby = fma( v10, dy, cby );
+
+    load_16x2_tr( vp00+16, vp01+16, vp02+16, vp03+16,
+                  vp04+16, vp05+16, vp06+16, vp07+16,
+                  vp08+16, vp09+16, vp10+16, vp11+16,
+                  vp12+16, vp13+16, vp14+16, vp15+16,
+                  cbz, v05 );
+
+    cbz = fma( v05, dz, cbz );
+
+    //--------------------------------------------------------------------------
+    // Advance the momentum to the time of the position: half an electric
+    // field push and half a Boris rotation.
+    //--------------------------------------------------------------------------
+    ux = fma( ex, qdt_2mc, ux );
+    uy = fma( ey, qdt_2mc, uy );
+    uz = fma( ez, qdt_2mc, uz );
+
+    ke_mc = fma( ux, ux, fma( uy, uy, uz*uz ) ); // ke_mc = |u|^2
+    vz    = sqrt( one + ke_mc );                 // vz = gamma
+    ke_mc = ( c * ke_mc ) / ( vz + one );        // ke_mc = c*(gamma-1)
+    vz    = c / vz;                              // vz = c/gamma
+
+    v00  = qdt_4mc2*vz;
+    v01  = fma( cbx, cbx, fma( cby, cby, cbz*cbz ) );
+    v02  = (v00*v00)*v01;
+    v03  = v00*fma( fma( two_fifteenths, v02, one_third ), v02, one );
+    v04  = v03 / fma( v03*v03, v01, one );
+    v04 += v04;
+
+    v00  = fma( fms(  uy, cbz,  uz*cby ), v03, ux );
+    v01  = fma( fms(  uz, cbx,  ux*cbz ), v03, uy );
+    v02  = fma( fms(  ux, cby,  uy*cbx ), v03, uz );
+
+    ux   = fma( fms( v01, cbz, v02*cby ), v04, ux );
+    uy   = fma( fms( v02, cbx, v00*cbz ), v04, uy );
+    uz   = fma( fms( v00, cby, v01*cbx ), v04, uz );
+
+    vx  = ux*vz;
+    vy  = uy*vz;
+    vz *= uz;
+
+    //--------------------------------------------------------------------------
+    // Compute the trilinear coefficients.
+    //--------------------------------------------------------------------------
+    w0  = r8V*w;       // w0 = (1/8)(w/V)
+    dx *= w0;          // dx = (1/8)(w/V) x
+    w1  = w0+dx;       // w1 = (1/8)(w/V)(1+x)
+    w0 -= dx;          // w0 = (1/8)(w/V)(1-x)
+    w3  = one+dy;      // w3 = 1+y
+    w2  = w0*w3;       // w2 = (1/8)(w/V)(1-x)(1+y)
+    w3 *= w1;          // w3 = (1/8)(w/V)(1+x)(1+y)
+    dy  = one-dy;      // dy = 1-y
+    w0 *= dy;          // w0 = (1/8)(w/V)(1-x)(1-y)
+    w1 *= dy;          // w1 = (1/8)(w/V)(1+x)(1-y)
+    w7  = one+dz;      // w7 = 1+z
+    w4  = w0*w7;       // w4 = (w/V) trilin_0
+    w5  = w1*w7;       // w5 = (w/V) trilin_1
+    w6  = w2*w7;       // w6 = (w/V) trilin_2
+    w7 *= w3;          // w7 = (w/V) trilin_3
+    dz  = one-dz;      // dz = 1-z
+    w0 *= dz;          // w0 = (w/V) trilin_4
+    w1 *= dz;          // w1 = (w/V) trilin_5
+    w2 *= dz;          // w2 = (w/V) trilin_6
+    w3 *= dz;          // w3 = (w/V) trilin_7
+
+    //--------------------------------------------------------------------------
+    // Accumulate the hydro fields.  The 16 hydro_t components of a node are
+    // computed for 16 particles, transposed to one row per particle and
+    // added to the hydro array with vector operations.
+    //--------------------------------------------------------------------------
+
+#   define INCREMENT_HYDRO( j, r, offset )                             \
+    increment_16x1( ( float * ALIGNED(64) ) ( h + ii(j) + (offset) ), r )
+
+#   define ACCUMULATE_HYDRO( wn, offset )                              \
+    t   = qsp*wn;     /* t   = (qsp w/V) trilin_n */                   \
+    v00 = t*vx;       /* jx  */                                        \
+    v01 = t*vy;       /* jy  */                                        \
+    v02 = t*vz;       /* jz  */                                        \
+    v03 = t;          /* rho */                                        \
+    t   = mspc*wn;    /* t   = (msp c w/V) trilin_n */                 \
+    v04 = t*ux;       /* px  */                                        \
+    v05 = t*uy;       /* py  */                                        \
+    v06 = t*uz;       /* pz  */                                        \
+    v07 = t*ke_mc;    /* ke  */                                        \
+    v08 = v04*vx;     /* txx */                                        \
+    v09 = v05*vy;     /* tyy */                                        \
+    v10 = v06*vz;     /* tzz */                                        \
+    v11 = v05*vz;     /* tyz */                                        \
+    v12 = v06*vx;     /* tzx */                                        \
+    v13 = v04*vy;     /* txy */                                        \
+    v14 = zero;                                                        \
+    v15 = zero;                                                        \
+    transpose( v00, v01, v02, v03, v04, v05, v06, v07,                 \
+               v08, v09, v10, v11, v12, v13, v14, v15 );               \
+    INCREMENT_HYDRO(  0, v00, offset );                                \
+    INCREMENT_HYDRO(  1, v01, offset );                                \
+    INCREMENT_HYDRO(  2, v02, offset );                                \
+    INCREMENT_HYDRO(  3, v03, offset );                                \
+    INCREMENT_HYDRO(  4, v04, offset );                                \
+    INCREMENT_HYDRO(  5, v05, offset );                                \
+    INCREMENT_HYDRO(  6, v06, offset );                                \
+    INCREMENT_HYDRO(  7, v07, offset );                                \
+    INCREMENT_HYDRO(  8, v08, offset );                                \
+    INCREMENT_HYDRO(  9, v09, offset );                                \
+    INCREMENT_HYDRO( 10, v10, offset );                                \
+    INCREMENT_HYDRO( 11, v11, offset );                                \
+    INCREMENT_HYDRO( 12, v12, offset );                                \
+    INCREMENT_HYDRO( 13, v13, offset );                                \
+    INCREMENT_HYDRO( 14, v14, offset );                                \
+    INCREMENT_HYDRO( 15, v15, offset )
+
+    ACCUMULATE_HYDRO( w0, 0           ); // Cell i,j,k
+    ACCUMULATE_HYDRO( w1, sx          ); // Cell i+1,j,k
+    ACCUMULATE_HYDRO( w2, sy          ); // Cell i,j+1,k
+    ACCUMULATE_HYDRO( w3, sx+sy       ); // Cell i+1,j+1,k
+    ACCUMULATE_HYDRO( w4, sz          ); // Cell i,j,k+1
+    ACCUMULATE_HYDRO( w5, sz+sx       ); // Cell i+1,j,k+1
+    ACCUMULATE_HYDRO( w6, sz+sy       ); // Cell i,j+1,k+1
+    ACCUMULATE_HYDRO( w7, sz+sy+sx    ); // Cell i+1,j+1,k+1
+
+#   undef ACCUMULATE_HYDRO
+#   undef INCREMENT_HYDRO
+  }
+}
+
+SIMD_KERNEL_END
+
+#else
+
+void
+accumulate_hydro_p_pipeline_v16( accumulate_hydro_p_pipeline_args_t * args,
+                                 int pipeline_rank,
+                                 int n_pipeline )
+{
+  // No v16 implementation.
+  ERROR( ( "No accumulate_hydro_p_pipeline_v16 implementation." ) );
+}
+
+#endif
@@ -0,0 +1,267 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V4_ACCELERATION)
+
+using namespace v4;
+
+SIMD_KERNEL_BEGIN
+
+void
+accumulate_hydro_p_pipeline_v4( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+  const particle_block_t * RESTRICT ALIGNED(128) p0 = args->p0;
+  const interpolator_t   * RESTRICT ALIGNED(128) f0 = args->f0;
+#if defined(VPIC_USE_COMPACT_P)
+  const particle_t       * RESTRICT ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 4 );
+#else
+  const particle_block_t * RESTRICT ALIGNED(128) p;
+#endif
+
+  hydro_t * RESTRICT ALIGNED(128) h;
+
+  const float          * RESTRICT ALIGNED(16)  vp00;
+  const float          * RESTRICT ALIGNED(16)  vp01;
+  const float          * RESTRICT ALIGNED(16)  vp02;
+  const float          * RESTRICT ALIGNED(16)  vp03;
+
+  float                * ALIGNED(16)           vh;
+
+  // Basic constants.
+  const v4float qdt_2mc(args->qdt_2mc);
+  const v4float qdt_4mc2(args->qdt_2mc/(2*args->cvac));
+  const v4float c(args->cvac);
+  const v4float qsp(args->qsp);
+  const v4float mspc(args->msp*args->cvac);
+  const v4float r8V(args->r8V);
+  const v4float one(1.0);
+  const v4float one_third(1.0/3.0);
+  const v4float two_fifteenths(2.0/15.0);
+  const v4float zero(0.0);
+
+  // Voxel offsets of the 8 nodes a particle contributes to, in the order
+  // of the reference implementation.
+  const int sx  = 1;
+  const int sy  = args->nx + 2;
+  const int sz  = ( args->nx + 2 )*( args->ny + 2 );
+
+  v4float dx, dy, dz, ux, uy, uz, w;
+  v4float ex, ey, ez, cbx, cby, cbz;
+  v4float vx, vy, vz, ke_mc, t;
+  v4float w0, w1, w2, w3, w4, w5, w6, w7;
+  v4float v00, v01, v02, v03, v04, v05, v06, v07;
+  v4float v08, v09, v10, v11, v12, v13, v14, v15;
+  v4int   ii;
+
+  int64_t n, nq;
+
+  // Determine which particle blocks this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n, nq );
+
+  nq >>= 2;
+
+  // Determine which hydro array to use.
+
+  h = pipeline_hydro_array( args->h, args->hp, args->stride,
+                            pipeline_rank, n_pipeline );
+
+  // Process the particle blocks for this pipeline.
+
+  for( ; nq; nq--, n+=4 )
+  {
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, n, p_bundle, 4 );
+    p = p_bundle;
+#   else
+    p = p0 + n/PARTICLE_BLOCK_SIZE;
+#   endif
+
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    const int l = n%PARTICLE_BLOCK_SIZE;
+
+    load_4x1( &p->dx[l], dx );
+    load_4x1( &p->dy[l], dy );
+    load_4x1( &p->dz[l], dz );
+    load_4x1( &p->i [l], ii );
+    load_4x1( &p->ux[l], ux );
+    load_4x1( &p->uy[l], uy );
+    load_4x1( &p->uz[l], uz );
+    load_4x1( &p->w [l], w  );
+#   else
+    load_4x4_tr( &p[0].dx, &p[1].dx, &p[2].dx, &p[3].dx,
+                 dx, dy, dz, ii );
+    load_4x4_tr( &p[0].ux, &p[1].ux, &p[2].ux, &p[3].ux,
+                 ux, uy, uz, w );
+#   endif
+
+    //--------------------------------------------------------------------------
+    // Set field interpolation pointers.
+    //--------------------------------------------------------------------------
+    vp00 = ( const float * ALIGNED(16) ) ( f0 + ii(0) );
+    vp01 = ( const float * ALIGNED(16) ) ( f0 + ii(1) );
+    vp02 = ( const float * ALIGNED(16) ) ( f0 + ii(2) );
+    vp03 = ( const float * ALIGNED(16) ) ( f0 + ii(3) );
+
+    //--------------------------------------------------------------------------
+    // Load interpolation data for particles.
+    //--------------------------------------------------------------------------
+    load_4x4_tr( vp00, vp01, vp02, vp03,
+                 ex, v00, v01, v02 );
+
+    ex = fma( fma( v02, dy, v01 ), dz, fma( v00, dy, ex ) );
+
+    load_4x4_tr( vp00+4, vp01+4, vp02+4, vp03+4,
+                 ey, v03, v04, v05 );
+
+    ey = fma( fma( v05, dz, v04 ), dx, fma( v03, dz, ey ) );
+
+    load_4x4_tr( vp00+8, vp01+8, vp02+8, vp03+8,
+                 ez, v00, v01, v02 );
+
+    ez = fma( fma( v02, dx, v01 ), dy, fma( v00, dx, ez ) );
+
+    load_4x4_tr( vp00+12, vp01+12, vp02+12, vp03+12,
+                 cbx, v03, cby, v04 );
+
+    cbx = fma( v03, dx, cbx );
+
+    cby = fma( v04, dy, cby );
+
+    load_4x2_tr( vp00+16, vp01+16, vp02+16, vp03+16,
+                 cbz, v05 );
+
+    cbz = fma( v05, dz, cbz );
+
+    //--------------------------------------------------------------------------
+    // Advance the momentum to the time of the position: half an electric
+    // field push and half a Boris rotation.
+    //--------------------------------------------------------------------------
+    ux = fma( ex, qdt_2mc, ux );
+    uy = fma( ey, qdt_2mc, uy );
+    uz = fma( ez, qdt_2mc, uz );
+
+    ke_mc = fma( ux, ux, fma( uy, uy, uz*uz ) ); // ke_mc = |u|^2
+    vz    = sqrt( one + ke_mc );                 // vz = gamma
+    ke_mc = ( c * ke_mc ) / ( vz + one );        // ke_mc = c*(gamma-1)
+    vz    = c / vz;                              // vz = c/gamma
+
+    v00  = qdt_4mc2*vz;
+    v01  = fma( cbx, cbx, fma( cby, cby, cbz*cbz ) );
+    v02  = (v00*v00)*v01;
+    v03  = v00*fma( fma( two_fifteenths, v02, one_third ), v02, one );
+    v04  = v03 / fma( v03*v03, v01, one );
+    v04 += v04;
+
+    v00  = fma( fms(  uy, cbz,  uz*cby ), v03, ux );
+    v01  = fma( fms(  uz, cbx,  ux*cbz ), v03, uy );
+    v02  = fma( fms(  ux, cby,  uy*cbx ), v03, uz );
+
+    ux   = fma( fms( v01, cbz, v02*cby ), v04, ux );
+    uy   = fma( fms( v02, cbx, v00*cbz ), v04, uy );
+    uz   = fma( fms( v00, cby, v01*cbx ), v04, uz );
+
+    vx  = ux*vz;
+    vy  = uy*vz;
+    vz *= uz;
+
+    //--------------------------------------------------------------------------
+    // Compute the trilinear coefficients.
+    //--------------------------------------------------------------------------
+    w0  = r8V*w;       // w0 = (1/8)(w/V)
+    dx *= w0;          // dx = (1/8)(w/V) x
+    w1  = w0+dx;       // w1 = (1/8)(w/V)(1+x)
+    w0 -= dx;          // w0 = (1/8)(w/V)(1-x)
+    w3  = one+dy;      // w3 = 1+y
+    w2  = w0*w3;       // w2 = (1/8)(w/V)(1-x)(1+y)
+    w3 *= w1;          // w3 = (1/8)(w/V)(1+x)(1+y)
+    dy  = one-dy;      // dy = 1-y
+    w0 *= dy;          // w0 = (1/8)(w/V)(1-x)(1-y)
+    w1 *= dy;          // w1 = (1/8)(w/V)(1+x)(1-y)
+    w7  = one+dz;      // w7 = 1+z
+    w4  = w0*w7;       // w4 = (w/V) trilin_0
+    w5  = w1*w7;       // w5 = (w/V) trilin_1
+    w6  = w2*w7;       // w6 = (w/V) trilin_2
+    w7 *= w3;          // w7 = (w/V) trilin_3
+    dz  = one-dz;      // dz = 1-z
+    w0 *= dz;          // w0 = (w/V) trilin_4
+    w1 *= dz;          // w1 = (w/V) trilin_5
+    w2 *= dz;          // w2 = (w/V) trilin_6
+    w3 *= dz;          // w3 = (w/V) trilin_7
+
+    //--------------------------------------------------------------------------
+    // Accumulate the hydro fields.  The 16 hydro_t components of a node are
+    // computed for 4 particles, transposed to one row per particle and added
+    // to the hydro array with vector operations.
+    //--------------------------------------------------------------------------
+
+#   define INCREMENT_HYDRO( j, r0, r1, r2, r3, offset )                \
+    vh = ( float * ALIGNED(16) ) ( h + ii(j) + (offset) );             \
+    increment_4x1( vh,    r0 );                                        \
+    increment_4x1( vh+4,  r1 );                                        \
+    increment_4x1( vh+8,  r2 );                                        \
+    increment_4x1( vh+12, r3 )
+
+#   define ACCUMULATE_HYDRO( wn, offset )                              \
+    t   = qsp*wn;     /* t   = (qsp w/V) trilin_n */                   \
+    v00 = t*vx;       /* jx  */                                        \
+    v01 = t*vy;       /* jy  */                                        \
+    v02 = t*vz;       /* jz  */                                        \
+    v03 = t;          /* rho */                                        \
+    t   = mspc*wn;    /* t   = (msp c w/V) trilin_n */                 \
+    v04 = t*ux;       /* px  */                                        \
+    v05 = t*uy;       /* py  */                                        \
+    v06 = t*uz;       /* pz  */                                        \
+    v07 = t*ke_mc;    /* ke  */                                        \
+    v08 = v04*vx;     /* txx */                                        \
+    v09 = v05*vy;     /* tyy */                                        \
+    v10 = v06*vz;     /* tzz */                                        \
+    v11 = v05*vz;     /* tyz */                                        \
+    v12 = v06*vx;     /* tzx */                                        \
+    v13 = v04*vy;     /* txy */                                        \
+    v14 = zero;                                                        \
+    v15 = zero;                                                        \
+    transpose( v00, v01, v02, v03 );                                   \
+    transpose( v04, v05, v06, v07 );                                   \
+    transpose( v08, v09, v10, v11 );                                   \
+    transpose( v12, v13, v14, v15 );                                   \
+    INCREMENT_HYDRO( 0, v00, v04, v08, v12, offset );                  \
+    INCREMENT_HYDRO( 1, v01, v05, v09, v13, offset );                  \
+    INCREMENT_HYDRO( 2, v02, v06, v10, v14, offset );                  \
+    INCREMENT_HYDRO( 3, v03, v07, v11, v15, offset )
+
+    ACCUMULATE_HYDRO( w0, 0           ); // Cell i,j,k
+    ACCUMULATE_HYDRO( w1, sx          ); // Cell i+1,j,k
+    ACCUMULATE_HYDRO( w2, sy          ); // Cell i,j+1,k
+    ACCUMULATE_HYDRO( w3, sx+sy       ); // Cell i+1,j+1,k
+    ACCUMULATE_HYDRO( w4, sz          ); // Cell i,j,k+1
+    ACCUMULATE_HYDRO( w5, sz+sx       ); // Cell i+1,j,k+1
+    ACCUMULATE_HYDRO( w6, sz+sy       ); // Cell i,j+1,k+1
+    ACCUMULATE_HYDRO( w7, sz+sy+sx    ); // Cell i+1,j+1,k+1
+
+#   undef ACCUMULATE_HYDRO
+#   undef INCREMENT_HYDRO
+  }
+}
+
+SIMD_KERNEL_END
+
+#else
+
+void
+accumulate_hydro_p_pipeline_v4( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+  // No v4 implementation.
+  ERROR( ( "No accumulate_hydro_p_pipeline_v4 implementation." ) );
+}
+
+#endif
@@ -0,0 +1,375 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V16_ACCELERATION)
+
+using namespace v16;
+
+SIMD_KERNEL_BEGIN
+
+// See spa_private.h.  Each of the 16 lanes moves one queued particle.  When
+// the particle of a lane is done, the lane takes the next particle from the
+// queue, so the lanes stay busy when some particles cross several faces.
+// The streaks are computed and accumulated with vector operations as in
+// advance_p_pipeline_v16.  Streaks that end on a face are handled per lane as
+// in move_p.
+
+int64_t
+move_p_batch_v16( particle_block_t * ALIGNED(128) p0,
+                 particle_mover_t * ALIGNED(128) pq,
+                 int64_t                         nq,
+                 accumulator_t    * ALIGNED(128) a0,
+                 const grid_t     *              g,
+                 const float                     qsp,
+                 const int                       tile )
+{
+  float                * ALIGNED(64)  vp00;
+  float                * ALIGNED(64)  vp01;
+  float                * ALIGNED(64)  vp02;
+  float                * ALIGNED(64)  vp03;
+  float                * ALIGNED(64)  vp04;
+  float                * ALIGNED(64)  vp05;
+  float                * ALIGNED(64)  vp06;
+  float                * ALIGNED(64)  vp07;
+  float                * ALIGNED(64)  vp08;
+  float                * ALIGNED(64)  vp09;
+  float                * ALIGNED(64)  vp10;
+  float                * ALIGNED(64)  vp11;
+  float                * ALIGNED(64)  vp12;
+  float                * ALIGNED(64)  vp13;
+  float                * ALIGNED(64)  vp14;
+  float                * ALIGNED(64)  vp15;
+
+  const v16float one(1.0);
+  const v16float one_third(1.0/3.0);
+  const v16float tiny(1e-37);
+
+  v16float dx, dy, dz, ux, uy, uz, q;
+  v16float rx, ry, rz, sx, sy, sz, s;
+  v16float v00, v01, v02, v03, v04, v05, v06, v07;
+  v16float v08, v09, v10, v11, v12, v13, v14, v15;
+
+  // State of each lane: its particle, position, remaining displacement,
+  // charge (0 for an idle lane), voxel and queue slot (-1 for an idle lane).
+
+  DECLARE_ALIGNED_ARRAY( particle_t, 64, p, 16 );
+  DECLARE_ALIGNED_ARRAY( float, 64, lrx, 16 );
+  DECLARE_ALIGNED_ARRAY( float, 64, lry, 16 );
+  DECLARE_ALIGNED_ARRAY( float, 64, lrz, 16 );
+  DECLARE_ALIGNED_ARRAY( float, 64, ldx, 16 );
+  DECLARE_ALIGNED_ARRAY( float, 64, ldy, 16 );
+  DECLARE_ALIGNED_ARRAY( float, 64, ldz, 16 );
+  DECLARE_ALIGNED_ARRAY( float, 64, lfx, 16 );
+  DECLARE_ALIGNED_ARRAY( float, 64, lfy, 16 );
+  DECLARE_ALIGNED_ARRAY( float, 64, lfz, 16 );
+  DECLARE_ALIGNED_ARRAY( float, 64, lq,  16 );
+  int32_t voxel[16];
+  int64_t slot[16];
+
+  float * RESTRICT lr[3] = { lrx, lry, lrz };
+  float * RESTRICT ld[3] = { ldx, ldy, ldz };
+
+  int64_t next, j, neighbor;
+  int n_busy, l, type, face;
+  float f, sgn;
+
+  if ( nq < 1 ) return 0;
+
+  // Idle lanes accumulate nothing into a voxel that is known to be valid.
+
+  for( l = 0; l < 16; l++ )
+  {
+    voxel[l] = PARTICLE_VOXEL( p0, pq[0].i );
+    slot [l] = -1;
+    lrx[l] = lry[l] = lrz[l] = 0;
+    ldx[l] = ldy[l] = ldz[l] = 0;
+    lq [l] = 0;
+  }
+
+# define START_LANE(l)                                                  \
+  if ( next < nq )                                                      \
+  {                                                                     \
+    load_particle( p0, pq[next].i, p + (l) );                           \
+    lrx  [l] = p[l].dx;                                                 \
+    lry  [l] = p[l].dy;                                                 \
+    lrz  [l] = p[l].dz;                                                 \
+    ldx  [l] = pq[next].dispx;                                          \
+    ldy  [l] = pq[next].dispy;                                          \
+    ldz  [l] = pq[next].dispz;                                          \
+    lq   [l] = qsp*p[l].w;                                              \
+    voxel[l] = p[l].i;                                                  \
+    slot [l] = next++;                                                  \
+    n_busy++;                                                           \
+  }                                                                     \
+  else                                                                  \
+  {                                                                     \
+    ldx[l] = ldy[l] = ldz[l] = 0;                                       \
+    lq [l] = 0;                                                         \
+    slot[l] = -1;                                                       \
+  }
+
+  // Finish the move of the particle in lane l.  If the particle hit a
+  // boundary the queue slot keeps the mover with the remaining
+  // displacement, otherwise it is marked free.
+
+# if defined(VPIC_USE_COMPACT_P)
+# define SNAP_LANE(l) snap_p( p + (l), a0, qsp, voxel[l] )
+# else
+# define SNAP_LANE(l)
+# endif
+
+# define FINISH_LANE(l,in_use)                                          \
+  p[l].dx = lrx[l];                                                     \
+  p[l].dy = lry[l];                                                     \
+  p[l].dz = lrz[l];                                                     \
+  SNAP_LANE(l);                                                         \
+  store_particle( p + (l), p0, pq[ slot[l] ].i );                       \
+  if ( in_use )                                                         \
+  {                                                                     \
+    pq[ slot[l] ].dispx = ldx[l];                                       \
+    pq[ slot[l] ].dispy = ldy[l];                                       \
+    pq[ slot[l] ].dispz = ldz[l];                                       \
+  }                                                                     \
+  else                                                                  \
+  {                                                                     \
+    pq[ slot[l] ].i = -1;                                               \
+  }                                                                     \
+  n_busy--;                                                             \
+  START_LANE(l)
+
+  next   = 0;
+  n_busy = 0;
+
+  for( l = 0; l < 16; l++ )
+  {
+    START_LANE(l)
+  }
+
+  while( n_busy )
+  {
+    //--------------------------------------------------------------------------
+    // Load the lanes.
+    //--------------------------------------------------------------------------
+    load_16x1( lrx, rx );
+    load_16x1( lry, ry );
+    load_16x1( lrz, rz );
+    load_16x1( ldx, dx );
+    load_16x1( ldy, dy );
+    load_16x1( ldz, dz );
+    load_16x1( lq,  q  );
+
+    //--------------------------------------------------------------------------
+    // Determine the fractional length of the current streak.  The streak
+    // ends on the first face intersected by the particle track or at the
+    // end of the particle track (see move_p).
+    //--------------------------------------------------------------------------
+    sx = copysign( one, dx );
+    sy = copysign( one, dy );
+    sz = copysign( one, dz );
+
+    sx = ( sx - rx ) / ( ( dx + dx ) + copysign( tiny, dx ) );
+    sy = ( sy - ry ) / ( ( dy + dy ) + copysign( tiny, dy ) );
+    sz = ( sz - rz ) / ( ( dz + dz ) + copysign( tiny, dz ) );
+
+    s  = one;
+    s  = merge( sx < s, sx, s );
+    s  = merge( sy < s, sy, s );
+    s  = merge( sz < s, sz, s );
+
+    //--------------------------------------------------------------------------
+    // Compute the streak midpoint and normalized displacement and update
+    // the particle position and remaining displacement.
+    //--------------------------------------------------------------------------
+    ux  = s*dx;
+    uy  = s*dy;
+    uz  = s*dz;
+
+    v00 = rx + ux;
+    v01 = ry + uy;
+    v02 = rz + uz;
+
+    dx -= ux;
+    dy -= uy;
+    dz -= uz;
+
+    rx += ux + ux;
+    ry += uy + uy;
+    rz += uz + uz;
+
+    store_16x1( rx, lrx );
+    store_16x1( ry, lry );
+    store_16x1( rz, lrz );
+    store_16x1( dx, ldx );
+    store_16x1( dy, ldy );
+    store_16x1( dz, ldz );
+    store_16x1( sx, lfx );
+    store_16x1( sy, lfy );
+    store_16x1( sz, lfz );
+
+    dx = v00;                      // Streak midpoint
+    dy = v01;
+    dz = v02;
+
+    v13 = q*ux*uy*uz*one_third;    // Charge conservation correction
+
+    //--------------------------------------------------------------------------
+    // Accumulate current density (see advance_p_pipeline_v16).
+    //--------------------------------------------------------------------------
+    vp00 = ( float * ALIGNED(64) ) ( a0 + voxel[ 0] );
+    vp01 = ( float * ALIGNED(64) ) ( a0 + voxel[ 1] );
+    vp02 = ( float * ALIGNED(64) ) ( a0 + voxel[ 2] );
+    vp03 = ( float * ALIGNED(64) ) ( a0 + voxel[ 3] );
+    vp04 = ( float * ALIGNED(64) ) ( a0 + voxel[ 4] );
+    vp05 = ( float * ALIGNED(64) ) ( a0 + voxel[ 5] );
+    vp06 = ( float * ALIGNED(64) ) ( a0 + voxel[ 6] );
+    vp07 = ( float * ALIGNED(64) ) ( a0 + voxel[ 7] );
+    vp08 = ( float * ALIGNED(64) ) ( a0 + voxel[ 8] );
+    vp09 = ( float * ALIGNED(64) ) ( a0 + voxel[ 9] );
+    vp10 = ( float * ALIGNED(64) ) ( a0 + voxel[10] );
+    vp11 = ( float * ALIGNED(64) ) ( a0 + voxel[11] );
+    vp12 = ( float * ALIGNED(64) ) ( a0 + voxel[12] );
+    vp13 = ( float * ALIGNED(64) ) ( a0 + voxel[13] );
+    vp14 = ( float * ALIGNED(64) ) ( a0 + voxel[14] );
+    vp15 = ( float * ALIGNED(64) ) ( a0 + voxel[15] );
+
+#   define ACCUMULATE_J(X,Y,Z,v0,v1,v2,v3)                             \
+    v12  = q*u##X;    /* v12 = q ux                            */      \
+    v1   = v12*d##Y;  /* v1  = q ux dy                         */      \
+    v0   = v12-v1;    /* v0  = q ux (1-dy)                     */      \
+    v1  += v12;       /* v1  = q ux (1+dy)                     */      \
+    v12  = one+d##Z;  /* v12 = 1+dz                            */      \
+    v2   = v0*v12;    /* v2  = q ux (1-dy)(1+dz)               */      \
+    v3   = v1*v12;    /* v3  = q ux (1+dy)(1+dz)               */      \
+    v12  = one-d##Z;  /* v12 = 1-dz                            */      \
+    v0  *= v12;       /* v0  = q ux (1-dy)(1-dz)               */      \
+    v1  *= v12;       /* v1  = q ux (1+dy)(1-dz)               */      \
+    v0  += v13;       /* v0  = q ux [ (1-dy)(1-dz) + uy*uz/3 ] */      \
+    v1  -= v13;       /* v1  = q ux [ (1+dy)(1-dz) - uy*uz/3 ] */      \
+    v2  -= v13;       /* v2  = q ux [ (1-dy)(1+dz) - uy*uz/3 ] */      \
+    v3  += v13;       /* v3  = q ux [ (1+dy)(1+dz) + uy*uz/3 ] */
+
+    ACCUMULATE_J( x, y, z, v00, v01, v02, v03 );
+    ACCUMULATE_J( y, z, x, v04, v05, v06, v07 );
+    ACCUMULATE_J( z, x, y, v08, v09, v10, v11 );
+
+    v12 = 0.0;
+    v13 = 0.0;
+    v14 = 0.0;
+    v15 = 0.0;
+
+    transpose( v00, v01, v02, v03, v04, v05, v06, v07,
+               v08, v09, v10, v11, v12, v13, v14, v15 );
+
+    increment_16x1( vp00, v00 );
+    increment_16x1( vp01, v01 );
+    increment_16x1( vp02, v02 );
+    increment_16x1( vp03, v03 );
+    increment_16x1( vp04, v04 );
+    increment_16x1( vp05, v05 );
+    increment_16x1( vp06, v06 );
+    increment_16x1( vp07, v07 );
+    increment_16x1( vp08, v08 );
+    increment_16x1( vp09, v09 );
+    increment_16x1( vp10, v10 );
+    increment_16x1( vp11, v11 );
+    increment_16x1( vp12, v12 );
+    increment_16x1( vp13, v13 );
+    increment_16x1( vp14, v14 );
+    increment_16x1( vp15, v15 );
+
+#   undef ACCUMULATE_J
+
+    //--------------------------------------------------------------------------
+    // Finish the particles whose streak ended at the end of their track and
+    // move the others through the face they hit.
+    //--------------------------------------------------------------------------
+    for( l = 0; l < 16; l++ )
+    {
+      if ( slot[l] < 0 ) continue;
+
+      /**/                type = 3; f = 1;   // Same choice as above
+      if ( lfx[l] < f ) { type = 0; f = lfx[l]; }
+      if ( lfy[l] < f ) { type = 1; f = lfy[l]; }
+      if ( lfz[l] < f ) { type = 2; f = lfz[l]; }
+
+      if ( type == 3 )
+      {
+        p[l].i = voxel[l];
+        FINISH_LANE( l, 0 );
+        continue;
+      }
+
+      sgn = ( ld[type][l] > 0 ) ? 1.f : -1.f;
+      lr[type][l] = sgn;           // Put the particle _exactly_ on the face
+      face = type; if ( sgn > 0 ) face += 3;
+      neighbor = g->neighbor[ 6*voxel[l] + face ];
+
+      if ( UNLIKELY( neighbor == reflect_particles ) )
+      {
+        // Reflect the momentum and remaining displacement.
+        (&(p[l].ux))[type] = -(&(p[l].ux))[type];
+        ld[type][l]        = -ld[type][l];
+        continue;
+      }
+
+      if ( UNLIKELY( neighbor < g->rangel || neighbor > g->rangeh ) )
+      {
+        // Cannot handle the boundary condition here.
+        p[l].i = 8*voxel[l] + face;
+        FINISH_LANE( l, 1 );
+        continue;
+      }
+
+#     if defined(VPIC_USE_TILE_ACCUMULATORS)
+      if ( UNLIKELY( tile &&
+                     neighbor - g->rangel !=
+                     voxel[l] + ( face<3 ? -1 : 1 )*(&g->sx)[type] ) )
+      {
+        // Crossed into a voxel that might not be in the tile.
+        p[l].i = 8*voxel[l] + face;
+        FINISH_LANE( l, 1 );
+        continue;
+      }
+#     endif
+
+      // Crossed into a normal voxel.
+      voxel[l]    = (int32_t)( neighbor - g->rangel );
+      lr[type][l] = -sgn;
+    }
+  }
+
+# undef FINISH_LANE
+# undef SNAP_LANE
+# undef START_LANE
+
+  // Keep the movers still in use, in queue order.
+
+  for( next = 0, j = 0; next < nq; next++ )
+  {
+    if ( pq[next].i >= 0 ) pq[j++] = pq[next];
+  }
+
+  return j;
+}
+
+SIMD_KERNEL_END
+
+#else
+
+int64_t
+move_p_batch_v16( particle_block_t * ALIGNED(128) p0,
+                 particle_mover_t * ALIGNED(128) pq,
+                 int64_t                         nq,
+                 accumulator_t    * ALIGNED(128) a0,
+                 const grid_t     *              g,
+                 const float                     qsp,
+                 const int                       tile )
+{
+  // No v16 implementation.
+  ERROR( ( "No move_p_batch_v16 implementation." ) );
+
+  return 0;
+}
+
+#endif
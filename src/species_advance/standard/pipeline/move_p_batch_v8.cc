@@ -0,0 +1,361 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V8_ACCELERATION)
+
+using namespace v8;
+
+SIMD_KERNEL_BEGIN
+
+// See spa_private.h.  Each of the 8 lanes moves one queued particle.  When
+// the particle of a lane is done, the lane takes the next particle from the
+// queue, so the lanes stay busy when some particles cross several faces.
+// The streaks are computed and accumulated with vector operations as in
+// advance_p_pipeline_v8.  Streaks that end on a face are handled per lane as
+// in move_p.
+
+int64_t
+move_p_batch_v8( particle_block_t * ALIGNED(128) p0,
+                 particle_mover_t * ALIGNED(128) pq,
+                 int64_t                         nq,
+                 accumulator_t    * ALIGNED(128) a0,
+                 const grid_t     *              g,
+                 const float                     qsp,
+                 const int                       tile )
+{
+  float                * ALIGNED(32)  vp00;
+  float                * ALIGNED(32)  vp01;
+  float                * ALIGNED(32)  vp02;
+  float                * ALIGNED(32)  vp03;
+  float                * ALIGNED(32)  vp04;
+  float                * ALIGNED(32)  vp05;
+  float                * ALIGNED(32)  vp06;
+  float                * ALIGNED(32)  vp07;
+
+  const v8float one(1.0);
+  const v8float one_third(1.0/3.0);
+  const v8float tiny(1e-37);
+
+  v8float dx, dy, dz, ux, uy, uz, q;
+  v8float rx, ry, rz, sx, sy, sz, s;
+  v8float v00, v01, v02, v03, v04, v05, v06, v07, v08, v09;
+
+  // State of each lane: its particle, position, remaining displacement,
+  // charge (0 for an idle lane), voxel and queue slot (-1 for an idle lane).
+
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 8 );
+  DECLARE_ALIGNED_ARRAY( float, 32, lrx, 8 );
+  DECLARE_ALIGNED_ARRAY( float, 32, lry, 8 );
+  DECLARE_ALIGNED_ARRAY( float, 32, lrz, 8 );
+  DECLARE_ALIGNED_ARRAY( float, 32, ldx, 8 );
+  DECLARE_ALIGNED_ARRAY( float, 32, ldy, 8 );
+  DECLARE_ALIGNED_ARRAY( float, 32, ldz, 8 );
+  DECLARE_ALIGNED_ARRAY( float, 32, lfx, 8 );
+  DECLARE_ALIGNED_ARRAY( float, 32, lfy, 8 );
+  DECLARE_ALIGNED_ARRAY( float, 32, lfz, 8 );
+  DECLARE_ALIGNED_ARRAY( float, 32, lq,  8 );
+  int32_t voxel[8];
+  int64_t slot[8];
+
+  float * RESTRICT lr[3] = { lrx, lry, lrz };
+  float * RESTRICT ld[3] = { ldx, ldy, ldz };
+
+  int64_t next, j, neighbor;
+  int n_busy, l, type, face;
+  float f, sgn;
+
+  if ( nq < 1 ) return 0;
+
+  // Idle lanes accumulate nothing into a voxel that is known to be valid.
+
+  for( l = 0; l < 8; l++ )
+  {
+    voxel[l] = PARTICLE_VOXEL( p0, pq[0].i );
+    slot [l] = -1;
+    lrx[l] = lry[l] = lrz[l] = 0;
+    ldx[l] = ldy[l] = ldz[l] = 0;
+    lq [l] = 0;
+  }
+
+# define START_LANE(l)                                                  \
+  if ( next < nq )                                                      \
+  {                                                                     \
+    load_particle( p0, pq[next].i, p + (l) );                           \
+    lrx  [l] = p[l].dx;                                                 \
+    lry  [l] = p[l].dy;                                                 \
+    lrz  [l] = p[l].dz;                                                 \
+    ldx  [l] = pq[next].dispx;                                          \
+    ldy  [l] = pq[next].dispy;                                          \
+    ldz  [l] = pq[next].dispz;                                          \
+    lq   [l] = qsp*p[l].w;                                              \
+    voxel[l] = p[l].i;                                                  \
+    slot [l] = next++;                                                  \
+    n_busy++;                                                           \
+  }                                                                     \
+  else                                                                  \
+  {                                                                     \
+    ldx[l] = ldy[l] = ldz[l] = 0;                                       \
+    lq [l] = 0;                                                         \
+    slot[l] = -1;                                                       \
+  }
+
+  // Finish the move of the particle in lane l.  If the particle hit a
+  // boundary the queue slot keeps the mover with the remaining
+  // displacement, otherwise it is marked free.
+
+# if defined(VPIC_USE_COMPACT_P)
+# define SNAP_LANE(l) snap_p( p + (l), a0, qsp, voxel[l] )
+# else
+# define SNAP_LANE(l)
+# endif
+
+# define FINISH_LANE(l,in_use)                                          \
+  p[l].dx = lrx[l];                                                     \
+  p[l].dy = lry[l];                                                     \
+  p[l].dz = lrz[l];                                                     \
+  SNAP_LANE(l);                                                         \
+  store_particle( p + (l), p0, pq[ slot[l] ].i );                       \
+  if ( in_use )                                                         \
+  {                                                                     \
+    pq[ slot[l] ].dispx = ldx[l];                                       \
+    pq[ slot[l] ].dispy = ldy[l];                                       \
+    pq[ slot[l] ].dispz = ldz[l];                                       \
+  }                                                                     \
+  else                                                                  \
+  {                                                                     \
+    pq[ slot[l] ].i = -1;                                               \
+  }                                                                     \
+  n_busy--;                                                             \
+  START_LANE(l)
+
+  next   = 0;
+  n_busy = 0;
+
+  for( l = 0; l < 8; l++ )
+  {
+    START_LANE(l)
+  }
+
+  while( n_busy )
+  {
+    //--------------------------------------------------------------------------
+    // Load the lanes.
+    //--------------------------------------------------------------------------
+    load_8x1( lrx, rx );
+    load_8x1( lry, ry );
+    load_8x1( lrz, rz );
+    load_8x1( ldx, dx );
+    load_8x1( ldy, dy );
+    load_8x1( ldz, dz );
+    load_8x1( lq,  q  );
+
+    //--------------------------------------------------------------------------
+    // Determine the fractional length of the current streak.  The streak
+    // ends on the first face intersected by the particle track or at the
+    // end of the particle track (see move_p).
+    //--------------------------------------------------------------------------
+    sx = copysign( one, dx );
+    sy = copysign( one, dy );
+    sz = copysign( one, dz );
+
+    sx = ( sx - rx ) / ( ( dx + dx ) + copysign( tiny, dx ) );
+    sy = ( sy - ry ) / ( ( dy + dy ) + copysign( tiny, dy ) );
+    sz = ( sz - rz ) / ( ( dz + dz ) + copysign( tiny, dz ) );
+
+    s  = one;
+    s  = merge( sx < s, sx, s );
+    s  = merge( sy < s, sy, s );
+    s  = merge( sz < s, sz, s );
+
+    //--------------------------------------------------------------------------
+    // Compute the streak midpoint and normalized displacement and update
+    // the particle position and remaining displacement.
+    //--------------------------------------------------------------------------
+    ux  = s*dx;
+    uy  = s*dy;
+    uz  = s*dz;
+
+    v00 = rx + ux;
+    v01 = ry + uy;
+    v02 = rz + uz;
+
+    dx -= ux;
+    dy -= uy;
+    dz -= uz;
+
+    rx += ux + ux;
+    ry += uy + uy;
+    rz += uz + uz;
+
+    store_8x1( rx, lrx );
+    store_8x1( ry, lry );
+    store_8x1( rz, lrz );
+    store_8x1( dx, ldx );
+    store_8x1( dy, ldy );
+    store_8x1( dz, ldz );
+    store_8x1( sx, lfx );
+    store_8x1( sy, lfy );
+    store_8x1( sz, lfz );
+
+    dx = v00;                      // Streak midpoint
+    dy = v01;
+    dz = v02;
+
+    v09 = q*ux*uy*uz*one_third;    // Charge conservation correction
+
+    //--------------------------------------------------------------------------
+    // Accumulate current density (see advance_p_pipeline_v8).
+    //--------------------------------------------------------------------------
+    vp00 = ( float * ALIGNED(32) ) ( a0 + voxel[0] );
+    vp01 = ( float * ALIGNED(32) ) ( a0 + voxel[1] );
+    vp02 = ( float * ALIGNED(32) ) ( a0 + voxel[2] );
+    vp03 = ( float * ALIGNED(32) ) ( a0 + voxel[3] );
+    vp04 = ( float * ALIGNED(32) ) ( a0 + voxel[4] );
+    vp05 = ( float * ALIGNED(32) ) ( a0 + voxel[5] );
+    vp06 = ( float * ALIGNED(32) ) ( a0 + voxel[6] );
+    vp07 = ( float * ALIGNED(32) ) ( a0 + voxel[7] );
+
+#   define ACCUMULATE_J(X,Y,Z,v0,v1,v2,v3)                             \
+    v08  = q*u##X;    /* v08 = q ux                            */      \
+    v1   = v08*d##Y;  /* v1  = q ux dy                         */      \
+    v0   = v08-v1;    /* v0  = q ux (1-dy)                     */      \
+    v1  += v08;       /* v1  = q ux (1+dy)                     */      \
+    v08  = one+d##Z;  /* v08 = 1+dz                            */      \
+    v2   = v0*v08;    /* v2  = q ux (1-dy)(1+dz)               */      \
+    v3   = v1*v08;    /* v3  = q ux (1+dy)(1+dz)               */      \
+    v08  = one-d##Z;  /* v08 = 1-dz                            */      \
+    v0  *= v08;       /* v0  = q ux (1-dy)(1-dz)               */      \
+    v1  *= v08;       /* v1  = q ux (1+dy)(1-dz)               */      \
+    v0  += v09;       /* v0  = q ux [ (1-dy)(1-dz) + uy*uz/3 ] */      \
+    v1  -= v09;       /* v1  = q ux [ (1+dy)(1-dz) - uy*uz/3 ] */      \
+    v2  -= v09;       /* v2  = q ux [ (1-dy)(1+dz) - uy*uz/3 ] */      \
+    v3  += v09;       /* v3  = q ux [ (1+dy)(1+dz) + uy*uz/3 ] */
+
+    ACCUMULATE_J( x, y, z, v00, v01, v02, v03 );
+    ACCUMULATE_J( y, z, x, v04, v05, v06, v07 );
+
+    transpose( v00, v01, v02, v03, v04, v05, v06, v07 );
+
+    increment_8x1( vp00, v00 );
+    increment_8x1( vp01, v01 );
+    increment_8x1( vp02, v02 );
+    increment_8x1( vp03, v03 );
+    increment_8x1( vp04, v04 );
+    increment_8x1( vp05, v05 );
+    increment_8x1( vp06, v06 );
+    increment_8x1( vp07, v07 );
+
+    ACCUMULATE_J( z, x, y, v00, v01, v02, v03 );
+
+    v04 = 0.0;
+    v05 = 0.0;
+    v06 = 0.0;
+    v07 = 0.0;
+
+    transpose( v00, v01, v02, v03, v04, v05, v06, v07 );
+
+    increment_8x1( vp00 + 8, v00 );
+    increment_8x1( vp01 + 8, v01 );
+    increment_8x1( vp02 + 8, v02 );
+    increment_8x1( vp03 + 8, v03 );
+    increment_8x1( vp04 + 8, v04 );
+    increment_8x1( vp05 + 8, v05 );
+    increment_8x1( vp06 + 8, v06 );
+    increment_8x1( vp07 + 8, v07 );
+
+#   undef ACCUMULATE_J
+
+    //--------------------------------------------------------------------------
+    // Finish the particles whose streak ended at the end of their track and
+    // move the others through the face they hit.
+    //--------------------------------------------------------------------------
+    for( l = 0; l < 8; l++ )
+    {
+      if ( slot[l] < 0 ) continue;
+
+      /**/                type = 3; f = 1;   // Same choice as above
+      if ( lfx[l] < f ) { type = 0; f = lfx[l]; }
+      if ( lfy[l] < f ) { type = 1; f = lfy[l]; }
+      if ( lfz[l] < f ) { type = 2; f = lfz[l]; }
+
+      if ( type == 3 )
+      {
+        p[l].i = voxel[l];
+        FINISH_LANE( l, 0 );
+        continue;
+      }
+
+      sgn = ( ld[type][l] > 0 ) ? 1.f : -1.f;
+      lr[type][l] = sgn;           // Put the particle _exactly_ on the face
+      face = type; if ( sgn > 0 ) face += 3;
+      neighbor = g->neighbor[ 6*voxel[l] + face ];
+
+      if ( UNLIKELY( neighbor == reflect_particles ) )
+      {
+        // Reflect the momentum and remaining displacement.
+        (&(p[l].ux))[type] = -(&(p[l].ux))[type];
+        ld[type][l]        = -ld[type][l];
+        continue;
+      }
+
+      if ( UNLIKELY( neighbor < g->rangel || neighbor > g->rangeh ) )
+      {
+        // Cannot handle the boundary condition here.
+        p[l].i = 8*voxel[l] + face;
+        FINISH_LANE( l, 1 );
+        continue;
+      }
+
+#     if defined(VPIC_USE_TILE_ACCUMULATORS)
+      if ( UNLIKELY( tile &&
+                     neighbor - g->rangel !=
+                     voxel[l] + ( face<3 ? -1 : 1 )*(&g->sx)[type] ) )
+      {
+        // Crossed into a voxel that might not be in the tile.
+        p[l].i = 8*voxel[l] + face;
+        FINISH_LANE( l, 1 );
+        continue;
+      }
+#     endif
+
+      // Crossed into a normal voxel.
+      voxel[l]    = (int32_t)( neighbor - g->rangel );
+      lr[type][l] = -sgn;
+    }
+  }
+
+# undef FINISH_LANE
+# undef SNAP_LANE
+# undef START_LANE
+
+  // Keep the movers still in use, in queue order.
+
+  for( next = 0, j = 0; next < nq; next++ )
+  {
+    if ( pq[next].i >= 0 ) pq[j++] = pq[next];
+  }
+
+  return j;
+}
+
+SIMD_KERNEL_END
+
+#else
+
+int64_t
+move_p_batch_v8( particle_block_t * ALIGNED(128) p0,
+                 particle_mover_t * ALIGNED(128) pq,
+                 int64_t                         nq,
+                 accumulator_t    * ALIGNED(128) a0,
+                 const grid_t     *              g,
+                 const float                     qsp,
+                 const int                       tile )
+{
+  // No v8 implementation.
+  ERROR( ( "No move_p_batch_v8 implementation." ) );
+
+  return 0;
+}
+
+#endif
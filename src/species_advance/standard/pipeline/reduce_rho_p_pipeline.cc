@@ -0,0 +1,99 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Node buffers for the accumulate_rho_p and accumulate_rhob_p pipelines.
+// One buffer per pipeline plus one for the host, each padded to 128 bytes.
+//----------------------------------------------------------------------------//
+
+float *
+rho_p_pipeline_buffers( const grid_t * g,
+                        int * stride )
+{
+  static VPIC_THREAD_LOCAL float * ALIGNED(128) scratch = NULL;
+  static VPIC_THREAD_LOCAL size_t           max_scratch = 0;
+
+  size_t sz_scratch;
+
+  *stride = POW2_CEIL( g->nv, 32 );
+
+  sz_scratch = (size_t) ( N_PIPELINE + 1 ) * (size_t) *stride;
+
+  if ( sz_scratch > max_scratch )
+  {
+    FREE_ALIGNED( scratch );
+
+    MALLOC_ALIGNED( scratch, sz_scratch, 128 );
+
+    max_scratch = sz_scratch;
+  }
+
+  return scratch;
+}
+
+//----------------------------------------------------------------------------//
+// Add the node buffers of the pipelines to rhof or rhob.  Each pipeline
+// reduces a block of voxels, adding the buffers in pipeline order so the
+// result does not depend on the number of threads doing the reduction.
+//----------------------------------------------------------------------------//
+
+void
+reduce_rho_p_pipeline_scalar( reduce_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  /**/  field_t * RESTRICT ALIGNED(128) f   = args->f;
+  const float   * RESTRICT ALIGNED(128) rho = args->rho;
+
+  const int     nr = args->n_array;
+  const int64_t sr = args->stride;
+
+  int64_t i, i1;
+  float r;
+  int k;
+
+  DISTRIBUTE( args->n, reduce_rho_n_block, pipeline_rank, n_pipeline, i, i1 );
+
+  i1 += i;
+
+  for( ; i < i1; i++ )
+  {
+    r = rho[i];
+
+    for( k = 1; k < nr; k++ )
+    {
+      r += rho[ i + k*sr ];
+    }
+
+    if ( args->rhob ) f[i].rhob += r;
+    else              f[i].rhof += r;
+  }
+}
+
+void
+reduce_rho_p_pipeline( field_array_t * RESTRICT fa,
+                       const float * RESTRICT rho,
+                       int stride,
+                       int rhob )
+{
+  DECLARE_ALIGNED_ARRAY( reduce_rho_p_pipeline_args_t, 128, args, 1 );
+
+  if ( !fa || !rho )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  args->f       = fa->f;
+  args->rho     = rho;
+  args->n       = fa->g->nv;
+  args->n_array = N_PIPELINE + 1;
+  args->stride  = stride;
+  args->rhob    = rhob;
+
+  EXEC_PIPELINES( reduce_rho_p, args, 0 );
+
+  WAIT_PIPELINES();
+}
@@ -0,0 +1,127 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V16_ACCELERATION)
+
+using namespace v16;
+
+SIMD_KERNEL_BEGIN
+
+void
+accumulate_rho_p_pipeline_v16( accumulate_rho_p_pipeline_args_t * args,
+                               int pipeline_rank,
+                               int n_pipeline )
+{
+  const particle_block_t * RESTRICT ALIGNED(128) p0 = args->p0;
+#if defined(VPIC_USE_COMPACT_P)
+  const particle_t       * RESTRICT ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 16 );
+#else
+  const particle_block_t * RESTRICT ALIGNED(128) p;
+#endif
+
+  float * RESTRICT ALIGNED(128) rho;
+
+  DECLARE_ALIGNED_ARRAY( float, 64, wt, 128 );
+
+  const v16float q_8V(args->q_8V);
+
+  const int sy = args->sy;
+  const int sz = args->sz;
+
+  v16float dx, dy, dz, ux, uy, uz, w;
+  v16float w0, w1, w2, w3, w4, w5, w6, w7;
+  v16int   ii;
+
+  int64_t n, nq;
+  int j, v;
+
+  // Determine which particle blocks this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n, nq );
+
+  nq >>= 4;
+
+  // Determine which node buffer to use.
+
+  rho = pipeline_rho_buffer( args->rho, args->stride, pipeline_rank );
+
+  // Process the particle blocks for this pipeline.
+
+  for( ; nq; nq--, n+=16 )
+  {
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, n, p_bundle, 16 );
+    p = p_bundle;
+#   else
+    p = p0 + n/PARTICLE_BLOCK_SIZE;
+#   endif
+
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    load_16x1( p->dx, dx );
+    load_16x1( p->dy, dy );
+    load_16x1( p->dz, dz );
+    load_16x1( p->i,  ii );
+    load_16x1( p->w,  w  );
+#   else
+    load_16x8_tr_p( &p[ 0].dx, &p[ 2].dx, &p[ 4].dx, &p[ 6].dx,
+                    &p[ 8].dx, &p[10].dx, &p[12].dx, &p[14].dx,
+                    dx, dy, dz, ii, ux, uy, uz, w );
+#   endif
+
+    //--------------------------------------------------------------------------
+    // Compute the trilinear weights.
+    //--------------------------------------------------------------------------
+    w7 = w*q_8V;
+
+    w6 = fnms( dx, w7, w7 );                           // q(1-dx)
+    w7 = fma(  dx, w7, w7 );                           // q(1+dx)
+    w4 = fnms( dy, w6, w6 ); w5 = fnms( dy, w7, w7 );  // q(1-dx)(1-dy), ...
+    w6 = fma(  dy, w6, w6 ); w7 = fma(  dy, w7, w7 );  // q(1-dx)(1+dy), ...
+    w0 = fnms( dz, w4, w4 ); w1 = fnms( dz, w5, w5 );
+    w2 = fnms( dz, w6, w6 ); w3 = fnms( dz, w7, w7 );
+    w4 = fma(  dz, w4, w4 ); w5 = fma(  dz, w5, w5 );
+    w6 = fma(  dz, w6, w6 ); w7 = fma(  dz, w7, w7 );
+
+    store_16x1( w0, wt       );
+    store_16x1( w1, wt +  16 );
+    store_16x1( w2, wt +  32 );
+    store_16x1( w3, wt +  48 );
+    store_16x1( w4, wt +  64 );
+    store_16x1( w5, wt +  80 );
+    store_16x1( w6, wt +  96 );
+    store_16x1( w7, wt + 112 );
+
+    //--------------------------------------------------------------------------
+    // Reduce the particle charge to the node buffer.
+    //--------------------------------------------------------------------------
+    for( j = 0; j < 16; j++ )
+    {
+      v = ii(j);
+
+      rho[v      ] += wt[j      ]; rho[v      +1] += wt[j +  16];
+      rho[v   +sy] += wt[j +  32]; rho[v   +sy+1] += wt[j +  48];
+      rho[v+sz   ] += wt[j +  64]; rho[v+sz   +1] += wt[j +  80];
+      rho[v+sz+sy] += wt[j +  96]; rho[v+sz+sy+1] += wt[j + 112];
+    }
+  }
+}
+
+SIMD_KERNEL_END
+
+#else
+
+void
+accumulate_rho_p_pipeline_v16( accumulate_rho_p_pipeline_args_t * args,
+                               int pipeline_rank,
+                               int n_pipeline )
+{
+  // No v16 implementation.
+  ERROR( ( "No accumulate_rho_p_pipeline_v16 implementation." ) );
+}
+
+#endif
@@ -0,0 +1,129 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#if defined(V8_ACCELERATION)
+
+using namespace v8;
+
+SIMD_KERNEL_BEGIN
+
+void
+accumulate_rho_p_pipeline_v8( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  const particle_block_t * RESTRICT ALIGNED(128) p0 = args->p0;
+#if defined(VPIC_USE_COMPACT_P)
+  const particle_t       * RESTRICT ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 8 );
+#else
+  const particle_block_t * RESTRICT ALIGNED(128) p;
+#endif
+
+  float * RESTRICT ALIGNED(128) rho;
+
+  DECLARE_ALIGNED_ARRAY( float, 32, wt, 64 );
+
+  const v8float q_8V(args->q_8V);
+
+  const int sy = args->sy;
+  const int sz = args->sz;
+
+  v8float dx, dy, dz, ux, uy, uz, w;
+  v8float w0, w1, w2, w3, w4, w5, w6, w7;
+  v8int   ii;
+
+  int64_t n, nq;
+  int j, v;
+
+  // Determine which particle blocks this pipeline processes.
+
+  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, n, nq );
+
+  nq >>= 3;
+
+  // Determine which node buffer to use.
+
+  rho = pipeline_rho_buffer( args->rho, args->stride, pipeline_rank );
+
+  // Process the particle blocks for this pipeline.
+
+  for( ; nq; nq--, n+=8 )
+  {
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, n, p_bundle, 8 );
+    p = p_bundle;
+#   else
+    p = p0 + n/PARTICLE_BLOCK_SIZE;
+#   endif
+
+    //--------------------------------------------------------------------------
+    // Load particle data.
+    //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    const int l = n%PARTICLE_BLOCK_SIZE;
+
+    load_8x1( &p->dx[l], dx );
+    load_8x1( &p->dy[l], dy );
+    load_8x1( &p->dz[l], dz );
+    load_8x1( &p->i [l], ii );
+    load_8x1( &p->w [l], w  );
+#   else
+    load_8x8_tr( &p[0].dx, &p[1].dx, &p[2].dx, &p[3].dx,
+                 &p[4].dx, &p[5].dx, &p[6].dx, &p[7].dx,
+                 dx, dy, dz, ii, ux, uy, uz, w );
+#   endif
+
+    //--------------------------------------------------------------------------
+    // Compute the trilinear weights.
+    //--------------------------------------------------------------------------
+    w7 = w*q_8V;
+
+    w6 = fnms( dx, w7, w7 );                           // q(1-dx)
+    w7 = fma(  dx, w7, w7 );                           // q(1+dx)
+    w4 = fnms( dy, w6, w6 ); w5 = fnms( dy, w7, w7 );  // q(1-dx)(1-dy), ...
+    w6 = fma(  dy, w6, w6 ); w7 = fma(  dy, w7, w7 );  // q(1-dx)(1+dy), ...
+    w0 = fnms( dz, w4, w4 ); w1 = fnms( dz, w5, w5 );
+    w2 = fnms( dz, w6, w6 ); w3 = fnms( dz, w7, w7 );
+    w4 = fma(  dz, w4, w4 ); w5 = fma(  dz, w5, w5 );
+    w6 = fma(  dz, w6, w6 ); w7 = fma(  dz, w7, w7 );
+
+    store_8x1( w0, wt      );
+    store_8x1( w1, wt +  8 );
+    store_8x1( w2, wt + 16 );
+    store_8x1( w3, wt + 24 );
+    store_8x1( w4, wt + 32 );
+    store_8x1( w5, wt + 40 );
+    store_8x1( w6, wt + 48 );
+    store_8x1( w7, wt + 56 );
+
+    //--------------------------------------------------------------------------
+    // Reduce the particle charge to the node buffer.
+    //--------------------------------------------------------------------------
+    for( j = 0; j < 8; j++ )
+    {
+      v = ii(j);
+
+      rho[v      ] += wt[j     ]; rho[v      +1] += wt[j +  8];
+      rho[v   +sy] += wt[j + 16]; rho[v   +sy+1] += wt[j + 24];
+      rho[v+sz   ] += wt[j + 32]; rho[v+sz   +1] += wt[j + 40];
+      rho[v+sz+sy] += wt[j + 48]; rho[v+sz+sy+1] += wt[j + 56];
+    }
+  }
+}
+
+SIMD_KERNEL_END
+
+#else
+
+void
+accumulate_rho_p_pipeline_v8( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  // No v8 implementation.
+  ERROR( ( "No accumulate_rho_p_pipeline_v8 implementation." ) );
+}
+
+#endif
@@ -0,0 +1,133 @@
+#define IN_spa
+
+#include "spa_private.h"
+
+#include "../../../util/pipelines/pipelines_exec.h"
+
+//----------------------------------------------------------------------------//
+// Reference implementation for an accumulate_rhob_p pipeline function.  The
+// particles are those referenced by the movers, whose voxel index has been
+// set to 8*voxel+face by move_p.  This is the computation of accumulate_rhob
+// done into the node buffer of the pipeline.
+//----------------------------------------------------------------------------//
+
+void
+accumulate_rhob_p_pipeline_scalar( accumulate_rho_p_pipeline_args_t * args,
+                                   int pipeline_rank,
+                                   int n_pipeline )
+{
+  const particle_block_t * RESTRICT ALIGNED(128) p0 = args->p0;
+  const particle_mover_t * RESTRICT ALIGNED(16)  pm = args->pm;
+
+  float * RESTRICT ALIGNED(128) rho;
+
+  const float q_8V = args->q_8V;
+  const int   nx   = args->nx;
+  const int   ny   = args->ny;
+  const int   nz   = args->nz;
+  const int   sy   = args->sy;
+  const int   sz   = args->sz;
+
+  float w0, w1, w2, w3, w4, w5, w6, w7, dz;
+
+  int64_t n, n0, n1;
+  int v, x, y, z;
+
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
+
+  // Determine which movers this pipeline processes.
+
+  DISTRIBUTE( args->np, 1, pipeline_rank, n_pipeline, n0, n1 );
+
+  n1 += n0;
+
+  // Determine which node buffer to use.
+
+  rho = pipeline_rho_buffer( args->rho, args->stride, pipeline_rank );
+
+  // Process movers for this pipeline.
+
+  for( n = n0; n < n1; n++ )
+  {
+    load_particle( p0, pm[n].i, p );
+
+    w0 = p->dx;
+    w1 = p->dy;
+    dz = p->dz;
+    v  = p->i >> 3;
+    w7 = p->w*q_8V;
+
+    // Compute the trilinear weights
+
+#   define FMA( x,y,z) ((z)+(x)*(y))
+#   define FNMS(x,y,z) ((z)-(x)*(y))
+    w6=FNMS(w0,w7,w7);                    // q(1-dx)
+    w7=FMA( w0,w7,w7);                    // q(1+dx)
+    w4=FNMS(w1,w6,w6); w5=FNMS(w1,w7,w7); // q(1-dx)(1-dy), q(1+dx)(1-dy)
+    w6=FMA( w1,w6,w6); w7=FMA( w1,w7,w7); // q(1-dx)(1+dy), q(1+dx)(1+dy)
+    w0=FNMS(dz,w4,w4); w1=FNMS(dz,w5,w5); w2=FNMS(dz,w6,w6); w3=FNMS(dz,w7,w7);
+    w4=FMA( dz,w4,w4); w5=FMA( dz,w5,w5); w6=FMA( dz,w6,w6); w7=FMA( dz,w7,w7);
+#   undef FNMS
+#   undef FMA
+
+    // Adjust the weights for a corrected local accumulation of rhob.
+    // See note in synchronize_rho why we must do this for rhob and not
+    // for rhof.
+
+    x  = v;    z = x/sz;
+    if( z==1  ) w0 += w0, w1 += w1, w2 += w2, w3 += w3;
+    if( z==nz ) w4 += w4, w5 += w5, w6 += w6, w7 += w7;
+    x -= sz*z; y = x/sy;
+    if( y==1  ) w0 += w0, w1 += w1, w4 += w4, w5 += w5;
+    if( y==ny ) w2 += w2, w3 += w3, w6 += w6, w7 += w7;
+    x -= sy*y;
+    if( x==1  ) w0 += w0, w2 += w2, w4 += w4, w6 += w6;
+    if( x==nx ) w1 += w1, w3 += w3, w5 += w5, w7 += w7;
+
+    // Reduce the particle charge to the node buffer
+
+    rho[v      ] += w0; rho[v      +1] += w1;
+    rho[v   +sy] += w2; rho[v   +sy+1] += w3;
+    rho[v+sz   ] += w4; rho[v+sz   +1] += w5;
+    rho[v+sz+sy] += w6; rho[v+sz+sy+1] += w7;
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Top level function to select and call the proper accumulate_rhob_p
+// pipeline function.
+//----------------------------------------------------------------------------//
+
+void
+accumulate_rhob_movers_pipeline( field_array_t * RESTRICT fa,
+                                 const species_t * RESTRICT sp )
+{
+  DECLARE_ALIGNED_ARRAY( accumulate_rho_p_pipeline_args_t, 128, args, 1 );
+
+  int stride;
+
+  if ( !fa || !sp || fa->g != sp->g )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  if ( !sp->nm ) return;
+
+  args->p0     = sp->p;
+  args->pm     = sp->pm;
+  args->rho    = rho_p_pipeline_buffers( sp->g, &stride );
+  args->q_8V   = sp->q*sp->g->r8V;
+  args->np     = sp->nm;
+  args->stride = stride;
+  args->nx     = sp->g->nx;
+  args->ny     = sp->g->ny;
+  args->nz     = sp->g->nz;
+  args->sy     = sp->g->sy;
+  args->sz     = sp->g->sz;
+
+  EXEC_PIPELINES( accumulate_rhob_p, args, 0 );
+
+  WAIT_PIPELINES();
+
+  reduce_rho_p_pipeline( fa, args->rho, stride, 1 );
+}
@@ -21,7 +21,15 @@
 #include "xmmintrin.h"
 #endif
 
-// FIXME: HOOK UP IN-PLACE / OUT-PLACE OPTIONS AGAIN.
+// The incremental sort falls back to the full sort when more than 1 in this
+// many particles would have to be moved.  Each moved particle is read and
+// written at random positions and the new slot of each is assigned in one
+// serial pass, while the full sort streams every particle through aux_p
+// twice, thread parallel.  Past about 1 in 8, the random accesses cost more
+// than the full sort, and the buffer of moved particles would no longer be
+// small next to the particle array.
+
+#define max_incremental_sort_fraction 8
 
 //----------------------------------------------------------------------------//
 // 
@@ -32,17 +40,19 @@ coarse_count_pipeline_scalar( sort_p_pipeline_args_t * args,
                               int pipeline_rank,
                               int n_pipeline )
 {
-  const particle_t * RESTRICT ALIGNED(128) p_src = args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) p_src = args->p;
+  const int              * RESTRICT ALIGNED(128) sfc   = args->sfc;
 
-  int i, i1;
+  int64_t i, i1;
 
   int n_subsort = args->n_subsort;
   int vl        = args->vl;
   int vh        = args->vh;
-  int cp_stride = POW2_CEIL( n_subsort, 4 );
 
-  // On pipeline stack to avoid cache hot spots.
-  int count[256];
+  // Each pipeline counts into its own cache line aligned row of the coarse
+  // partition storage to avoid cache hot spots.
+  int64_t * RESTRICT ALIGNED(128) count = args->coarse_partition +
+                                      CP_STRIDE( n_subsort )*pipeline_rank;
 
   // No straggler cleanup needed.
   if ( pipeline_rank == n_pipeline )
@@ -50,11 +60,6 @@ coarse_count_pipeline_scalar( sort_p_pipeline_args_t * args,
     return;
   }
 
-  if ( n_subsort > 256 )
-  {
-    ERROR( ( "n_subsort too large." ) );
-  }
-
   DISTRIBUTE( args->n, 1, pipeline_rank, n_pipeline, i, i1 );
 
   i1 += i;
@@ -65,13 +70,90 @@ coarse_count_pipeline_scalar( sort_p_pipeline_args_t * args,
   // Local coarse count the input particles.
   for( ; i < i1; i++ )
   {
-    count[ V2P( p_src[i].i, n_subsort, vl, vh ) ]++;
+    count[ V2P( sfc[ PARTICLE_VOXEL( p_src, i ) ], n_subsort, vl, vh ) ]++;
+  }
+}
+
+//----------------------------------------------------------------------------//
+// The coarse counts are converted into the coarse partitioning in parallel.
+// The particles of subsort s counted by pipeline r go after those of subsort
+// s counted by pipelines 0:r-1 and after all those of subsorts 0:s-1.  Each
+// pipeline first totals the counts of a range of subsorts over all
+// pipelines.  After the host has converted the totals into the partitioning
+// by subsort, each pipeline offsets the counts of its subsorts.
+//----------------------------------------------------------------------------//
+
+void
+coarse_total_pipeline_scalar( sort_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline )
+{
+  const int64_t * RESTRICT ALIGNED(128) count = args->coarse_partition;
+  /**/  int64_t * RESTRICT ALIGNED(128) total = args->subsort_partition;
+
+  int64_t sum;
+
+  int s, s1, r;
+
+  int cp_stride = CP_STRIDE( args->n_subsort );
+
+  // No straggler cleanup needed.
+  if ( pipeline_rank == n_pipeline )
+  {
+    return;
   }
 
-  // Copy local coarse count to output.
-  COPY( args->coarse_partition + cp_stride*pipeline_rank,
-	count,
-	n_subsort );
+  DISTRIBUTE( args->n_subsort, 1, pipeline_rank, n_pipeline, s, s1 );
+
+  s1 += s;
+
+  for( ; s < s1; s++ )
+  {
+    sum = 0;
+    for( r = 0; r < n_pipeline; r++ )
+    {
+      sum += count[ s + cp_stride*r ];
+    }
+
+    total[s] = sum;
+  }
+}
+
+void
+coarse_scan_pipeline_scalar( sort_p_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline )
+{
+  /**/  int64_t * RESTRICT ALIGNED(128) count     = args->coarse_partition;
+  const int64_t * RESTRICT ALIGNED(128) partition = args->subsort_partition;
+
+  int64_t sum, c;
+
+  int s, s1, r, i;
+
+  int cp_stride = CP_STRIDE( args->n_subsort );
+
+  // No straggler cleanup needed.
+  if ( pipeline_rank == n_pipeline )
+  {
+    return;
+  }
+
+  DISTRIBUTE( args->n_subsort, 1, pipeline_rank, n_pipeline, s, s1 );
+
+  s1 += s;
+
+  for( ; s < s1; s++ )
+  {
+    sum = partition[s];
+    for( r = 0; r < n_pipeline; r++ )
+    {
+      i         = s + cp_stride*r;
+      c         = count[i];
+      count[i]  = sum;
+      sum      += c;
+    }
+  }
 }
 
 //----------------------------------------------------------------------------//
@@ -83,19 +165,20 @@ coarse_sort_pipeline_scalar( sort_p_pipeline_args_t * args,
                              int pipeline_rank,
                              int n_pipeline )
 {
-  const particle_t * RESTRICT ALIGNED(128) p_src = args->p;
-  /**/  particle_t * RESTRICT ALIGNED(128) p_dst = args->aux_p;
+  const particle_block_t * RESTRICT ALIGNED(128) p_src = args->p;
+  /**/  particle_block_t * RESTRICT ALIGNED(128) p_dst = args->aux_p;
+  const int              * RESTRICT ALIGNED(128) sfc   = args->sfc;
 
-  int i, i1;
+  int64_t i, i1, j;
   int n_subsort = args->n_subsort;
   int vl        = args->vl;
   int vh        = args->vh;
-  int cp_stride = POW2_CEIL( n_subsort, 4 );
-  int j;
 
-  // On pipeline stack to avoid cache hot spots and to allow reuse of coarse
-  // partitioning for fine sort stage.
-  int next[ 256 ];
+
+  // The local coarse partitioning.  The fine sort stage uses the subsort
+  // partitioning instead, so this is consumed in place.
+  int64_t * RESTRICT ALIGNED(128) next = args->coarse_partition +
+                                     CP_STRIDE( n_subsort )*pipeline_rank;
 
   // No straggler cleanup needed.
   if ( pipeline_rank == n_pipeline )
@@ -103,33 +186,23 @@ coarse_sort_pipeline_scalar( sort_p_pipeline_args_t * args,
     return;
   }
 
-  if ( n_subsort > 256 )
-  {
-    ERROR( ( "n_subsort too large." ) );
-  }
-
   DISTRIBUTE( args->n, 1, pipeline_rank, n_pipeline, i, i1 );
 
   i1 += i;
 
-  // Load the local coarse partitioning into next.
-  COPY( next,
-	args->coarse_partition + cp_stride*pipeline_rank,
-	n_subsort );
-
   // Copy particles into aux array in coarse sorted order.
   for( ; i < i1; i++ )
   {
-    j = next[ V2P( p_src[i].i, n_subsort, vl, vh ) ]++;
+    j = next[ V2P( sfc[ PARTICLE_VOXEL( p_src, i ) ], n_subsort, vl, vh ) ]++;
 
-#   if defined( __SSE__ )
+#   if defined( __SSE__ ) && PARTICLE_LAYOUT_AOS
 
     _mm_store_ps( &p_dst[j].dx, _mm_load_ps( &p_src[i].dx ) );
     _mm_store_ps( &p_dst[j].ux, _mm_load_ps( &p_src[i].ux ) );
 
 #   else
 
-    p_dst[j] = p_src[i];
+    copy_particle( p_dst, j, p_src, i );
 
 #   endif
   }
@@ -144,17 +217,20 @@ subsort_pipeline_scalar( sort_p_pipeline_args_t * args,
                          int pipeline_rank,
                          int n_pipeline )
 {
-  const particle_t * RESTRICT ALIGNED(128) p_src = args->aux_p;
-  /**/  particle_t * RESTRICT ALIGNED(128) p_dst = args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) p_src = args->aux_p;
+  /**/  particle_block_t * RESTRICT ALIGNED(128) p_dst = args->p;
+  const int              * RESTRICT ALIGNED(128) sfc   = args->sfc;
+
+  int64_t i0, i1, i, j, sum, count;
 
-  int i0, i1, v0, v1, i, j, v, sum, count;
+  int v0, v1, v;
 
   int subsort;
 
   int n_subsort = args->n_subsort;
 
-  int * RESTRICT ALIGNED(128) partition = args->partition;
-  int * RESTRICT ALIGNED(128) next      = args->next;
+  int64_t * RESTRICT ALIGNED(128) partition = args->partition;
+  int64_t * RESTRICT ALIGNED(128) next      = args->next;
 
   // No straggler cleanup needed.
   if ( pipeline_rank == n_pipeline )
@@ -165,9 +241,10 @@ subsort_pipeline_scalar( sort_p_pipeline_args_t * args,
   for( subsort = pipeline_rank; subsort < n_subsort; subsort += n_pipeline )
   {
     // This subsort sorts particles in [i0,i1) in the aux array. These
-    // particles are in voxels [v0,v1).
-    i0 = args->coarse_partition[ subsort   ];
-    i1 = args->coarse_partition[ subsort+1 ];
+    // particles have sort keys (positions of their voxels along the
+    // grid's space filling curve) in [v0,v1).
+    i0 = args->subsort_partition[ subsort   ];
+    i1 = args->subsort_partition[ subsort+1 ];
 
     v0 = P2V( subsort,   n_subsort, args->vl, args->vh );
     v1 = P2V( subsort+1, n_subsort, args->vl, args->vh );
@@ -178,7 +255,7 @@ subsort_pipeline_scalar( sort_p_pipeline_args_t * args,
     // Fine grained count.
     for( i = i0; i < i1; i++ )
     {
-      next[ p_src[i].i ]++;
+      next[ sfc[ PARTICLE_VOXEL( p_src, i ) ] ]++;
     }
 
     // Compute the partitioning.
@@ -196,23 +273,381 @@ subsort_pipeline_scalar( sort_p_pipeline_args_t * args,
     // Local fine grained sort.
     for( i = i0; i < i1; i++ )
     {
-      v = p_src[i].i;
+      v = sfc[ PARTICLE_VOXEL( p_src, i ) ];
       j = next[v]++;
 
-#     if defined( __SSE__ )
+#     if defined( __SSE__ ) && PARTICLE_LAYOUT_AOS
 
       _mm_store_ps( &p_dst[j].dx, _mm_load_ps( &p_src[i].dx ) );
       _mm_store_ps( &p_dst[j].ux, _mm_load_ps( &p_src[i].ux ) );
 
 #     else
 
-      p_dst[j] = p_src[i];
+      copy_particle( p_dst, j, p_src, i );
 
 #     endif
     }
   }
 }
 
+//----------------------------------------------------------------------------//
+// Incremental in-place sort.  Particle n is misplaced if it is not in the
+// range of its voxel's sort key k in the last partitioning, i.e. it is not
+// in [partition[k],partition[k+1]) (or n >= n_sorted).  Between sorts, this
+// is the case for the particles that changed voxels and those moved around
+// by boundary_p and injection.
+//----------------------------------------------------------------------------//
+
+void
+find_misplaced_pipeline_scalar( find_misplaced_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+  const particle_block_t * RESTRICT ALIGNED(128) p         = args->p;
+  const int64_t          * RESTRICT ALIGNED(128) partition = args->partition;
+  const int              * RESTRICT ALIGNED(128) sfc       = args->sfc;
+  /**/  int64_t          * RESTRICT ALIGNED(128) misplaced;
+
+  int64_t i, i1, n_sorted, n_misplaced = 0;
+
+  int k;
+
+  // No straggler cleanup needed.
+  if ( pipeline_rank == n_pipeline )
+  {
+    return;
+  }
+
+  DISTRIBUTE( args->n, 1, pipeline_rank, n_pipeline, i, i1 );
+
+  i1 += i;
+
+  // Each pipeline writes to the part of misplaced matching its particles.
+  misplaced = args->misplaced + i;
+  n_sorted  = args->n_sorted;
+
+  for( ; i < i1; i++ )
+  {
+    k = sfc[ PARTICLE_VOXEL( p, i ) ];
+
+    if ( i >= n_sorted || i < partition[k] || i >= partition[k+1] )
+    {
+      misplaced[ n_misplaced++ ] = i;
+    }
+  }
+
+  args->n_misplaced[ pipeline_rank ] = n_misplaced;
+}
+
+// The particles to move are copied out of their slots into aux_p (and the
+// sort keys of their voxels saved in dest), then, once each has been given
+// the slot it goes to, copied back into p.  Both are thread parallel.
+
+void
+gather_misfit_pipeline_scalar( move_misfit_pipeline_args_t * args,
+                               int pipeline_rank,
+                               int n_pipeline )
+{
+  const particle_block_t * RESTRICT ALIGNED(128) p     = args->p;
+  /**/  particle_block_t * RESTRICT ALIGNED(128) aux_p = args->aux_p;
+  const int64_t          * RESTRICT ALIGNED(128) slot  = args->slot;
+  /**/  int64_t          * RESTRICT ALIGNED(128) dest  = args->dest;
+  const int              * RESTRICT ALIGNED(128) sfc   = args->sfc;
+
+  int64_t i, i1;
+
+  // No straggler cleanup needed.
+  if ( pipeline_rank == n_pipeline )
+  {
+    return;
+  }
+
+  DISTRIBUTE( args->n, 1, pipeline_rank, n_pipeline, i, i1 );
+
+  i1 += i;
+
+  for( ; i < i1; i++ )
+  {
+    copy_particle( aux_p, i, p, slot[i] );
+
+    dest[i] = sfc[ PARTICLE_VOXEL( p, slot[i] ) ];
+  }
+}
+
+void
+scatter_misfit_pipeline_scalar( move_misfit_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline )
+{
+  /**/  particle_block_t * RESTRICT ALIGNED(128) p     = args->p;
+  const particle_block_t * RESTRICT ALIGNED(128) aux_p = args->aux_p;
+  const int64_t          * RESTRICT ALIGNED(128) dest  = args->dest;
+
+  int64_t i, i1;
+
+  // No straggler cleanup needed.
+  if ( pipeline_rank == n_pipeline )
+  {
+    return;
+  }
+
+  DISTRIBUTE( args->n, 1, pipeline_rank, n_pipeline, i, i1 );
+
+  i1 += i;
+
+  for( ; i < i1; i++ )
+  {
+    copy_particle( p, dest[i], aux_p, i );
+  }
+}
+
+// Sorts sp in place, only moving the particles that are not in the range
+// of their sort key in the new partitioning.  These are the misplaced
+// particles and the particles at the edges of the voxel ranges that
+// shifted as particles changed voxels.  Finding the misplaced particles
+// reads the voxel index of every particle (thread parallel).  The rest of
+// the work is proportional to the number of voxels plus the number of
+// particles moved.
+//
+// The particles to move go through a buffer holding just them, so this
+// only pays off when few particles need to move.  If more than max_misfit
+// do (or sp was not sorted before), nothing is done and 0 is returned.
+
+static int
+incremental_sort_p( species_t * sp,
+                    int64_t max_misfit )
+{
+  static VPIC_THREAD_LOCAL int64_t * ALIGNED(128) scratch = NULL;
+  static VPIC_THREAD_LOCAL size_t             max_scratch = 0;
+
+  static VPIC_THREAD_LOCAL particle_block_t * ALIGNED(128) aux_p = NULL;
+  static VPIC_THREAD_LOCAL size_t                       max_aux_p = 0;
+
+  DECLARE_ALIGNED_ARRAY( find_misplaced_pipeline_args_t, 128, args, 1 );
+
+  DECLARE_ALIGNED_ARRAY( move_misfit_pipeline_args_t, 128, margs, 1 );
+
+  DECLARE_ALIGNED_ARRAY( int64_t, 16, n_misplaced, MAX_PIPELINE + 1 );
+
+  particle_block_t * RESTRICT ALIGNED(128) p         = sp->p;
+  int64_t          * RESTRICT ALIGNED(128) partition = sp->partition;
+  const int        * RESTRICT ALIGNED(128) sfc       = sp->g->sfc;
+
+  int64_t * RESTRICT misfit;    // Particles to move (0:np-1), then the
+  /**/                          // slots they go to
+  int64_t * RESTRICT slot;      // The same in order (0:np-1)
+  int64_t * RESTRICT next;      // New partitioning (0:n_key)
+  int64_t * RESTRICT take;      // Next slot of each key (0:n_key)
+
+  const int64_t np    = sp->np;
+  const int     n_key = sp->g->nv;
+  const int     vh    = VOXEL( sp->g->nx, sp->g->ny, sp->g->nz,
+                               sp->g->nx, sp->g->ny, sp->g->nz );
+
+  int64_t n_sorted, n_misfit, n_shifted, i, j, k, lo, hi, sum, count;
+
+  int rank;
+
+  size_t sz_scratch;
+
+  // The last partitioning must be usable.
+
+  if ( sp->last_sorted == INT64_MIN || partition[0] != 0 )
+  {
+    return 0;
+  }
+
+  for( k = 0; k < n_key - 1 && partition[k] <= partition[k+1]; k++ );
+
+  if ( k != n_key - 1 )
+  {
+    return 0;
+  }
+
+  n_sorted = partition[ vh + 1 ];
+
+  sz_scratch = 2*( (size_t) np + (size_t) n_key + 1 );
+
+  if ( sz_scratch > max_scratch )
+  {
+    FREE_ALIGNED( scratch );
+
+    MALLOC_ALIGNED( scratch, sz_scratch, 128 );
+
+    max_scratch = sz_scratch;
+  }
+
+  misfit = scratch;
+  slot   = misfit + np;
+  next   = slot   + np;
+  take   = next   + n_key + 1;
+
+  // Find the misplaced particles.
+
+  args->p           = p;
+  args->partition   = partition;
+  args->sfc         = sfc;
+  args->misplaced   = misfit;
+  args->n_misplaced = n_misplaced;
+  args->n           = np;
+  args->n_sorted    = n_sorted;
+
+  EXEC_PIPELINES( find_misplaced, args, 0 );
+
+  WAIT_PIPELINES();
+
+  n_misfit = 0;
+  for( rank = 0; rank < N_PIPELINE; rank++ )
+  {
+    DISTRIBUTE( np, 1, rank, N_PIPELINE, i, count );
+
+    MOVE( misfit + n_misfit, misfit + i, n_misplaced[rank] );
+
+    n_misfit += n_misplaced[rank];
+  }
+
+  if ( n_misfit > max_misfit )
+  {
+    return 0;
+  }
+
+  // Count the particles with each key.  The particles that are not
+  // misplaced stay in the range of their key in the last partitioning.
+  // The misplaced particles are in increasing order, so the key of the
+  // range they were in is found by walking the last partitioning.
+
+  for( k = 0; k < n_key; k++ )
+  {
+    lo = partition[k];
+    hi = partition[k+1] < np ? partition[k+1] : np;
+
+    next[k] = hi > lo ? hi - lo : 0;
+  }
+
+  for( k = 0, i = 0; i < n_misfit; i++ )
+  {
+    j = misfit[i];
+
+    if ( j < n_sorted )
+    {
+      while( partition[k+1] <= j ) k++;
+
+      next[k]--;
+    }
+
+    next[ sfc[ PARTICLE_VOXEL( p, j ) ] ]++;
+  }
+
+  // Convert the counts into the new partitioning.
+
+  sum = 0;
+  for( k = 0; k < n_key; k++ )
+  {
+    count    = next[k];
+    next[k]  = sum;
+    sum     += count;
+  }
+  next[n_key] = sum;
+
+  // Keep the misplaced particles that are not (by chance) in the range of
+  // their key in the new partitioning.  Add the particles that were in the
+  // range of their key in the last partitioning but are not in the new one
+  // (the parts of the last range outside the new range).  Both lists are
+  // in increasing order.
+
+  for( count = 0, i = 0; i < n_misfit; i++ )
+  {
+    j = misfit[i];
+    k = sfc[ PARTICLE_VOXEL( p, j ) ];
+
+    if ( j < next[k] || j >= next[k+1] ) misfit[ count++ ] = j;
+  }
+
+  n_misfit  = count;
+  n_shifted = 0;
+
+  for( k = 0; k < n_key && n_misfit + n_shifted <= max_misfit; k++ )
+  {
+    lo = partition[k];
+    hi = partition[k+1] < np ? partition[k+1] : np;
+
+    for( j = lo; j < hi && j < next[k]; j++ )
+    {
+      if ( sfc[ PARTICLE_VOXEL( p, j ) ] == k ) slot[ n_shifted++ ] = j;
+    }
+
+    for( j = lo > next[k+1] ? lo : next[k+1]; j < hi; j++ )
+    {
+      if ( sfc[ PARTICLE_VOXEL( p, j ) ] == k ) slot[ n_shifted++ ] = j;
+    }
+  }
+
+  if ( n_misfit + n_shifted > max_misfit )
+  {
+    return 0;
+  }
+
+  // The positions of the particles to move are the free slots of the keys
+  // whose new range contains them.  Merge the two lists into slot, such
+  // that the free slots of each key are contiguous, and find where the
+  // free slots of each key start.
+
+  MOVE( misfit + n_misfit, slot, n_shifted );
+
+  for( i = 0, j = n_misfit, count = 0; count < n_misfit + n_shifted; count++ )
+  {
+    if ( j == n_misfit + n_shifted ||
+         ( i < n_misfit && misfit[i] < misfit[j] ) ) slot[count] = misfit[i++];
+    else                                           slot[count] = misfit[j++];
+  }
+
+  n_misfit += n_shifted;
+
+  for( k = 0, i = 0; k <= n_key; k++ )
+  {
+    while( i < n_misfit && slot[i] < next[k] ) i++;
+
+    take[k] = i;
+  }
+
+  // Each particle to move goes to the next free slot of its key.  The
+  // slots are assigned in one serial pass, the particles are copied out
+  // and back thread parallel.
+
+  if ( (size_t) PARTICLE_BLOCKS( n_misfit ) > max_aux_p )
+  {
+    FREE_ALIGNED( aux_p );
+
+    max_aux_p = PARTICLE_BLOCKS( max_misfit );
+
+    MALLOC_ALIGNED( aux_p, max_aux_p, 128 );
+  }
+
+  margs->p     = p;
+  margs->aux_p = aux_p;
+  margs->slot  = slot;
+  margs->dest  = misfit;
+  margs->sfc   = sfc;
+  margs->n     = n_misfit;
+
+  EXEC_PIPELINES( gather_misfit, margs, 0 );
+
+  WAIT_PIPELINES();
+
+  for( i = 0; i < n_misfit; i++ )
+  {
+    misfit[i] = slot[ take[ misfit[i] ]++ ];
+  }
+
+  EXEC_PIPELINES( scatter_misfit, margs, 0 );
+
+  WAIT_PIPELINES();
+
+  COPY( partition, next, n_key + 1 );
+
+  return 1;
+}
+
 //----------------------------------------------------------------------------//
 // 
 //----------------------------------------------------------------------------//
@@ -225,21 +660,30 @@ sort_p_pipeline( species_t * sp )
     ERROR( ( "Bad args" ) );
   }
 
+  // Species are sorted incrementally when few particles need to move.
+  if ( incremental_sort_p( sp, sp->np / max_incremental_sort_fraction ) )
+  {
+    sp->last_sorted = sp->g->step;
+
+    return;
+  }
+
   sp->last_sorted = sp->g->step;
 
-  static char * ALIGNED(128)     scratch = NULL;
-  static size_t              max_scratch = 0;
+  static VPIC_THREAD_LOCAL char * ALIGNED(128)     scratch = NULL;
+  static VPIC_THREAD_LOCAL size_t              max_scratch = 0;
 
   size_t sz_scratch;
 
-  particle_t * RESTRICT ALIGNED(128) p = sp->p;
-  particle_t * RESTRICT ALIGNED(128) aux_p;
+  particle_block_t * RESTRICT ALIGNED(128) p = sp->p;
+  particle_block_t * RESTRICT ALIGNED(128) aux_p;
 
-  int n_particle = sp->np;
+  int64_t n_particle = sp->np;
 
-  int * RESTRICT ALIGNED(128) partition = sp->partition;
-  int * RESTRICT ALIGNED(128) next;
+  int64_t * RESTRICT ALIGNED(128) partition = sp->partition;
+  int64_t * RESTRICT ALIGNED(128) next;
 
+  // Non-ghost voxels have sort keys in [vl,vh] (see grid.h).
   int vl = VOXEL( 1,
 		  1,
 		  1,
@@ -256,23 +700,28 @@ sort_p_pipeline( species_t * sp )
 
   int n_voxel = sp->g->nv;
 
-  int * RESTRICT ALIGNED(128) coarse_partition;
+  int64_t * RESTRICT ALIGNED(128) coarse_partition;
+  int64_t * RESTRICT ALIGNED(128) subsort_partition;
 
   int n_pipeline = N_PIPELINE;
   int n_subsort  = N_PIPELINE;
 
-  int cp_stride = POW2_CEIL( n_subsort, 4 );
+  int cp_stride = CP_STRIDE( n_subsort );
 
-  int i, pipeline_rank, subsort, count, sum;
+  int64_t count, sum;
+
+  int i, subsort;
 
   DECLARE_ALIGNED_ARRAY( sort_p_pipeline_args_t, 128, args, 1 );
 
   // Ensure enough scratch space is allocated for the sorting.
-  sz_scratch = ( sizeof( *p ) * n_particle      +
+  sz_scratch = ( sizeof( *p ) * PARTICLE_BLOCKS( n_particle ) +
 		 128                            +
                  sizeof( *partition ) * n_voxel +
 		 128                            +
-                 sizeof( *coarse_partition ) * ( cp_stride * n_pipeline + 1 ) );
+                 sizeof( *coarse_partition ) * cp_stride * n_pipeline +
+		 128                            +
+                 sizeof( *subsort_partition ) * ( n_subsort + 1 ) );
 
   if ( sz_scratch > max_scratch )
   {
@@ -283,21 +732,24 @@ sort_p_pipeline( species_t * sp )
     max_scratch = sz_scratch;
   }
 
-  aux_p            = ALIGN_PTR( particle_t, scratch,            128 );
-  next             = ALIGN_PTR( int,        aux_p + n_particle, 128 );
-  coarse_partition = ALIGN_PTR( int,        next  + n_voxel,    128 );
+  aux_p             = ALIGN_PTR( particle_block_t, scratch, 128 );
+  next              = ALIGN_PTR( int64_t, aux_p + PARTICLE_BLOCKS( n_particle ), 128 );
+  coarse_partition  = ALIGN_PTR( int64_t, next  + n_voxel, 128 );
+  subsort_partition = ALIGN_PTR( int64_t, coarse_partition + cp_stride*n_pipeline, 128 );
 
   // Setup pipeline arguments.
-  args->p                = p;
-  args->aux_p            = aux_p;
-  args->coarse_partition = coarse_partition;
-  args->next             = next;
-  args->partition        = partition;
-  args->n                = n_particle;
-  args->n_subsort        = n_subsort;
-  args->vl               = vl;
-  args->vh               = vh;
-  args->n_voxel          = n_voxel;
+  args->p                 = p;
+  args->aux_p             = aux_p;
+  args->coarse_partition  = coarse_partition;
+  args->subsort_partition = subsort_partition;
+  args->next              = next;
+  args->partition         = partition;
+  args->sfc               = sp->g->sfc;
+  args->n                 = n_particle;
+  args->n_subsort         = n_subsort;
+  args->vl                = vl;
+  args->vh                = vh;
+  args->n_voxel           = n_voxel;
 
   if ( n_subsort != 1 )
   {
@@ -306,35 +758,39 @@ sort_p_pipeline( species_t * sp )
 
     WAIT_PIPELINES();
 
-    // Convert the coarse count into a coarse partitioning.
+    // Total the coarse count by subsort.
+    EXEC_PIPELINES( coarse_total, args, 0 );
+
+    WAIT_PIPELINES();
+
+    // Convert the totals into the partitioning of the particle list by
+    // subsort pipelines.
     sum = 0;
     for( subsort = 0; subsort < n_subsort; subsort++ )
     {
-      for( pipeline_rank = 0; pipeline_rank < n_pipeline; pipeline_rank++ )
-      {
-        i                   = subsort + cp_stride * pipeline_rank;
-        count               = coarse_partition[i];
-        coarse_partition[i] = sum;
-        sum                += count;
-      }
+      count                       = subsort_partition[subsort];
+      subsort_partition[subsort]  = sum;
+      sum                        += count;
     }
+    subsort_partition[ n_subsort ] = sum;
+
+    // Convert the coarse count into a coarse partitioning.
+    EXEC_PIPELINES( coarse_scan, args, 0 );
+
+    WAIT_PIPELINES();
 
     // Do the coarse sort.
     EXEC_PIPELINES( coarse_sort, args, 0 );
 
     WAIT_PIPELINES();
 
-    // Convert the coarse partitioning used during the coarse sort into the
-    // partitioning of the particle list by subsort pipelines.
-    coarse_partition[ n_subsort ] = n_particle;
-
     // Do fine grained subsorts.  While the fine grained subsorts are
     // executing, clear the ghost parts of the partitioning array.
     EXEC_PIPELINES( subsort, args, 0 );
 
     CLEAR( partition, vl );
 
-    for( i = vh + 1; i < n_voxel; i++ )
+    for( i = vh + 1; i <= n_voxel; i++ )
     {
       partition[i] = n_particle;
     }
@@ -347,8 +803,8 @@ sort_p_pipeline( species_t * sp )
     // Just do the subsort when single threaded.  We need to hack the aux
     // arrays and what not to make it look like coarse sorting was done to
     // the subsort pipeline.
-    coarse_partition[0] = 0;
-    coarse_partition[1] = n_particle;
+    subsort_partition[0] = 0;
+    subsort_partition[1] = n_particle;
 
     args->p     = aux_p;
     args->aux_p = p;
@@ -357,7 +813,7 @@ sort_p_pipeline( species_t * sp )
 
     CLEAR( partition, vl );
 
-    for( i = vh + 1; i < n_voxel; i++ )
+    for( i = vh + 1; i <= n_voxel; i++ )
     {
       partition[i] = n_particle;
     }
@@ -366,6 +822,6 @@ sort_p_pipeline( species_t * sp )
     // Copy it to the right place and undo the above hack. FIXME: IF WILLING
     // TO MOVE SP->P AROUND AND DO MORE MALLOCS PER STEP I.E. HEAP
     // FRAGMENTATION, COULD AVOID THIS COPY.
-    COPY( p, aux_p, n_particle );
+    COPY( p, aux_p, PARTICLE_BLOCKS( n_particle ) );
   }
 }
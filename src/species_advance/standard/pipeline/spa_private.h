@@ -7,45 +7,389 @@
 
 #include "../../species_advance.h"
 
+// The vector kernels work on compact particles through an AoS copy of each
+// bundle of w particles starting at particle n.  The copy stays in cache.
+
+#if defined(VPIC_USE_COMPACT_P)
+
+#define LOAD_PARTICLE_BUNDLE( p0, n, p, w ) do {                     \
+    int _l;                                                           \
+    for( _l = 0; _l < (w); _l++ ) load_particle( (p0), (n)+_l, (p)+_l ); \
+  } while(0)
+
+#define STORE_PARTICLE_BUNDLE( p, p0, n, w ) do {                    \
+    int _l;                                                           \
+    for( _l = 0; _l < (w); _l++ ) store_particle( (p)+_l, (p0), (n)+_l ); \
+  } while(0)
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Hydro accumulation helpers (see hydro_p_pipeline.cc)
+
+// The hydro array a pipeline accumulates into.  The host accumulates into
+// the hydro array h directly, the pipelines into their own hydro arrays in
+// hp (see reduce_hydro_array), which they clear first.  No hydro array is
+// used if h is NULL.
+
+static inline hydro_t *
+pipeline_hydro_array( hydro_t * h,
+                      hydro_t * hp,
+                      int       stride,
+                      int       pipeline_rank,
+                      int       n_pipeline )
+{
+  if ( !h || pipeline_rank == n_pipeline ) return h;
+
+  hp += (int64_t) pipeline_rank * stride;
+
+  CLEAR( hp, stride );
+
+  return hp;
+}
+
+// hydro_p_particle adds the hydro fields of particle p to the hydro array h
+// (if not NULL) and its kinetic energy, normalized by c^2, to en (if not
+// NULL).  These are the reference computations of accumulate_hydro_p and
+// energy_p: the momentum is advanced to the time of the position with half
+// an electric field push and half a Boris rotation.
+
+static inline void
+hydro_p_particle( hydro_t              * RESTRICT h,
+                  double               * RESTRICT en,
+                  const particle_t     * RESTRICT p,
+                  const interpolator_t * RESTRICT f0,
+                  const float                     qdt_2mc,
+                  const float                     qsp,
+                  const float                     msp,
+                  const float                     c,
+                  const float                     r8V,
+                  const int                       nx,
+                  const int                       ny )
+{
+  const interpolator_t * RESTRICT f = f0 + p->i;
+  const float mspc = msp*c, qdt_4mc2 = qdt_2mc / (2*c);
+  const int stride_10 = 1;
+  const int stride_21 = nx + 1;
+  const int stride_43 = ( nx + 2 )*( ny + 1 ) - 1;
+
+  float dx, dy, dz, ux, uy, uz, vx, vy, vz, ke_mc;
+  float w0, w1, w2, w3, w4, w5, w6, w7, t;
+  int i;
+
+  dx = p->dx;
+  dy = p->dy;
+  dz = p->dz;
+  i  = p->i;
+
+  // Half advance E
+  ux = p->ux + qdt_2mc*(    ( f->ex    + dy*f->dexdy    ) +
+                         dz*( f->dexdz + dy*f->d2exdydz ) );
+  uy = p->uy + qdt_2mc*(    ( f->ey    + dz*f->deydz    ) +
+                         dx*( f->deydx + dz*f->d2eydzdx ) );
+  uz = p->uz + qdt_2mc*(    ( f->ez    + dx*f->dezdx    ) +
+                         dy*( f->dezdy + dx*f->d2ezdxdy ) );
+
+  // Kinetic energy.  Note: gamma-1 = |u|^2 / (gamma+1) is the numerically
+  // accurate way to compute gamma-1.
+  ke_mc = ux*ux + uy*uy + uz*uz;               // ke_mc = |u|^2
+  vz    = sqrtf( 1 + ke_mc );                  // vz = gamma
+
+  if ( en ) *en += (double)( ( msp*p->w ) * ( ke_mc / ( 1 + vz ) ) );
+
+  if ( !h ) return;
+
+  ke_mc *= c / ( vz + 1 );                     // ke_mc = c*(gamma-1)
+  vz     = c / vz;                             // vz = c/gamma
+
+  // Boris rotation - Interpolate B field
+  w5 = f->cbx + dx*f->dcbxdx;
+  w6 = f->cby + dy*f->dcbydy;
+  w7 = f->cbz + dz*f->dcbzdz;
+
+  // Boris rotation - curl scalars (0.5 in w0 for half rotate)
+  w0 = qdt_4mc2*vz;
+  w1 = w5*w5 + w6*w6 + w7*w7;                  // |cB|^2
+  w2 = w0*w0*w1;
+  w3 = w0*( 1 + (1.f/3.f)*w2*( 1 + 0.4f*w2 ) );
+  w4 = w3/( 1 + w1*w3*w3 ); w4 += w4;
+
+  // Boris rotation - uprime
+  w0 = ux + w3*( uy*w7 - uz*w6 );
+  w1 = uy + w3*( uz*w5 - ux*w7 );
+  w2 = uz + w3*( ux*w6 - uy*w5 );
+
+  // Boris rotation - u
+  ux += w4*( w1*w7 - w2*w6 );
+  uy += w4*( w2*w5 - w0*w7 );
+  uz += w4*( w0*w6 - w1*w5 );
+
+  // Compute physical velocities
+  vx  = ux*vz;
+  vy  = uy*vz;
+  vz *= uz;
+
+  // Compute the trilinear coefficients
+  w0  = r8V*p->w;  // w0 = (1/8)(w/V)
+  dx *= w0;        // dx = (1/8)(w/V) x
+  w1  = w0+dx;     // w1 = (1/8)(w/V)(1+x)
+  w0 -= dx;        // w0 = (1/8)(w/V)(1-x)
+  w3  = 1+dy;      // w3 = 1+y
+  w2  = w0*w3;     // w2 = (1/8)(w/V)(1-x)(1+y)
+  w3 *= w1;        // w3 = (1/8)(w/V)(1+x)(1+y)
+  dy  = 1-dy;      // dy = 1-y
+  w0 *= dy;        // w0 = (1/8)(w/V)(1-x)(1-y)
+  w1 *= dy;        // w1 = (1/8)(w/V)(1+x)(1-y)
+  w7  = 1+dz;      // w7 = 1+z
+  w4  = w0*w7;     // w4 = (w/V) trilin_0
+  w5  = w1*w7;     // w5 = (w/V) trilin_1
+  w6  = w2*w7;     // w6 = (w/V) trilin_2
+  w7 *= w3;        // w7 = (w/V) trilin_3
+  dz  = 1-dz;      // dz = 1-z
+  w0 *= dz;        // w0 = (w/V) trilin_4
+  w1 *= dz;        // w1 = (w/V) trilin_5
+  w2 *= dz;        // w2 = (w/V) trilin_6
+  w3 *= dz;        // w3 = (w/V) trilin_7
+
+  // Accumulate the hydro fields
+# define ACCUM_HYDRO( wn )                                      \
+  t  = qsp*wn;        /* t  = (qsp w/V) trilin_n */             \
+  h[i].jx  += t*vx;                                             \
+  h[i].jy  += t*vy;                                             \
+  h[i].jz  += t*vz;                                             \
+  h[i].rho += t;                                                \
+  t  = mspc*wn;       /* t = (msp c w/V) trilin_n */            \
+  dx = t*ux;          /* dx = (px w/V) trilin_n */              \
+  dy = t*uy;                                                    \
+  dz = t*uz;                                                    \
+  h[i].px  += dx;                                               \
+  h[i].py  += dy;                                               \
+  h[i].pz  += dz;                                               \
+  h[i].ke  += t*ke_mc;                                          \
+  h[i].txx += dx*vx;                                            \
+  h[i].tyy += dy*vy;                                            \
+  h[i].tzz += dz*vz;                                            \
+  h[i].tyz += dy*vz;                                            \
+  h[i].tzx += dz*vx;                                            \
+  h[i].txy += dx*vy
+
+  /**/            ACCUM_HYDRO( w0 ); // Cell i,j,k
+  i += stride_10; ACCUM_HYDRO( w1 ); // Cell i+1,j,k
+  i += stride_21; ACCUM_HYDRO( w2 ); // Cell i,j+1,k
+  i += stride_10; ACCUM_HYDRO( w3 ); // Cell i+1,j+1,k
+  i += stride_43; ACCUM_HYDRO( w4 ); // Cell i,j,k+1
+  i += stride_10; ACCUM_HYDRO( w5 ); // Cell i+1,j,k+1
+  i += stride_21; ACCUM_HYDRO( w6 ); // Cell i,j+1,k+1
+  i += stride_10; ACCUM_HYDRO( w7 ); // Cell i+1,j+1,k+1
+
+# undef ACCUM_HYDRO
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // advance_p_pipeline interface
 
 typedef struct particle_mover_seg
 {
   MEM_PTR( particle_mover_t, 16 ) pm; // First mover in segment
-  int max_nm;                         // Maximum number of movers
-  int nm;                             // Number of movers used
-  int n_ignored;                      // Number of movers ignored
+  int64_t max_nm;                     // Maximum number of movers
+  int64_t nm;                         // Number of movers used
+  int64_t n_ignored;                  // Number of movers ignored
+  int64_t n_far;                      // Number of far particles (see below)
 
-  PAD_STRUCT( SIZEOF_MEM_PTR+3*sizeof(int) )
+  PAD_STRUCT( SIZEOF_MEM_PTR+4*sizeof(int64_t) )
 
 } particle_mover_seg_t;
 
+// With tile accumulators, the pipelines stop particles that cross into a
+// voxel outside their tile through an in-rank periodic boundary and
+// advance_p_pipeline finishes moving them on the host.
+
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+#define ADVANCE_P_MOVE_P move_p_tile
+#define ADVANCE_P_TILE   1
+#else
+#define ADVANCE_P_MOVE_P move_p
+#define ADVANCE_P_TILE   0
+#endif
+
+// The particles of an advance_p pipeline.  Like FOR_EACH_PIPELINE_CHUNK,
+// this is followed by the loop over the n particles starting at i of each
+// chunk.  With tile accumulators, the tile of a pipeline covers the voxels
+// of the particles of its DISTRIBUTE share (see advance_p_tiles_pipeline),
+// so these pipelines never steal.
+
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+static inline void
+advance_p_share( int64_t np,
+                 int pipeline_rank,
+                 int n_pipeline,
+                 int64_t * i,
+                 int64_t * n )
+{
+  DISTRIBUTE( np, 16, pipeline_rank, n_pipeline, *i, *n );
+}
+
+#define FOR_EACH_ADVANCE_P_CHUNK( i, n )                               \
+  for( int _share = 1;                                                 \
+       _share && ( advance_p_share( args->np, pipeline_rank,           \
+                                    n_pipeline, &(i), &(n) ), 1 );     \
+       _share = 0 )
+#else
+#define FOR_EACH_ADVANCE_P_CHUNK( i, n )                               \
+  FOR_EACH_PIPELINE_CHUNK( args->np, 16, pipeline_rank, n_pipeline, i, n )
+#endif
+
+// Save the mover m of a particle that is still moving.  Without stealing,
+// each pipeline saves its movers in a segment of the movers of its own.
+// With stealing, the number of particles a pipeline processes is not known
+// beforehand, so the pipelines take the movers one at a time from a shared
+// counter (args->shared_nm) and advance_p_pipeline puts them back in
+// particle order.  Few particles need a mover, so the counter is rarely
+// contended.  pm, nm, max_nm and itmp are the kernel's.
+
+#define ADVANCE_P_SAVE_MOVER( m )                                      \
+  do                                                                   \
+  {                                                                    \
+    if ( args->shared_nm )                                             \
+    {                                                                  \
+      int64_t _k = __atomic_fetch_add( args->shared_nm, 1,             \
+                                       __ATOMIC_RELAXED );             \
+      if ( _k < args->max_nm ) args->pm[_k] = (m), nm++;               \
+      else                     itmp++;               /* Unlikely */    \
+    }                                                                  \
+    else if ( nm < max_nm )    pm[nm++] = (m);                         \
+    else                       itmp++;               /* Unlikely */    \
+  } while(0)
+
+// With batched movers, the V8 and V16 advance_p pipelines queue the
+// particles that leave their voxel instead of moving each one with move_p
+// right away.  When the queue fills up and at the end of the pipeline,
+// move_p_batch moves the queued particles several at a time.  It has the
+// semantics of move_p (move_p_tile if tile) applied to each queued mover in
+// turn, except that the current is accumulated in a different order.  The
+// movers still in use are returned at the front of the queue, in queue
+// order, and their number is returned.
+
+#define MOVE_P_BATCH 128 // Movers in the queue of a pipeline
+
+int64_t
+move_p_batch_v8( particle_block_t * ALIGNED(128) p0,
+                 particle_mover_t * ALIGNED(128) pq,
+                 int64_t                         nq,
+                 accumulator_t    * ALIGNED(128) a0,
+                 const grid_t     *              g,
+                 const float                     qsp,
+                 const int                       tile );
+
+int64_t
+move_p_batch_v16( particle_block_t * ALIGNED(128) p0,
+                  particle_mover_t * ALIGNED(128) pq,
+                  int64_t                         nq,
+                  accumulator_t    * ALIGNED(128) a0,
+                  const grid_t     *              g,
+                  const float                     qsp,
+                  const int                       tile );
+
+// Move the n_queued particles in the queue pq of an advance_p pipeline and
+// save movers for the ones that are still in use like MOVE_OUTBND does;
+// pm, nm, max_nm, itmp and _qsp are the kernel's.
+
+#define ADVANCE_P_MOVE_P_BATCH( move_p_batch )                         \
+  do                                                                   \
+  {                                                                    \
+    int64_t _j;                                                        \
+    n_queued = move_p_batch( p0, pq, n_queued, a0, g, _qsp,            \
+                             ADVANCE_P_TILE );                         \
+    for( _j = 0; _j < n_queued; _j++ )                                 \
+    {                                                                  \
+      ADVANCE_P_SAVE_MOVER( pq[_j] );                                  \
+    }                                                                  \
+    n_queued = 0;                                                      \
+  } while(0)
+
 typedef struct advance_p_pipeline_args
 {
-  MEM_PTR( particle_t,           128 ) p0;       // Particle array
+  MEM_PTR( particle_block_t,     128 ) p0;       // Particle array
   MEM_PTR( particle_mover_t,     128 ) pm;       // Particle mover array
   MEM_PTR( accumulator_t,        128 ) a0;       // Accumulator arrays
   MEM_PTR( const interpolator_t, 128 ) f0;       // Interpolator array
   MEM_PTR( particle_mover_seg_t, 128 ) seg;      // Dest for return values
   MEM_PTR( const grid_t,         1   ) g;        // Local domain grid params
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+  MEM_PTR( accumulator_t *,      16  ) a_tile;   // Accumulator of each
+  /**/                                           // pipeline's tile
+#endif
+  MEM_PTR( hydro_t,              128 ) h;        // Host hydro array
+  /**/                                           // (NULL: no hydro)
+  MEM_PTR( hydro_t,              128 ) hp;       // Pipeline hydro arrays
+  MEM_PTR( double,               128 ) en;       // Kinetic energies
+  /**/                                           // (NULL: no moments)
+  MEM_PTR( int64_t,              8   ) shared_nm; // Movers taken when
+  /**/                                           // stealing (NULL: a
+  /**/                                           // segment per pipeline)
 
   float                                qdt_2mc;  // Particle/field coupling
   float                                cdt_dx;   // x-space/time coupling
   float                                cdt_dy;   // y-space/time coupling
   float                                cdt_dz;   // z-space/time coupling
   float                                qsp;      // Species particle charge
+  float                                msp;      // Species particle mass
+  float                                cvac;     // Speed of light
+  float                                r8V;      // 1/(8 voxel volume)
 
-  int                                  np;       // Number of particles
-  int                                  max_nm;   // Number of movers
+  int64_t                              np;       // Number of particles
+  int64_t                              max_nm;   // Number of movers
   int                                  nx;       // x-mesh resolution
   int                                  ny;       // y-mesh resolution
   int                                  nz;       // z-mesh resolution
+  int                                  far;      // Far voxel distance
+  /**/                                           // (0: do not count)
+  int                                  h_stride; // Stride between pipeline
+  /**/                                           // hydro arrays
  
-  PAD_STRUCT( 6*SIZEOF_MEM_PTR + 5*sizeof(float) + 5*sizeof(int) )
+  PAD_STRUCT( 10*SIZEOF_MEM_PTR + 8*sizeof(float) + 2*sizeof(int64_t) +
+              5*sizeof(int) )
 
 } advance_p_pipeline_args_t;
 
+// For adaptive sorting (see sort_p.c), the advance_p pipelines count the
+// particles whose voxel index differs from the previous particle's by
+// more than args->far, the index distance to the farthest voxel of the
+// 3x3x3 block centered on a voxel.  ADVANCE_P_COUNT_FAR counts this for
+// the w particles of a vector bundle (ii); far, n_far and ii_far are the
+// kernel's.
+
+#define ADVANCE_P_COUNT_FAR( ii, w )                                   \
+  if ( far )                                                           \
+  {                                                                    \
+    int _j;                                                            \
+    for( _j = 0; _j < (w); _j++ )                                      \
+    {                                                                  \
+      n_far  += (unsigned)( (ii)(_j) - ii_far + far ) > 2u*far;        \
+      ii_far  = (ii)(_j);                                              \
+    }                                                                  \
+  }
+
+// On diagnostic steps (see advance_p_moments), the advance_p pipelines
+// also accumulate the hydro fields and the kinetic energy of the particles
+// before pushing them (see hydro_p_particle).  The hydro fields go to the
+// hydro array of the pipeline (see pipeline_hydro_array) if args->h is not
+// NULL.  ADVANCE_P_MOMENTS does this for the w particles of a vector bundle
+// starting at particle n; hp, en and p_moments are the kernel's.
+
+#define ADVANCE_P_MOMENTS( n, w )                                      \
+  if ( args->en )                                                      \
+  {                                                                    \
+    int _j;                                                            \
+    for( _j = 0; _j < (w); _j++ )                                      \
+    {                                                                  \
+      load_particle( p0, (n)+_j, p_moments );                          \
+      hydro_p_particle( hp, &en, p_moments, f0, args->qdt_2mc,         \
+                        args->qsp, args->msp, args->cvac, args->r8V,   \
+                        args->nx, args->ny );                          \
+    }                                                                  \
+  }
+
 // PROTOTYPE_PIPELINE( advance_p, advance_p_pipeline_args_t );
 
 void
@@ -68,17 +412,50 @@ advance_p_pipeline_v16( advance_p_pipeline_args_t * args,
                         int pipeline_rank,
                         int n_pipeline );
 
+#if defined(VPIC_USE_TILE_ACCUMULATORS)
+
+///////////////////////////////////////////////////////////////////////////////
+// advance_p_tiles_pipeline interface
+
+typedef struct voxel_range_pipeline_args
+{
+  MEM_PTR( const particle_block_t, 128 ) p0; // Particle array
+  MEM_PTR( int,                    16  ) lo; // First voxel of each pipeline
+  MEM_PTR( int,                    16  ) hi; // Last voxel of each pipeline
+  int64_t                                np; // Number of particles
+
+  PAD_STRUCT( 3*SIZEOF_MEM_PTR + sizeof(int64_t) )
+
+} voxel_range_pipeline_args_t;
+
+void
+voxel_range_pipeline_scalar( voxel_range_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline );
+
+// Assign each advance_p pipeline a tile accumulator covering the voxels
+// its particles can deposit current to and set a_tile accordingly.
+// a_tile[N_PIPELINE] is the host accumulator.  This updates
+// sp->wide_tiles.
+
+void
+advance_p_tiles_pipeline( species_t * RESTRICT sp,
+                          accumulator_array_t * RESTRICT aa,
+                          accumulator_t ** RESTRICT a_tile );
+
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // center_p_pipeline and uncenter_p_pipeline interface
 
 typedef struct center_p_pipeline_args
 {
-  MEM_PTR( particle_t,           128 ) p0;      // Particle array
+  MEM_PTR( particle_block_t,     128 ) p0;      // Particle array
   MEM_PTR( const interpolator_t, 128 ) f0;      // Interpolator array
   float                                qdt_2mc; // Particle/field coupling
-  int                                  np;      // Number of particles
+  int64_t                              np;      // Number of particles
 
-  PAD_STRUCT( 2*SIZEOF_MEM_PTR + sizeof(float) + sizeof(int) )
+  PAD_STRUCT( 2*SIZEOF_MEM_PTR + sizeof(float) + sizeof(int64_t) )
 
 } center_p_pipeline_args_t;
 
@@ -130,14 +507,14 @@ uncenter_p_pipeline_v16( center_p_pipeline_args_t * args,
 
 typedef struct energy_p_pipeline_args
 {
-  MEM_PTR( const particle_t,     128 ) p;       // Particle array
-  MEM_PTR( const interpolator_t, 128 ) f;       // Interpolator array
-  MEM_PTR( double,               128 ) en;      // Return values
-  float                                qdt_2mc; // Particle/field coupling
-  float                                msp;     // Species particle rest mass
-  int                                  np;      // Number of particles
+  MEM_PTR( const particle_block_t, 128 ) p;       // Particle array
+  MEM_PTR( const interpolator_t,   128 ) f;       // Interpolator array
+  MEM_PTR( double,                 128 ) en;      // Return values
+  float                                  qdt_2mc; // Particle/field coupling
+  float                                  msp;     // Species particle rest mass
+  int64_t                                np;      // Number of particles
 
-  PAD_STRUCT( 3*SIZEOF_MEM_PTR + 2*sizeof(float) + sizeof(int) )
+  PAD_STRUCT( 3*SIZEOF_MEM_PTR + 2*sizeof(float) + sizeof(int64_t) )
 
 } energy_p_pipeline_args_t;
 
@@ -163,6 +540,162 @@ energy_p_pipeline_v16( energy_p_pipeline_args_t * args,
                        int pipeline_rank,
                        int n_pipeline );
 
+///////////////////////////////////////////////////////////////////////////////
+// accumulate_hydro_p_pipeline interface
+
+typedef struct accumulate_hydro_p_pipeline_args
+{
+  MEM_PTR( const particle_block_t, 128 ) p0;      // Particle array
+  MEM_PTR( const interpolator_t,   128 ) f0;      // Interpolator array
+  MEM_PTR( hydro_t,                128 ) h;       // Host hydro array
+  MEM_PTR( hydro_t,                128 ) hp;      // Pipeline hydro arrays
+  float                                  qdt_2mc; // Particle/field coupling
+  float                                  qsp;     // Species particle charge
+  float                                  msp;     // Species particle mass
+  float                                  cvac;    // Speed of light
+  float                                  r8V;     // 1/(8 voxel volume)
+  int64_t                                np;      // Number of particles
+  int                                    nx;      // x-mesh resolution
+  int                                    ny;      // y-mesh resolution
+  int                                    stride;  // Stride between pipeline
+  /**/                                            // hydro arrays
+
+  PAD_STRUCT( 4*SIZEOF_MEM_PTR + 5*sizeof(float) + sizeof(int64_t) +
+              3*sizeof(int) )
+
+} accumulate_hydro_p_pipeline_args_t;
+
+// PROTOTYPE_PIPELINE( accumulate_hydro_p, accumulate_hydro_p_pipeline_args_t );
+
+void
+accumulate_hydro_p_pipeline_scalar( accumulate_hydro_p_pipeline_args_t * args,
+                                    int pipeline_rank,
+                                    int n_pipeline );
+
+void
+accumulate_hydro_p_pipeline_v4( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline );
+
+void
+accumulate_hydro_p_pipeline_v8( accumulate_hydro_p_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline );
+
+void
+accumulate_hydro_p_pipeline_v16( accumulate_hydro_p_pipeline_args_t * args,
+                                 int pipeline_rank,
+                                 int n_pipeline );
+
+///////////////////////////////////////////////////////////////////////////////
+// accumulate_rho_p_pipeline interface
+
+// The pipelines (and the host) deposit charge into node centered buffers
+// of their own (see rho_p_pipeline_buffers).  reduce_rho_p_pipeline then
+// adds the buffers to rhof or rhob in pipeline order, such that the result
+// does not depend on how the threads are scheduled.
+
+typedef struct accumulate_rho_p_pipeline_args
+{
+  MEM_PTR( const particle_block_t, 128 ) p0;     // Particle array
+  MEM_PTR( const particle_mover_t, 16  ) pm;     // Movers of the particles
+  /**/                                           // to drop (rhob only)
+  MEM_PTR( float,                  128 ) rho;    // Pipeline buffers
+  float                                  q_8V;   // Particle charge / (8 V)
+  int64_t                                np;     // Number of particles
+  /**/                                           // (movers for rhob)
+  int                                    stride; // Stride between buffers
+  int                                    nx;     // x-mesh resolution
+  int                                    ny;     // y-mesh resolution
+  int                                    nz;     // z-mesh resolution
+  int                                    sy;     // Voxel stride in y
+  int                                    sz;     // Voxel stride in z
+
+  PAD_STRUCT( 3*SIZEOF_MEM_PTR + sizeof(float) + sizeof(int64_t) +
+              6*sizeof(int) )
+
+} accumulate_rho_p_pipeline_args_t;
+
+// PROTOTYPE_PIPELINE( accumulate_rho_p,  accumulate_rho_p_pipeline_args_t );
+// PROTOTYPE_PIPELINE( accumulate_rhob_p, accumulate_rho_p_pipeline_args_t );
+
+void
+accumulate_rho_p_pipeline_scalar( accumulate_rho_p_pipeline_args_t * args,
+                                  int pipeline_rank,
+                                  int n_pipeline );
+
+void
+accumulate_rho_p_pipeline_v4( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+void
+accumulate_rho_p_pipeline_v8( accumulate_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+void
+accumulate_rho_p_pipeline_v16( accumulate_rho_p_pipeline_args_t * args,
+                               int pipeline_rank,
+                               int n_pipeline );
+
+void
+accumulate_rhob_p_pipeline_scalar( accumulate_rho_p_pipeline_args_t * args,
+                                   int pipeline_rank,
+                                   int n_pipeline );
+
+enum { reduce_rho_n_block = 32 };
+
+typedef struct reduce_rho_p_pipeline_args
+{
+  MEM_PTR( field_t,     128 ) f;       // Field array
+  MEM_PTR( const float, 128 ) rho;     // Pipeline buffers
+  int64_t                     n;       // Number of voxels
+  int                         n_array; // Number of buffers
+  int                         stride;  // Stride between buffers
+  int                         rhob;    // Reduce into rhob instead of rhof
+
+  PAD_STRUCT( 2*SIZEOF_MEM_PTR + sizeof(int64_t) + 3*sizeof(int) )
+
+} reduce_rho_p_pipeline_args_t;
+
+// PROTOTYPE_PIPELINE( reduce_rho_p, reduce_rho_p_pipeline_args_t );
+
+void
+reduce_rho_p_pipeline_scalar( reduce_rho_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+// Returns the buffer of the given pipeline and clears it.  The host
+// (pipeline_rank == n_pipeline) gets the last buffer.
+
+static inline float *
+pipeline_rho_buffer( float * RESTRICT rho,
+                     int stride,
+                     int pipeline_rank )
+{
+  rho += (size_t) pipeline_rank * (size_t) stride;
+
+  CLEAR( rho, stride );
+
+  return rho;
+}
+
+// Returns N_PIPELINE+1 node buffers for grid g, stride floats apart.  The
+// buffers are kept between calls.
+
+float *
+rho_p_pipeline_buffers( const grid_t * g,
+                        int * stride );
+
+// Adds the buffers to rhof (or to rhob if rhob is set) of fa.
+
+void
+reduce_rho_p_pipeline( field_array_t * RESTRICT fa,
+                       const float * RESTRICT rho,
+                       int stride,
+                       int rhob );
+
 ///////////////////////////////////////////////////////////////////////////////
 // sort_p_pipeline interface
 
@@ -190,26 +723,35 @@ energy_p_pipeline_v16( energy_p_pipeline_args_t * args,
   ((vl)+((((int64_t)(p))*((int64_t)((vh)-(vl)+1)) + ((int64_t)((P)-1))) / \
           ((int64_t)(P))))
 
+// Stride between the coarse counts of consecutive pipelines.  Rows are
+// padded to 128 bytes such that pipelines do not share cache lines.
+#define CP_STRIDE( n_subsort ) POW2_CEIL( (n_subsort), 16 )
+
 // FIXME: safe to remove? enum { max_subsort_voxel = 26624 };
 
 typedef struct sort_p_pipeline_args
 {
-  MEM_PTR( particle_t, 128 ) p;                // Particles (0:n-1)
-  MEM_PTR( particle_t, 128 ) aux_p;            // Aux particle atorage (0:n-1)
-  MEM_PTR( int,        128 ) coarse_partition; // Coarse partition storage
-  /**/ // (0:max_subsort-1,0:MAX_PIPELINE-1)
-  MEM_PTR( int,        128 ) partition;        // Partitioning (0:n_voxel)
-  MEM_PTR( int,        128 ) next;             // Aux partitioning (0:n_voxel)
-  int n;         // Number of particles
+  MEM_PTR( particle_block_t, 128 ) p;                // Particles (0:n-1)
+  MEM_PTR( particle_block_t, 128 ) aux_p;            // Aux particle atorage (0:n-1)
+  MEM_PTR( int64_t,          128 ) coarse_partition; // Coarse partition storage
+  /**/ // (0:cp_stride-1,0:n_pipeline-1)
+  MEM_PTR( int64_t,          128 ) subsort_partition; // Subsort partitioning
+  /**/ // (0:n_subsort)
+  MEM_PTR( int64_t,          128 ) partition;        // Partitioning (0:n_voxel)
+  MEM_PTR( int64_t,          128 ) next;             // Aux partitioning (0:n_voxel)
+  MEM_PTR( const int,        128 ) sfc;              // Voxel sort keys (g->sfc)
+  int64_t n;     // Number of particles
   int n_subsort; // Number of pipelines to be used for subsorts
-  int vl, vh;    // Particles may be contained in voxels [vl,vh].
+  int vl, vh;    // Particles may have sort keys in [vl,vh].
   int n_voxel;   // Number of voxels total (including ghosts)
 
-  PAD_STRUCT( 5*SIZEOF_MEM_PTR + 5*sizeof(int) )
+  PAD_STRUCT( 7*SIZEOF_MEM_PTR + sizeof(int64_t) + 4*sizeof(int) )
 
 } sort_p_pipeline_args_t;
 
 // PROTOTYPE_PIPELINE( coarse_count, sort_p_pipeline_args_t );
+// PROTOTYPE_PIPELINE( coarse_total, sort_p_pipeline_args_t );
+// PROTOTYPE_PIPELINE( coarse_scan,  sort_p_pipeline_args_t );
 // PROTOTYPE_PIPELINE( coarse_sort,  sort_p_pipeline_args_t );
 // PROTOTYPE_PIPELINE( subsort,      sort_p_pipeline_args_t );
 
@@ -218,6 +760,16 @@ coarse_count_pipeline_scalar( sort_p_pipeline_args_t * args,
                               int pipeline_rank,
                               int n_pipeline );
 
+void
+coarse_total_pipeline_scalar( sort_p_pipeline_args_t * args,
+                              int pipeline_rank,
+                              int n_pipeline );
+
+void
+coarse_scan_pipeline_scalar( sort_p_pipeline_args_t * args,
+                             int pipeline_rank,
+                             int n_pipeline );
+
 void
 coarse_sort_pipeline_scalar( sort_p_pipeline_args_t * args,
                              int pipeline_rank,
@@ -228,4 +780,55 @@ subsort_pipeline_scalar( sort_p_pipeline_args_t * args,
                          int pipeline_rank,
                          int n_pipeline );
 
+// The incremental in-place sort (see sort_p_pipeline.c) first finds the
+// particles that are not in the voxel range of the last partitioning.
+
+typedef struct find_misplaced_pipeline_args
+{
+  MEM_PTR( const particle_block_t, 128 ) p;           // Particles (0:n-1)
+  MEM_PTR( const int64_t,          128 ) partition;   // Last partitioning
+  MEM_PTR( const int,              128 ) sfc;         // Voxel sort keys
+  MEM_PTR( int64_t,                128 ) misplaced;   // Misplaced particles
+  /**/                                                // (0:n-1)
+  MEM_PTR( int64_t,                16  ) n_misplaced; // Number found by
+  /**/                                                // each pipeline
+  int64_t n;        // Number of particles
+  int64_t n_sorted; // Particles [0,n_sorted) are covered by partition
+
+  PAD_STRUCT( 5*SIZEOF_MEM_PTR + 2*sizeof(int64_t) )
+
+} find_misplaced_pipeline_args_t;
+
+void
+find_misplaced_pipeline_scalar( find_misplaced_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline );
+
+// It then moves the particles that are not in the range of their key in
+// the new partitioning through a buffer.
+
+typedef struct move_misfit_pipeline_args
+{
+  MEM_PTR( particle_block_t, 128 ) p;     // Particles
+  MEM_PTR( particle_block_t, 128 ) aux_p; // Particles moved (0:n-1)
+  MEM_PTR( const int64_t,    128 ) slot;  // Their slots in p (0:n-1)
+  MEM_PTR( int64_t,          128 ) dest;  // Their sort keys, then the slots
+  /**/                                    // they go to (0:n-1)
+  MEM_PTR( const int,        128 ) sfc;   // Voxel sort keys
+  int64_t n;     // Number of particles moved
+
+  PAD_STRUCT( 5*SIZEOF_MEM_PTR + sizeof(int64_t) )
+
+} move_misfit_pipeline_args_t;
+
+void
+gather_misfit_pipeline_scalar( move_misfit_pipeline_args_t * args,
+                               int pipeline_rank,
+                               int n_pipeline );
+
+void
+scatter_misfit_pipeline_scalar( move_misfit_pipeline_args_t * args,
+                                int pipeline_rank,
+                                int n_pipeline );
+
 #endif // _spa_private_h_
@@ -6,6 +6,8 @@
 
 using namespace v8;
 
+SIMD_KERNEL_BEGIN
+
 void
 uncenter_p_pipeline_v8( center_p_pipeline_args_t * args,
                         int pipeline_rank,
@@ -13,7 +15,14 @@ uncenter_p_pipeline_v8( center_p_pipeline_args_t * args,
 {
   const interpolator_t * ALIGNED(128) f0 = args->f0;
 
+  particle_block_t     * ALIGNED(128) p0 = args->p0;
+
+#if defined(VPIC_USE_COMPACT_P)
   particle_t           * ALIGNED(128) p;
+  DECLARE_ALIGNED_ARRAY( particle_t, 128, p_bundle, 8 );
+#else
+  particle_block_t     * ALIGNED(128) p;
+#endif
 
   const float          * ALIGNED(32)  vp00;
   const float          * ALIGNED(32)  vp01;
@@ -35,26 +44,37 @@ uncenter_p_pipeline_v8( center_p_pipeline_args_t * args,
   v8float v00, v01, v02, v03, v04, v05;
   v8int   ii;
 
-  int first, nq;
-
-  // Determine which particle quads this pipeline processes.
-
-  DISTRIBUTE( args->np, 16, pipeline_rank, n_pipeline, first, nq );
+  int64_t first, nq;
 
-  p = args->p0 + first;
+  // Determine which particle quads this pipeline processes and process them.
+  // The particles come in chunks idle pipelines can steal (see
+  // FOR_EACH_PIPELINE_CHUNK).
 
-  nq >>= 3;
-
-  // Process the particle blocks for this pipeline.
-
-  for( ; nq; nq--, p+=8 )
+  FOR_EACH_PIPELINE_CHUNK( args->np, 16, pipeline_rank, n_pipeline, first, nq )
+  for( nq >>= 3; nq; nq--, first+=8 )
   {
+#   if defined(VPIC_USE_COMPACT_P)
+    LOAD_PARTICLE_BUNDLE( p0, first, p_bundle, 8 );
+    p = p_bundle;
+#   else
+    p = p0 + first/PARTICLE_BLOCK_SIZE;
+#   endif
+
     //--------------------------------------------------------------------------
     // Load particle data.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    const int l = first%PARTICLE_BLOCK_SIZE;
+
+    load_8x1( &p->dx[l], dx );
+    load_8x1( &p->dy[l], dy );
+    load_8x1( &p->dz[l], dz );
+    load_8x1( &p->i [l], ii );
+#   else
     load_8x4_tr( &p[0].dx, &p[1].dx, &p[2].dx, &p[3].dx,
 		 &p[4].dx, &p[5].dx, &p[6].dx, &p[7].dx,
 		 dx, dy, dz, ii );
+#   endif
 
     //--------------------------------------------------------------------------
     // Set field interpolation pointers.
@@ -117,9 +137,16 @@ uncenter_p_pipeline_v8( center_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Load particle data.  Could use load_8x3_tr.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    load_8x1( &p->ux[l], ux );
+    load_8x1( &p->uy[l], uy );
+    load_8x1( &p->uz[l], uz );
+    load_8x1( &p->w [l], q  );
+#   else
     load_8x4_tr( &p[0].ux, &p[1].ux, &p[2].ux, &p[3].ux,
 		 &p[4].ux, &p[5].ux, &p[6].ux, &p[7].ux,
 		 ux, uy, uz, q );
+#   endif
 
     //--------------------------------------------------------------------------
     // Update momentum.
@@ -143,12 +170,24 @@ uncenter_p_pipeline_v8( center_p_pipeline_args_t * args,
     //--------------------------------------------------------------------------
     // Store particle data.  Could use store_8x3_tr.
     //--------------------------------------------------------------------------
+#   if defined(VPIC_USE_AOSOA_P)
+    store_8x1( ux, &p->ux[l] );
+    store_8x1( uy, &p->uy[l] );
+    store_8x1( uz, &p->uz[l] );
+#   else
     store_8x4_tr( ux, uy, uz, q,
 		  &p[0].ux, &p[1].ux, &p[2].ux, &p[3].ux,
 		  &p[4].ux, &p[5].ux, &p[6].ux, &p[7].ux );
+#   endif
+
+#   if defined(VPIC_USE_COMPACT_P)
+    STORE_PARTICLE_BUNDLE( p, p0, first, 8 );
+#   endif
   }
 }
 
+SIMD_KERNEL_END
+
 #else
 
 void
@@ -29,19 +29,21 @@ sort_p( species_t * sp )
 
   sp->last_sorted = sp->g->step;
 
-  particle_t * ALIGNED(128) p = sp->p;
+  particle_block_t * ALIGNED(128) p = sp->p;
 
-  const int np                = sp->np; 
+  const int64_t np            = sp->np; 
   const int nc                = sp->g->nv;
   const int nc1               = nc + 1;
 
-  int * RESTRICT ALIGNED(128) partition = sp->partition;
+  int64_t * RESTRICT ALIGNED(128) partition = sp->partition;
 
-  static int * RESTRICT ALIGNED(128) next = NULL;
+  const int * RESTRICT ALIGNED(128) sfc = sp->g->sfc;
 
-  static int max_nc1 = 0;
+  static VPIC_THREAD_LOCAL int64_t * RESTRICT ALIGNED(128) next = NULL;
 
-  int i, j;
+  static VPIC_THREAD_LOCAL int max_nc1 = 0;
+
+  int64_t i, j;
 
   // Do not need to sort.
   if ( np == 0 )
@@ -53,7 +55,7 @@ sort_p( species_t * sp )
   if ( max_nc1 < nc1 )
   {
     // Hack around RESTRICT issues.
-    int *tmp = next;
+    int64_t *tmp = next;
 
     FREE_ALIGNED( tmp );
 
@@ -63,12 +65,12 @@ sort_p( species_t * sp )
     max_nc1 = nc1;
   }
 
-  // Count particles in each cell.
+  // Count particles in each cell (indexed by sort key).
   CLEAR( next, nc1 );
 
   for( i = 0; i < np; i++ )
   {
-    next[ p[i].i ]++;
+    next[ sfc[ PARTICLE_VOXEL( p, i ) ] ]++;
   }
 
   // Convert the count to a partitioning and save a copy in next.
@@ -84,18 +86,19 @@ sort_p( species_t * sp )
   {
     // Throw down the particle array in order.
 
-    /**/  particle_t *          ALIGNED(128) new_p;
-    const particle_t * RESTRICT ALIGNED( 32)  in_p;
-    /**/  particle_t * RESTRICT ALIGNED( 32) out_p;
+    /**/  particle_block_t *          ALIGNED(128) new_p;
+    const particle_block_t * RESTRICT ALIGNED( 32)  in_p;
+    /**/  particle_block_t * RESTRICT ALIGNED( 32) out_p;
 
-    MALLOC_ALIGNED( new_p, sp->max_np, 128 );
+    MALLOC_ALIGNED( new_p, PARTICLE_BLOCKS( sp->max_np ), 128 );
 
     in_p  = sp->p;
     out_p = new_p;
 
     for( i = 0; i < np; i++ )
     {
-      out_p[ next[ in_p[i].i ]++ ] = in_p[i];
+      copy_particle( out_p, next[ sfc[ PARTICLE_VOXEL( in_p, i ) ] ]++,
+                     in_p, i );
     }
 
     FREE_ALIGNED( sp->p );
@@ -107,9 +110,8 @@ sort_p( species_t * sp )
   {
     // Run sort cycles until the list is sorted.
 
-    particle_t               save_p;
-    particle_t * ALIGNED(32) src;
-    particle_t * ALIGNED(32) dest;
+    particle_t save_p, src_p;
+    int64_t src, dest;
 
     i = 0;
     while( i < nc )
@@ -121,17 +123,18 @@ sort_p( species_t * sp )
 
       else
       {
-        src = &p[ next[i] ];
+        src = next[i];
 
         for( ; ; )
         {
-          dest = &p[ next[ src->i ]++ ];
+          dest = next[ sfc[ PARTICLE_VOXEL( p, src ) ] ]++;
 
           if ( src == dest ) break;
 
-          save_p = *dest;
-          *dest  = *src;
-          *src   = save_p;
+          load_particle( p, dest, &save_p );
+          load_particle( p, src,  &src_p  );
+          store_particle( &src_p,  p, dest );
+          store_particle( &save_p, p, src  );
         }
       }
     }
@@ -163,3 +166,122 @@ sort_p( species_t * sp )
 }
 
 #endif
+
+//----------------------------------------------------------------------------//
+// Adaptive sorting.  A species with a negative sort_interval is sorted when
+// the advance_p slowdown accumulated since its last sort exceeds the time
+// that sort took.  When the slowdown grows linearly in time, this sort
+// interval minimizes the average time per step.
+//
+// The slowdown of a step is the advance_p time in excess of the time per
+// particle measured right after the last sort.  To keep timing noise out of
+// the estimate, only steps where advance_p found the particles more
+// disordered than right after the sort count.  The disorder is the fraction
+// of far particles, particles whose voxel is not near the voxel of the
+// previous particle in the particle array (see advance_p_pipeline).
+//----------------------------------------------------------------------------//
+
+int
+adaptive_sort_p( species_t * sp )
+{
+  double t;
+
+  if ( !sp )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  if ( sp->last_sorted != INT64_MIN &&
+       sp->push_excess < sp->sort_cost )
+  {
+    return 0;
+  }
+
+  t = wallclock();
+
+  sort_p( sp );
+
+  sp->sort_cost   = wallclock() - t;
+  sp->push_ref    = 0; // Calibrated by the next advance_p
+  sp->push_excess = 0;
+  sp->n_sort++;
+
+  return 1;
+}
+
+void
+update_adaptive_sort_p( species_t * sp,
+                        double t_push )
+{
+  double far;
+
+  if ( !sp )
+  {
+    ERROR( ( "Bad args" ) );
+  }
+
+  if ( sp->np < 1 )
+  {
+    return;
+  }
+
+  far = (double) sp->n_far / (double) sp->np;
+
+  if ( sp->push_ref == 0 )
+  {
+    sp->push_ref = t_push / (double) sp->np;
+    sp->far_ref  = far;
+  }
+
+  else if ( far > sp->far_ref )
+  {
+    sp->push_excess += t_push - sp->push_ref * (double) sp->np;
+
+    if ( sp->push_excess < 0 )
+    {
+      sp->push_excess = 0;
+    }
+  }
+}
+
+void
+report_adaptive_sort_p( species_t * sp_list,
+                        int dump )
+{
+  species_t * sp;
+  int header = 1;
+
+  LIST_FOR_EACH( sp, sp_list )
+  {
+    if ( sp->sort_interval >= 0 )
+    {
+      continue;
+    }
+
+    if ( dump )
+    {
+      if ( header )
+      {
+        log_printf( "    Adaptive sort (local)  | Sorts   Far    Far@sort Slowdown Sort time\n"
+                    "---------------------------+----------------------------------------------\n" );
+
+        header = 0;
+      }
+
+      log_printf( "%26.26s | %5d %.1e %.1e %.1e %.1e\n",
+                  sp->name,
+                  sp->n_sort,
+                  sp->np ? (double) sp->n_far / (double) sp->np : 0.,
+                  sp->far_ref,
+                  sp->push_excess,
+                  sp->sort_cost );
+    }
+
+    sp->n_sort = 0;
+  }
+
+  if ( dump && !header )
+  {
+    log_printf( "\n" );
+  }
+}
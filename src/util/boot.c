@@ -2,7 +2,7 @@
 
 #include "stdio.h"
 
-double _boot_timestamp = 0;
+VPIC_THREAD_LOCAL double _boot_timestamp = 0;
 
 double
 uptime( void ) {
@@ -23,8 +23,14 @@ boot_services( int * pargc,
   // cores if threads are booted _after_ MPI is initialized.  So we
   // start up the pipeline dispatchers _before_ starting up MPI.
 
-  // FIXME: The thread utilities should take responsibility for
-  // thread-core affinity instead of leaving this to chance.
+  // The thread utilities pin the pipelines to cores when asked to
+  // (--pin, see pipelines_numa.c).  Otherwise this is left to chance.
+
+  // Select the simd kernels before anything is dispatched.
+
+#if defined(VPIC_USE_SIMD_DISPATCH)
+  boot_simd( pargc, pargv );
+#endif
 
   // Boot up the communications layer
 
@@ -54,6 +60,9 @@ boot_services( int * pargc,
   if (_world_rank == 0)
   {
       printf("Booting with %d threads and %d (MPI) ranks \n", thread.n_pipeline, _world_size);
+#if defined(VPIC_USE_SIMD_DISPATCH)
+      printf("Using %s pipeline kernels \n", simd_name( simd_width ));
+#endif
   }
 }
 
@@ -12,16 +12,124 @@
 #define IN_checkpt
 #include "checkpt_private.h"
 
+#include <pthread.h>
+
 /* Boolean flag indicating whether or not checkpoint is booted. */
 
-static int booted = 0;
+static VPIC_THREAD_LOCAL int booted = 0;
 
 /* If NULL, indicates that we are not in the middle of a checkpt or a
    restore.  Otherwise, it gives the handle of the stream used for I/O
    operations. */
 
-static checkpt_t * checkpt = NULL;
-static checkpt_t * restore = NULL;
+static VPIC_THREAD_LOCAL checkpt_t * checkpt = NULL;
+static VPIC_THREAD_LOCAL checkpt_t * restore = NULL;
+
+/* Asynchronous checkpointing ("--checkpt_async 1").  checkpt_objects
+   serializes the objects into a staging buffer in memory instead of
+   the checkpt and hands the buffer to a writer thread, which streams
+   it to the checkpt while the caller goes on.  The staging buffer is a
+   list of chunks, such that it grows without copying what was already
+   serialized.  It holds a full copy of the local state until the
+   writer is done with it.  Only one checkpt is written at a time.
+
+   The staged checkpt is self-contained (the writer does not look at
+   the registry or at the objects), so the objects can change and even
+   be deleted while it is written.
+
+   The writers are also counted process wide (the state above is per
+   rank under THREAD_MP), and an atexit handler waits for all of them.
+   Decks commonly end with "checkpt(...); halt_mp(); exit(0);", which
+   would otherwise truncate the last checkpt. */
+
+enum { STAGE_CHUNK = 1<<24 }; /* Bytes per chunk (16 MiB) */
+
+typedef struct stage_chunk {
+  struct stage_chunk * next;
+  size_t n;
+  char data[STAGE_CHUNK];
+} stage_chunk_t;
+
+typedef struct stage {
+  char * name;
+  stage_chunk_t * head, * tail;
+} stage_t;
+
+static VPIC_THREAD_LOCAL int       async   = 0;    /* --checkpt_async */
+static VPIC_THREAD_LOCAL stage_t * stage   = NULL; /* Checkpt being staged */
+static VPIC_THREAD_LOCAL int       writing = 0;    /* Writer running? */
+static VPIC_THREAD_LOCAL pthread_t writer;
+
+static pthread_mutex_t n_writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  n_writer_done = PTHREAD_COND_INITIALIZER;
+static pthread_once_t  n_writer_once = PTHREAD_ONCE_INIT;
+static int             n_writer      = 0; /* Writers in the process */
+
+static void
+flush_all_writers( void ) {
+  pthread_mutex_lock( &n_writer_lock );
+  while( n_writer ) pthread_cond_wait( &n_writer_done, &n_writer_lock );
+  pthread_mutex_unlock( &n_writer_lock );
+}
+
+static void
+register_flush_all_writers( void ) {
+  if( atexit( flush_all_writers ) )
+    ERROR(( "Unable to register the checkpt writer flush" ));
+}
+
+static void
+stage_write( stage_t * s,
+             const void * data,
+             size_t n_byte ) {
+  const char * d = (const char *)data;
+  size_t n;
+
+  while( n_byte ) {
+    if( !s->tail || s->tail->n==STAGE_CHUNK ) {
+      stage_chunk_t * c;
+      MALLOC( c, 1 );
+      c->next = NULL;
+      c->n    = 0;
+      if( s->tail ) s->tail->next = c;
+      else          s->head       = c;
+      s->tail = c;
+    }
+    n = STAGE_CHUNK - s->tail->n;
+    if( n>n_byte ) n = n_byte;
+    memcpy( s->tail->data + s->tail->n, d, n );
+    s->tail->n += n;
+    d += n, n_byte -= n;
+  }
+}
+
+/* Writer thread.  Writes the staged checkpt, freeing each chunk once
+   it is written, and then frees the stage. */
+
+static void *
+write_stage( void * _s ) {
+  stage_t * s = (stage_t *)_s;
+  stage_chunk_t * c;
+  checkpt_t * out;
+
+  out = checkpt_open_wronly( s->name );
+  while( s->head ) {
+    c = s->head;
+    s->head = c->next;
+    checkpt_write( out, c->data, c->n );
+    FREE( c );
+  }
+  checkpt_close( out );
+
+  FREE( s->name );
+  FREE( s );
+
+  pthread_mutex_lock( &n_writer_lock );
+  n_writer--;
+  pthread_cond_broadcast( &n_writer_done );
+  pthread_mutex_unlock( &n_writer_lock );
+  return NULL;
+}
 
 /* The registry is a list of objects that need to checkpointed (in the
    order they should be checkpointed).  The registry gives each object
@@ -37,12 +145,12 @@ typedef struct registry {
   struct registry * next;
 } registry_t;
 
-static registry_t * registry = NULL;
+static VPIC_THREAD_LOCAL registry_t * registry = NULL;
 
 /* Counter used to dole out unique ids.  Zero ids are used to indicate
    an error condition. */
 
-static size_t next_id = 1;
+static VPIC_THREAD_LOCAL size_t next_id = 1;
 
 #ifdef VERBOSE_CHECKPOINTING
 
@@ -105,6 +213,10 @@ boot_checkpt( int * pargc,
   checkpt  = NULL;
   restore  = NULL;
   next_id  = 1;
+  stage    = NULL;
+  writing  = 0;
+  async    = strip_cmdline_int( pargc, pargv, "--checkpt_async", 0 );
+  if( async ) pthread_once( &n_writer_once, register_flush_all_writers );
 
   /* Mark the service as booted */
 
@@ -121,9 +233,13 @@ halt_checkpt( void ) {
     dump_registry();
     ERROR(( "halt called with some objects still registered" ));
   }
-  if( checkpt  ) ERROR(( "currently writing a checkpt" ));
+  if( checkpt || stage ) ERROR(( "currently writing a checkpt" ));
   if( restore  ) ERROR(( "currently reading a checkpt" ));
 
+  /* Wait for the last checkpt to be written */
+
+  flush_checkpt();
+
   /* Mark the service as halted */
 
   booted = 0;
@@ -181,7 +297,7 @@ void register_object(
   /* Check input args */
 
   if( !booted ) ERROR(( "checkpt service not booted" ));
-  if( checkpt ) ERROR(( "currently writing a checkpt" ));
+  if( checkpt || stage ) ERROR(( "currently writing a checkpt" ));
   if( restore ) ERROR(( "currently reading a checkpt" ));
 
   /* Check that obj is valid and that obj isn't already registered.
@@ -215,7 +331,7 @@ unregister_object( void * obj ) {
   /* Check input args */
 
   if( !booted ) ERROR(( "checkpt service not booted" ));
-  if( checkpt ) ERROR(( "currently writing a checkpt" ));
+  if( checkpt || stage ) ERROR(( "currently writing a checkpt" ));
   if( restore ) ERROR(( "currently reading a checkpt" ));
 
   /* Find the entry for this object in the register and the previous
@@ -243,12 +359,24 @@ checkpt_objects( const char * name ) {
   /* Check input args */
 
   if( !booted ) ERROR(( "checkpt not booted" ));
-  if( checkpt ) ERROR(( "currently writing a checkpt" ));
+  if( checkpt || stage ) ERROR(( "currently writing a checkpt" ));
   if( restore ) ERROR(( "currently reading a checkpt" ));
 
-  /* Open the checkpt serialization stream */
-
-  checkpt = checkpt_open_wronly( name );
+  /* Open the checkpt serialization stream.  When checkpointing
+     asynchronously, wait for the last checkpt to be written and stage
+     this one. */
+
+  if( async ) {
+    if( !name ) ERROR(( "NULL name" ));
+    flush_checkpt();
+    MALLOC( stage, 1 );
+    MALLOC( stage->name, strlen(name)+1 );
+    strcpy( stage->name, name );
+    stage->head = NULL;
+    stage->tail = NULL;
+  } else {
+    checkpt = checkpt_open_wronly( name );
+  }
   CHECKPT_VAL( size_t, next_id );
 
   /* Checkpoint the objects */
@@ -268,8 +396,25 @@ checkpt_objects( const char * name ) {
      checkpt */
   
   CHECKPT_VAL( size_t, 0xBADF00D );
-  checkpt_close( checkpt );
-  checkpt = NULL;
+  if( stage ) {
+    pthread_mutex_lock( &n_writer_lock );
+    n_writer++;
+    pthread_mutex_unlock( &n_writer_lock );
+    if( pthread_create( &writer, NULL, write_stage, stage ) )
+      ERROR(( "Unable to start the checkpt writer" ));
+    writing = 1;
+    stage   = NULL;
+  } else {
+    checkpt_close( checkpt );
+    checkpt = NULL;
+  }
+}
+
+void
+flush_checkpt( void ) {
+  if( !writing ) return;
+  if( pthread_join( writer, NULL ) ) ERROR(( "Unable to stop the checkpt writer" ));
+  writing = 0;
 }
 
 void
@@ -280,9 +425,13 @@ restore_objects( const char * name ) {
   /* Check input args */
 
   if( !booted ) ERROR(( "checkpt not booted" ));
-  if( checkpt ) ERROR(( "currently writing a checkpt" ));
+  if( checkpt || stage ) ERROR(( "currently writing a checkpt" ));
   if( restore ) ERROR(( "currently reading a checkpt" ));
 
+  /* The checkpt might be the one being written */
+
+  flush_checkpt();
+
   /* Delete all objects in the in favor of the checkpointed objects */
 
   node = registry;
@@ -334,7 +483,7 @@ reanimate_objects( void ) {
   /* Check input args */
 
   if( !booted ) ERROR(( "checkpt not booted" ));
-  if( checkpt ) ERROR(( "currently writing a checkpt" ));
+  if( checkpt || stage ) ERROR(( "currently writing a checkpt" ));
   if( restore ) ERROR(( "currently reading a checkpt" ));
 
   /* Call each objects reanimate function */
@@ -353,12 +502,14 @@ checkpt_raw( const void * data,
 
   /* Check input args */
 
-  if( !checkpt ) ERROR(( "not writing a checkpt" ));
+  if( !checkpt && !stage ) ERROR(( "not writing a checkpt" ));
   if( !data && n_byte ) ERROR(( "NULL data" ));
 
   /* Write data to the serialization stream */
 
-  if( n_byte ) checkpt_write( checkpt, data, n_byte );
+  if( !n_byte ) return;
+  if( stage ) stage_write( stage, data, n_byte );
+  else        checkpt_write( checkpt, data, n_byte );
 }
 
 void
@@ -103,6 +103,16 @@ checkpt_objects( const char * name );
 void
 restore_objects( const char * name );
 
+/* With "--checkpt_async 1", checkpt_objects copies the objects into
+   memory and returns while a background thread writes the checkpt.
+   flush_checkpt waits until the checkpt is written (it returns
+   immediately otherwise).  checkpt_objects, restore_objects and
+   halt_checkpt flush the previous checkpt, and exit waits for any
+   checkpt still being written. */
+
+void
+flush_checkpt( void );
+
 /* Call the reanimate functions on all objects.  This is typically
    done after the restore process. */
 
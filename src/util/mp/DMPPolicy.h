@@ -4,6 +4,9 @@
 #include <mpi.h>
 #include <cstdlib>
 #include <cstdlib>
+#if defined(VPIC_USE_SHARED_MP)
+#include <sched.h>
+#endif
 
 #include "../checkpt/checkpt.h"
 
@@ -17,12 +20,115 @@ struct collective {
   MPI_Comm comm;
 };
 
+#if defined(VPIC_USE_PERSISTENT_MP)
+
+/* With persistent communication, each port keeps up to MP_N_PREQ
+   persistent requests for each direction, for the messages recently
+   posted on it.  A message is posted with a persistent request if it has
+   the same buffer, size, peer and tag as one of these (the port is
+   implied).  Otherwise, it is posted as usual and a persistent request
+   is made for it if it matches one of the last MP_N_PREQ messages posted
+   as usual on the port (ports are used for messages of a few different
+   sizes in turn).  Resizing the buffer of a port frees its persistent
+   requests.
+
+   The size of a message changes from step to step for the particle
+   payloads of boundary_p, so messages that go through MPI are padded to
+   a size class (mp_psize; at most 1/16 larger) and payloads of about the
+   same size use the same persistent request.  The sender and the
+   receiver pad the same size the same way.  Buffer sizes are size
+   classes, such that a padded message always fits in a buffer that
+   holds the message. */
+
+enum { MP_N_PREQ = 4 };
+
+/* Round sz up to a size class (the sizes with at most 5 significant
+   bits) */
+
+static inline int
+mp_psize( int sz ) {
+  int g = 1;
+  while( ( g<<5 )<=sz ) g <<= 1;
+  return ( ( sz + g - 1 )/g )*g;
+}
+
+typedef struct mp_preq {
+  MPI_Request req;  /* MPI_REQUEST_NULL if not in use */
+  char * buf;
+  int sz, peer, tag;
+} mp_preq_t;
+
+typedef struct mp_pport {
+  mp_preq_t preq[MP_N_PREQ]; /* Persistent requests */
+  mp_preq_t seen[MP_N_PREQ]; /* Last messages posted without one */
+  int next;                  /* Persistent request to replace next */
+  int next_seen;             /* Seen message to replace next */
+  int active;                /* Persistent request in flight (-1 if none) */
+} mp_pport_t;
+
+#endif
+
+#if defined(VPIC_USE_SHARED_MP)
+
+/* With shared memory communication, the ranks on a node share an MPI-3
+   shared memory window.  The segment of each rank holds a control block
+   and a slot of MP_SHM_SLOT_SIZE bytes for each port of the first mp made
+   (the one of the grid).  The send buffer of a port is its slot while the
+   buffer fits in it, so a message to a rank on the same node is posted by
+   just filling in the control block, and the receiver copies it straight
+   out of the slot into its receive buffer.  Messages to other nodes and
+   messages that do not fit in a slot go through MPI as usual.  Both sides
+   of a message make the same choice, as it only depends on the size of
+   the message and on whether the ranks share a node.
+
+   This is a one-copy path (the receive buffers are private to their
+   rank).  The window is kept in a lock_all epoch, and the control
+   blocks are handed off with atomics bracketed by MPI_Win_sync, which
+   orders the slot and control block accesses as the MPI-3 shared memory
+   model requires.  Like MPI, a receive matches the earliest message
+   posted with its source and tag; the sender numbers its messages for
+   this, as the receiving port is not known to the sender. */
+
+#ifndef MP_SHM_SLOT_SIZE
+#define MP_SHM_SLOT_SIZE 262144 /* Must be a multiple of 128 */
+#endif
+
+typedef struct mp_shm_ctl {
+  int posted;   /* Messages posted on the slot (written by the sender) */
+  int done;     /* Messages copied out of the slot (written by the receiver) */
+  int dst, tag, sz;
+  int seq;      /* Messages posted by the sender before this one */
+  int _pad[26]; /* Control blocks are 128 bytes apart */
+} mp_shm_ctl_t;
+
+typedef struct mp_shm {
+  MPI_Win win;         /* MPI_WIN_NULL until the first mp is made */
+  MPI_Comm node;       /* The ranks on this node */
+  int n_port;          /* Ports of each segment */
+  int * node_rank;     /* Node rank of each world rank (-1 if off node) */
+  mp_shm_ctl_t ** ctl; /* Control blocks of each node rank */
+  char ** slot;        /* Slots of each node rank */
+  int n_posted;        /* Messages this rank posted in the window */
+} mp_shm_t;
+
+static mp_shm_t __mp_shm = { MPI_WIN_NULL, MPI_COMM_NULL, 0, NULL, NULL, NULL, 0 };
+
+#endif
+
 struct mp {
   int n_port;
   char * ALIGNED(128) * rbuf; char * ALIGNED(128) * sbuf;
   int * rbuf_sz;              int * sbuf_sz;
   int * rreq_sz;              int * sreq_sz;
   MPI_Request * rreq;         MPI_Request * sreq;
+# if defined(VPIC_USE_PERSISTENT_MP)
+  mp_pport_t * rpport;        mp_pport_t * spport;
+# endif
+# if defined(VPIC_USE_SHARED_MP)
+  char * sslot;               /* Send slots of this rank (NULL if none) */
+  int * rshm;                 int * sshm; /* Message in shared memory? */
+  int * rsrc;                 int * rtag;
+# endif
 };
 
 /* Create the world collective */
@@ -57,6 +163,330 @@ restore_collective( void ) {
   return world;
 }
 
+#if defined(VPIC_USE_PERSISTENT_MP)
+
+/* Persistent requests do not survive a restart, so they are not
+   checkpointed. */
+
+static void
+free_mp_pport( mp_pport_t * pp ) {
+  if( pp->active>=0 ) ERROR(( "Port buffer resized while in use" ));
+  for( int n=0; n<MP_N_PREQ; n++ ) {
+    if( pp->preq[n].req!=MPI_REQUEST_NULL ) MPI_Request_free( &pp->preq[n].req );
+    pp->seen[n].buf = NULL;
+  }
+  pp->next      = 0;
+  pp->next_seen = 0;
+  pp->active    = -1;
+}
+
+static void
+new_mp_pports( mp_t * mp ) {
+  int port, n;
+  MALLOC( mp->rpport, mp->n_port ); MALLOC( mp->spport, mp->n_port );
+  for( port=0; port<mp->n_port; port++ ) {
+    for( n=0; n<MP_N_PREQ; n++ ) {
+      mp->rpport[port].preq[n].req = MPI_REQUEST_NULL;
+      mp->spport[port].preq[n].req = MPI_REQUEST_NULL;
+    }
+    mp->rpport[port].active = -1;
+    mp->spport[port].active = -1;
+  }
+  for( port=0; port<mp->n_port; port++ ) {
+    free_mp_pport( mp->rpport + port );
+    free_mp_pport( mp->spport + port );
+  }
+}
+
+static void
+delete_mp_pports( mp_t * mp ) {
+  for( int port=0; port<mp->n_port; port++ ) {
+    free_mp_pport( mp->rpport + port );
+    free_mp_pport( mp->spport + port );
+  }
+  FREE( mp->rpport ); FREE( mp->spport );
+}
+
+/* Start the message (buf,sz,peer,tag) with a persistent request of pp if
+   there is (or should be) one for it.  Returns 0 if the message should be
+   posted as usual. */
+
+static int
+start_mp_pport( mp_pport_t * pp,
+                char * buf,
+                int sz,
+                int peer,
+                int tag,
+                int send ) {
+  mp_preq_t * r;
+  int n, ierr;
+
+# define MATCH(r) ( (r)->buf==buf && (r)->sz==sz && \
+                    (r)->peer==peer && (r)->tag==tag )
+
+  for( n=0; n<MP_N_PREQ; n++ )
+    if( pp->preq[n].req!=MPI_REQUEST_NULL && MATCH( pp->preq + n ) ) break;
+
+  if( n==MP_N_PREQ ) {
+
+    // Is this message posted regularly?
+
+    for( n=0; n<MP_N_PREQ; n++ ) if( MATCH( pp->seen + n ) ) break;
+    if( n==MP_N_PREQ ) {
+      r = pp->seen + pp->next_seen; pp->next_seen = (pp->next_seen+1) % MP_N_PREQ;
+      r->buf = buf, r->sz = sz, r->peer = peer, r->tag = tag;
+      return 0;
+    }
+    pp->seen[n].buf = NULL;
+
+    // Make a persistent request for it
+
+    n = pp->next; pp->next = (n+1) % MP_N_PREQ;
+    r = pp->preq + n;
+    if( r->req!=MPI_REQUEST_NULL ) MPI_Request_free( &r->req );
+    r->buf = buf, r->sz = sz, r->peer = peer, r->tag = tag;
+    ierr = send ?
+      MPI_Ssend_init( buf, sz, MPI_BYTE, peer, tag, world->comm, &r->req ) :
+      MPI_Recv_init(  buf, sz, MPI_BYTE, peer, tag, world->comm, &r->req );
+    if( ierr!=MPI_SUCCESS ) ERROR(( "MPI error %i on MPI_*_init", ierr ));
+  }
+
+# undef MATCH
+
+  ierr = MPI_Start( &pp->preq[n].req );
+  if( ierr!=MPI_SUCCESS ) ERROR(( "MPI error %i on MPI_Start", ierr ));
+  pp->active = n;
+  return 1;
+}
+
+/* Wait for the message started last on pp to complete */
+
+static MPI_Request *
+end_mp_pport( mp_pport_t * pp,
+              MPI_Request * req ) {
+  if( pp->active>=0 ) req = &pp->preq[pp->active].req;
+  pp->active = -1;
+  return req;
+}
+
+#endif
+
+#if defined(VPIC_USE_SHARED_MP)
+
+/* The shared memory state is remade on restore.  The send buffers that
+   fit in their slot are moved into it. */
+
+static void
+new_mp_shm( mp_t * mp ) {
+  int port, n, n_node, disp, off, * r;
+  MPI_Aint sz;
+  MPI_Group world_group, node_group;
+  char * seg;
+
+  MALLOC( mp->rshm, mp->n_port ); MALLOC( mp->sshm, mp->n_port );
+  MALLOC( mp->rsrc, mp->n_port ); MALLOC( mp->rtag, mp->n_port );
+  CLEAR(  mp->rshm, mp->n_port ); CLEAR(  mp->sshm, mp->n_port );
+  CLEAR(  mp->rsrc, mp->n_port ); CLEAR(  mp->rtag, mp->n_port );
+  mp->sslot = NULL;
+
+  // Only the first mp made uses the window (all ranks make their mps in
+  // the same order, so they all agree)
+
+  if( __mp_shm.win!=MPI_WIN_NULL ) return;
+
+  if( MPI_Comm_split_type( world->comm, MPI_COMM_TYPE_SHARED, world_rank,
+                           MPI_INFO_NULL, &__mp_shm.node )!=MPI_SUCCESS )
+    ERROR(( "MPI error on MPI_Comm_split_type" ));
+  MPI_Comm_size( __mp_shm.node, &n_node );
+
+  MALLOC( __mp_shm.node_rank, world_size ); MALLOC( r, world_size );
+  for( n=0; n<world_size; n++ ) r[n] = n;
+  MPI_Comm_group( world->comm, &world_group );
+  MPI_Comm_group( __mp_shm.node, &node_group );
+  MPI_Group_translate_ranks( world_group, world_size, r,
+                             node_group, __mp_shm.node_rank );
+  MPI_Group_free( &world_group ); MPI_Group_free( &node_group );
+  FREE( r );
+  for( n=0; n<world_size; n++ )
+    if( __mp_shm.node_rank[n]==MPI_UNDEFINED ) __mp_shm.node_rank[n] = -1;
+
+  // Segments are 128-byte aligned as seen by their owner (the segments
+  // need not be mapped at the same addresses on all ranks)
+
+  sz = (MPI_Aint)mp->n_port*( sizeof(mp_shm_ctl_t) + MP_SHM_SLOT_SIZE ) + 128;
+  if( MPI_Win_allocate_shared( sz, 1, MPI_INFO_NULL, __mp_shm.node,
+                               &seg, &__mp_shm.win )!=MPI_SUCCESS )
+    ERROR(( "MPI error on MPI_Win_allocate_shared" ));
+  MPI_Win_lock_all( MPI_MODE_NOCHECK, __mp_shm.win );
+
+  MALLOC( r, n_node );
+  off = (int)( ( 128 - ((size_t)seg & 127) ) & 127 );
+  MPI_Allgather( &off, 1, MPI_INT, r, 1, MPI_INT, __mp_shm.node );
+
+  MALLOC( __mp_shm.ctl, n_node ); MALLOC( __mp_shm.slot, n_node );
+  for( n=0; n<n_node; n++ ) {
+    MPI_Win_shared_query( __mp_shm.win, n, &sz, &disp, &seg );
+    seg += r[n];
+    __mp_shm.ctl[n]  = (mp_shm_ctl_t *)seg;
+    __mp_shm.slot[n] = seg + mp->n_port*sizeof(mp_shm_ctl_t);
+  }
+  FREE( r );
+  __mp_shm.n_port = mp->n_port;
+
+  n = __mp_shm.node_rank[world_rank];
+  CLEAR( __mp_shm.ctl[n], mp->n_port );
+  MPI_Win_sync( __mp_shm.win );
+  MPI_Barrier( __mp_shm.node );
+
+  mp->sslot = __mp_shm.slot[n];
+# if defined(VPIC_USE_PERSISTENT_MP)
+  if( mp_psize( MP_SHM_SLOT_SIZE )!=MP_SHM_SLOT_SIZE )
+    ERROR(( "MP_SHM_SLOT_SIZE must have at most 5 significant bits with "
+            "persistent communication" ));
+# endif
+  for( port=0; port<mp->n_port; port++ ) {
+    if( mp->sbuf_sz[port]>MP_SHM_SLOT_SIZE ) continue;
+    seg = mp->sslot + (size_t)port*MP_SHM_SLOT_SIZE;
+    if( mp->sbuf[port] ) {
+      COPY( seg, mp->sbuf[port], mp->sbuf_sz[port] );
+      FREE_ALIGNED( mp->sbuf[port] );
+    }
+    mp->sbuf[port]    = seg;
+    mp->sbuf_sz[port] = MP_SHM_SLOT_SIZE;
+  }
+}
+
+static void
+delete_mp_shm( void ) {
+  if( __mp_shm.win==MPI_WIN_NULL ) return;
+  MPI_Win_unlock_all( __mp_shm.win );
+  MPI_Win_free( &__mp_shm.win );
+  MPI_Comm_free( &__mp_shm.node );
+  FREE( __mp_shm.slot ); FREE( __mp_shm.ctl ); FREE( __mp_shm.node_rank );
+  __mp_shm.n_port = 0;
+}
+
+/* Is the send buffer of port a shared memory slot? */
+
+static inline int
+in_mp_shm_slot( const mp_t * mp,
+                int port ) {
+  return mp->sslot &&
+         mp->sbuf[port]==mp->sslot + (size_t)port*MP_SHM_SLOT_SIZE;
+}
+
+/* Wait a bit for another rank on the node, letting MPI progress
+   meanwhile */
+
+static void
+mp_shm_poll( void ) {
+  int flag;
+  MPI_Iprobe( MPI_ANY_SOURCE, MPI_ANY_TAG, world->comm, &flag,
+              MPI_STATUS_IGNORE );
+  sched_yield();
+}
+
+/* Post the message (port,sz,dst,tag) in the slot of the port if it
+   should go through shared memory.  Returns 0 if it should go through
+   MPI. */
+
+static int
+begin_mp_shm_send( mp_t * mp,
+                   int port,
+                   int sz,
+                   int dst,
+                   int tag ) {
+  mp_shm_ctl_t * c;
+  char * s;
+  if( !mp->sslot || sz>MP_SHM_SLOT_SIZE || __mp_shm.node_rank[dst]<0 )
+    return 0;
+  c = __mp_shm.ctl[ __mp_shm.node_rank[world_rank] ] + port;
+  s = mp->sslot + (size_t)port*MP_SHM_SLOT_SIZE;
+  if( mp->sbuf[port]!=s ) COPY( s, mp->sbuf[port], sz ); // Buffer outgrew the slot
+  c->dst = dst, c->tag = tag, c->sz = sz, c->seq = __mp_shm.n_posted++;
+  MPI_Win_sync( __mp_shm.win );
+  __atomic_store_n( &c->posted, c->posted+1, __ATOMIC_RELEASE );
+  mp->sshm[port] = 1;
+  return 1;
+}
+
+/* rshm[port] is 1 while a shared memory receive on port waits for its
+   message and 2 once the message has been copied. */
+
+static int
+begin_mp_shm_recv( mp_t * mp,
+                   int port,
+                   int sz,
+                   int src,
+                   int tag ) {
+  if( !mp->sslot || sz>MP_SHM_SLOT_SIZE || __mp_shm.node_rank[src]<0 )
+    return 0;
+  mp->rshm[port] = 1, mp->rsrc[port] = src, mp->rtag[port] = tag;
+  return 1;
+}
+
+/* Copy the message of the receive on port out of the sender's slot and
+   release the slot if the sender has posted it.  Of the messages posted
+   to this rank with the tag of the receive, the earliest posted one is
+   taken.  Returns 1 if the receive is complete. */
+
+static int
+test_mp_shm_recv( mp_t * mp,
+                  int port ) {
+  const int n = __mp_shm.node_rank[ mp->rsrc[port] ], tag = mp->rtag[port];
+  mp_shm_ctl_t * c = __mp_shm.ctl[n];
+  int p, q, posted;
+  if( mp->rshm[port]!=1 ) return 1;
+  for( p=0, q=-1; p<__mp_shm.n_port; p++ ) {
+    posted = __atomic_load_n( &c[p].posted, __ATOMIC_ACQUIRE );
+    if( posted==__atomic_load_n( &c[p].done, __ATOMIC_RELAXED ) ) continue;
+    MPI_Win_sync( __mp_shm.win );
+    if( c[p].dst==world_rank && c[p].tag==tag &&
+        ( q<0 || (int)( (unsigned)c[p].seq - (unsigned)c[q].seq )<0 ) )
+      q = p;
+  }
+  if( q<0 ) return 0;
+  if( c[q].sz!=mp->rreq_sz[port] ) ERROR(( "Sizes do not match" ));
+  COPY( mp->rbuf[port], __mp_shm.slot[n] + (size_t)q*MP_SHM_SLOT_SIZE,
+        mp->rreq_sz[port] );
+  MPI_Win_sync( __mp_shm.win );
+  __atomic_store_n( &c[q].done, c[q].posted, __ATOMIC_RELEASE );
+  mp->rshm[port] = 2;
+  return 1;
+}
+
+/* Like MPI, complete the receives that can be while waiting (a sender
+   may wait for its message to be received before it waits for its own
+   receives) */
+
+static void
+progress_mp_shm( mp_t * mp ) {
+  for( int port=0; port<mp->n_port; port++ )
+    if( mp->rshm[port]==1 ) test_mp_shm_recv( mp, port );
+  mp_shm_poll();
+}
+
+static void
+end_mp_shm_recv( mp_t * mp,
+                 int port ) {
+  while( !test_mp_shm_recv( mp, port ) ) progress_mp_shm( mp );
+  mp->rshm[port] = 0;
+}
+
+/* Wait for the receiver to copy the message out of the slot of port */
+
+static void
+end_mp_shm_send( mp_t * mp,
+                 int port ) {
+  mp_shm_ctl_t * c = __mp_shm.ctl[ __mp_shm.node_rank[world_rank] ] + port;
+  while( __atomic_load_n( &c->done, __ATOMIC_ACQUIRE )!=c->posted )
+    progress_mp_shm( mp );
+  MPI_Win_sync( __mp_shm.win ); // Before the slot is written again
+  mp->sshm[port] = 0;
+}
+
+#endif
+
 /* mp checkpointer */
 
 void
@@ -86,6 +516,12 @@ restore_mp( void ) {
     RESTORE_ALIGNED( mp->rbuf[port] );
     RESTORE_ALIGNED( mp->sbuf[port] );
   }
+# if defined(VPIC_USE_PERSISTENT_MP)
+  new_mp_pports( mp );
+# endif
+# if defined(VPIC_USE_SHARED_MP)
+  new_mp_shm( mp );
+# endif
   return mp;
 }
 
@@ -113,6 +549,9 @@ struct DMPPolicy {
   
   inline void
   halt_mp( void ) {
+#   if defined(VPIC_USE_SHARED_MP)
+    delete_mp_shm();
+#   endif
     UNREGISTER_OBJECT( &__world );
     TRAP( MPI_Comm_free( &__world.comm ) );
     __world.parent = NULL, __world.color = 0, __world.key = 0;
@@ -206,6 +645,12 @@ struct DMPPolicy {
     CLEAR(  mp->rbuf_sz, n_port ); CLEAR(  mp->sbuf_sz, n_port ); 
     CLEAR(  mp->rreq_sz, n_port ); CLEAR(  mp->sreq_sz, n_port ); 
     CLEAR(  mp->rreq,    n_port ); CLEAR(  mp->sreq,    n_port ); 
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    new_mp_pports( mp );
+#   endif
+#   if defined(VPIC_USE_SHARED_MP)
+    new_mp_shm( mp );
+#   endif
     REGISTER_OBJECT( mp, checkpt_mp, restore_mp, NULL );
     return mp;
   }
@@ -215,6 +660,16 @@ struct DMPPolicy {
     int port;
     if( !mp ) return;
     UNREGISTER_OBJECT( mp );
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    delete_mp_pports( mp );
+#   endif
+#   if defined(VPIC_USE_SHARED_MP)
+    // The window is freed by halt_mp
+    for( port=0; port<mp->n_port; port++ )
+      if( in_mp_shm_slot( mp, port ) ) mp->sbuf[port] = NULL;
+    FREE( mp->rtag ); FREE( mp->rsrc );
+    FREE( mp->sshm ); FREE( mp->rshm );
+#   endif
     for( port=0; port<mp->n_port; port++ ) {
       FREE_ALIGNED( mp->rbuf[port] ); FREE_ALIGNED( mp->sbuf[port] ); 
     }
@@ -252,6 +707,9 @@ struct DMPPolicy {
 
     // Try to reduce the number of reallocs
     sz = (int)( sz*(double)RESIZE_FACTOR );
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    sz = mp_psize( sz );
+#   endif
 
     // If no buffer allocated for this port, malloc it and return
     if( !mp->rbuf[port] ) {
@@ -262,6 +720,9 @@ struct DMPPolicy {
 
     // Resize the existing buffer (preserving any data in it)
     // (FIXME: THIS IS PROBABLY SILLY!)
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    free_mp_pport( mp->rpport + port );
+#   endif
     MALLOC_ALIGNED( buf, sz, 128 );
     COPY( buf, mp->rbuf[port], mp->rbuf_sz[port] );
     FREE_ALIGNED( mp->rbuf[port] );
@@ -283,6 +744,9 @@ struct DMPPolicy {
 
     // Try to reduce the number of reallocs
     sz = (int)( sz*(double)RESIZE_FACTOR );
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    sz = mp_psize( sz );
+#   endif
   
     // If no buffer allocated for this port, malloc it and return
     if( !mp->sbuf[port] ) {
@@ -293,8 +757,14 @@ struct DMPPolicy {
   
     // Resize the existing buffer (preserving any data in it)
     // (FIXME: THIS IS PROBABLY SILLY!)
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    free_mp_pport( mp->spport + port );
+#   endif
     MALLOC_ALIGNED( buf, sz, 128 );
     COPY( buf, mp->sbuf[port], mp->sbuf_sz[port] );
+#   if defined(VPIC_USE_SHARED_MP)
+    if( !in_mp_shm_slot( mp, port ) ) // Slots stay in the window
+#   endif
     FREE_ALIGNED( mp->sbuf[port] );
     mp->sbuf[port]    = buf;
     mp->sbuf_sz[port] = sz;
@@ -309,6 +779,15 @@ struct DMPPolicy {
     if( !mp || port<0 || port>=mp->n_port || sz<1 || sz>mp->rbuf_sz[port] ||
         src<0 || src>=world_size ) ERROR(( "Bad args" ));
     mp->rreq_sz[port] = sz;
+#   if defined(VPIC_USE_SHARED_MP)
+    if( begin_mp_shm_recv( mp, port, sz, src, tag ) ) return;
+#   endif
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    sz = mp_psize( sz );
+    if( sz>mp->rbuf_sz[port] ) ERROR(( "Buffer not sized with mp_size_recv_buffer" ));
+    if( start_mp_pport( mp->rpport + port, mp->rbuf[port], sz,
+                        src, tag, 0 ) ) return;
+#   endif
     TRAP(MPI_Irecv(mp->rbuf[port], sz, MPI_BYTE, src, tag, world->comm, &mp->rreq[port]));
   }
   
@@ -321,6 +800,15 @@ struct DMPPolicy {
     if( !mp || port<0 || port>=mp->n_port || dst<0 || dst>=world_size ||
         sz<1 || mp->sbuf_sz[port]<sz ) ERROR(( "Bad args" ));
     mp->sreq_sz[port] = sz;
+#   if defined(VPIC_USE_SHARED_MP)
+    if( begin_mp_shm_send( mp, port, sz, dst, tag ) ) return;
+#   endif
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    sz = mp_psize( sz );
+    if( sz>mp->sbuf_sz[port] ) ERROR(( "Buffer not sized with mp_size_send_buffer" ));
+    if( start_mp_pport( mp->spport + port, mp->sbuf[port], sz,
+                        dst, tag, 1 ) ) return;
+#   endif
     TRAP(MPI_Issend(mp->sbuf[port],sz, MPI_BYTE, dst, tag, world->comm, &mp->sreq[port]));
   }
   
@@ -330,16 +818,35 @@ struct DMPPolicy {
     MPI_Status status;
     int sz;
     if( !mp || port<0 || port>=mp->n_port ) ERROR(( "Bad args" ));
+#   if defined(VPIC_USE_SHARED_MP)
+    if( mp->rshm[port] ) { end_mp_shm_recv( mp, port ); return; }
+#   endif
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    TRAP( MPI_Wait( end_mp_pport( mp->rpport + port, &mp->rreq[port] ), &status ) );
+#   else
     TRAP( MPI_Wait( &mp->rreq[port], &status ) );
+#   endif
     TRAP( MPI_Get_count( &status, MPI_BYTE, &sz ) );
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    if( mp_psize( mp->rreq_sz[port] )!=sz ) ERROR(( "Sizes do not match" ));
+#   else
     if( mp->rreq_sz[port]!=sz ) ERROR(( "Sizes do not match" ));
+#   endif
   }
   
   inline void
   mp_end_send( mp_t * mp,
                int port ) {
     if( !mp || port<0 || port>=mp->n_port ) ERROR(( "Bad args" ));
+#   if defined(VPIC_USE_SHARED_MP)
+    if( mp->sshm[port] ) { end_mp_shm_send( mp, port ); return; }
+#   endif
+#   if defined(VPIC_USE_PERSISTENT_MP)
+    TRAP( MPI_Wait( end_mp_pport( mp->spport + port, &mp->sreq[port] ),
+                    MPI_STATUS_IGNORE ) );
+#   else
     TRAP( MPI_Wait( &mp->sreq[port], MPI_STATUS_IGNORE ) );
+#   endif
   }
   
 # undef RESIZE_FACTOR
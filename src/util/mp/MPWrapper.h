@@ -16,6 +16,9 @@ private:
 #ifdef USE_MPRELAY
 #include "RelayPolicy.h"
 typedef MPWrapper_T<RelayPolicy> MPWrapper;
+#elif defined(VPIC_USE_THREAD_MP)
+#include "ThreadPolicy.h"
+typedef MPWrapper_T<ThreadPolicy> MPWrapper;
 #else
 #include "DMPPolicy.h"
 typedef MPWrapper_T<DMPPolicy> MPWrapper;
@@ -0,0 +1,628 @@
+#ifndef ThreadPolicy_h
+#define ThreadPolicy_h
+
+#include <pthread.h>
+#include <sched.h>
+#include <cstdlib>
+
+#include "../checkpt/checkpt.h"
+
+/* Define this comm and mp opaque handles */
+/* FIXME: PARENT, COLOR AND KEY ARE FOR FUTURE EXPANSION */
+
+struct collective {
+  collective_t * parent;
+  int color;
+  int key;
+};
+
+/* The ranks are threads of this process (see mp_run_ranks) and messages
+   are passed through memory.  Each (tag,src,dst) has a channel, a single
+   producer single consumer ring of MP_THREAD_N_SLOT slots.  A message is
+   copied into the next slot of its channel when it is sent (so a send
+   completes without the receiver) and out of it when it is received.
+
+   The messages on a channel are numbered in the order they are sent and
+   the receives in the order they are posted.  Receive n gets message n
+   (like with MPI, messages with the same source, destination and tag do
+   not overtake each other).  The slot of message n is full once its seq
+   is n+1 and free once its seq is 0.  If the slot of a message is still
+   full when it is sent, the message is appended to the overflow list of the
+   channel instead, so a send never waits for the receiver (as an MPI_Isend
+   would not; otherwise two ranks that both send more than MP_THREAD_N_SLOT
+   messages with one tag before receiving would deadlock).  Channels are
+   made the first time either end uses them.
+
+   Tags 0:26 are used by the ports of the grid and boundary_p.
+   mp_send_i and mp_recv_i use a tag of their own. */
+
+#define MP_THREAD_N_TAG   28
+#define MP_THREAD_TAG_I   (MP_THREAD_N_TAG-1)
+#define MP_THREAD_N_SLOT  8
+
+typedef struct mp_thread_slot {
+  volatile long seq;              /* Message number+1 if full, 0 if free */
+  int sz;                         /* Message size */
+  int buf_sz;                     /* Slot buffer size */
+  char * ALIGNED(128) buf;        /* Slot buffer (owned by the sender while
+                                     the slot is free) */
+} mp_thread_slot_t;
+
+typedef struct mp_thread_node {
+  struct mp_thread_node * next;   /* Next message (written by the sender) */
+  long n;                         /* Message number */
+  int sz;                         /* Message size */
+  int taken;                      /* Received? (receiver only) */
+  char * buf;                     /* Message */
+} mp_thread_node_t;
+
+typedef struct mp_thread_channel {
+  long n_send;                    /* Messages sent (sender only) */
+  long n_recv;                    /* Receives posted (receiver only) */
+  mp_thread_slot_t slot[ MP_THREAD_N_SLOT ];
+  mp_thread_node_t * head;        /* Overflow list, starting at a dummy
+                                     node (receiver only) */
+  mp_thread_node_t * tail;        /* Last node of it (sender only) */
+} mp_thread_channel_t;
+
+struct mp {
+  int n_port;
+  char * ALIGNED(128) * rbuf; char * ALIGNED(128) * sbuf;
+  int * rbuf_sz;              int * sbuf_sz;
+  int * rreq_sz;              int * sreq_sz;
+  mp_thread_channel_t ** rreq; long * rreq_n; /* Channel and message number
+                                                 of the posted receives */
+};
+
+/* Create the world collective */
+
+static collective_t __world = { NULL, 0, 0 };
+collective_t * _world = &__world;
+VPIC_THREAD_LOCAL int _world_rank = 0;
+int _world_size = 1;
+
+/* State shared by the ranks */
+
+static pthread_barrier_t mp_thread_barrier;
+static const void ** mp_thread_operand = NULL;   /* Collective operand of
+                                                    each rank */
+static mp_thread_channel_t ** mp_thread_channel = NULL;
+static int mp_thread_booted_alone = 0;          /* Set up by boot_mp? */
+
+static void
+new_mp_thread_world( int n_rank ) {
+  _world_size = n_rank;
+  _world_rank = 0;
+  if( pthread_barrier_init( &mp_thread_barrier, NULL, n_rank ) )
+    ERROR(( "pthread_barrier_init failed" ));
+  MALLOC( mp_thread_operand, n_rank );
+  CLEAR( mp_thread_operand, n_rank );
+  MALLOC( mp_thread_channel, (size_t)MP_THREAD_N_TAG*n_rank*n_rank );
+  CLEAR( mp_thread_channel, (size_t)MP_THREAD_N_TAG*n_rank*n_rank );
+}
+
+static void
+delete_mp_thread_world( void ) {
+  size_t n = (size_t)MP_THREAD_N_TAG*world_size*world_size, c;
+  mp_thread_node_t * node;
+  int n_slot;
+  for( c=0; c<n; c++ ) {
+    if( !mp_thread_channel[c] ) continue;
+    for( n_slot=0; n_slot<MP_THREAD_N_SLOT; n_slot++ )
+      FREE_ALIGNED( mp_thread_channel[c]->slot[n_slot].buf );
+    while( ( node = mp_thread_channel[c]->head ) ) {
+      mp_thread_channel[c]->head = node->next;
+      FREE( node->buf );
+      FREE( node );
+    }
+    FREE_ALIGNED( mp_thread_channel[c] );
+  }
+  FREE( mp_thread_channel );
+  FREE( mp_thread_operand );
+  pthread_barrier_destroy( &mp_thread_barrier );
+  _world_size = 1;
+  _world_rank = 0;
+}
+
+static mp_thread_channel_t *
+mp_thread_get_channel( int tag,
+                       int src,
+                       int dst ) {
+  mp_thread_channel_t ** pc, * c, * made;
+  pc = mp_thread_channel + ((size_t)tag*world_size + src)*world_size + dst;
+  c  = __atomic_load_n( pc, __ATOMIC_ACQUIRE );
+  if( c ) return c;
+  MALLOC_ALIGNED( made, 1, 128 );
+  CLEAR( made, 1 );
+  MALLOC( made->head, 1 );
+  CLEAR( made->head, 1 );
+  made->tail = made->head;
+  if( __atomic_compare_exchange_n( pc, &c, made, 0,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+    return made;
+  FREE( made->head );
+  FREE_ALIGNED( made ); // The other end made it first
+  return c;
+}
+
+static void
+mp_thread_put( mp_thread_channel_t * c,
+               const void * buf,
+               int sz ) {
+  long n = c->n_send++;
+  mp_thread_slot_t * s = c->slot + n%MP_THREAD_N_SLOT;
+  mp_thread_node_t * node;
+  if( __atomic_load_n( &s->seq, __ATOMIC_ACQUIRE ) ) { // Unlikely
+    MALLOC( node, 1 );
+    MALLOC( node->buf, sz );
+    COPY( node->buf, (const char *)buf, sz );
+    node->next  = NULL;
+    node->n     = n;
+    node->sz    = sz;
+    node->taken = 0;
+    __atomic_store_n( &c->tail->next, node, __ATOMIC_RELEASE );
+    c->tail = node;
+    return;
+  }
+  if( s->buf_sz<sz ) {
+    FREE_ALIGNED( s->buf );
+    MALLOC_ALIGNED( s->buf, sz, 128 );
+    s->buf_sz = sz;
+  }
+  COPY( s->buf, (const char *)buf, sz );
+  s->sz = sz;
+  __atomic_store_n( &s->seq, n+1, __ATOMIC_RELEASE );
+}
+
+static void
+mp_thread_get( mp_thread_channel_t * c,
+               long n,
+               void * buf,
+               int sz ) {
+  mp_thread_slot_t * s = c->slot + n%MP_THREAD_N_SLOT;
+  mp_thread_node_t * node;
+  for(;;) {
+    if( __atomic_load_n( &s->seq, __ATOMIC_ACQUIRE )==n+1 ) {
+      if( s->sz!=sz ) ERROR(( "Sizes do not match" ));
+      COPY( (char *)buf, s->buf, sz );
+      __atomic_store_n( &s->seq, 0, __ATOMIC_RELEASE );
+      return;
+    }
+    for( node = __atomic_load_n( &c->head->next, __ATOMIC_ACQUIRE ); node;
+         node = __atomic_load_n( &node->next, __ATOMIC_ACQUIRE ) )
+      if( node->n==n ) break;
+    if( node ) break;
+    sched_yield();
+  }
+
+  // Take the message out of the overflow list.  The nodes at the start of
+  // the list that have been received are freed, except the last one (which
+  // becomes the dummy node) as the sender may still append to it.
+
+  if( node->sz!=sz ) ERROR(( "Sizes do not match" ));
+  COPY( (char *)buf, node->buf, sz );
+  node->taken = 1;
+  while( ( node = __atomic_load_n( &c->head->next, __ATOMIC_ACQUIRE ) ) &&
+         node->taken ) {
+    FREE( c->head->buf );
+    FREE( c->head );
+    c->head = node;
+  }
+}
+
+/* Collectives publish the operand of each rank and then read the operands
+   of all ranks between two barriers.  Sums are done in rank order, so all
+   ranks get the same (and reproducible) result. */
+
+template<typename T> static void
+mp_thread_allsum( const T * local,
+                  T * global,
+                  int n ) {
+  int i, r;
+  mp_thread_operand[world_rank] = local;
+  pthread_barrier_wait( &mp_thread_barrier );
+  for( i=0; i<n; i++ ) {
+    T sum = 0;
+    for( r=0; r<world_size; r++ ) sum += ((const T *)mp_thread_operand[r])[i];
+    global[i] = sum;
+  }
+  pthread_barrier_wait( &mp_thread_barrier );
+}
+
+template<typename T> static void
+mp_thread_gather( const T * sbuf,
+                  T * rbuf,
+                  int n,
+                  int root ) { // root<0: all ranks get the result
+  int r;
+  mp_thread_operand[world_rank] = sbuf;
+  pthread_barrier_wait( &mp_thread_barrier );
+  if( root<0 || root==world_rank )
+    for( r=0; r<world_size; r++ )
+      COPY( rbuf + (size_t)r*n, (const T *)mp_thread_operand[r], n );
+  pthread_barrier_wait( &mp_thread_barrier );
+}
+
+/* Rank threads */
+
+typedef struct mp_thread_rank {
+  pthread_t handle;
+  int rank;
+  int argc;
+  char ** argv;
+  int (*rank_main)( int argc, char ** argv );
+  int ret;
+} mp_thread_rank_t;
+
+static void *
+mp_thread_run_rank( void * _r ) {
+  mp_thread_rank_t * r = (mp_thread_rank_t *)_r;
+  _world_rank = r->rank;
+  r->ret = r->rank_main( r->argc, r->argv );
+  return NULL;
+}
+
+/* collective checkpointer */
+/* FIXME: SINCE RIGHT NOW, THERE IS ONLY THE WORLD COLLECTIVE AND NO WAY
+   TO CREATE CHILDREN COLLECTIVES, THIS IS BASICALLY A PLACEHOLDER. */
+
+void
+checkpt_collective( const collective_t * comm ) {
+  CHECKPT_VAL( int, world_rank );
+  CHECKPT_VAL( int, world_size );
+}
+
+collective_t *
+restore_collective( void ) {
+  int rank, size;
+  RESTORE_VAL( int, rank );
+  RESTORE_VAL( int, size );
+  if( size!=world_size )
+    ERROR(( "The number of ranks that made this checkpt (%i) is different "
+            "from the number of ranks currently (%i)", size, world_size ));
+  if( rank!=world_rank )
+    ERROR(( "This rank (%i) is reading a checkpoint previously written by "
+            "a different rank (%i).", rank, world_rank ));
+  return world;
+}
+
+/* mp checkpointer */
+/* Posted receives do not survive a restart, so they are not
+   checkpointed. */
+
+void
+checkpt_mp( mp_t * mp ) {
+  int port;
+  CHECKPT( mp, 1 );
+  CHECKPT( mp->rbuf,    mp->n_port ); CHECKPT( mp->sbuf,    mp->n_port );
+  CHECKPT( mp->rbuf_sz, mp->n_port ); CHECKPT( mp->sbuf_sz, mp->n_port );
+  CHECKPT( mp->rreq_sz, mp->n_port ); CHECKPT( mp->sreq_sz, mp->n_port );
+  for( port=0; port<mp->n_port; port++ ) {
+    CHECKPT_ALIGNED( mp->rbuf[port], mp->rbuf_sz[port], 128 );
+    CHECKPT_ALIGNED( mp->sbuf[port], mp->sbuf_sz[port], 128 );
+  }
+}
+
+mp_t *
+restore_mp( void ) {
+  mp_t * mp;
+  int port;
+  RESTORE( mp );
+  RESTORE( mp->rbuf    ); RESTORE( mp->sbuf    );
+  RESTORE( mp->rbuf_sz ); RESTORE( mp->sbuf_sz );
+  RESTORE( mp->rreq_sz ); RESTORE( mp->sreq_sz );
+  for( port=0; port<mp->n_port; port++ ) {
+    RESTORE_ALIGNED( mp->rbuf[port] );
+    RESTORE_ALIGNED( mp->sbuf[port] );
+  }
+  MALLOC( mp->rreq, mp->n_port ); MALLOC( mp->rreq_n, mp->n_port );
+  CLEAR(  mp->rreq, mp->n_port ); CLEAR(  mp->rreq_n, mp->n_port );
+  return mp;
+}
+
+struct ThreadPolicy {
+
+  // FIXME-KJB: The whole sizing process in here is kinda silly and should
+  // be removed in the long haul.
+
+# define RESIZE_FACTOR 1.3125
+
+  inline int
+  mp_run_ranks( int argc,
+                char ** argv,
+                int (*rank_main)( int argc, char ** argv ) ) {
+    mp_thread_rank_t * r;
+    int n_rank, rank, ret;
+
+    n_rank = strip_cmdline_int( &argc, &argv, "--ranks", 1 );
+    if( n_rank<1 ) ERROR(( "Bad number of ranks (%i)", n_rank ));
+
+    new_mp_thread_world( n_rank );
+
+    // Each rank strips its own copy of the command line
+
+    MALLOC( r, n_rank );
+    for( rank=0; rank<n_rank; rank++ ) {
+      r[rank].rank      = rank;
+      r[rank].argc      = argc;
+      r[rank].rank_main = rank_main;
+      r[rank].ret       = 0;
+      MALLOC( r[rank].argv, argc+1 );
+      COPY( r[rank].argv, argv, argc+1 );
+    }
+
+    // Rank 0 runs on the calling thread
+
+    for( rank=1; rank<n_rank; rank++ )
+      if( pthread_create( &r[rank].handle, NULL, mp_thread_run_rank, r+rank ) )
+        ERROR(( "pthread_create failed" ));
+    mp_thread_run_rank( r );
+
+    ret = r[0].ret;
+    for( rank=1; rank<n_rank; rank++ ) {
+      if( pthread_join( r[rank].handle, NULL ) )
+        ERROR(( "pthread_join failed" ));
+      if( ret<r[rank].ret ) ret = r[rank].ret;
+    }
+
+    for( rank=0; rank<n_rank; rank++ ) FREE( r[rank].argv );
+    FREE( r );
+    delete_mp_thread_world();
+    return ret;
+  }
+
+  inline void
+  boot_mp( int * pargc,
+           char *** pargv ) {
+    // A program that does not start its ranks with mp_run_ranks is
+    // a single rank
+    if( !mp_thread_channel ) {
+      new_mp_thread_world( 1 );
+      mp_thread_booted_alone = 1;
+    }
+    __world.parent = NULL, __world.color = 0, __world.key = 0;
+    REGISTER_OBJECT( &__world, checkpt_collective, restore_collective, NULL );
+  }
+
+  inline void
+  halt_mp( void ) {
+    UNREGISTER_OBJECT( &__world );
+    if( mp_thread_booted_alone ) {
+      delete_mp_thread_world();
+      mp_thread_booted_alone = 0;
+    }
+  }
+
+  inline void
+  mp_abort( int reason ) {
+    exit( reason );
+  }
+
+  inline void
+  mp_barrier( void ) {
+    pthread_barrier_wait( &mp_thread_barrier );
+  }
+
+  inline void
+  mp_allsum_d( double * local,
+               double * global,
+               int n ) {
+    if( !local || !global || n<1 || std::abs(local-global)<n ) {
+      ERROR(( "Bad args" ));
+    } // if
+    mp_thread_allsum( local, global, n );
+  }
+
+  inline void
+  mp_allsum_i( int * local,
+               int * global,
+               int n ) {
+    if( !local || !global || n<1 || std::abs(local-global)<n ) {
+      ERROR(( "Bad args" ));
+    } // if
+    mp_thread_allsum( local, global, n );
+  }
+
+  inline void
+  mp_allgather_i( int * sbuf,
+                  int * rbuf,
+                  int n ) {
+    if( !sbuf || !rbuf || n<1 ) ERROR(( "Bad args" ));
+    mp_thread_gather( sbuf, rbuf, n, -1 );
+  }
+
+  inline void
+  mp_allgather_i64( int64_t * sbuf,
+                    int64_t * rbuf,
+                    int n ) {
+    if( !sbuf || !rbuf || n<1 ) ERROR(( "Bad args" ));
+    mp_thread_gather( sbuf, rbuf, n, -1 );
+  }
+
+  inline void
+  mp_gather_uc( unsigned char * sbuf,
+                unsigned char * rbuf,
+                int n ) {
+    if( !sbuf || (!rbuf && world_rank==0) || n<1 ) ERROR(( "Bad args" ));
+    mp_thread_gather( sbuf, rbuf, n, 0 );
+  }
+
+  inline void
+  mp_send_i( int * buf,
+             int n,
+             int dst ) {
+    if( !buf || n<1 || dst<0 || dst>=world_size ) ERROR(( "Bad args" ));
+    mp_thread_put( mp_thread_get_channel( MP_THREAD_TAG_I, world_rank, dst ),
+                   buf, n*sizeof(int) );
+  }
+
+  inline void
+  mp_recv_i( int * buf,
+             int n,
+             int src ) {
+    mp_thread_channel_t * c;
+    if( !buf || n<1 || src<0 || src>=world_size ) ERROR(( "Bad args" ));
+    c = mp_thread_get_channel( MP_THREAD_TAG_I, src, world_rank );
+    mp_thread_get( c, c->n_recv++, buf, n*sizeof(int) );
+  }
+
+  inline mp_t *
+  new_mp( int n_port ) {
+    mp_t * mp;
+    if( n_port<1 ) ERROR(( "Bad args" ));
+    MALLOC( mp, 1 );
+    mp->n_port = n_port;
+    MALLOC( mp->rbuf,    n_port ); MALLOC( mp->sbuf,    n_port );
+    MALLOC( mp->rbuf_sz, n_port ); MALLOC( mp->sbuf_sz, n_port );
+    MALLOC( mp->rreq_sz, n_port ); MALLOC( mp->sreq_sz, n_port );
+    MALLOC( mp->rreq,    n_port ); MALLOC( mp->rreq_n,  n_port );
+    CLEAR(  mp->rbuf,    n_port ); CLEAR(  mp->sbuf,    n_port );
+    CLEAR(  mp->rbuf_sz, n_port ); CLEAR(  mp->sbuf_sz, n_port );
+    CLEAR(  mp->rreq_sz, n_port ); CLEAR(  mp->sreq_sz, n_port );
+    CLEAR(  mp->rreq,    n_port ); CLEAR(  mp->rreq_n,  n_port );
+    REGISTER_OBJECT( mp, checkpt_mp, restore_mp, NULL );
+    return mp;
+  }
+
+  inline void
+  delete_mp( mp_t * mp ) {
+    int port;
+    if( !mp ) return;
+    UNREGISTER_OBJECT( mp );
+    for( port=0; port<mp->n_port; port++ ) {
+      FREE_ALIGNED( mp->rbuf[port] ); FREE_ALIGNED( mp->sbuf[port] );
+    }
+    FREE( mp->rreq_n  ); FREE( mp->rreq    );
+    FREE( mp->rreq_sz ); FREE( mp->sreq_sz );
+    FREE( mp->rbuf_sz ); FREE( mp->sbuf_sz );
+    FREE( mp->rbuf    ); FREE( mp->sbuf    );
+    FREE( mp );
+  }
+
+  inline void * ALIGNED(128)
+  mp_recv_buffer( mp_t * mp,
+                  int port ) {
+    if( !mp || port<0 || port>=mp->n_port ) ERROR(( "Bad args" ));
+    return mp->rbuf[port];
+  }
+
+  inline void * ALIGNED(128)
+  mp_send_buffer( mp_t * mp,
+                  int port ) {
+    if( !mp || port<0 || port>=mp->n_port ) ERROR(( "Bad args" ));
+    return mp->sbuf[port];
+  }
+
+  inline void
+  mp_size_recv_buffer( mp_t * mp,
+                       int port,
+                       int sz ) {
+    char * ALIGNED(128) buf;
+
+    if( !mp || port<0 || port>mp->n_port || sz<1 ) ERROR(( "Bad args" ));
+
+    // If there already a large enough buffer, we are done
+    if( mp->rbuf_sz[port]>=sz ) return;
+
+    // Try to reduce the number of reallocs
+    sz = (int)( sz*(double)RESIZE_FACTOR );
+
+    // If no buffer allocated for this port, malloc it and return
+    if( !mp->rbuf[port] ) {
+      MALLOC_ALIGNED( mp->rbuf[port], sz, 128 );
+      mp->rbuf_sz[port] = sz;
+      return;
+    }
+
+    // Resize the existing buffer (preserving any data in it)
+    // (FIXME: THIS IS PROBABLY SILLY!)
+    MALLOC_ALIGNED( buf, sz, 128 );
+    COPY( buf, mp->rbuf[port], mp->rbuf_sz[port] );
+    FREE_ALIGNED( mp->rbuf[port] );
+    mp->rbuf[port]    = buf;
+    mp->rbuf_sz[port] = sz;
+  }
+
+  inline void
+  mp_size_send_buffer( mp_t * mp,
+                       int port,
+                       int sz ) {
+    char * ALIGNED(128) buf;
+
+    // Check input arguments
+    if( !mp || port<0 || port>mp->n_port || sz<1 ) ERROR(( "Bad args" ));
+
+    // Is there already a large enough buffer
+    if( mp->sbuf_sz[port]>=sz ) return;
+
+    // Try to reduce the number of reallocs
+    sz = (int)( sz*(double)RESIZE_FACTOR );
+
+    // If no buffer allocated for this port, malloc it and return
+    if( !mp->sbuf[port] ) {
+      MALLOC_ALIGNED( mp->sbuf[port], sz, 128 );
+      mp->sbuf_sz[port] = sz;
+      return;
+    }
+
+    // Resize the existing buffer (preserving any data in it)
+    // (FIXME: THIS IS PROBABLY SILLY!)
+    MALLOC_ALIGNED( buf, sz, 128 );
+    COPY( buf, mp->sbuf[port], mp->sbuf_sz[port] );
+    FREE_ALIGNED( mp->sbuf[port] );
+    mp->sbuf[port]    = buf;
+    mp->sbuf_sz[port] = sz;
+  }
+
+  inline void
+  mp_begin_recv( mp_t * mp,
+                 int port,
+                 int sz,
+                 int src,
+                 int tag ) {
+    mp_thread_channel_t * c;
+    if( !mp || port<0 || port>=mp->n_port || sz<1 || sz>mp->rbuf_sz[port] ||
+        src<0 || src>=world_size || tag<0 || tag>=MP_THREAD_TAG_I )
+      ERROR(( "Bad args" ));
+    c = mp_thread_get_channel( tag, src, world_rank );
+    mp->rreq_sz[port] = sz;
+    mp->rreq[port]    = c;
+    mp->rreq_n[port]  = c->n_recv++;
+  }
+
+  inline void
+  mp_begin_send( mp_t * mp,
+                 int port,
+                 int sz,
+                 int dst,
+                 int tag ) {
+    if( !mp || port<0 || port>=mp->n_port || dst<0 || dst>=world_size ||
+        sz<1 || mp->sbuf_sz[port]<sz || tag<0 || tag>=MP_THREAD_TAG_I )
+      ERROR(( "Bad args" ));
+    mp->sreq_sz[port] = sz;
+    mp_thread_put( mp_thread_get_channel( tag, world_rank, dst ),
+                   mp->sbuf[port], sz );
+  }
+
+  inline void
+  mp_end_recv( mp_t * mp,
+               int port ) {
+    if( !mp || port<0 || port>=mp->n_port || !mp->rreq[port] )
+      ERROR(( "Bad args" ));
+    mp_thread_get( mp->rreq[port], mp->rreq_n[port],
+                   mp->rbuf[port], mp->rreq_sz[port] );
+    mp->rreq[port] = NULL;
+  }
+
+  inline void
+  mp_end_send( mp_t * mp,
+               int port ) {
+    // The message was copied out of the send buffer when it was sent
+    if( !mp || port<0 || port>=mp->n_port ) ERROR(( "Bad args" ));
+  }
+
+# undef RESIZE_FACTOR
+
+}; // struct ThreadPolicy
+
+#endif // ThreadPolicy_h
@@ -17,6 +17,13 @@ void boot_mp( int * pargc, char *** pargv ) {
 
 void halt_mp( void ) { MPWrapper::instance().halt_mp(); }
 
+#if defined(VPIC_USE_THREAD_MP)
+int mp_run_ranks( int argc, char ** argv,
+                  int (*rank_main)( int argc, char ** argv ) ) {
+  return MPWrapper::instance().mp_run_ranks( argc, argv, rank_main );
+}
+#endif
+
 void mp_abort( int reason ) { MPWrapper::instance().mp_abort( reason ); }
 
 void mp_barrier( void ) { MPWrapper::instance().mp_barrier(); }
@@ -57,6 +57,20 @@ halt_mp( void );
 void
 mp_abort( int reason );
 
+#if defined(VPIC_USE_THREAD_MP)
+
+/* With the threaded backend, the ranks are threads of one process.
+   mp_run_ranks strips "--ranks N" (default 1) from the command line, runs
+   rank_main on N threads (each with its own copy of argv and world_rank
+   set) and returns the largest value rank_main returned. */
+
+int
+mp_run_ranks( int argc,
+              char ** argv,
+              int (*rank_main)( int argc, char ** argv ) );
+
+#endif
+
 /* Collective commucations */
 
 void
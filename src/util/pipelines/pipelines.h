@@ -7,11 +7,169 @@
 
 #include "../util_base.h"
 
-enum { MAX_PIPELINE = 272 };
+// The maximum number of pipelines (threads) per process.  It sizes some
+// static and stack arrays, so it can be set at build time (SET_MAX_PIPELINE).
+
+#ifndef VPIC_MAX_PIPELINE
+#define VPIC_MAX_PIPELINE 1024
+#endif
+
+enum { MAX_PIPELINE = VPIC_MAX_PIPELINE };
 
 // Is this even related to pipelines.  Maybe this should be in util_base.h.
 # define PAD_STRUCT( sz )
 
+//----------------------------------------------------------------------------//
+// When the v8 and v16 kernels are selected at runtime, simd_width is the
+// width (1, 4, 8 or 16) of the kernels EXEC_PIPELINES dispatches.  It is set
+// by boot_simd, see pipelines_simd.c.
+//----------------------------------------------------------------------------//
+
+#if defined(VPIC_USE_SIMD_DISPATCH)
+
+BEGIN_C_DECLS
+
+extern int simd_width;
+
+void
+boot_simd( int * pargc,
+           char *** pargv );
+
+const char *
+simd_name( int width );
+
+END_C_DECLS
+
+#endif
+
+//----------------------------------------------------------------------------//
+// Work stealing.  A pipeline function can process its share of N items with
+//
+//   FOR_EACH_PIPELINE_CHUNK( N, b, pipeline_rank, n_pipeline, i, n )
+//   for( ; n; n--, i++ ) { ... }
+//
+// instead of DISTRIBUTE( N, b, pipeline_rank, n_pipeline, i, n ) followed by
+// the loop.  The items are then cut into chunks of a multiple of b items.
+// Each pipeline starts on the chunks of its DISTRIBUTE share, in increasing
+// order, and then steals chunks from the end of the shares of pipelines that
+// are behind.  The dispatching process (pipeline_rank==n_pipeline) gets the
+// same remainder as with DISTRIBUTE.
+//
+// Stealing is enabled with "--steal 1" on the command line.  Otherwise, each
+// pipeline gets exactly its DISTRIBUTE share.  Only pipeline functions that
+// treat each item independently and do not size per-pipeline output by their
+// share should use this, since which pipeline processes which item then
+// changes from run to run (advance_p hands out its particle movers from a
+// shared counter when the pipelines steal).  The pool of chunks is kept by
+// the dispatcher, so the arguments of a pipeline function do not change.
+//----------------------------------------------------------------------------//
+
+typedef struct pipeline_chunks {
+  int64_t i, n;       // Current chunk (first item, number of items)
+  int64_t N, b;       // Items and block size
+  int64_t chunk;      // Items per chunk (0: one DISTRIBUTE share)
+  int64_t n_chunk;    // Chunks
+  int p, P;           // Pipeline rank and number of pipelines
+  int victim;         // Pipelines looked at so far
+} pipeline_chunks_t;
+
+typedef struct pipeline_chunk_pool pipeline_chunk_pool_t;
+
+BEGIN_C_DECLS
+
+// Strips "--steal" from the command line (called by the dispatcher boot)
+
+void
+boot_pipeline_chunks( int * pargc,
+                      char *** pargv );
+
+// Empties the pool of the calling host before a dispatch
+
+void
+reset_pipeline_chunks( int n_pipeline );
+
+// The pool of the calling host and the pool the calling pipeline thread
+// takes its chunks from (default: the pool of the calling host)
+
+pipeline_chunk_pool_t *
+host_pipeline_chunk_pool( void );
+
+void
+set_pipeline_chunk_pool( pipeline_chunk_pool_t * pool );
+
+pipeline_chunks_t
+begin_pipeline_chunks( int64_t N,
+                       int64_t b,
+                       int p,
+                       int P );
+
+int
+next_pipeline_chunk( pipeline_chunks_t * pc );
+
+// Do the pipelines of the calling host steal chunks (--steal)?
+
+int
+pipelines_steal( void );
+
+END_C_DECLS
+
+#define FOR_EACH_PIPELINE_CHUNK( N_, B_, P_, NP_, I_, C_ )             \
+  for( pipeline_chunks_t _pc = begin_pipeline_chunks( (N_), (B_), (P_), (NP_) ); \
+       next_pipeline_chunk( &_pc ) && ( (I_) = _pc.i, (C_) = _pc.n, 1 ); )
+
+//----------------------------------------------------------------------------//
+// NUMA placement.  With "--pin 1" on the command line, each pipeline thread
+// is pinned to a CPU (see pipelines_numa.c).  Memory is placed in the NUMA
+// domain of the thread that first touches it, so arrays should then be
+// first touched by the pipelines that later process them:
+//
+//   CLEAR_PIPELINES( a, N, b )
+//
+// clears a[0:N-1] like CLEAR( a, N ) but each pipeline clears the items of
+// DISTRIBUTE( N, b, pipeline_rank, n_pipeline, i, n ).  COPY_PIPELINES does
+// the same for COPY.  Use the block size of the kernels that process the
+// array.
+//----------------------------------------------------------------------------//
+
+BEGIN_C_DECLS
+
+// Strips "--pin" and "--pin_stride" from the command line (called by the
+// dispatcher boot)
+
+void
+boot_pipeline_affinity( int * pargc,
+                        char *** pargv,
+                        int n_pipeline );
+
+// Are the pipelines pinned?
+
+int
+pipelines_pinned( void );
+
+// The CPU of pipeline pipeline_rank (-1: not pinned) and pinning the
+// calling thread to a CPU (a no-op for -1)
+
+int
+pipeline_cpu( int pipeline_rank );
+
+void
+pin_thread( int cpu );
+
+void
+touch_pipelines( void * d,
+                 const void * s,
+                 int64_t N,
+                 int64_t b,
+                 size_t sz );
+
+END_C_DECLS
+
+#define CLEAR_PIPELINES( d, N, b ) \
+  touch_pipelines( (d), NULL, (N), (b), sizeof(*(d)) )
+
+#define COPY_PIPELINES( d, s, N, b ) \
+  touch_pipelines( (d), (s), (N), (b), sizeof(*(d)) )
+
 //----------------------------------------------------------------------------//
 // Make sure that pipelines_pthreads.h and pipelines_openmp.h can only be
 // included via this header file.
@@ -16,15 +16,60 @@
 
 #define WAIT_PIPELINES() _Pragma( TOSTRING( omp barrier ) )
 
+//----------------------------------------------------------------------------//
+// Macro defines to support selecting the simd vector kernels at runtime.  Runs
+// the widest pipeline no wider than simd_width that exists for name and the
+// caller does straggler cleanup with the scalar pipeline.
+//----------------------------------------------------------------------------//
+
+#if defined(VPIC_USE_SIMD_DISPATCH)
+
+# if defined(VPIC_DISPATCH_V16) && defined(HAS_V16_PIPELINE)
+#   define SIMD_PIPELINE_V16(name, a, id)                                  \
+  if( simd_width >= 16 ) name##_pipeline_v16( a, id, N_PIPELINE ); else
+# else
+#   define SIMD_PIPELINE_V16(name, a, id)
+# endif
+
+# if defined(VPIC_DISPATCH_V8) && defined(HAS_V8_PIPELINE)
+#   define SIMD_PIPELINE_V8(name, a, id)                                   \
+  if( simd_width >=  8 ) name##_pipeline_v8( a, id, N_PIPELINE ); else
+# else
+#   define SIMD_PIPELINE_V8(name, a, id)
+# endif
+
+# if defined(V4_ACCELERATION) && defined(HAS_V4_PIPELINE)
+#   define SIMD_PIPELINE_V4(name, a, id)                                   \
+  if( simd_width >=  4 ) name##_pipeline_v4( a, id, N_PIPELINE ); else
+# else
+#   define SIMD_PIPELINE_V4(name, a, id)
+# endif
+
+# define EXEC_PIPELINES(name, args, str)                                   \
+  reset_pipeline_chunks( N_PIPELINE );                                     \
+  _Pragma( TOSTRING( omp parallel num_threads(N_PIPELINE) shared(args) ) ) \
+  {                                                                        \
+    _Pragma( TOSTRING( omp for ) )                                         \
+    for( int id = 0; id < N_PIPELINE; id++ )                               \
+    {                                                                      \
+      SIMD_PIPELINE_V16( name, args+id*sizeof(*args)*str, id )             \
+      SIMD_PIPELINE_V8(  name, args+id*sizeof(*args)*str, id )             \
+      SIMD_PIPELINE_V4(  name, args+id*sizeof(*args)*str, id )             \
+      name##_pipeline_scalar( args+id*sizeof(*args)*str, id, N_PIPELINE ); \
+    }                                                                      \
+  }                                                                        \
+  name##_pipeline_scalar( args+str*N_PIPELINE, N_PIPELINE, N_PIPELINE );
+
 //----------------------------------------------------------------------------//
 // Macro defines to support v16 simd vector acceleration.  Uses thread
 // dispatcher on the v16 pipeline and the caller does straggler cleanup with
 // the scalar pipeline.
 //----------------------------------------------------------------------------//
 
-#if defined(V16_ACCELERATION) && defined(HAS_V16_PIPELINE)
+#elif defined(V16_ACCELERATION) && defined(HAS_V16_PIPELINE)
 
 # define EXEC_PIPELINES(name, args, str)                                   \
+  reset_pipeline_chunks( N_PIPELINE );                                     \
   _Pragma( TOSTRING( omp parallel num_threads(N_PIPELINE) shared(args) ) ) \
   {                                                                        \
     _Pragma( TOSTRING( omp for ) )                                         \
@@ -44,6 +89,7 @@
 #elif defined(V8_ACCELERATION) && defined(HAS_V8_PIPELINE)
 
 # define EXEC_PIPELINES(name, args, str)                                   \
+  reset_pipeline_chunks( N_PIPELINE );                                     \
   _Pragma( TOSTRING( omp parallel num_threads(N_PIPELINE) shared(args) ) ) \
   {                                                                        \
     _Pragma( TOSTRING( omp for ) )                                         \
@@ -63,6 +109,7 @@
 #elif defined(V4_ACCELERATION) && defined(HAS_V4_PIPELINE)
 
 # define EXEC_PIPELINES(name, args, str)                                   \
+  reset_pipeline_chunks( N_PIPELINE );                                     \
   _Pragma( TOSTRING( omp parallel num_threads(N_PIPELINE) shared(args) ) ) \
   {                                                                        \
     _Pragma( TOSTRING( omp for ) )                                         \
@@ -82,6 +129,7 @@
 #else
 
 # define EXEC_PIPELINES(name, args, str)                                   \
+  reset_pipeline_chunks( N_PIPELINE );                                     \
   _Pragma( TOSTRING( omp parallel num_threads(N_PIPELINE) shared(args) ) ) \
   {                                                                        \
     _Pragma( TOSTRING( omp for ) )                                         \
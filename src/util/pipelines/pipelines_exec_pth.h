@@ -12,13 +12,51 @@
 
 # define WAIT_PIPELINES() thread.wait()
 
+//----------------------------------------------------------------------------//
+// Macro defines to support selecting the simd vector kernels at runtime.  Uses
+// thread dispatcher on the widest pipeline no wider than simd_width that
+// exists for name and the caller does straggler cleanup with the scalar
+// pipeline.
+//----------------------------------------------------------------------------//
+
+#if defined(VPIC_USE_SIMD_DISPATCH)
+
+# if defined(VPIC_DISPATCH_V16) && defined(HAS_V16_PIPELINE)
+#   define SIMD_PIPELINE_V16(name)                               \
+  simd_width >= 16 ? (pipeline_func_t)name##_pipeline_v16 :
+# else
+#   define SIMD_PIPELINE_V16(name)
+# endif
+
+# if defined(VPIC_DISPATCH_V8) && defined(HAS_V8_PIPELINE)
+#   define SIMD_PIPELINE_V8(name)                                \
+  simd_width >=  8 ? (pipeline_func_t)name##_pipeline_v8  :
+# else
+#   define SIMD_PIPELINE_V8(name)
+# endif
+
+# if defined(V4_ACCELERATION) && defined(HAS_V4_PIPELINE)
+#   define SIMD_PIPELINE_V4(name)                                \
+  simd_width >=  4 ? (pipeline_func_t)name##_pipeline_v4  :
+# else
+#   define SIMD_PIPELINE_V4(name)
+# endif
+
+# define EXEC_PIPELINES(name,args,str)                           \
+  thread.dispatch( ( SIMD_PIPELINE_V16(name)                     \
+                     SIMD_PIPELINE_V8(name)                      \
+                     SIMD_PIPELINE_V4(name)                      \
+                     (pipeline_func_t)name##_pipeline_scalar ),  \
+                   args, sizeof(*args), str );                   \
+  name##_pipeline_scalar( args+str*N_PIPELINE, N_PIPELINE, N_PIPELINE )
+
 //----------------------------------------------------------------------------//
 // Macro defines to support v16 simd vector acceleration.  Uses thread
 // dispatcher on the v16 pipeline and the caller does straggler cleanup with
 // the scalar pipeline.
 //----------------------------------------------------------------------------//
 
-#if defined(V16_ACCELERATION) && defined(HAS_V16_PIPELINE)
+#elif defined(V16_ACCELERATION) && defined(HAS_V16_PIPELINE)
 
 # define EXEC_PIPELINES(name,args,str)                           \
   thread.dispatch( (pipeline_func_t)name##_pipeline_v16,         \
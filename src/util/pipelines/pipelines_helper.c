@@ -24,6 +24,18 @@ omp_boot( int * pargc,
   //initialize dispatch_to_host
   int dispatch_to_host = strip_cmdline_int( pargc, pargv, "--dispatch_to_host", 1 );
 
+  boot_pipeline_chunks( pargc, pargv );
+
+  // Pin the threads of the team.  EXEC_PIPELINES hands pipeline id to
+  // thread id of the team (with the static schedule, the default of the
+  // common runtimes) and the threads persist between parallel regions.
+
+  boot_pipeline_affinity( pargc, pargv, n_pipeline );
+  if( pipelines_pinned() ) {
+    #pragma omp parallel num_threads(n_pipeline)
+    pin_thread( pipeline_cpu( omp_get_thread_num() ) );
+  }
+
   //assign our helper values
   omp_helper.n_pipeline       = n_pipeline;
   omp_helper.dispatch_to_host = dispatch_to_host;
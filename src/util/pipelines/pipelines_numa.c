@@ -0,0 +1,150 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // For the CPU affinity interface of Linux
+#endif
+
+#include "pipelines.h" // For util_base.h, datatypes and prototypes
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+// With "--pin 1", pipeline k is pinned to CPU Base+k*Stride of the list of
+// CPUs the process was allowed to run on at boot (the list wraps around).
+// The list is in the order of the CPU numbers, which on most systems keeps
+// the pipelines of a NUMA domain together.  Launchers that bind ranks to a
+// socket or a NUMA domain then get pipelines pinned inside it.  Launchers
+// that bind ranks to a single core get all pipelines pinned to that core,
+// so use "--bind-to none" (or similar) when running more than one pipeline
+// per rank.  When the ranks are threads of one process, rank r starts at
+// Base = r*n_pipeline*Stride so ranks do not share CPUs.
+//
+// FIXME: THIS DOES NOT KNOW ABOUT SMT SIBLINGS.  USE --pin_stride 2 TO GET
+// ONE PIPELINE PER CORE ON SYSTEMS THAT NUMBER SIBLINGS CONSECUTIVELY.
+
+#if defined(__linux__)
+static VPIC_THREAD_LOCAL int Cpu[ CPU_SETSIZE ]; // Allowed CPUs at boot
+#endif
+static VPIC_THREAD_LOCAL int N_Cpu  = 0;
+static VPIC_THREAD_LOCAL int Pin    = 0; // Pin pipelines (--pin)?
+static VPIC_THREAD_LOCAL int Stride = 1; // --pin_stride
+static VPIC_THREAD_LOCAL int Base   = 0;
+
+void
+boot_pipeline_affinity( int * pargc,
+                        char *** pargv,
+                        int n_pipeline ) {
+  Pin    = strip_cmdline_int( pargc, pargv, "--pin",        0 );
+  Stride = strip_cmdline_int( pargc, pargv, "--pin_stride", 1 );
+  N_Cpu  = 0;
+  Base   = 0;
+
+  if( !Pin ) return;
+
+  if( Stride<1 ) ERROR(( "Invalid pipeline pin stride (%i)", Stride ));
+
+# if defined(__linux__)
+  cpu_set_t mask;
+  int c;
+
+  CPU_ZERO( &mask );
+  if( sched_getaffinity( 0, sizeof(mask), &mask ) )
+    ERROR(( "sched_getaffinity failed" ));
+  for( c=0; c<CPU_SETSIZE; c++ ) if( CPU_ISSET( c, &mask ) ) Cpu[ N_Cpu++ ] = c;
+
+# if defined(VPIC_USE_THREAD_MP)
+  Base = _world_rank*n_pipeline*Stride;
+# endif
+# else
+  WARNING(( "Pinning pipelines is not supported on this platform" ));
+  Pin = 0;
+# endif
+}
+
+int
+pipelines_pinned( void ) {
+  return Pin;
+}
+
+int
+pipeline_cpu( int pipeline_rank ) {
+# if defined(__linux__)
+  if( Pin && N_Cpu ) return Cpu[ ( Base + pipeline_rank*Stride ) % N_Cpu ];
+# endif
+  return -1;
+}
+
+void
+pin_thread( int cpu ) {
+# if defined(__linux__)
+  cpu_set_t mask;
+  if( cpu<0 ) return;
+  CPU_ZERO( &mask );
+  CPU_SET( cpu, &mask );
+  if( sched_setaffinity( 0, sizeof(mask), &mask ) )
+    WARNING(( "Unable to pin a pipeline to CPU %i", cpu ));
+# endif
+}
+
+// First touch.  Each pipeline clears (or copies into) its DISTRIBUTE
+// share of d and the dispatching process does the remainder.
+
+typedef struct touch_pipeline_args {
+  char       * d;
+  const char * s;
+  int64_t      N, b;
+  size_t       sz;
+} touch_pipeline_args_t;
+
+static void
+touch_pipeline( touch_pipeline_args_t * args,
+                int pipeline_rank,
+                int n_pipeline ) {
+  int64_t i, n;
+  DISTRIBUTE( args->N, args->b, pipeline_rank, n_pipeline, i, n );
+  if( args->s ) COPY(  args->d + i*args->sz, args->s + i*args->sz, n*args->sz );
+  else          CLEAR( args->d + i*args->sz,                       n*args->sz );
+}
+
+void
+touch_pipelines( void * d,
+                 const void * s,
+                 int64_t N,
+                 int64_t b,
+                 size_t sz ) {
+  touch_pipeline_args_t args[1];
+  int n_pipeline;
+
+  if( N<1 ) return;
+  if( !d || b<1 || !sz ) ERROR(( "Bad args" ));
+
+  args->d  = (char *)d;
+  args->s  = (const char *)s;
+  args->N  = N;
+  args->b  = b;
+  args->sz = sz;
+
+# if defined(VPIC_USE_PTHREADS)
+  n_pipeline = thread.n_pipeline;
+  if( n_pipeline ) {
+    thread.dispatch( (pipeline_func_t)touch_pipeline, args, 0, 0 );
+    touch_pipeline( args, n_pipeline, n_pipeline );
+    thread.wait();
+    return;
+  }
+# elif defined(VPIC_USE_OPENMP)
+  n_pipeline = omp_helper.n_pipeline;
+  if( n_pipeline ) {
+    int id;
+#   pragma omp parallel for num_threads(n_pipeline)
+    for( id=0; id<n_pipeline; id++ ) touch_pipeline( args, id, n_pipeline );
+    touch_pipeline( args, n_pipeline, n_pipeline );
+    return;
+  }
+# endif
+
+  // The dispatcher is not booted
+
+  n_pipeline = 1;
+  touch_pipeline( args, 0,          n_pipeline );
+  touch_pipeline( args, n_pipeline, n_pipeline );
+}
@@ -78,8 +78,8 @@ typedef struct pipeline_dispatcher
 
 BEGIN_C_DECLS
 
-extern pipeline_dispatcher_t serial; // For debugging purposes
-extern pipeline_dispatcher_t thread;
+extern VPIC_THREAD_LOCAL pipeline_dispatcher_t serial; // For debugging purposes
+extern VPIC_THREAD_LOCAL pipeline_dispatcher_t thread;
 
 END_C_DECLS
 
@@ -2,7 +2,7 @@
 
 #if defined(VPIC_USE_PTHREADS)
 
-static int Busy = 0;
+static VPIC_THREAD_LOCAL int Busy = 0;
 
 /*****************************************************************************/
 
@@ -46,6 +46,7 @@ serial_dispatch( pipeline_func_t func,
   if( serial.n_pipeline==0 ) ERROR(( "Boot serial dispatcher first!" ));
   if( Busy ) ERROR(( "Pipelines are busy!" ));
   Busy = 1;
+  reset_pipeline_chunks( serial.n_pipeline );
   for( id=0; id<serial.n_pipeline; id++ )
     if( func ) func( ((char *)args) + id*sz*str, id, serial.n_pipeline );
 }
@@ -65,7 +66,7 @@ serial_halt( void ) {
   serial.n_pipeline = 0;
 }
 
-pipeline_dispatcher_t serial = {
+VPIC_THREAD_LOCAL pipeline_dispatcher_t serial = {
   0,               // n_pipeline
   serial_boot,     // boot
   serial_halt,     // halt
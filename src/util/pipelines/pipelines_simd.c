@@ -0,0 +1,153 @@
+#include "pipelines.h" // For util_base.h, datatypes and prototypes
+
+#if defined(VPIC_USE_SIMD_DISPATCH)
+
+#include <stdlib.h>
+#include <string.h>
+
+// Until boot_simd is called, only the scalar pipelines are used.
+
+int simd_width = 1;
+
+//----------------------------------------------------------------------------//
+// Host capability detection.  The baseline v4 classes are compiled into every
+// source file, so the host must support them to run at all.  The AVX flavors
+// of the v4 kernels and the v8 and v16 kernels are compiled separately for
+// their instruction sets and CPUID is queried to decide if the host can
+// execute them.
+//----------------------------------------------------------------------------//
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HOST_HAS( isa ) __builtin_cpu_supports( isa )
+#else
+#define HOST_HAS( isa ) 0
+#endif
+
+static int
+simd_supported( int width )
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+#endif
+
+  switch( width )
+  {
+  case 1:
+    return 1;
+
+  case 4:
+#if defined(VPIC_DISPATCH_V4_AVX)
+    return HOST_HAS( "avx" );
+#elif defined(VPIC_DISPATCH_V4_AVX2)
+    return HOST_HAS( "avx2" ) && HOST_HAS( "fma" );
+#elif defined(USE_V4_PORTABLE) || \
+      defined(USE_V4_SSE)      || \
+      defined(USE_V4_AVX)      || \
+      defined(USE_V4_AVX2)     || \
+      defined(USE_V4_ALTIVEC)
+    return 1;
+#else
+    return 0;
+#endif
+
+  case 8:
+#if defined(VPIC_DISPATCH_V8_PORTABLE)
+    return 1;
+#elif defined(VPIC_DISPATCH_V8_AVX)
+    return HOST_HAS( "avx" );
+#elif defined(VPIC_DISPATCH_V8_AVX2)
+    return HOST_HAS( "avx2" ) && HOST_HAS( "fma" );
+#else
+    return 0;
+#endif
+
+  case 16:
+#if defined(VPIC_DISPATCH_V16_PORTABLE)
+    return 1;
+#elif defined(VPIC_DISPATCH_V16_AVX512)
+    return HOST_HAS( "avx512f" ) && HOST_HAS( "avx512dq" );
+#else
+    return 0;
+#endif
+
+  default:
+    return 0;
+  }
+}
+
+// Pipelines without a kernel of the selected width fall back to the narrower
+// kernels, so the host must also be able to run every narrower one that is
+// dispatched.
+
+static int
+simd_available( int width )
+{
+#if defined(VPIC_DISPATCH_V4)
+  if( width > 4 && !simd_supported( 4 ) ) return 0;
+#endif
+#if defined(VPIC_DISPATCH_V8)
+  if( width > 8 && !simd_supported( 8 ) ) return 0;
+#endif
+  return simd_supported( width );
+}
+
+static int
+simd_parse( const char * name )
+{
+  if( !strcmp( name, "scalar" ) ) return 1;
+  if( !strcmp( name, "v4"     ) ) return 4;
+  if( !strcmp( name, "v8"     ) ) return 8;
+  if( !strcmp( name, "v16"    ) ) return 16;
+  if( !strcmp( name, "auto"   ) ) return 0;
+
+  ERROR(( "Unknown SIMD kernel selection \"%s\" (expected auto, scalar, "
+          "v4, v8 or v16)", name ));
+
+  return 0;
+}
+
+const char *
+simd_name( int width )
+{
+  switch( width )
+  {
+  case 4:  return "v4";
+  case 8:  return "v8";
+  case 16: return "v16";
+  default: return "scalar";
+  }
+}
+
+// boot_simd selects the widest kernels the host supports.  This can be
+// overridden with the VPIC_SIMD environment variable and the --simd command
+// line option (which takes priority).  Both accept auto, scalar, v4, v8 or
+// v16.  Requesting kernels that were not compiled in, or that the host cannot
+// execute, is an error.
+
+void
+boot_simd( int * pargc,
+           char *** pargv )
+{
+  const char * env = getenv( "VPIC_SIMD" );
+  const char * req = strip_cmdline_string( pargc, pargv, "--simd",
+                                           env ? env : "auto" );
+
+  static const int widths[] = { 16, 8, 4, 1 };
+  int n, width = simd_parse( req );
+
+  if( width == 0 )
+  {
+    for( n = 0; !simd_available( widths[n] ); n++ );
+    width = widths[n];
+  }
+
+  else if( !simd_available( width ) )
+  {
+    ERROR(( "SIMD kernels \"%s\" are not compiled in or not supported by "
+            "this host", req ));
+  }
+
+  simd_width = width;
+}
+
+#endif
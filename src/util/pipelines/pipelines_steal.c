@@ -0,0 +1,154 @@
+#include "pipelines.h" // For util_base.h, datatypes and prototypes
+
+// The pool keeps a deque of chunks for each pipeline.  As the chunks of a
+// deque are consecutive, a deque is just the range lo:hi-1 of the chunks it
+// has left, packed into one word ((hi<<32)|lo).  The owner takes chunks from
+// the front (advancing lo) and thieves take chunks from the back (retreating
+// hi), both with a compare and swap on the word.  A deque is UNSET after a
+// reset, and the first pipeline that looks at it during a dispatch sets it to
+// the chunks of the DISTRIBUTE share of its owner.
+//
+// FIXME: THE CHUNK SIZE SHOULD PROBABLY BE TUNABLE.
+
+#define PIPELINE_CHUNKS 16 // Chunks per pipeline
+#define UNSET           (~(uint64_t)0)
+#define PACK(lo,hi)     ( ( (uint64_t)(hi)<<32 ) | (uint64_t)(lo) )
+
+typedef struct pipeline_deque {
+  volatile uint64_t range;
+  char pad[ 64-sizeof(uint64_t) ]; // Each deque gets its own cache line
+} pipeline_deque_t;
+
+struct pipeline_chunk_pool {
+  int steal;                             // Steal chunks (--steal)?
+  pipeline_deque_t deque[ MAX_PIPELINE ];
+};
+
+// The pool of this host and the pool this thread takes chunks from (NULL:
+// the pool of this host)
+
+static VPIC_THREAD_LOCAL pipeline_chunk_pool_t Pool;
+static VPIC_THREAD_LOCAL pipeline_chunk_pool_t * Pool_In_Use = NULL;
+
+#define POOL ( Pool_In_Use ? Pool_In_Use : &Pool )
+
+void
+boot_pipeline_chunks( int * pargc,
+                      char *** pargv ) {
+  Pool.steal = strip_cmdline_int( pargc, pargv, "--steal", 0 );
+  reset_pipeline_chunks( MAX_PIPELINE );
+}
+
+void
+reset_pipeline_chunks( int n_pipeline ) {
+  int p;
+  if( !Pool.steal ) return;
+  for( p=0; p<n_pipeline; p++ ) Pool.deque[p].range = UNSET;
+}
+
+int
+pipelines_steal( void ) {
+  return POOL->steal;
+}
+
+pipeline_chunk_pool_t *
+host_pipeline_chunk_pool( void ) {
+  return &Pool;
+}
+
+void
+set_pipeline_chunk_pool( pipeline_chunk_pool_t * pool ) {
+  Pool_In_Use = pool;
+}
+
+pipeline_chunks_t
+begin_pipeline_chunks( int64_t N,
+                       int64_t b,
+                       int p,
+                       int P ) {
+  pipeline_chunks_t pc;
+  int64_t n_block = N/b, c;
+
+  pc.i = 0, pc.n = 0, pc.N = N, pc.b = b;
+  pc.chunk = 0, pc.n_chunk = 0;
+  pc.p = p, pc.P = P, pc.victim = 0;
+
+  // The dispatching process only gets the remainder and there is nothing
+  // to steal from a single pipeline
+
+  if( p<P && P>1 && n_block>0 && POOL->steal ) {
+    c = ( n_block + (int64_t)P*PIPELINE_CHUNKS - 1 ) /
+        ( (int64_t)P*PIPELINE_CHUNKS );
+    pc.chunk   = c*b;
+    pc.n_chunk = ( n_block + c - 1 ) / c;
+  }
+
+  return pc;
+}
+
+// Take a chunk from the front (owner) or back (thief) of deque d, whose
+// initial chunks are lo0:hi0-1.  Returns -1 if the deque is empty.
+
+static int64_t
+take_chunk( pipeline_deque_t * d,
+            int64_t lo0,
+            int64_t hi0,
+            int front ) {
+  uint64_t r, s, lo, hi;
+  for(;;) {
+    r = __atomic_load_n( &d->range, __ATOMIC_ACQUIRE );
+    if( r==UNSET ) {
+      __atomic_compare_exchange_n( &d->range, &r, PACK( lo0, hi0 ), 0,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+      continue;
+    }
+    lo = r & 0xffffffff, hi = r>>32;
+    if( lo>=hi ) return -1;
+    s = front ? PACK( lo+1, hi ) : PACK( lo, hi-1 );
+    if( __atomic_compare_exchange_n( &d->range, &r, s, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+      return (int64_t)( front ? lo : hi-1 );
+  }
+}
+
+int
+next_pipeline_chunk( pipeline_chunks_t * pc ) {
+  pipeline_deque_t * deque;
+  int64_t c, n_item;
+  int v;
+
+  // Without stealing, the pipeline gets its DISTRIBUTE share in one go
+
+  if( !pc->chunk ) {
+    if( pc->victim ) return 0;
+    pc->victim = 1;
+    DISTRIBUTE( pc->N, pc->b, pc->p, pc->P, pc->i, pc->n );
+    return 1;
+  }
+
+  // Take the chunks of this pipeline first and then steal from the
+  // pipelines after it
+
+  deque  = POOL->deque;
+  n_item = ( pc->N/pc->b )*pc->b;
+  for( ; pc->victim<pc->P; pc->victim++ ) {
+    v = ( pc->p + pc->victim ) % pc->P;
+    c = take_chunk( deque + v,
+                    ( (int64_t) v   *pc->n_chunk )/pc->P,
+                    ( (int64_t)(v+1)*pc->n_chunk )/pc->P,
+                    pc->victim==0 );
+    if( c>=0 ) {
+      pc->i = c*pc->chunk;
+      pc->n = n_item - pc->i;
+      if( pc->n>pc->chunk ) pc->n = pc->chunk;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+#undef POOL
+#undef PACK
+#undef UNSET
+#undef PIPELINE_CHUNKS
@@ -37,11 +37,17 @@
 // (?) Signal blocking in pipelines
 // (?) Timeouts in thread_halt, thread_boot (spin wait)
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // For sched_getaffinity
+#endif
+
 #include "pipelines.h"
 
 #if defined(VPIC_USE_PTHREADS)
 
 #include <pthread.h>
+#include <sched.h>
+#include <time.h>
 
 static void *
 pipeline_mgr( void *_id );
@@ -53,6 +59,14 @@ enum {
   PIPELINE_ACK = 3
 };
 
+// Default for the longest a pipeline polls for a new task before it
+// sleeps (--spin, in microseconds).  Polling lets the host hand out the
+// next task without waking the pipeline up.  But a polling pipeline takes
+// CPU time from the host and the other pipelines when there are more
+// threads than CPUs, so pipelines then sleep right away.
+
+enum { PIPELINE_SPIN = 50 };
+
 typedef struct pipeline_state {
   pthread_t handle;
   pthread_mutex_t mutex;
@@ -63,14 +77,29 @@ typedef struct pipeline_state {
   int job;
   int n_job;
   volatile int *flag;
+  pipeline_chunk_pool_t *chunks;
+  int cpu;
+  int64_t spin; // Longest poll in ns (0: sleep right away)
 } pipeline_state_t;
 
-static pthread_t Host;
-static pipeline_state_t Pipeline[ MAX_PIPELINE ];
-static volatile int Done[ MAX_PIPELINE ];
-static int Id = 0;
-static int Busy = 0;
-static int Dispatch_To_Host = 0;
+static VPIC_THREAD_LOCAL pthread_t Host;
+static VPIC_THREAD_LOCAL pipeline_state_t Pipeline[ MAX_PIPELINE ];
+static VPIC_THREAD_LOCAL volatile int Done[ MAX_PIPELINE ];
+static VPIC_THREAD_LOCAL int Id = 0;
+static VPIC_THREAD_LOCAL int Busy = 0;
+static VPIC_THREAD_LOCAL int Dispatch_To_Host = 0;
+
+// The number of CPUs the calling thread may run on (0: unknown)
+
+static int
+pipeline_n_cpu( void ) {
+# if defined(__linux__)
+  cpu_set_t mask;
+  CPU_ZERO( &mask );
+  if( !sched_getaffinity( 0, sizeof(mask), &mask ) ) return CPU_COUNT( &mask );
+# endif
+  return 0;
+}
 
 /****************************************************************************/
 
@@ -168,7 +197,7 @@ restore_thread( void ) {
 static void
 thread_boot( int * pargc,
              char *** pargv ) {
-  int i, n_pipeline;
+  int i, n_pipeline, n_thread, n_cpu, spin;
 
   // Check if arguments are valid and dispatcher isn't already initialized
 
@@ -179,10 +208,26 @@ thread_boot( int * pargc,
 
   n_pipeline       = strip_cmdline_int( pargc, pargv, "--tpp",              1 );
   Dispatch_To_Host = strip_cmdline_int( pargc, pargv, "--dispatch_to_host", 1 );
+  spin             = strip_cmdline_int( pargc, pargv, "--spin", PIPELINE_SPIN );
+  boot_pipeline_chunks( pargc, pargv );
 
   if( n_pipeline<1 || n_pipeline>MAX_PIPELINE )
     ERROR(( "Invalid number of pipelines requested (%i)", n_pipeline ));
 
+  if( spin<0 ) ERROR(( "Invalid pipeline spin time (%i)", spin ));
+
+  // Count the host and the pipeline threads (of all the ranks when the
+  // ranks are threads of one process)
+
+  n_thread = n_pipeline + ( Dispatch_To_Host ? 0 : 1 );
+# if defined(VPIC_USE_THREAD_MP)
+  n_thread *= world_size;
+# endif
+  n_cpu = pipeline_n_cpu();
+  if( n_cpu && n_thread>n_cpu ) spin = 0;
+
+  boot_pipeline_affinity( pargc, pargv, n_pipeline );
+
   // Initialize some global variables. Note: thread.n_pipeline = 0 here
 
   Id   = 0;
@@ -197,7 +242,10 @@ thread_boot( int * pargc,
     // cleared once the thread control function pipeline_mgr starts
     // executing and the thread is ready to execute pipelines.
 
-    Pipeline[i].state = PIPELINE_ACK;
+    Pipeline[i].state  = PIPELINE_ACK;
+    Pipeline[i].chunks = host_pipeline_chunk_pool();
+    Pipeline[i].cpu    = pipeline_cpu( i );
+    Pipeline[i].spin   = (int64_t)spin*1000;
 
     // Initialize the pipeline mutex and signal condition variables
     // and spawn the pipeline.  Note: When mutexes are initialized,
@@ -227,6 +275,10 @@ thread_boot( int * pargc,
 
   }
 
+  // The host executes the last pipeline when dispatching to the host
+
+  if( Dispatch_To_Host ) pin_thread( pipeline_cpu( n_pipeline-1 ) );
+
   thread.n_pipeline = n_pipeline;
   REGISTER_OBJECT( &thread, checkpt_thread, restore_thread, NULL );
 }
@@ -386,9 +438,12 @@ parallel_execute( pipeline_func_t func,
 
   for(;;) {
 
-    // Get an id of a pipeline to query.
+    // Get an id of a pipeline to query.  Pinned pipelines only execute
+    // their own job, such that a job always runs in the NUMA domain
+    // where the pipeline first touched its data.
 
-    id = Id; if( (++Id) >= thread.n_pipeline-Dispatch_To_Host ) Id = 0;
+    if( pipelines_pinned() ) id = job;
+    else { id = Id; if( (++Id) >= thread.n_pipeline-Dispatch_To_Host ) Id = 0; }
 
     if( !pthread_mutex_trylock( &Pipeline[id].mutex ) ) {
 
@@ -437,6 +492,30 @@ parallel_execute( pipeline_func_t func,
   // Never get here
 }
 
+static int64_t
+pipeline_clock( void ) {
+  struct timespec t;
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return (int64_t)t.tv_sec*1000000000 + (int64_t)t.tv_nsec;
+}
+
+// Polls the state of a sleeping pipeline for at most pipeline->spin ns,
+// backing off between polls.  The pipeline mutex is unlocked.
+
+static void
+pipeline_poll( pipeline_state_t * pipeline ) {
+  int64_t start;
+  uint32_t delay = 16;
+
+  if( pipeline->spin<=0 ) return;
+  start = pipeline_clock();
+  while( pipeline->state==PIPELINE_SLEEP ) {
+    nanodelay( delay );
+    if( delay<4096 ) delay <<= 1;
+    if( pipeline_clock()-start>=pipeline->spin ) break;
+  }
+}
+
 /****************************************************************************
  *
  * Function: pipeline_mgr(params) - internal use only
@@ -463,6 +542,12 @@ pipeline_mgr(void *_pipeline) {
 
   pipeline_state_t* pipeline = (pipeline_state_t*)_pipeline;
 
+  // Pipeline functions that steal work take it from the pool of the host.
+  // Pinned pipelines move to their CPU before touching any data.
+
+  set_pipeline_chunk_pool( pipeline->chunks );
+  pin_thread( pipeline->cpu );
+
   // Pipeline state is PIPELINE_ACK and the pipeline mutex is unlocked
   // when entering.  Since pthread_cond_wait unlockes the pipeline
   // mutex when the pipeline goes to sleep and the PIPELINE_ACK case
@@ -500,12 +585,18 @@ pipeline_mgr(void *_pipeline) {
     case PIPELINE_SLEEP:
     default:
 
-      // Go to sleep. Note: pthread_cond_wait unlocks the pipeline
-      // mutex while the pipeline is sleeping and locks it when the
-      // pipeline wakes up
+      // Go to sleep.  As the host usually dispatches the next task
+      // soon, the pipeline first polls its state for a while with the
+      // mutex unlocked (the host can then assign a task without waking
+      // it up).  Note: pthread_cond_wait unlocks the pipeline mutex while
+      // the pipeline is sleeping and locks it when the pipeline wakes up
 
       pipeline->state = PIPELINE_SLEEP;
-      pthread_cond_wait( &pipeline->wake, &pipeline->mutex );
+      pthread_mutex_unlock( &pipeline->mutex );
+      pipeline_poll( pipeline );
+      pthread_mutex_lock( &pipeline->mutex );
+      if( pipeline->state==PIPELINE_SLEEP )
+        pthread_cond_wait( &pipeline->wake, &pipeline->mutex );
 
       break;
 
@@ -531,6 +622,8 @@ thread_dispatch( pipeline_func_t func,
   if( Busy ) ERROR(( "Pipelines are busy!" ));
   Busy = 1;
 
+  reset_pipeline_chunks( thread.n_pipeline );
+
   for( id=0; id<thread.n_pipeline-Dispatch_To_Host; id++ ) {
     Done[id] = 0;
     parallel_execute( func,
@@ -567,7 +660,7 @@ thread_wait( void ) {
   Busy = 0;
 }
 
-pipeline_dispatcher_t thread = {
+VPIC_THREAD_LOCAL pipeline_dispatcher_t thread = {
   0,               // n_pipeline
   thread_boot,     // boot
   thread_halt,     // halt
@@ -1,7 +1,7 @@
 #include "profile.h"
 #include "sys/time.h"
 
-profile_internal_use_only_timer_t profile_internal_use_only[] = {
+VPIC_THREAD_LOCAL profile_internal_use_only_timer_t profile_internal_use_only[] = {
 # define PROFILE_TIMER_INIT( timer ) { #timer, 0., 0., 0, 0 },
   PROFILE_TIMERS( PROFILE_TIMER_INIT )
 # undef PROFILE_TIMER_INIT
@@ -11,9 +11,11 @@
 #define PROFILE_TIMERS(_) \
   _( clear_accumulators ) \
   _( sort_p            ) \
+  _( rebalance         ) \
   _( collision_model   ) \
   _( advance_p         ) \
   _( reduce_accumulators ) \
+  _( subcycle_p        ) \
   _( emission_model    ) \
   _( boundary_p        ) \
   _( clear_jf          ) \
@@ -78,7 +80,7 @@ typedef struct profile_internal_use_only_timer {
   int n, n_total;
 } profile_internal_use_only_timer_t;
 
-extern profile_internal_use_only_timer_t profile_internal_use_only[];
+extern VPIC_THREAD_LOCAL profile_internal_use_only_timer_t profile_internal_use_only[];
 
 BEGIN_C_DECLS
 
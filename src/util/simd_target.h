@@ -0,0 +1,69 @@
+#ifndef _simd_target_h_
+#define _simd_target_h_
+
+//----------------------------------------------------------------------------//
+// With USE_SIMD_DISPATCH, the *_v4.cc, *_v8.cc and *_v16.cc kernel sources are
+// compiled with VPIC_SIMD_KERNEL set to their vector width and the USE_V*
+// define of the instruction set dispatched for that width, but without any
+// -mavx2 style flags.  Only the code between SIMD_KERNEL_BEGIN and
+// SIMD_KERNEL_END, that is the vector classes of that width (see v4.h, v8.h
+// and v16.h) and the kernels themselves, is compiled for that instruction set.
+//
+// Inline functions from every other header stay at the baseline instruction
+// set.  They are emitted as weak definitions in each object file using them,
+// and the linker keeps an arbitrary one, so they must be safe on any host.
+// Compiling whole kernel sources with -mavx512f could make, say, boundary_p
+// call an AVX-512 copy of a shared helper on an AVX2 host.
+//
+// Outside of kernel sources, SIMD_KERNEL_BEGIN and SIMD_KERNEL_END are empty.
+//----------------------------------------------------------------------------//
+
+#if defined(VPIC_SIMD_KERNEL)
+
+# if   VPIC_SIMD_KERNEL ==  4 && defined(USE_V4_AVX2)
+#   define SIMD_KERNEL_TARGET "avx2,fma"
+# elif VPIC_SIMD_KERNEL ==  4 && defined(USE_V4_AVX)
+#   define SIMD_KERNEL_TARGET "avx"
+# elif VPIC_SIMD_KERNEL ==  8 && defined(USE_V8_AVX2)
+#   define SIMD_KERNEL_TARGET "avx2,fma"
+# elif VPIC_SIMD_KERNEL ==  8 && defined(USE_V8_AVX)
+#   define SIMD_KERNEL_TARGET "avx"
+# elif VPIC_SIMD_KERNEL == 16 && defined(USE_V16_AVX512)
+#   define SIMD_KERNEL_TARGET "avx512f,avx512dq"
+# endif
+
+#endif
+
+#if defined(SIMD_KERNEL_TARGET)
+
+// The intrinsics and math headers must be seen before the target is changed,
+// else their inline functions would be compiled for it too.
+
+# include <immintrin.h>
+# include <math.h>
+
+# define SIMD_PRAGMA(x) _Pragma(#x)
+
+# if defined(__clang__)
+#   define SIMD_TARGET_PUSH(t)                                            \
+  SIMD_PRAGMA(clang attribute push(__attribute__((target(t))),            \
+                                   apply_to = function))
+#   define SIMD_KERNEL_END SIMD_PRAGMA(clang attribute pop)
+# elif defined(__GNUC__)
+#   define SIMD_TARGET_PUSH(t)                                            \
+  SIMD_PRAGMA(GCC push_options) SIMD_PRAGMA(GCC target(t))
+#   define SIMD_KERNEL_END SIMD_PRAGMA(GCC pop_options)
+# else
+#   error "USE_SIMD_DISPATCH requires a compiler with GCC or Clang target pragmas"
+# endif
+
+# define SIMD_KERNEL_BEGIN SIMD_TARGET_PUSH(SIMD_KERNEL_TARGET)
+
+#else
+
+# define SIMD_KERNEL_BEGIN
+# define SIMD_KERNEL_END
+
+#endif
+
+#endif // _simd_target_h_
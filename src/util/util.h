@@ -30,7 +30,7 @@ halt_services( void );
 // (in seconds since the epoch).  All processes agree on this.
 
 #define boot_timestamp (double)_boot_timestamp
-extern double _boot_timestamp;
+extern VPIC_THREAD_LOCAL double _boot_timestamp;
 
 // Give an estimate of how many seconds since boot_services was
 // called (in seconds).  This call must be loosly synchronous over
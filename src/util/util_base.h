@@ -104,6 +104,19 @@ typedef struct collective collective_t;
 #define RESTRICT __restrict
 #endif 
 
+// This storage modifier marks process wide state that belongs to a
+// rank.  When the ranks are threads of one process (the threaded
+// message passing backend), each rank thread gets its own copy.
+// Otherwise, it is an ordinary global.
+
+#ifndef VPIC_THREAD_LOCAL
+#if defined(VPIC_USE_THREAD_MP)
+#define VPIC_THREAD_LOCAL __thread
+#else
+#define VPIC_THREAD_LOCAL
+#endif
+#endif
+
 // Normal pointers (e.g. a *) are in whatever address space the given
 // compile unit uses.  However, sometimes it is necessary to declare
 // pointers that are understandable in multiple address spaces.  The
@@ -186,14 +199,18 @@ typedef struct collective collective_t;
 // This macro is robust.  (All arguments only evaluated once;
 // inputs can be same as output.)  Any compiler worth its
 // salt will replace the divison and modulo with bit shifts
-// and masks for power-of-two block sizes.
-
-#define DISTRIBUTE( N, b, p, P, i, n ) BEGIN_PRIMITIVE {             \
-    int _N = (N), _b = (b), _p = (p), _P = (P);                      \
-    double _t = (double)(_N/_b)/(double)_P;                          \
-    int _i =                    _b*(int)(_t*(double) _p   +0.5);     \
-    (n) = (_p==_P) ? (_N%_b) : (_b*(int)(_t*(double)(_p+1)+0.5)-_i); \
-    (i) = _i;                                                        \
+// and masks for power-of-two block sizes.  N may exceed
+// 2^31 (e.g. the local number of particles) if i and n are
+// 64-bit.
+
+#define DISTRIBUTE( N, b, p, P, i, n ) BEGIN_PRIMITIVE {       \
+    int64_t _N = (N), _b = (b);                                \
+    int _p = (p), _P = (P);                                    \
+    double _t = (double)(_N/_b)/(double)_P;                    \
+    int64_t _i = _b*(int64_t)(_t*(double) _p   +0.5);          \
+    (n) = (_p==_P) ? (_N%_b) :                                 \
+                     (_b*(int64_t)(_t*(double)(_p+1)+0.5)-_i); \
+    (i) = _i;                                                  \
   } END_PRIMITIVE
 
 // INDEX_FORTRAN_x and INDEX_C_x give macros for accessing
@@ -292,7 +309,7 @@ extern collective_t * _world;
 extern int _world_size;
 
 #define world_rank ((int)_world_rank)
-extern int _world_rank;
+extern VPIC_THREAD_LOCAL int _world_rank;
 
 // Strip all instances of key from the command line. Returns the
 // number of times key was found.
@@ -4,11 +4,18 @@
 #define IN_v16_h
 /* FIXME: SHOULDN'T THIS INCLUDE UTIL_BASE.H? */
 #ifdef __cplusplus
+# include "../simd_target.h"
+# if defined(VPIC_SIMD_KERNEL) && VPIC_SIMD_KERNEL == 16
+SIMD_KERNEL_BEGIN
+# endif
 # if defined USE_V16_PORTABLE
 #   include "v16_portable.h"
 # elif defined USE_V16_AVX512
 #   include "v16_avx512.h"
 # endif
+# if defined(VPIC_SIMD_KERNEL) && VPIC_SIMD_KERNEL == 16
+SIMD_KERNEL_END
+# endif
 #endif
 #undef IN_v16_h
 #endif // _v16_h_
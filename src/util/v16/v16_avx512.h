@@ -622,22 +622,26 @@ namespace v16
     __m512 t00, t01, t02,      t04,      t06,      t08, t09, t10,      t12,      t14;
     __m512 u00, u01, u02, u03, u04, u05, u06, u07, u08, u09, u10, u11, u12, u13, u14, u15;
 
-    u00   = _mm512_load_ps( (const float *)a00 );                      //   0   1   2   3   4   5   6   7   8   9  10  11  12  13  14  15
-    u01   = _mm512_load_ps( (const float *)a01 );                      //  16  17  18  19  20  21  22  23  24  25  26  27  28  29  30  31
-    u02   = _mm512_load_ps( (const float *)a02 );                      //  32  33  34  35  36  37  38  39  40  41  42  43  44  45  46  47
-    u03   = _mm512_load_ps( (const float *)a03 );                      //  48  49  50  51  52  53  54  55  56  57  58  59  60  61  62  63
-    u04   = _mm512_load_ps( (const float *)a04 );                      //  64  65  66  67  68  69  70  71  72  73  74  75  76  77  78  79
-    u05   = _mm512_load_ps( (const float *)a05 );                      //  80  81  82  83  84  85  86  87  88  89  90  91  92  93  94  95
-    u06   = _mm512_load_ps( (const float *)a06 );                      //  96  97  98  99 100 101 102 103 104 105 106 107 108 109 110 111
-    u07   = _mm512_load_ps( (const float *)a07 );                      // 112 113 114 115 116 117 118 119 120 121 122 123 124 125 126 127
-    u08   = _mm512_load_ps( (const float *)a08 );                      // 128 129 130 131 132 133 134 135 136 137 138 139 140 141 142 143
-    u09   = _mm512_load_ps( (const float *)a09 );                      // 144 145 146 147 148 149 150 151 152 153 154 155 156 157 158 159
-    u10   = _mm512_load_ps( (const float *)a10 );                      // 160 161 162 163 164 165 166 167 168 169 170 171 172 173 174 175
-    u11   = _mm512_load_ps( (const float *)a11 );                      // 176 177 178 179 180 181 182 183 184 185 186 187 188 189 190 191
-    u12   = _mm512_load_ps( (const float *)a12 );                      // 192 193 194 195 196 197 198 199 200 201 202 203 204 205 206 207
-    u13   = _mm512_load_ps( (const float *)a13 );                      // 208 209 210 211 212 213 214 215 216 217 218 219 220 221 222 223
-    u14   = _mm512_load_ps( (const float *)a14 );                      // 224 225 226 227 228 229 230 231 232 233 234 235 236 237 238 239
-    u15   = _mm512_load_ps( (const float *)a15 );                      // 240 241 242 243 244 245 246 247 248 249 250 251 252 253 254 255
+    // Only the first two floats of each record are used.  Load just the
+    // 128 bits holding them, without requiring the records to be aligned.
+    // The upper lanes are never selected below.
+
+    u00   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a00 ) );
+    u01   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a01 ) );
+    u02   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a02 ) );
+    u03   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a03 ) );
+    u04   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a04 ) );
+    u05   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a05 ) );
+    u06   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a06 ) );
+    u07   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a07 ) );
+    u08   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a08 ) );
+    u09   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a09 ) );
+    u10   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a10 ) );
+    u11   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a11 ) );
+    u12   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a12 ) );
+    u13   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a13 ) );
+    u14   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a14 ) );
+    u15   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a15 ) );
 
     t00   = _mm512_unpacklo_ps( u00, u01 );                            //   0  16   1  17   4  20   5  21   8  24   9  25  12  28  13  29 
     t02   = _mm512_unpacklo_ps( u02, u03 );                            //  32  48  33  49  36  52  37  53  40  56  41  57  44  60  45  61
@@ -698,22 +702,26 @@ namespace v16
     __m512 t00, t01, t02, t03, t04, t05, t06, t07, t08, t09, t10, t11, t12, t13, t14, t15;
     __m512 u00, u01, u02, u03, u04, u05, u06, u07, u08, u09, u10, u11, u12, u13, u14, u15;
 
-    u00   = _mm512_load_ps( (const float *)a00 );                      //   0   1   2   3   4   5   6   7   8   9  10  11  12  13  14  15
-    u01   = _mm512_load_ps( (const float *)a01 );                      //  16  17  18  19  20  21  22  23  24  25  26  27  28  29  30  31
-    u02   = _mm512_load_ps( (const float *)a02 );                      //  32  33  34  35  36  37  38  39  40  41  42  43  44  45  46  47
-    u03   = _mm512_load_ps( (const float *)a03 );                      //  48  49  50  51  52  53  54  55  56  57  58  59  60  61  62  63
-    u04   = _mm512_load_ps( (const float *)a04 );                      //  64  65  66  67  68  69  70  71  72  73  74  75  76  77  78  79
-    u05   = _mm512_load_ps( (const float *)a05 );                      //  80  81  82  83  84  85  86  87  88  89  90  91  92  93  94  95
-    u06   = _mm512_load_ps( (const float *)a06 );                      //  96  97  98  99 100 101 102 103 104 105 106 107 108 109 110 111
-    u07   = _mm512_load_ps( (const float *)a07 );                      // 112 113 114 115 116 117 118 119 120 121 122 123 124 125 126 127
-    u08   = _mm512_load_ps( (const float *)a08 );                      // 128 129 130 131 132 133 134 135 136 137 138 139 140 141 142 143
-    u09   = _mm512_load_ps( (const float *)a09 );                      // 144 145 146 147 148 149 150 151 152 153 154 155 156 157 158 159
-    u10   = _mm512_load_ps( (const float *)a10 );                      // 160 161 162 163 164 165 166 167 168 169 170 171 172 173 174 175
-    u11   = _mm512_load_ps( (const float *)a11 );                      // 176 177 178 179 180 181 182 183 184 185 186 187 188 189 190 191
-    u12   = _mm512_load_ps( (const float *)a12 );                      // 192 193 194 195 196 197 198 199 200 201 202 203 204 205 206 207
-    u13   = _mm512_load_ps( (const float *)a13 );                      // 208 209 210 211 212 213 214 215 216 217 218 219 220 221 222 223
-    u14   = _mm512_load_ps( (const float *)a14 );                      // 224 225 226 227 228 229 230 231 232 233 234 235 236 237 238 239
-    u15   = _mm512_load_ps( (const float *)a15 );                      // 240 241 242 243 244 245 246 247 248 249 250 251 252 253 254 255
+    // Only the first three floats of each record are used.  Load just the
+    // 128 bits holding them, without requiring the records to be aligned.
+    // The upper lanes are never selected below.
+
+    u00   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a00 ) );
+    u01   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a01 ) );
+    u02   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a02 ) );
+    u03   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a03 ) );
+    u04   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a04 ) );
+    u05   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a05 ) );
+    u06   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a06 ) );
+    u07   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a07 ) );
+    u08   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a08 ) );
+    u09   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a09 ) );
+    u10   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a10 ) );
+    u11   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a11 ) );
+    u12   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a12 ) );
+    u13   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a13 ) );
+    u14   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a14 ) );
+    u15   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a15 ) );
 
     t00   = _mm512_unpacklo_ps( u00, u01 );                            //   0  16   1  17   4  20   5  21   8  24   9  25  12  28  13  29 
     t01   = _mm512_unpackhi_ps( u00, u01 );                            //   2  18   3  19   6  22   7  23  10  26  11  27  14  30  15  31
@@ -778,22 +786,26 @@ namespace v16
     __m512 t00, t01, t02, t03, t04, t05, t06, t07, t08, t09, t10, t11, t12, t13, t14, t15;
     __m512 u00, u01, u02, u03, u04, u05, u06, u07, u08, u09, u10, u11, u12, u13, u14, u15;
 
-    u00   = _mm512_load_ps( (const float *)a00 );                      //   0   1   2   3   4   5   6   7   8   9  10  11  12  13  14  15
-    u01   = _mm512_load_ps( (const float *)a01 );                      //  16  17  18  19  20  21  22  23  24  25  26  27  28  29  30  31
-    u02   = _mm512_load_ps( (const float *)a02 );                      //  32  33  34  35  36  37  38  39  40  41  42  43  44  45  46  47
-    u03   = _mm512_load_ps( (const float *)a03 );                      //  48  49  50  51  52  53  54  55  56  57  58  59  60  61  62  63
-    u04   = _mm512_load_ps( (const float *)a04 );                      //  64  65  66  67  68  69  70  71  72  73  74  75  76  77  78  79
-    u05   = _mm512_load_ps( (const float *)a05 );                      //  80  81  82  83  84  85  86  87  88  89  90  91  92  93  94  95
-    u06   = _mm512_load_ps( (const float *)a06 );                      //  96  97  98  99 100 101 102 103 104 105 106 107 108 109 110 111
-    u07   = _mm512_load_ps( (const float *)a07 );                      // 112 113 114 115 116 117 118 119 120 121 122 123 124 125 126 127
-    u08   = _mm512_load_ps( (const float *)a08 );                      // 128 129 130 131 132 133 134 135 136 137 138 139 140 141 142 143
-    u09   = _mm512_load_ps( (const float *)a09 );                      // 144 145 146 147 148 149 150 151 152 153 154 155 156 157 158 159
-    u10   = _mm512_load_ps( (const float *)a10 );                      // 160 161 162 163 164 165 166 167 168 169 170 171 172 173 174 175
-    u11   = _mm512_load_ps( (const float *)a11 );                      // 176 177 178 179 180 181 182 183 184 185 186 187 188 189 190 191
-    u12   = _mm512_load_ps( (const float *)a12 );                      // 192 193 194 195 196 197 198 199 200 201 202 203 204 205 206 207
-    u13   = _mm512_load_ps( (const float *)a13 );                      // 208 209 210 211 212 213 214 215 216 217 218 219 220 221 222 223
-    u14   = _mm512_load_ps( (const float *)a14 );                      // 224 225 226 227 228 229 230 231 232 233 234 235 236 237 238 239
-    u15   = _mm512_load_ps( (const float *)a15 );                      // 240 241 242 243 244 245 246 247 248 249 250 251 252 253 254 255
+    // Only the first four floats of each record are used.  Load just the
+    // 128 bits holding them, without requiring the records to be aligned.
+    // The upper lanes are never selected below.
+
+    u00   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a00 ) );
+    u01   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a01 ) );
+    u02   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a02 ) );
+    u03   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a03 ) );
+    u04   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a04 ) );
+    u05   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a05 ) );
+    u06   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a06 ) );
+    u07   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a07 ) );
+    u08   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a08 ) );
+    u09   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a09 ) );
+    u10   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a10 ) );
+    u11   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a11 ) );
+    u12   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a12 ) );
+    u13   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a13 ) );
+    u14   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a14 ) );
+    u15   = _mm512_castps128_ps512( _mm_loadu_ps( (const float *)a15 ) );
 
     t00   = _mm512_unpacklo_ps( u00, u01 );                            //   0  16   1  17   4  20   5  21   8  24   9  25  12  28  13  29 
     t01   = _mm512_unpackhi_ps( u00, u01 );                            //   2  18   3  19   6  22   7  23  10  26  11  27  14  30  15  31
@@ -866,22 +878,26 @@ namespace v16
     __m512 t00, t01, t02, t03, t04, t05, t06, t07, t08, t09, t10, t11, t12, t13, t14, t15;
     __m512 u00, u01, u02, u03, u04, u05, u06, u07, u08, u09, u10, u11, u12, u13, u14, u15;
 
-    u00   = _mm512_load_ps( (const float *)a00 );                      //   0   1   2   3   4   5   6   7   8   9  10  11  12  13  14  15
-    u01   = _mm512_load_ps( (const float *)a01 );                      //  16  17  18  19  20  21  22  23  24  25  26  27  28  29  30  31
-    u02   = _mm512_load_ps( (const float *)a02 );                      //  32  33  34  35  36  37  38  39  40  41  42  43  44  45  46  47
-    u03   = _mm512_load_ps( (const float *)a03 );                      //  48  49  50  51  52  53  54  55  56  57  58  59  60  61  62  63
-    u04   = _mm512_load_ps( (const float *)a04 );                      //  64  65  66  67  68  69  70  71  72  73  74  75  76  77  78  79
-    u05   = _mm512_load_ps( (const float *)a05 );                      //  80  81  82  83  84  85  86  87  88  89  90  91  92  93  94  95
-    u06   = _mm512_load_ps( (const float *)a06 );                      //  96  97  98  99 100 101 102 103 104 105 106 107 108 109 110 111
-    u07   = _mm512_load_ps( (const float *)a07 );                      // 112 113 114 115 116 117 118 119 120 121 122 123 124 125 126 127
-    u08   = _mm512_load_ps( (const float *)a08 );                      // 128 129 130 131 132 133 134 135 136 137 138 139 140 141 142 143
-    u09   = _mm512_load_ps( (const float *)a09 );                      // 144 145 146 147 148 149 150 151 152 153 154 155 156 157 158 159
-    u10   = _mm512_load_ps( (const float *)a10 );                      // 160 161 162 163 164 165 166 167 168 169 170 171 172 173 174 175
-    u11   = _mm512_load_ps( (const float *)a11 );                      // 176 177 178 179 180 181 182 183 184 185 186 187 188 189 190 191
-    u12   = _mm512_load_ps( (const float *)a12 );                      // 192 193 194 195 196 197 198 199 200 201 202 203 204 205 206 207
-    u13   = _mm512_load_ps( (const float *)a13 );                      // 208 209 210 211 212 213 214 215 216 217 218 219 220 221 222 223
-    u14   = _mm512_load_ps( (const float *)a14 );                      // 224 225 226 227 228 229 230 231 232 233 234 235 236 237 238 239
-    u15   = _mm512_load_ps( (const float *)a15 );                      // 240 241 242 243 244 245 246 247 248 249 250 251 252 253 254 255
+    // Only the first eight floats of each record are used.  Load just the
+    // 256 bits holding them, without requiring the records to be aligned.
+    // The upper lanes are never selected below.
+
+    u00   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a00 ) );
+    u01   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a01 ) );
+    u02   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a02 ) );
+    u03   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a03 ) );
+    u04   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a04 ) );
+    u05   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a05 ) );
+    u06   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a06 ) );
+    u07   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a07 ) );
+    u08   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a08 ) );
+    u09   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a09 ) );
+    u10   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a10 ) );
+    u11   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a11 ) );
+    u12   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a12 ) );
+    u13   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a13 ) );
+    u14   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a14 ) );
+    u15   = _mm512_castps256_ps512( _mm256_loadu_ps( (const float *)a15 ) );
 
     t00   = _mm512_unpacklo_ps( u00, u01 );                            //   0  16   1  17   4  20   5  21   8  24   9  25  12  28  13  29 
     t01   = _mm512_unpackhi_ps( u00, u01 );                            //   2  18   3  19   6  22   7  23  10  26  11  27  14  30  15  31
@@ -4,7 +4,20 @@
 #define IN_v4_h
 /* FIXME: SHOULDN'T THIS INCLUDE UTIL_BASE.H? */
 #ifdef __cplusplus
-# if defined USE_V4_ALTIVEC
+# include "../simd_target.h"
+# if defined(VPIC_SIMD_KERNEL) && VPIC_SIMD_KERNEL == 4
+    /* A v4 kernel source of a USE_SIMD_DISPATCH build.  The rest of the
+       library uses the baseline v4 classes, so these get their own namespace
+       to keep the two sets of inline functions apart. */
+#   define v4 v4_kernel
+SIMD_KERNEL_BEGIN
+#   if defined USE_V4_AVX2
+#     include "v4_avx2.h"
+#   elif defined USE_V4_AVX
+#     include "v4_avx.h"
+#   endif
+SIMD_KERNEL_END
+# elif defined USE_V4_ALTIVEC
 #   include "v4_altivec.h"
 # elif defined USE_V4_PORTABLE
 #   include "v4_portable.h"
@@ -4,6 +4,10 @@
 #define IN_v8_h
 // FIXME: SHOULDN'T THIS INCLUDE UTIL_BASE.H?
 #ifdef __cplusplus
+# include "../simd_target.h"
+# if defined(VPIC_SIMD_KERNEL) && VPIC_SIMD_KERNEL == 8
+SIMD_KERNEL_BEGIN
+# endif
 # if defined USE_V8_PORTABLE
 #   include "v8_portable.h"
 # elif defined USE_V8_AVX2
@@ -11,6 +15,9 @@
 # elif defined USE_V8_AVX
 #   include "v8_avx.h"
 # endif
+# if defined(VPIC_SIMD_KERNEL) && VPIC_SIMD_KERNEL == 8
+SIMD_KERNEL_END
+# endif
 #endif
 #undef IN_v8_h
 #endif // _v8_h_
@@ -12,21 +12,63 @@
 
 #define FAK field_array->kernel
 
+// Particles sent to other domains usually get to the domain they stop in
+// in the first round of boundary_p (particles leaving through an edge or a
+// corner are sent there directly).  Further rounds are only done while
+// some domain has unprocessed movers.
+
+static int
+unprocessed_movers( species_t * sp_list ) {
+  species_t * sp;
+  int local = 0, global;
+  LIST_FOR_EACH( sp, sp_list ) local |= ( sp->nm>0 );
+  mp_allsum_i( &local, &global, 1 );
+  return global;
+}
+
 int vpic_simulation::advance(void) {
   species_t *sp;
   double err;
 
-  // Determine if we are done ... see note below why this is done here
+  // Determine if we are done ... see note below why this is done here.
+  // Dumps deferred by the last user_diagnostics are written first.
+
+  if( num_step>0 && step()>=num_step ) {
+    flush_deferred_dumps();
+    return 0;
+  }
+
+  // The phases of a step run one after the other.  Each phase that does
+  // real work either dispatches all the pipelines (the dispatcher runs one
+  // pipeline function at a time) or passes messages on this thread, so
+  // phases that do not depend on each other still cannot run at the same
+  // time.  Only small host-only phases (clearing jf, removing particles
+  // with unprocessed movers) could overlap with them.
+
+  // Move the domain boundaries to balance the load if desired.  The
+  // particles are all in their local domain and the interpolator is
+  // loaded at this point.
 
-  if( num_step>0 && step()>=num_step ) return 0;
+  if( rebalance_interval>0 && step()>0 && (step() % rebalance_interval)==0 )
+    TIC rebalance(); TOC( rebalance, 1 );
 
-  // Sort the particles for performance if desired.
+  // Sort the particles for performance if desired.  Species with a
+  // negative sort_interval are sorted when advance_p finds that the
+  // particles have become disordered enough for sorting to pay off.
+  // Subcycled species only move on their push steps, so they are only
+  // sorted on those (a sort due in between is done on the next push step).
 
   LIST_FOR_EACH( sp, species_list )
-    if( (sp->sort_interval>0) && ((step() % sp->sort_interval)==0) ) {
+    if( !SUBCYCLE_PUSH_STEP( sp, step() ) ) {
+      continue;
+    } else if( (sp->sort_interval>0) &&
+               ((step() % sp->sort_interval)<sp->subcycle) ) {
       if( rank()==0 ) MESSAGE(( "Performance sorting \"%s\"", sp->name ));
       TIC sort_p( sp ); TOC( sort_p, 1 );
-    } 
+    } else if( sp->sort_interval<0 ) {
+      int sorted;
+      TIC sorted = adaptive_sort_p( sp ); TOC( sort_p, sorted );
+    }
 
   // At this point, fields are at E_0 and B_0 and the particle positions
   // are at r_0 and u_{-1/2}.  Further the mover lists for the particles should
@@ -46,8 +88,38 @@ int vpic_simulation::advance(void) {
     TIC apply_collision_op_list( collision_op_list ); TOC( collision_model, 1 );
   TIC user_particle_collisions(); TOC( user_particle_collisions, 1 );
 
+  // Subcycled species due this step are pushed first, each on its own, such
+  // that the accumulators hold only the current of that species over its
+  // larger step once its guard list has been processed.  This current is
+  // then deposited evenly over the steps until the next push of the species
+  // (orbit averaging, see store_subcycle_p).
+
+  // Energy and hydro dumps deferred by the last user_diagnostics are
+  // computed while pushing the particles (see fused_moments in dump.cc).
+
+  LIST_FOR_EACH( sp, species_list )
+    if( sp->subcycle>1 && SUBCYCLE_PUSH_STEP( sp, step() ) ) {
+      fused_advance_p( sp );
+      TIC reduce_accumulator_array( accumulator_array ); TOC( reduce_accumulators, 1 );
+      int round = 0;
+      TIC
+        for( ; round<num_comm_round &&
+               ( round==0 || unprocessed_movers( species_list ) ); round++ )
+          boundary_p( particle_bc_list, species_list,
+                      field_array, accumulator_array );
+      TOC( boundary_p, round );
+      TIC store_subcycle_p( sp, accumulator_array ); TOC( subcycle_p, 1 );
+      TIC clear_accumulator_array( accumulator_array ); TOC( clear_accumulators, 1 );
+    }
+
   LIST_FOR_EACH( sp, species_list )
-    TIC advance_p( sp, accumulator_array, interpolator_array ); TOC( advance_p, 1 );
+    if( sp->subcycle==1 )
+      fused_advance_p( sp );
+
+  // The fields have not changed yet, so the remaining deferred dumps (energy
+  // and those of species not pushed this step) can be written now.
+
+  TIC flush_deferred_dumps(); TOC( user_diagnostics, 0 );
 
   // Because the partial position push when injecting aged particles might
   // place those particles onto the guard list (boundary interaction) and
@@ -65,36 +137,56 @@ int vpic_simulation::advance(void) {
   if( species_list )
     TIC reduce_accumulator_array( accumulator_array ); TOC( reduce_accumulators, 1 );
 
-  // At this point, most particle positions are at r_1 and u_{1/2}. Particles
+  // Add the orbit averaged current of the subcycled species.
+
+  LIST_FOR_EACH( sp, species_list )
+    if( sp->subcycle>1 )
+      TIC accumulate_subcycle_p( accumulator_array, sp ); TOC( subcycle_p, 1 );
+
+  // At this point, most particle positions are at r_1 and u_{1/2} (subcycled
+  // species are at r_N and u_{N/2} after their push steps). Particles
   // that had boundary interactions are now on the guard list. Process the
   // guard lists. Particles that absorbed are added to rhob (using a corrected
   // local accumulation).
+  //
+  // The current of the interior of the local domain is unloaded while the
+  // particles of the first round are exchanged with the neighboring
+  // domains.  The particles received only move through the voxels on the
+  // surface of the local domain (a particle moves less than a cell per step),
+  // so they do not change the current of the interior.
 
-  TIC
-    for( int round=0; round<num_comm_round; round++ )
-      boundary_p( particle_bc_list, species_list,
-                  field_array, accumulator_array );
-  TOC( boundary_p, num_comm_round );
+  TIC FAK->clear_jf( field_array ); TOC( clear_jf, 1 );
+  if( species_list && num_comm_round>0 ) {
+    TIC begin_boundary_p( particle_bc_list, species_list,
+                          field_array, accumulator_array ); TOC( boundary_p, 0 );
+    TIC unload_accumulator_array_interior( field_array, accumulator_array ); TOC( unload_accumulator, 0 );
+    int round = 1;
+    TIC {
+      end_boundary_p( species_list, field_array, accumulator_array );
+      for( ; round<num_comm_round &&
+             unprocessed_movers( species_list ); round++ )
+        boundary_p( particle_bc_list, species_list,
+                    field_array, accumulator_array );
+    } TOC( boundary_p, round );
+  }
   LIST_FOR_EACH( sp, species_list ) {
     if( sp->nm && verbose )
-      WARNING(( "Removing %i particles associated with unprocessed %s movers (increase num_comm_round)",
-                sp->nm, sp->name ));
+      WARNING(( "Removing %li particles associated with unprocessed %s movers (increase num_comm_round)",
+                (long)sp->nm, sp->name ));
     // Drop the particles that have unprocessed movers due to a user defined
     // boundary condition. Particles of this type with unprocessed movers are
     // in the list of particles and move_p has set the voxel in the particle to
     // 8*voxel + face. This is an incorrect voxel index and in many cases can
-    // in fact go out of bounds of the voxel indexing space. Removal is in
-    // reverse order for back filling. Particle charge is accumulated to the
-    // mesh before removing the particle.
-    int nm = sp->nm;
+    // in fact go out of bounds of the voxel indexing space. The charge of
+    // these particles is accumulated to the mesh before removing them.
+    // Removal is in reverse order for back filling.
+    if( sp->nm ) accumulate_rhob_movers( field_array, sp );
+    int64_t nm = sp->nm;
     particle_mover_t * RESTRICT ALIGNED(16)  pm = sp->pm + sp->nm - 1;
-    particle_t * RESTRICT ALIGNED(128) p0 = sp->p;
+    particle_block_t * RESTRICT ALIGNED(128) p0 = sp->p;
     for (; nm; nm--, pm--) {
-      int i = pm->i; // particle index we are removing
-      p0[i].i >>= 3; // shift particle voxel down
-      // accumulate the particle's charge to the mesh
-      accumulate_rhob( field_array->f, p0+i, sp->g, sp->q );
-      p0[i] = p0[sp->np-1]; // put the last particle into position i
+      int64_t i = pm->i; // particle index we are removing
+      copy_particle( p0, i, p0, sp->np-1 ); // put the last particle into position i
       sp->np--; // decrement the number of particles
     }
     sp->nm = 0;
@@ -104,8 +196,9 @@ int vpic_simulation::advance(void) {
   // guard lists are empty and the accumulators on each processor are current.
   // Convert the accumulators into currents.
 
-  TIC FAK->clear_jf( field_array ); TOC( clear_jf, 1 );
-  if( species_list )
+  if( species_list && num_comm_round>0 )
+    TIC unload_accumulator_array_surface( field_array, accumulator_array ); TOC( unload_accumulator, 1 );
+  else if( species_list )
     TIC unload_accumulator_array( field_array, accumulator_array ); TOC( unload_accumulator, 1 );
   TIC FAK->synchronize_jf( field_array ); TOC( synchronize_jf, 1 );
 
@@ -141,6 +234,16 @@ int vpic_simulation::advance(void) {
   if( (clean_div_e_interval>0) && ((step() % clean_div_e_interval)==0) ) {
     if( rank()==0 ) MESSAGE(( "Divergence cleaning electric field" ));
 
+    // Between the multiples of their subcycle interval, subcycled species
+    // have moved further than the current they deposited so far accounts
+    // for.  Cleaning would treat this as a divergence error.
+
+    LIST_FOR_EACH( sp, species_list )
+      if( (step() % sp->subcycle) && rank()==0 )
+        WARNING(( "Cleaning while the current of \"%s\" is partly deposited "
+                  "(make clean_div_e_interval a multiple of %i)",
+                  sp->name, sp->subcycle ));
+
     TIC FAK->clear_rhof( field_array ); TOC( clear_rhof,1 );
     if( species_list ) TIC LIST_FOR_EACH( sp, species_list ) accumulate_rho_p( field_array, sp ); TOC( accumulate_rho_p, species_list->id );
     TIC FAK->synchronize_rho( field_array ); TOC( synchronize_rho, 1 );
@@ -191,6 +294,7 @@ int vpic_simulation::advance(void) {
   if( (status_interval>0) && ((step() % status_interval)==0) ) {
     if( rank()==0 ) MESSAGE(( "Completed step %i of %i", step(), num_step ));
     update_profile( rank()==0 );
+    report_adaptive_sort_p( species_list, rank()==0 );
   }
 
   // Let the user compute diagnostics
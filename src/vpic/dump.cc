@@ -30,6 +30,127 @@ int vpic_simulation::dump_cwd(char * dname, size_t size) {
 	return FileUtils::getCurrentWorkingDirectory(dname, size);
 } // dump_mkdir
 
+/*****************************************************************************
+ * Fused diagnostics
+ *****************************************************************************/
+
+// When the user sets fused_moments, dump_energies, dump_hydro and
+// hydro_dump called from user_diagnostics do not sweep the particles.  At
+// that point, the particles are in the state the next advance_p starts
+// from, so these dumps are deferred to the next step, where
+// advance_p_moments computes the moments in the same pass over the
+// particles as the push.  The fields and the interpolator do not change
+// before, so the dumps are the same (up to round-off), only written a
+// step later.  Since collision operators change the particle momenta
+// before the push, nothing is deferred if there are any or if the deck
+// defines begin_particle_collisions (which could do the same; an empty
+// one cannot be told apart).  User particle injection runs after the
+// push and before user_diagnostics, so it does not matter.
+
+int
+vpic_simulation::defer_dump( DeferredDumpType type,
+                             species_t * sp,
+                             const char * name,
+                             int tag,
+                             DumpParameters * params ) {
+  DeferredDump * d;
+
+  if( !fused_moments || flushing_dumps || collision_op_list ||
+      deck_particle_collisions || !species_list ||
+      n_deferred_dump==MAX_DEFERRED_DUMP ) return 0;
+  if( strlen( name )>=sizeof(d->name) ) return 0;
+
+  if( type==deferred_energies && !fused_en ) {
+    int n = num_species( species_list );
+    MALLOC( fused_en, n );
+    while( n ) fused_en[--n] = -1; // Not computed in the push
+  }
+
+  d = deferred_dump + n_deferred_dump++;
+  d->type   = type;
+  d->sp     = sp;
+  d->tag    = tag;
+  d->params = params;
+  strcpy( d->name, name );
+  return 1;
+}
+
+// Push a species, computing the moments the deferred dumps need.  As there
+// is one hydro_array, hydro dumps of the species are written right away.
+
+void
+vpic_simulation::fused_advance_p( species_t * sp ) {
+  const int64_t np = sp->np;
+  int n, m, hydro = 0, energies = 0;
+  double t0, en;
+
+  for( n=0; n<n_deferred_dump; n++ )
+    if( deferred_dump[n].type==deferred_energies ) energies = 1;
+    else if( deferred_dump[n].sp==sp )              hydro    = 1;
+
+  if( !energies && !hydro ) {
+    t0 = wallclock();
+    TIC advance_p( sp, accumulator_array, interpolator_array ); TOC( advance_p, 1 );
+    tally_push_cost( sp, np, wallclock() - t0 );
+    return;
+  }
+
+  TIC {
+    if( hydro ) clear_hydro_array( hydro_array );
+    t0 = wallclock();
+    en = advance_p_moments( sp, accumulator_array, interpolator_array,
+                            hydro ? hydro_array : NULL );
+    tally_push_cost( sp, np, wallclock() - t0 );
+    if( hydro ) synchronize_hydro_array( hydro_array );
+  } TOC( advance_p, 1 );
+
+  if( energies ) fused_en[ sp->id ] = en;
+  if( !hydro ) return;
+
+  TIC {
+    flushing_dumps = 1;
+    fused_hydro    = sp;
+    for( n=0, m=0; n<n_deferred_dump; n++ ) {
+      DeferredDump * d = deferred_dump + n;
+      if( d->type==deferred_energies || d->sp!=sp ) {
+        deferred_dump[m++] = *d;
+      } else if( d->type==deferred_hydro ) {
+        dump_hydro( sp->name, d->name, d->tag );
+      } else {
+        hydro_dump( sp->name, *d->params );
+      }
+    }
+    n_deferred_dump = m;
+    fused_hydro     = NULL;
+    flushing_dumps  = 0;
+  } TOC( user_diagnostics, 0 );
+}
+
+// Write the deferred dumps not written yet.  This is done after the
+// particle push and whenever the particles are about to change otherwise
+// (e.g. the end of the run or a checkpoint).  Dumps of species not pushed
+// in between sweep the particles as usual.
+
+void
+vpic_simulation::flush_deferred_dumps( void ) {
+  int n;
+
+  if( !n_deferred_dump ) return;
+
+  flushing_dumps = 1;
+  for( n=0; n<n_deferred_dump; n++ ) {
+    DeferredDump * d = deferred_dump + n;
+    switch( d->type ) {
+    case deferred_energies:   dump_energies( d->name, d->tag );         break;
+    case deferred_hydro:      dump_hydro( d->sp->name, d->name, d->tag ); break;
+    case deferred_hydro_dump: hydro_dump( d->sp->name, *d->params );    break;
+    }
+  }
+  n_deferred_dump = 0;
+  flushing_dumps  = 0;
+  FREE( fused_en );
+}
+
 /*****************************************************************************
  * ASCII dump IO
  *****************************************************************************/
@@ -44,6 +165,8 @@ vpic_simulation::dump_energies( const char *fname,
 
   if( !fname ) ERROR(("Invalid file name"));
 
+  if( defer_dump( deferred_energies, NULL, fname, append, NULL ) ) return;
+
   if( rank()==0 ) {
     status = fileIO.open(fname, append ? io_append : io_write);
     if( status==fail ) ERROR(( "Could not open \"%s\".", fname ));
@@ -66,7 +189,8 @@ vpic_simulation::dump_energies( const char *fname,
                   en_f[3], en_f[4], en_f[5] );
 
   LIST_FOR_EACH(sp,species_list) {
-    en_p = energy_p( sp, interpolator_array );
+    if( fused_en && fused_en[sp->id]>=0 ) en_p = fused_en[sp->id];
+    else                                  en_p = energy_p( sp, interpolator_array );
     if( rank()==0 && status!=fail ) fileIO.print( " %e", en_p );
   }
 
@@ -224,12 +348,16 @@ vpic_simulation::dump_hydro( const char *sp_name,
   sp = find_species_name( sp_name, species_list );
   if( !sp ) ERROR(( "Invalid species \"%s\"", sp_name ));
 
-  clear_hydro_array( hydro_array );
-  accumulate_hydro_p( hydro_array, sp, interpolator_array );
-  synchronize_hydro_array( hydro_array );
-
   if( !fbase ) ERROR(( "Invalid filename" ));
 
+  if( defer_dump( deferred_hydro, sp, fbase, ftag, NULL ) ) return;
+
+  if( fused_hydro!=sp ) {
+    clear_hydro_array( hydro_array );
+    accumulate_hydro_p( hydro_array, sp, interpolator_array );
+    synchronize_hydro_array( hydro_array );
+  }
+
   if( rank()==0 )
     MESSAGE(("Dumping \"%s\" hydro fields to \"%s\"",sp->name,fbase));
 
@@ -263,16 +391,31 @@ vpic_simulation::dump_particles( const char *sp_name,
   species_t *sp;
   char fname[256];
   FileIO fileIO;
-  int dim[1], buf_start;
-  static particle_t * ALIGNED(128) p_buf = NULL;
+  int dim[1];
+  int64_t buf_start;
+  static VPIC_THREAD_LOCAL particle_block_t * ALIGNED(128) p_buf = NULL;
 # define PBUF_SIZE 32768 // 1MB of particles
 
+  // Particles are always written in the AoS format.  For other particle
+  // layouts, each hunk is converted into o_buf before it is written.
+
+# if PARTICLE_LAYOUT_AOS
+  particle_t * o_buf;
+# else
+  static VPIC_THREAD_LOCAL particle_t * ALIGNED(128) o_buf = NULL;
+# endif
+
   sp = find_species_name( sp_name, species_list );
   if( !sp ) ERROR(( "Invalid species name \"%s\".", sp_name ));
 
   if( !fbase ) ERROR(( "Invalid filename" ));
 
-  if( !p_buf ) MALLOC_ALIGNED( p_buf, PBUF_SIZE, 128 );
+  if( !p_buf ) MALLOC_ALIGNED( p_buf, PARTICLE_BLOCKS(PBUF_SIZE), 128 );
+# if PARTICLE_LAYOUT_AOS
+  o_buf = p_buf;
+# else
+  if( !o_buf ) MALLOC_ALIGNED( o_buf, PBUF_SIZE, 128 );
+# endif
 
   if( rank()==0 )
     MESSAGE(("Dumping \"%s\" particles to \"%s\"",sp->name,fbase));
@@ -292,8 +435,12 @@ vpic_simulation::dump_particles( const char *sp_name,
 
   WRITE_HEADER_V0( dump_type::particle_dump, sp->id, sp->q/sp->m, fileIO );
 
+  // The dump format stores array dimensions as int.
+  if( sp->np > INT_MAX )
+    ERROR(( "Too many \"%s\" particles (%li) on this rank for the particle "
+            "dump format.", sp->name, (long)sp->np ));
   dim[0] = sp->np;
-  WRITE_ARRAY_HEADER( p_buf, 1, dim, fileIO );
+  WRITE_ARRAY_HEADER( o_buf, 1, dim, fileIO );
 
   // Copy a PBUF_SIZE hunk of the particle list into the particle
   // buffer, timecenter it and write it out. This is done this way to
@@ -303,14 +450,18 @@ vpic_simulation::dump_particles( const char *sp_name,
   // FIXME: WITH A PIPELINED CENTER_P, PBUF NOMINALLY SHOULD BE QUITE
   // LARGE.
 
-  particle_t * sp_p = sp->p;      sp->p      = p_buf;
-  int sp_np         = sp->np;     sp->np     = 0;
-  int sp_max_np     = sp->max_np; sp->max_np = PBUF_SIZE;
+  particle_block_t * sp_p = sp->p; sp->p     = p_buf;
+  int64_t sp_np     = sp->np;     sp->np     = 0;
+  int64_t sp_max_np = sp->max_np; sp->max_np = PBUF_SIZE;
   for( buf_start=0; buf_start<sp_np; buf_start += PBUF_SIZE ) {
     sp->np = sp_np-buf_start; if( sp->np > PBUF_SIZE ) sp->np = PBUF_SIZE;
-    COPY( sp->p, &sp_p[buf_start], sp->np );
+    COPY( sp->p, &sp_p[buf_start/PARTICLE_BLOCK_SIZE],
+          PARTICLE_BLOCKS(sp->np) );
     center_p( sp, interpolator_array );
-    fileIO.write( sp->p, sp->np );
+#   if !PARTICLE_LAYOUT_AOS
+    for( int64_t n=0; n<sp->np; n++ ) load_particle( sp->p, n, o_buf+n );
+#   endif
+    fileIO.write( o_buf, sp->np );
   }
   sp->p      = sp_p;
   sp->np     = sp_np;
@@ -660,6 +811,12 @@ void
 vpic_simulation::hydro_dump( const char * speciesname,
                              DumpParameters & dumpParams ) {
 
+  species_t * sp = find_species_name(speciesname, species_list);
+  if( !sp ) ERROR(( "Invalid species name: %s", speciesname ));
+
+  if( defer_dump( deferred_hydro_dump, sp, speciesname, 0, &dumpParams ) )
+    return;
+
   // Create directory for this time step
   char timeDir[256];
   sprintf(timeDir, "%s/T.%ld", dumpParams.baseDir, (long)step());
@@ -676,12 +833,11 @@ vpic_simulation::hydro_dump( const char * speciesname,
   status = fileIO.open(filename, io_write);
   if(status == fail) ERROR(("Failed opening file: %s", filename));
 
-  species_t * sp = find_species_name(speciesname, species_list);
-  if( !sp ) ERROR(( "Invalid species name: %s", speciesname ));
-
-  clear_hydro_array( hydro_array );
-  accumulate_hydro_p( hydro_array, sp, interpolator_array );
-  synchronize_hydro_array( hydro_array );
+  if( fused_hydro!=sp ) {
+    clear_hydro_array( hydro_array );
+    accumulate_hydro_p( hydro_array, sp, interpolator_array );
+    synchronize_hydro_array( hydro_array );
+  }
 
   // convenience
   const size_t istride(dumpParams.stride_x);
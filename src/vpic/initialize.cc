@@ -11,6 +11,15 @@ vpic_simulation::initialize( int argc,
 
   TIC user_initialization( argc, argv ); TOC( user_initialization, 1 );
 
+  if( fused_moments && deck_particle_collisions && rank()==0 )
+    WARNING(( "Not fusing diagnostics, as the deck defines "
+              "begin_particle_collisions (leave it out if it is empty)" ));
+
+  // The user loaded the particles on the host.  Move them next to the
+  // pipelines that push them.
+
+  if( pipelines_pinned() ) LIST_FOR_EACH( sp, species_list ) home_species( sp );
+
   // Do some consistency checks on user initialized fields
 
   if( rank()==0 ) MESSAGE(( "Checking interdomain synchronization" ));
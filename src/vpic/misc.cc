@@ -24,6 +24,10 @@ vpic_simulation::inject_particle( species_t * sp,
   if( !accumulator_array ) ERROR(( "Accumulator not setup yet" ));
   if( !sp                ) ERROR(( "Invalid species" ));
   if( w < 0              ) ERROR(( "inject_particle: w < 0" ));
+# if defined(VPIC_USE_COMPACT_P)
+  if( w != 1             ) ERROR(( "inject_particle: w != 1 (fold the weight "
+                                   "into the species charge and mass)" ));
+# endif
 
   const double x0 = (double)grid->x0, y0 = (double)grid->y0, z0 = (double)grid->z0;
   const double x1 = (double)grid->x1, y1 = (double)grid->y1, z1 = (double)grid->z1;
@@ -73,7 +77,7 @@ vpic_simulation::inject_particle( species_t * sp,
   if( iz==nz ) iz = nz-1;             // On far wall ... conditional move
   iz++;                               // Adjust for mesh indexing
 
-  particle_t * p = sp->p + (sp->np++);
+  DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
   p->dx = (float)x; // Note: Might be rounded to be on [-1,1]
   p->dy = (float)y; // Note: Might be rounded to be on [-1,1]
   p->dz = (float)z; // Note: Might be rounded to be on [-1,1]
@@ -82,6 +86,10 @@ vpic_simulation::inject_particle( species_t * sp,
   p->uy = (float)uy;
   p->uz = (float)uz;
   p->w  = w;
+  store_particle( p, sp->p, sp->np++ );
+# if defined(VPIC_USE_COMPACT_P)
+  load_particle( sp->p, sp->np-1, p ); // Position as stored
+# endif
 
   if( update_rhob ) accumulate_rhob( field_array->f, p, grid, -sp->q );
 
@@ -221,13 +229,29 @@ void vpic_simulation::output_checksum_fields() {
   } // if
 } // vpic_simulation::output_checksum_fields
 
+// Checksum the particles of a species in the AoS interchange format such
+// that the result does not depend on the particle layout.
+
+static void
+checksum_particles( const species_t * sp, CheckSum & cs ) {
+# if PARTICLE_LAYOUT_AOS
+  checkSumBuffer<particle_t>(sp->p, sp->np, cs, "sha1");
+# else
+  particle_t * p;
+  MALLOC_ALIGNED( p, sp->np, 128 );
+  for( int64_t n=0; n<sp->np; n++ ) load_particle( sp->p, n, p+n );
+  checkSumBuffer<particle_t>(p, sp->np, cs, "sha1");
+  FREE_ALIGNED( p );
+# endif
+} // checksum_particles
+
 void vpic_simulation::checksum_species(const char * species, CheckSum & cs) {
   species_t * sp = find_species_name(species, species_list);
   if(sp == NULL) {
     ERROR(("Invalid species name \"%s\".", species));
   } // if
   
-  checkSumBuffer<particle_t>(sp->p, sp->np, cs, "sha1");
+  checksum_particles(sp, cs);
 
   if(nproc() > 1) {
     const unsigned int csels = cs.length*nproc();
@@ -255,7 +279,7 @@ void vpic_simulation::output_checksum_species(const char * species) {
   } // if
   
   CheckSum cs;
-  checkSumBuffer<particle_t>(sp->p, sp->np, cs, "sha1");
+  checksum_particles(sp, cs);
 
   if(nproc() > 1) {
     const unsigned int csels = cs.length*nproc();
@@ -0,0 +1,473 @@
+/*
+ * Dynamic load balancing.
+ *
+ * The domains of each row of the domain decomposition (the domains with
+ * the same y and z index) are x-slabs of the same width in a uniform
+ * partition.  rebalance moves the x-boundaries of the slabs such that
+ * they all have about the same load and moves the fields and particles
+ * to their new domains.  The load of each x-layer of voxels is estimated
+ * from the particles in it, each costing the time a push of its species
+ * took per particle on its domain since the last rebalance (times how
+ * often it is pushed), plus rebalance_cell_cost mean particle pushes per
+ * voxel.  All the domains with the same x index move their boundaries the
+ * same way, so the faces shared in y and z stay matched.
+ *
+ */
+
+#include "vpic.h"
+
+// Each domain s of the row sends a message to each domain d!=s for which
+// talk(s,d) holds (possibly an empty one) and these receive it.  The
+// ranges lo/hi (old domains) and nlo/nhi (new domains) are inclusive
+// x-layer ranges and talk(s,d) is that they intersect.  All the messages
+// of a domain are in flight at the same time: first the sizes (port
+// gpx+d of mp for domain d) and then the non-empty payloads (port d).
+
+#define TALK(s,d) ( lo[s]<=nhi[d] && nlo[d]<=hi[s] )
+
+static void
+exchange_row( const int * row, int ix, int gpx,
+              const int * lo,  const int * hi,
+              const int * nlo, const int * nhi,
+              int ** sbuf, const int * n_send,
+              int ** rbuf, int * n_recv ) {
+  mp_t * mp = new_mp( 2*gpx );
+  int s, d;
+
+  for( s=0; s<gpx; s++ )
+    if( s!=ix && TALK(s,ix) ) {
+      mp_size_recv_buffer( mp, gpx+s, sizeof(int) );
+      mp_begin_recv( mp, gpx+s, sizeof(int), row[s], 0 );
+    }
+
+  for( d=0; d<gpx; d++ )
+    if( d!=ix && TALK(ix,d) ) {
+      mp_size_send_buffer( mp, gpx+d, sizeof(int) );
+      *(int *)mp_send_buffer( mp, gpx+d ) = n_send[d];
+      mp_begin_send( mp, gpx+d, sizeof(int), row[d], 0 );
+    }
+
+  for( s=0; s<gpx; s++ ) {
+    n_recv[s] = 0;
+    if( s==ix ) {
+      n_recv[s] = n_send[s];
+    } else if( TALK(s,ix) ) {
+      mp_end_recv( mp, gpx+s );
+      n_recv[s] = *(int *)mp_recv_buffer( mp, gpx+s );
+      if( n_recv[s] ) {
+        mp_size_recv_buffer( mp, s, n_recv[s]*sizeof(int) );
+        mp_begin_recv( mp, s, n_recv[s]*sizeof(int), row[s], 1 );
+      }
+    }
+  }
+
+  for( d=0; d<gpx; d++ )
+    if( d!=ix && TALK(ix,d) && n_send[d] ) {
+      mp_size_send_buffer( mp, d, n_send[d]*sizeof(int) );
+      COPY( (int *)mp_send_buffer( mp, d ), sbuf[d], n_send[d] );
+      mp_begin_send( mp, d, n_send[d]*sizeof(int), row[d], 1 );
+    }
+
+  for( s=0; s<gpx; s++ ) {
+    MALLOC( rbuf[s], n_recv[s] );
+    if( s==ix ) {
+      COPY( rbuf[s], sbuf[s], n_recv[s] );
+    } else if( n_recv[s] ) {
+      mp_end_recv( mp, s );
+      COPY( rbuf[s], (int *)mp_recv_buffer( mp, s ), n_recv[s] );
+    }
+  }
+
+  for( d=0; d<gpx; d++ )
+    if( d!=ix && TALK(ix,d) ) {
+      mp_end_send( mp, gpx+d );
+      if( n_send[d] ) mp_end_send( mp, d );
+    }
+
+  delete_mp( mp );
+}
+
+#undef TALK
+
+// Move the voxel array a (sz bytes per voxel, a multiple of sizeof(int))
+// from the old x-slabs (cut) to the new ones (ncut).  Returns the array
+// for the new local domain.  If ghost is set, the new domain gets all of
+// its x-layers (ghost layers included) from the domains that had them in
+// their interior (or, at the ends of the row, as ghost layers).
+// Otherwise only the interior layers are moved and the ghost layers are
+// zero.
+
+static void *
+migrate_voxels( const void * a, int sz, int ghost,
+                const int * row, int ix, int gpx,
+                const int * cut, const int * ncut,
+                int ny, int nz ) {
+  const int nyz = (ny+2)*(nz+2), ni = sz/sizeof(int);
+  const int nx = cut[ix+1]-cut[ix], nnx = ncut[ix+1]-ncut[ix];
+  int * lo, * hi, * nlo, * nhi, ** sbuf, ** rbuf, * n_send, * n_recv;
+  int s, d, L, x, yz, l0, l1;
+  char * b;
+
+  MALLOC( lo, gpx ); MALLOC( hi, gpx ); MALLOC( nlo, gpx ); MALLOC( nhi, gpx );
+  MALLOC( sbuf, gpx ); MALLOC( rbuf, gpx );
+  MALLOC( n_send, gpx ); MALLOC( n_recv, gpx );
+
+  for( s=0; s<gpx; s++ ) {
+    lo[s]  = cut[s];    hi[s]  = cut[s+1]-1;
+    nlo[s] = ncut[s];   nhi[s] = ncut[s+1]-1;
+    if( ghost ) {
+      if( s==0     ) lo[s]--;
+      if( s==gpx-1 ) hi[s]++;
+      nlo[s]--, nhi[s]++;
+    }
+  }
+
+  // Pack the layers for each domain (voxel (x,y,z) is at x+(nx+2)*(y+..))
+
+  for( d=0; d<gpx; d++ ) {
+    l0 = lo[ix]>nlo[d] ? lo[ix] : nlo[d];
+    l1 = hi[ix]<nhi[d] ? hi[ix] : nhi[d];
+    n_send[d] = l1<l0 ? 0 : (l1-l0+1)*nyz*ni;
+    MALLOC( sbuf[d], n_send[d] );
+    for( L=l0, b=(char *)sbuf[d]; L<=l1; L++ ) {
+      x = L - cut[ix] + 1;
+      for( yz=0; yz<nyz; yz++, b+=sz )
+        memcpy( b, (const char *)a + (size_t)sz*( x + (nx+2)*(size_t)yz ), sz );
+    }
+  }
+
+  exchange_row( row, ix, gpx, lo, hi, nlo, nhi, sbuf, n_send, rbuf, n_recv );
+
+  // Unpack the layers from each domain
+
+  MALLOC_ALIGNED( b, (size_t)sz*(nnx+2)*nyz, 128 );
+  CLEAR( b, (size_t)sz*(nnx+2)*nyz );
+  for( s=0; s<gpx; s++ ) {
+    l0 = lo[s]>nlo[ix] ? lo[s] : nlo[ix];
+    l1 = hi[s]<nhi[ix] ? hi[s] : nhi[ix];
+    if( l1<l0 ) continue;
+    if( n_recv[s]!=(l1-l0+1)*nyz*ni ) ERROR(( "Bad voxel message" ));
+    const char * r = (const char *)rbuf[s];
+    for( L=l0; L<=l1; L++ ) {
+      x = L - ncut[ix] + 1;
+      for( yz=0; yz<nyz; yz++, r+=sz )
+        memcpy( b + (size_t)sz*( x + (nnx+2)*(size_t)yz ), r, sz );
+    }
+  }
+
+  for( s=0; s<gpx; s++ ) { FREE( sbuf[s] ); FREE( rbuf[s] ); }
+  FREE( n_recv ); FREE( n_send ); FREE( rbuf ); FREE( sbuf );
+  FREE( nhi ); FREE( nlo ); FREE( hi ); FREE( lo );
+  return b;
+}
+
+// Move the particles of sp from the old x-slabs (cut) to the new ones
+// (ncut).  The particles must all be in the interior of the local domain
+// (no pending movers).
+
+static void
+migrate_particles( species_t * sp,
+                   const int * row, int ix, int gpx,
+                   const int * cut, const int * ncut,
+                   int ny, int nz ) {
+  const int ni = sizeof(particle_t)/sizeof(int);
+  const int sy = cut[ix+1]-cut[ix]+2;
+  const int nsy = ncut[ix+1]-ncut[ix]+2, nsz = nsy*(ny+2);
+  int * lo, * hi, * nlo, * nhi, ** sbuf, ** rbuf, * n_send, * n_recv, * next;
+  int64_t n, np, n_in;
+  particle_t q;
+  int s, d, i, x, yz;
+
+  MALLOC( lo, gpx ); MALLOC( hi, gpx ); MALLOC( nlo, gpx ); MALLOC( nhi, gpx );
+  MALLOC( sbuf, gpx ); MALLOC( rbuf, gpx );
+  MALLOC( n_send, gpx ); MALLOC( n_recv, gpx ); MALLOC( next, gpx );
+
+  for( s=0; s<gpx; s++ ) {
+    lo[s]  = cut[s];  hi[s]  = cut[s+1]-1;
+    nlo[s] = ncut[s]; nhi[s] = ncut[s+1]-1;
+  }
+
+  // Count the particles leaving for each domain
+
+# define DOMAIN_OF(L) do {                                         \
+    d = ix;                                                        \
+    while( (L)<ncut[d]   ) d--;                                    \
+    while( (L)>=ncut[d+1] ) d++;                                   \
+  } while(0)
+
+  CLEAR( n_send, gpx );
+  for( n=0; n<sp->np; n++ ) {
+    i = PARTICLE_VOXEL( sp->p, n );
+    x = i - sy*(i/sy);
+    DOMAIN_OF( cut[ix]+x-1 );
+    if( d!=ix ) n_send[d]++;
+  }
+  for( d=0; d<gpx; d++ ) {
+    if( (int64_t)n_send[d]*ni>INT_MAX )
+      ERROR(( "Too many %s particles to rebalance", sp->name ));
+    MALLOC( sbuf[d], n_send[d]*ni );
+    next[d] = 0, n_send[d] *= ni;
+  }
+
+  // Pack the leaving particles and compact the staying ones (moved to the
+  // voxel indexing of the new local domain)
+
+  for( n=0, np=0; n<sp->np; n++ ) {
+    load_particle( sp->p, n, &q );
+    i = q.i;
+    yz = i/sy;
+    x  = i - sy*yz;
+    DOMAIN_OF( cut[ix]+x-1 );
+    q.i = ( cut[ix]+x-ncut[d] ) + ( ncut[d+1]-ncut[d]+2 )*yz;
+    if( d==ix ) store_particle( &q, sp->p, np++ );
+    else        memcpy( sbuf[d] + next[d], &q, sizeof(q) ), next[d] += ni;
+  }
+  sp->np = np;
+
+# undef DOMAIN_OF
+
+  exchange_row( row, ix, gpx, lo, hi, nlo, nhi, sbuf, n_send, rbuf, n_recv );
+
+  // Make room for the arriving particles (see reserve_particles in
+  // boundary_p.cc)
+
+  for( s=0, n_in=0; s<gpx; s++ ) n_in += n_recv[s]/ni;
+  n = sp->np + n_in;
+  if( n>sp->max_np ) {
+    particle_block_t * new_p;
+    n += 0.3125*n;
+    WARNING(( "Resizing local %s particle storage from %li to %li",
+              sp->name, (long)sp->max_np, (long)n ));
+    MALLOC_ALIGNED( new_p, PARTICLE_BLOCKS(n), 128 );
+    COPY( new_p, sp->p, PARTICLE_BLOCKS(sp->np) );
+    FREE_ALIGNED( sp->p );
+    sp->p = new_p, sp->max_np = n;
+  }
+
+  for( s=0; s<gpx; s++ )
+    for( n=0; n<n_recv[s]; n+=ni ) {
+      memcpy( &q, rbuf[s] + n, sizeof(q) );
+      if( q.i<nsy || q.i>=nsz*(nz+1) ) ERROR(( "Bad particle message" ));
+      store_particle( &q, sp->p, sp->np++ );
+    }
+
+  for( s=0; s<gpx; s++ ) { FREE( sbuf[s] ); FREE( rbuf[s] ); }
+  FREE( next ); FREE( n_recv ); FREE( n_send ); FREE( rbuf ); FREE( sbuf );
+  FREE( nhi ); FREE( nlo ); FREE( hi ); FREE( lo );
+}
+
+// Cut the row into slabs of at least 2 voxels with a load of at most
+// max_load each (P is the prefix sum of the load of the x-layers).
+// Returns whether this is possible.  reach(j,L) is whether the first j
+// slabs can end at layer L.  As P is increasing, the latest reachable end
+// of the first j-1 slabs before L-1 is the best start of slab j.
+
+static int
+cut_slabs( const double * P, int gnx, int gpx, double max_load, int * cut ) {
+  char * reach;
+  int j, L, l;
+
+  MALLOC( reach, gpx*(gnx+1) );
+  CLEAR( reach, gpx*(gnx+1) );
+  reach[0] = 1;
+  for( j=1; j<gpx; j++ ) {
+    const char * r0 = reach + (j-1)*(gnx+1);
+    char       * r1 = reach +  j   *(gnx+1);
+    for( L=2, l=-1; L<=gnx; L++ ) {
+      if( r0[L-2] ) l = L-2;
+      r1[L] = ( l>=0 && P[L]-P[l]<=max_load );
+    }
+  }
+
+  cut[gpx] = gnx;
+  for( j=gpx; j>0; j-- ) {
+    const char * r0 = reach + (j-1)*(gnx+1);
+    for( l=cut[j]-2; l>=0 && !r0[l]; l-- ) ;
+    if( l<0 || P[cut[j]]-P[l]>max_load ) break;
+    cut[j-1] = l;
+  }
+
+  FREE( reach );
+  return j==0;
+}
+
+// Largest load of the x-slabs cut relative to the mean load (P is the
+// prefix sum of the load of the x-layers)
+
+static double
+slab_imbalance( const double * P, const int * cut, int gpx, int gnx ) {
+  double max_load = 0;
+  for( int j=0; j<gpx; j++ )
+    if( P[cut[j+1]]-P[cut[j]]>max_load ) max_load = P[cut[j+1]]-P[cut[j]];
+  return P[gnx]>0 ? max_load*gpx/P[gnx] : 1;
+}
+
+// Add a push of np particles of sp that took t seconds to the measured
+// push cost (used to estimate the load)
+
+void
+vpic_simulation::tally_push_cost( const species_t * sp, int64_t np, double t ) {
+  if( rebalance_interval<=0 ) return;
+  if( !push_cost ) {
+    const int n = 2*num_species( species_list );
+    MALLOC( push_cost, n );
+    CLEAR( push_cost, n );
+  }
+  push_cost[ 2*sp->id   ] += t;
+  push_cost[ 2*sp->id+1 ] += np;
+}
+
+void
+vpic_simulation::rebalance( void ) {
+  const int gpx = px, gpy = py, gpz = pz;
+  const int nsp = num_species( species_list );
+  int ix = 0, j, L, nx, gnx, ok, local[2], global[2];
+  int * row, * cut, * ncut, * lnx;
+  double * load, * P, * tally, * cost, x0[2], gx[2], imbalance, new_imbalance;
+  double lo_load, hi_load, mean_cost, t, pushed;
+  species_t * sp;
+
+  if( !grid || !field_array || !species_list ) return;
+
+  // Check that the domains were partitioned into a gpx x gpy x gpz
+  // decomposition by a partition helper, that their particle boundary
+  // conditions are those of whole domain faces (repartition_grid_x keeps
+  // only these) and that nothing else depends on the local voxel indexing.
+
+  ok = ( gpx>1 && gpx*gpy*gpz==world_size && !emitter_list &&
+         can_repartition_grid_x( grid ) );
+  if( ok ) {
+    ix = world_rank % gpx;
+    if( ix>0     && grid->bc[BOUNDARY(-1,0,0)]!=world_rank-1 ) ok = 0;
+    if( ix<gpx-1 && grid->bc[BOUNDARY( 1,0,0)]!=world_rank+1 ) ok = 0;
+  }
+  LIST_FOR_EACH( sp, species_list ) if( sp->nm ) ok = 0;
+  local[0] = !ok; local[1] = grid->nx<2;
+  mp_allsum_i( local, global, 2 );
+  if( global[0] || global[1] ) {
+    if( rank()==0 )
+      WARNING(( "Load balancing needs at least 2 domains along x, 2 voxels "
+                "per domain, a partition helper decomposition, no emitters "
+                "and no particle boundary conditions inside the domains "
+                "(disabled)" ));
+    rebalance_interval = 0;
+    return;
+  }
+  // Get the current x-slabs of the row (all rows have the same slabs)
+
+  MALLOC( row, gpx ); MALLOC( lnx, world_size );
+  MALLOC( cut, gpx+1 ); MALLOC( ncut, gpx+1 );
+  for( j=0; j<gpx; j++ ) row[j] = world_rank - ix + j;
+  nx = grid->nx;
+  mp_allgather_i( &nx, lnx, 1 );
+  for( j=0, cut[0]=0; j<gpx; j++ ) cut[j+1] = cut[j] + lnx[row[j]];
+  gnx = cut[gpx];
+
+  x0[0] = ix==0     ? grid->x0 : 0;
+  x0[1] = ix==gpx-1 ? grid->x1 : 0;
+  mp_allsum_d( x0, gx, 2 );
+  gx[0] /= gpy*gpz, gx[1] /= gpy*gpz;
+
+  // Get the measured cost of a push of a particle of each species: on
+  // this domain if it pushed any, else the mean over the domains that did.
+  // Without any measurement (say, right after a restart), all particle
+  // pushes cost the same.
+
+  MALLOC( tally, 4*nsp ); MALLOC( cost, nsp );
+  if( push_cost ) COPY( tally, push_cost, 2*nsp );
+  else            CLEAR( tally, 2*nsp );
+  mp_allsum_d( tally, tally+2*nsp, 2*nsp );
+  const double * all = tally+2*nsp;
+  for( j=0, t=0, pushed=0; j<nsp; j++ ) t += all[2*j], pushed += all[2*j+1];
+  mean_cost = pushed>0 ? t/pushed : 1;
+  for( j=0; j<nsp; j++ )
+    cost[j] = tally[2*j+1]>0 ? tally[2*j]/tally[2*j+1] :
+              all[2*j+1]>0   ? all[2*j]/all[2*j+1]     : mean_cost;
+
+  // Estimate the load of each x-layer
+
+  MALLOC( load, gnx ); MALLOC( P, gnx+1 );
+  CLEAR( load, gnx );
+  LIST_FOR_EACH( sp, species_list ) {
+    const int sy = nx+2;
+    const double w = cost[ sp->id ]/sp->subcycle;
+    for( int64_t n=0; n<sp->np; n++ ) {
+      int i = PARTICLE_VOXEL( sp->p, n );
+      load[ cut[ix] + i - sy*(i/sy) - 1 ] += w;
+    }
+  }
+  for( L=0; L<gnx; L++ ) P[L] = load[L];
+  mp_allsum_d( P, load, gnx );
+  for( L=0, P[0]=0; L<gnx; L++ )
+    P[L+1] = P[L] + load[L] +
+             rebalance_cell_cost*mean_cost*grid->ny*grid->nz*gpy*gpz;
+
+  // Find the smallest largest slab load the row can be cut into by
+  // bisection
+
+  lo_load = P[gnx]/gpx, hi_load = P[gnx];
+  for( j=0; j<50; j++ ) {
+    const double mid_load = 0.5*( lo_load + hi_load );
+    if( cut_slabs( P, gnx, gpx, mid_load, ncut ) ) hi_load = mid_load;
+    else                                          lo_load = mid_load;
+  }
+  cut_slabs( P, gnx, gpx, hi_load, ncut );
+
+  imbalance     = slab_imbalance( P, cut,  gpx, gnx );
+  new_imbalance = slab_imbalance( P, ncut, gpx, gnx );
+
+  if( imbalance>rebalance_tolerance && new_imbalance<imbalance ) {
+    if( rank()==0 )
+      MESSAGE(( "Rebalancing load (imbalance %.3f -> %.3f)",
+                imbalance, new_imbalance ));
+
+    // Move the fields and particles to their new domains
+
+    field_t * f = (field_t *)
+      migrate_voxels( field_array->f, sizeof(field_t), 1,
+                      row, ix, gpx, cut, ncut, grid->ny, grid->nz );
+    FREE_ALIGNED( field_array->f );
+    field_array->f = f;
+
+    LIST_FOR_EACH( sp, species_list ) {
+      migrate_particles( sp, row, ix, gpx, cut, ncut, grid->ny, grid->nz );
+      if( sp->sub_a ) {
+        accumulator_t * a = (accumulator_t *)
+          migrate_voxels( sp->sub_a, sizeof(accumulator_t), 0,
+                          row, ix, gpx, cut, ncut, grid->ny, grid->nz );
+        FREE_ALIGNED( sp->sub_a );
+        sp->sub_a = a;
+      }
+    }
+
+    // Move the domain boundaries
+
+    double f0 = (double)ncut[ix]  /(double)gnx;
+    double f1 = (double)ncut[ix+1]/(double)gnx;
+    repartition_grid_x( grid, gx[0]*(1-f0) + gx[1]*f0,
+                              gx[0]*(1-f1) + gx[1]*f1, ncut[ix+1]-ncut[ix] );
+
+    // Rebuild what depends on the local voxel indexing
+
+    LIST_FOR_EACH( sp, species_list ) {
+      FREE_ALIGNED( sp->partition );
+      MALLOC_ALIGNED( sp->partition, grid->nv+1, 128 );
+      sort_p( sp );
+    }
+
+    delete_interpolator_array( interpolator_array );
+    delete_accumulator_array( accumulator_array );
+    delete_hydro_array( hydro_array );
+    interpolator_array = new_interpolator_array( grid );
+    accumulator_array  = new_accumulator_array( grid );
+    hydro_array        = new_hydro_array( grid );
+    load_interpolator_array( interpolator_array, field_array );
+  }
+
+  // Measure the push cost anew for the next rebalance
+
+  if( push_cost ) CLEAR( push_cost, 2*nsp );
+
+  FREE( P ); FREE( load ); FREE( cost ); FREE( tally );
+  FREE( ncut ); FREE( cut ); FREE( lnx ); FREE( row );
+}
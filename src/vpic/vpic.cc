@@ -54,11 +54,22 @@ restore_vpic_simulation( void ) {
   RESTORE_FPTR( vpic->particle_bc_list );
   RESTORE_FPTR( vpic->emitter_list );
   RESTORE_FPTR( vpic->collision_op_list );
+
+  // Dumps deferred after the checkpoint was written are lost.
+
+  if( vpic->n_deferred_dump )
+    WARNING(( "%i deferred dumps lost in checkpoint", vpic->n_deferred_dump ));
+  vpic->n_deferred_dump = 0;
+  vpic->flushing_dumps  = 0;
+  vpic->fused_en        = NULL;
+  vpic->fused_hydro     = NULL;
+  vpic->push_cost       = NULL;
   return vpic;
 }
 
 void
 reanimate_vpic_simulation( vpic_simulation * vpic ) {
+  species_t * sp;
   REANIMATE_FPTR( vpic->material_list );
   REANIMATE_FPTR( vpic->field_array );
   REANIMATE_FPTR( vpic->interpolator_array );
@@ -68,9 +79,22 @@ reanimate_vpic_simulation( vpic_simulation * vpic ) {
   REANIMATE_FPTR( vpic->particle_bc_list );
   REANIMATE_FPTR( vpic->emitter_list );
   REANIMATE_FPTR( vpic->collision_op_list );
+
+  // Restored particles were read on the host (see initialize)
+
+  if( pipelines_pinned() )
+    LIST_FOR_EACH( sp, vpic->species_list ) home_species( sp );
 }
 
 
+int vpic_simulation::deck_particle_collisions = 0;
+
+// Decks that do not touch the particles before the push can leave out
+// begin_particle_collisions, which then uses this one (see defer_dump).
+
+void __attribute__((weak))
+vpic_simulation::user_particle_collisions( void ) {}
+
 vpic_simulation::vpic_simulation() {
   CLEAR( this, 1 );
 
@@ -79,6 +103,8 @@ vpic_simulation::vpic_simulation() {
   num_comm_round = 3;
   num_div_e_round = 2;
   num_div_b_round = 2;
+  rebalance_tolerance = 1.1;
+  rebalance_cell_cost = 1;
 
 #if defined(VPIC_USE_PTHREADS)                         // Pthreads case.
   int                              n_rng = serial.n_pipeline;
@@ -111,6 +137,7 @@ vpic_simulation::vpic_simulation() {
  
 vpic_simulation::~vpic_simulation() {
   UNREGISTER_OBJECT( this );
+  FREE( push_cost );
   delete_emitter_list( emitter_list );
   delete_particle_bc_list( particle_bc_list );
   delete_species_list( species_list );
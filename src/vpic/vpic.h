@@ -117,6 +117,28 @@ struct DumpParameters {
 
 }; // struct DumpParameters
 
+/*----------------------------------------------------------------------------
+ * DeferredDump Struct
+----------------------------------------------------------------------------*/
+// An energies or hydro dump deferred to the next particle push (see
+// fused_moments in dump.cc)
+
+#define MAX_DEFERRED_DUMP 32
+
+enum DeferredDumpType {
+  deferred_energies = 0,  // dump_energies
+  deferred_hydro = 1,     // dump_hydro
+  deferred_hydro_dump = 2 // hydro_dump
+}; // enum DeferredDumpType
+
+struct DeferredDump {
+  DeferredDumpType type;
+  species_t * sp;           // Species (hydro)
+  int tag;                  // append (energies) or fname_tag (hydro)
+  char name[256];           // File name (energies) or base (hydro)
+  DumpParameters * params;  // hydro_dump parameters
+}; // struct DeferredDump
+
 class vpic_simulation {
 public:
   vpic_simulation();
@@ -125,6 +147,11 @@ public:
   void modify( const char *fname );
   int advance( void );
   void finalize( void );
+  void flush_deferred_dumps( void );
+  void rebalance( void );
+
+  // Set if the deck defines begin_particle_collisions (see defer_dump)
+  static int deck_particle_collisions;
 
 protected:
 
@@ -139,6 +166,13 @@ protected:
   int clean_div_b_interval; // How often to clean div b
   int num_div_b_round;      // How many clean div b rounds per div b interval
   int sync_shared_interval; // How often to synchronize shared faces
+  int fused_moments;        // Compute energy and hydro dumps in the push
+  int rebalance_interval;   // How often to rebalance the load (see
+  /**/                      // rebalance.cc)
+  double rebalance_tolerance; // Rebalance if the largest domain load
+  /**/                        // exceeds the mean by more than this factor
+  double rebalance_cell_cost; // Load of a voxel relative to a particle
+  /**/                        // push
 
   // FIXME: THESE INTERVALS SHOULDN'T BE PART OF vpic_simulation
   // THE BIG LIST FOLLOWING IT SHOULD BE CLEANED UP TOO
@@ -196,6 +230,19 @@ protected:
                                              // emitter helpers
   collision_op_t       * collision_op_list;  // collision helpers
 
+  // Dumps deferred to the next particle push (see fused_moments)
+
+  int                    n_deferred_dump;
+  DeferredDump           deferred_dump[MAX_DEFERRED_DUMP];
+  int                    flushing_dumps;     // Write, do not defer
+  double               * fused_en;           // Energy of each species
+  const species_t      * fused_hydro;        // Species in hydro_array
+
+  // Time spent pushing each species and number of particles pushed since
+  // the last rebalance (see rebalance.cc)
+
+  double               * push_cost;
+
   // User defined checkpt preserved variables
   // Note: user_global is aliased with user_global_t (see deck_wrapper.cxx)
  
@@ -254,6 +301,12 @@ protected:
   void field_dump(DumpParameters & dumpParams);
   void hydro_dump(const char * speciesname, DumpParameters & dumpParams);
 
+  // Fused diagnostics (see fused_moments)
+  int defer_dump( DeferredDumpType type, species_t * sp, const char * name,
+                  int tag, DumpParameters * params );
+  void fused_advance_p( species_t * sp );
+  void tally_push_cost( const species_t * sp, int64_t np, double t );
+
   ///////////////////
   // Useful accessors
 
@@ -398,6 +451,12 @@ protected:
     set_pbc( grid, boundary, pbc );
   }
 
+  // Sets the space filling curve (fortran_sfc, morton_sfc or hilbert_sfc)
+  // along which particles are sorted in the local domain
+  inline void set_domain_sfc( int sfc ) {
+    set_sfc( grid, sfc );
+  }
+
   ///////////////////
   // Material helpers
 
@@ -490,7 +549,8 @@ protected:
                   double max_local_np,
                   double max_local_nm,
                   double sort_interval,
-                  double sort_out_of_place ) {
+                  double sort_out_of_place,
+                  double subcycle = 1 ) {
     // Compute a reasonble number of movers if user did not specify
     // Based on the twice the number of particles expected to hit the boundary
     // of a wpdt=0.2 / dx=lambda species in a 3x3x3 domain
@@ -502,7 +562,7 @@ protected:
     return append_species( species( name, (float)q, (float)m,
                                     (size_t)max_local_np, (size_t)max_local_nm,
                                     (int)sort_interval, (int)sort_out_of_place,
-                                    grid ), &species_list );
+                                    (int)subcycle, grid ), &species_list );
   }
 
   inline species_t *
@@ -541,9 +601,10 @@ protected:
   inject_particle_raw( species_t * RESTRICT sp,
                        float dx, float dy, float dz, int32_t i,
                        float ux, float uy, float uz, float w ) {
-    particle_t * RESTRICT p = sp->p + (sp->np++);
+    DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
     p->dx = dx; p->dy = dy; p->dz = dz; p->i = i;
     p->ux = ux; p->uy = uy; p->uz = uz; p->w = w;
+    store_particle( p, sp->p, sp->np++ );
   }
 
   // This variant does a raw inject and moves the particles
@@ -554,10 +615,11 @@ protected:
                        float ux, float uy, float uz, float w,
                        float dispx, float dispy, float dispz,
                        int update_rhob ) {
-    particle_t       * RESTRICT p  = sp->p  + (sp->np++);
+    DECLARE_ALIGNED_ARRAY( particle_t, 32, p, 1 );
     particle_mover_t * RESTRICT pm = sp->pm + sp->nm;
     p->dx = dx; p->dy = dy; p->dz = dz; p->i = i;
     p->ux = ux; p->uy = uy; p->uz = uz; p->w = w;
+    store_particle( p, sp->p, sp->np++ );
     pm->dispx = dispx; pm->dispy = dispy; pm->dispz = dispz; pm->i = sp->np-1;
     if( update_rhob ) accumulate_rhob( field_array->f, p, grid, -sp->q );
     sp->nm += move_p( sp->p, pm, accumulator_array->a, grid, sp->q );